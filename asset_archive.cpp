@@ -0,0 +1,322 @@
+
+#include "asset_archive.h"
+#include "lz4_block.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace {
+    static constexpr std::size_t DECODE_THREAD_MAX = 4;
+
+    // Threads decoding blocks of compressed entries. The calling thread decodes blocks too
+    // If the pool is busy with another entry, the caller decodes its entry alone
+    //
+    class BlockDecodePool {
+    public:
+        BlockDecodePool() {
+            std::size_t threadCount = std::min(std::max(std::thread::hardware_concurrency(), 2u) - 1, unsigned(DECODE_THREAD_MAX));
+
+            for (std::size_t i = 0; i < threadCount; i++) {
+                _workers.emplace_back(&BlockDecodePool::_workerLoop, this);
+            }
+        }
+
+        ~BlockDecodePool() {
+            {
+                std::lock_guard<std::mutex> guard(_guard);
+                _stopped = true;
+            }
+
+            _wakeup.notify_all();
+
+            for (auto &worker : _workers) {
+                worker.join();
+            }
+        }
+
+        // Calls @task for every index in [0, count). Returns false if any call has failed
+        //
+        bool run(std::size_t count, const std::function<bool(std::size_t)> &task) {
+            std::unique_lock<std::mutex> busy(_runGuard, std::try_to_lock);
+
+            if (busy.owns_lock() == false || count < 2) {
+                bool result = true;
+
+                for (std::size_t i = 0; i < count; i++) {
+                    result = task(i) && result;
+                }
+
+                return result;
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(_guard);
+                _task = &task;
+                _count = count;
+                _next = 0;
+                _done = 0;
+                _failed = false;
+                _generation++;
+            }
+
+            _wakeup.notify_all();
+            _process();
+
+            std::unique_lock<std::mutex> lock(_guard);
+            _finished.wait(lock, [this] { return _done == _count && _active == 0; });
+            _task = nullptr;
+            return _failed == false;
+        }
+
+    private:
+        void _process() {
+            std::size_t index;
+            std::size_t processed = 0;
+            bool failed = false;
+
+            while ((index = _next.fetch_add(1)) < _count) {
+                failed = _task->operator()(index) == false || failed;
+                processed++;
+            }
+
+            std::lock_guard<std::mutex> guard(_guard);
+            _done += processed;
+            _failed = _failed || failed;
+
+            if (_done == _count) {
+                _finished.notify_all();
+            }
+        }
+
+        void _workerLoop() {
+            std::uint64_t generation = 0;
+
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(_guard);
+                    _wakeup.wait(lock, [this, generation] { return _stopped || (_task && _generation != generation); });
+
+                    if (_stopped) {
+                        break;
+                    }
+
+                    generation = _generation;
+                    _active++;
+                }
+
+                _process();
+
+                std::lock_guard<std::mutex> guard(_guard);
+                _active--;
+                _finished.notify_all();
+            }
+        }
+
+        std::mutex _runGuard;
+        std::mutex _guard;
+        std::condition_variable _wakeup;
+        std::condition_variable _finished;
+        std::vector<std::thread> _workers;
+
+        const std::function<bool(std::size_t)> *_task = nullptr;
+        std::atomic<std::size_t> _next {0};
+        std::size_t _count = 0;
+        std::size_t _done = 0;
+        std::size_t _active = 0;
+        std::uint64_t _generation = 0;
+        bool _failed = false;
+        bool _stopped = false;
+    };
+
+    BlockDecodePool &getBlockDecodePool() {
+        static BlockDecodePool pool;
+        return pool;
+    }
+
+    const char *normalizePath(const char *path, std::size_t &length) {
+        while (path[0] == '.' && path[1] == '/') {
+            path += 2;
+        }
+
+        length = std::strlen(path);
+
+        while (length && path[length - 1] == '/') {
+            length--;
+        }
+
+        return path;
+    }
+}
+
+namespace platform {
+    AssetArchive::AssetArchive(const std::shared_ptr<FileView> &view)
+    : _view(view)
+    , _header(nullptr)
+    , _slots(nullptr)
+    , _sorted(nullptr)
+    , _strings(nullptr)
+    , _valid(false)
+    {
+        if (_view == nullptr || _view->getSize() < sizeof(AssetArchiveHeader)) {
+            return;
+        }
+
+        const std::uint8_t *base = _view->getData();
+        const std::uint64_t size = _view->getSize();
+
+        _header = reinterpret_cast<const AssetArchiveHeader *>(base);
+
+        if (_header->magic != ASSET_ARCHIVE_MAGIC || _header->version != ASSET_ARCHIVE_VERSION) {
+            return;
+        }
+        if (_header->slotCount == 0 || (_header->slotCount & (_header->slotCount - 1)) != 0 || _header->slotCount < 2 * std::uint64_t(_header->entryCount)) {
+            return;
+        }
+        if (_header->slotsOffset + std::uint64_t(_header->slotCount) * sizeof(AssetArchiveEntry) > size) {
+            return;
+        }
+        if (_header->sortedOffset + std::uint64_t(_header->entryCount) * sizeof(std::uint32_t) > size) {
+            return;
+        }
+        if (_header->stringsOffset + _header->stringsSize > size) {
+            return;
+        }
+
+        _slots = reinterpret_cast<const AssetArchiveEntry *>(base + _header->slotsOffset);
+        _sorted = reinterpret_cast<const std::uint32_t *>(base + _header->sortedOffset);
+        _strings = reinterpret_cast<const char *>(base + _header->stringsOffset);
+
+        std::uint32_t occupiedCount = 0;
+
+        for (std::uint32_t i = 0; i < _header->slotCount; i++) {
+            const AssetArchiveEntry &entry = _slots[i];
+
+            if (entry.pathHash) {
+                occupiedCount++;
+
+                if (std::uint64_t(entry.pathOffset) + entry.pathLength > _header->stringsSize || entry.dataOffset + entry.storedSize > size) {
+                    return;
+                }
+                if ((entry.flags & ASSET_ARCHIVE_ENTRY_COMPRESSED) == 0 && entry.storedSize != entry.size) {
+                    return;
+                }
+                if ((entry.flags & ASSET_ARCHIVE_ENTRY_COMPRESSED) && _header->blockSize == 0) {
+                    return;
+                }
+            }
+        }
+        // find() probes until empty slot, so index must have one
+        if (occupiedCount != _header->entryCount || occupiedCount >= _header->slotCount) {
+            return;
+        }
+        for (std::uint32_t i = 0; i < _header->entryCount; i++) {
+            if (_sorted[i] >= _header->slotCount || _slots[_sorted[i]].pathHash == 0) {
+                return;
+            }
+        }
+
+        _valid = true;
+    }
+
+    bool AssetArchive::isValid() const {
+        return _valid;
+    }
+
+    const AssetArchiveEntry *AssetArchive::find(const char *filePath) const {
+        std::size_t length = 0;
+        const char *path = normalizePath(filePath, length);
+        const std::uint64_t hash = assetArchivePathHash(path, length);
+        const std::uint32_t mask = _header->slotCount - 1;
+
+        // table is at most half full, so the first probe usually hits
+        for (std::uint32_t index = std::uint32_t(hash) & mask; _slots[index].pathHash != 0; index = (index + 1) & mask) {
+            const AssetArchiveEntry &entry = _slots[index];
+
+            if (entry.pathHash == hash && entry.pathLength == length && std::memcmp(_strings + entry.pathOffset, path, length) == 0) {
+                return &entry;
+            }
+        }
+
+        return nullptr;
+    }
+
+    const std::uint8_t *AssetArchive::getData(const AssetArchiveEntry &entry) const {
+        return _view->getData() + entry.dataOffset;
+    }
+
+    bool AssetArchive::read(const AssetArchiveEntry &entry, std::uint8_t *dst) const {
+        const std::uint8_t *src = getData(entry);
+
+        if ((entry.flags & ASSET_ARCHIVE_ENTRY_COMPRESSED) == 0) {
+            if (entry.size) {
+                std::memcpy(dst, src, std::size_t(entry.size));
+            }
+
+            return true;
+        }
+
+        const std::uint64_t blockSize = _header->blockSize;
+        const std::size_t blockCount = std::size_t((entry.size + blockSize - 1) / blockSize);
+        const std::uint32_t *blockTable = reinterpret_cast<const std::uint32_t *>(src);
+
+        if (std::uint64_t(blockCount) * sizeof(std::uint32_t) > entry.storedSize) {
+            return false;
+        }
+
+        // block offsets inside blob, the last item is the end of blocks
+        std::vector<std::uint64_t> blockOffsets (blockCount + 1);
+        blockOffsets[0] = blockCount * sizeof(std::uint32_t);
+
+        for (std::size_t i = 0; i < blockCount; i++) {
+            blockOffsets[i + 1] = blockOffsets[i] + (blockTable[i] & ~ASSET_ARCHIVE_BLOCK_RAW);
+        }
+
+        if (blockOffsets[blockCount] > entry.storedSize) {
+            return false;
+        }
+
+        return getBlockDecodePool().run(blockCount, [&](std::size_t index) {
+            const std::uint8_t *block = src + blockOffsets[index];
+            const std::size_t storedSize = std::size_t(blockOffsets[index + 1] - blockOffsets[index]);
+            const std::size_t size = std::size_t(std::min(blockSize, entry.size - index * blockSize));
+            std::uint8_t *output = dst + index * blockSize;
+
+            if (blockTable[index] & ASSET_ARCHIVE_BLOCK_RAW) {
+                if (storedSize != size) {
+                    return false;
+                }
+
+                std::memcpy(output, block, size);
+                return true;
+            }
+
+            return lz4Decompress(block, storedSize, output, size);
+        });
+    }
+
+    bool AssetArchive::load(const AssetArchiveEntry &entry, std::unique_ptr<uint8_t[]> &data, std::size_t &size) const {
+        data = std::make_unique<uint8_t[]>(std::size_t(entry.size));
+        size = std::size_t(entry.size);
+        return read(entry, data.get());
+    }
+
+    std::uint32_t AssetArchive::getEntryCount() const {
+        return _header->entryCount;
+    }
+
+    const AssetArchiveEntry &AssetArchive::getEntry(std::uint32_t index) const {
+        return _slots[_sorted[index]];
+    }
+
+    const char *AssetArchive::getPath(const AssetArchiveEntry &entry) const {
+        return _strings + entry.pathOffset;
+    }
+
+    const std::shared_ptr<FileView> &AssetArchive::getView() const {
+        return _view;
+    }
+}
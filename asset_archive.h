@@ -0,0 +1,115 @@
+#pragma once
+
+#include "interfaces.h"
+
+// Asset archive layout (little-endian):
+//
+//     AssetArchiveHeader
+//     AssetArchiveEntry[slotCount]   - open addressing hash table of entries. Empty slot has pathHash == 0
+//     std::uint32_t[entryCount]      - slot indices sorted by path. Used for directory listing
+//     char[stringsSize]              - entry paths (not null-terminated)
+//     blobs                          - file contents, each blob starts at ASSET_ARCHIVE_ALIGNMENT boundary
+//
+// Compressed blob is split to blocks of header.blockSize uncompressed bytes (the last one can be smaller):
+//
+//     std::uint32_t[blockCount]      - stored size of every block. ASSET_ARCHIVE_BLOCK_RAW bit marks block stored without compression
+//     blocks                         - LZ4 blocks, one after another
+//
+// Paths are relative to the root of packed directory with '/' as separator. Example: "data/map1/test.png"
+
+namespace platform {
+    static constexpr std::uint32_t ASSET_ARCHIVE_MAGIC = 0x52414B50; // 'PKAR'
+    static constexpr std::uint32_t ASSET_ARCHIVE_VERSION = 2;
+    static constexpr std::uint64_t ASSET_ARCHIVE_ALIGNMENT = 4096;
+    static constexpr std::uint32_t ASSET_ARCHIVE_BLOCK_SIZE = 64 * 1024;
+    static constexpr std::uint32_t ASSET_ARCHIVE_BLOCK_RAW = 0x80000000;
+    static constexpr std::uint32_t ASSET_ARCHIVE_ENTRY_COMPRESSED = 0x1;
+
+    struct AssetArchiveHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t entryCount;
+        std::uint32_t slotCount;         // power of two, at least 2 * entryCount
+        std::uint64_t slotsOffset;
+        std::uint64_t sortedOffset;
+        std::uint64_t stringsOffset;
+        std::uint64_t stringsSize;
+        std::uint32_t blockSize;         // uncompressed size of block of compressed entries
+        std::uint32_t reserved[3];
+    };
+
+    struct AssetArchiveEntry {
+        std::uint64_t pathHash;
+        std::uint32_t pathOffset;        // offset in strings block
+        std::uint32_t pathLength;
+        std::uint64_t dataOffset;        // offset from the beginning of archive
+        std::uint64_t size;              // size of file contents
+        std::uint64_t storedSize;        // size of blob. Equals to size for uncompressed entries
+        std::uint32_t flags;
+        std::uint32_t reserved;
+    };
+
+    static_assert(sizeof(AssetArchiveHeader) == 64, "Unexpected header size");
+    static_assert(sizeof(AssetArchiveEntry) == 48, "Unexpected entry size");
+
+    // FNV-1a. Never returns 0 because 0 marks empty slot
+    //
+    inline std::uint64_t assetArchivePathHash(const char *path, std::size_t length) {
+        std::uint64_t result = 0xcbf29ce484222325ull;
+
+        for (std::size_t i = 0; i < length; i++) {
+            result = (result ^ std::uint8_t(path[i])) * 0x100000001b3ull;
+        }
+
+        return result ? result : 1;
+    }
+
+    // Read-only access to mapped archive
+    //
+    class AssetArchive {
+    public:
+        AssetArchive(const std::shared_ptr<FileView> &view);
+
+        // Checks layout of mapped file. Other methods must not be called for invalid archive
+        //
+        bool isValid() const;
+
+        // Looks up entry by path
+        // @return nullptr if there is no such file in archive
+        //
+        const AssetArchiveEntry *find(const char *filePath) const;
+
+        // Pointer to entry blob inside mapped archive. Contents of compressed entry must be obtained by read()
+        //
+        const std::uint8_t *getData(const AssetArchiveEntry &entry) const;
+
+        // Copies or decompresses entry contents to @dst of entry.size bytes
+        // Blocks of compressed entry are decoded in parallel directly into @dst
+        //
+        bool read(const AssetArchiveEntry &entry, std::uint8_t *dst) const;
+
+        // Copies or decompresses entry contents to newly allocated memory
+        //
+        bool load(const AssetArchiveEntry &entry, std::unique_ptr<uint8_t[]> &data, std::size_t &size) const;
+
+        // Entries in order of paths
+        // @index - [0, getEntryCount())
+        //
+        std::uint32_t getEntryCount() const;
+        const AssetArchiveEntry &getEntry(std::uint32_t index) const;
+
+        // Entry path, not null-terminated. Length is entry.pathLength
+        //
+        const char *getPath(const AssetArchiveEntry &entry) const;
+
+        const std::shared_ptr<FileView> &getView() const;
+
+    private:
+        std::shared_ptr<FileView> _view;
+        const AssetArchiveHeader *_header;
+        const AssetArchiveEntry *_slots;
+        const std::uint32_t *_sorted;
+        const char *_strings;
+        bool _valid;
+    };
+}
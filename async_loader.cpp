@@ -0,0 +1,120 @@
+
+#include "async_loader.h"
+
+#include <algorithm>
+
+namespace platform {
+    AsyncFileLoader::AsyncFileLoader(Platform &platform, std::size_t threadCount, std::size_t maxInFlight) : _platform(platform), _maxInFlight(std::max(maxInFlight, std::size_t(1))) {
+        for (std::size_t i = 0; i < std::max(threadCount, std::size_t(1)); i++) {
+            _workers.emplace_back(&AsyncFileLoader::_workerLoop, this);
+        }
+    }
+
+    AsyncFileLoader::~AsyncFileLoader() {
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+            _stopped = true;
+        }
+
+        _wakeup.notify_all();
+
+        for (auto &worker : _workers) {
+            worker.join();
+        }
+    }
+
+    FileLoadToken AsyncFileLoader::load(const char *filePath, LoadPriority priority, Completion &&completion) {
+        std::unique_ptr<Request> request = std::make_unique<Request>();
+        FileLoadToken token;
+
+        request->priority = priority;
+        request->filePath = filePath;
+        request->completion = std::move(completion);
+
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+            token = request->token = ++_lastToken;
+            _requests.emplace(token, request.get());
+            _queue.emplace(QueueKey(-int(priority), token), std::move(request));
+        }
+
+        _wakeup.notify_one();
+        return token;
+    }
+
+    bool AsyncFileLoader::cancel(FileLoadToken token) {
+        std::lock_guard<std::mutex> guard(_guard);
+        auto index = _requests.find(token);
+
+        if (index != _requests.end()) {
+            Request *request = index->second;
+
+            // not started yet: just forget it, otherwise the result is dropped on delivery
+            if (_queue.erase(QueueKey(-int(request->priority), token)) == 0) {
+                request->cancelled = true;
+            }
+
+            _requests.erase(index);
+            return true;
+        }
+
+        return false;
+    }
+
+    void AsyncFileLoader::dispatchCompletions() {
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+
+            if (_completed.empty()) {
+                return;
+            }
+
+            _delivering.swap(_completed);
+
+            for (auto &request : _delivering) {
+                _requests.erase(request->token);
+            }
+        }
+
+        for (auto &request : _delivering) {
+            if (request->cancelled == false && request->completion) {
+                request->completion(request->loaded, request->data, request->size);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+            _inFlight -= _delivering.size();
+        }
+
+        _delivering.clear();
+        _wakeup.notify_all();
+    }
+
+    void AsyncFileLoader::_workerLoop() {
+        while (true) {
+            std::unique_ptr<Request> request;
+
+            {
+                std::unique_lock<std::mutex> lock(_guard);
+                _wakeup.wait(lock, [this] {
+                    return _stopped || (_queue.empty() == false && _inFlight < _maxInFlight);
+                });
+
+                if (_stopped) {
+                    break;
+                }
+
+                request = std::move(_queue.begin()->second);
+                _queue.erase(_queue.begin());
+                _inFlight++;
+            }
+
+            // cancellation while reading is handled on delivery
+            request->loaded = _platform.loadFile(request->filePath.c_str(), request->data, request->size);
+
+            std::lock_guard<std::mutex> guard(_guard);
+            _completed.emplace_back(std::move(request));
+        }
+    }
+}
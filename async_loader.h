@@ -0,0 +1,61 @@
+#pragma once
+
+#include "interfaces.h"
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+
+namespace platform {
+    // Pool of I/O threads reading files through Platform::loadFile
+    // Requests are served in priority order. At most @maxInFlight requests are being read or wait for delivery at the same time,
+    // the rest stay in queue. Completions are delivered by dispatchCompletions() on the thread that runs Platform::run()
+    //
+    class AsyncFileLoader {
+    public:
+        using Completion = std::function<void(bool loaded, std::unique_ptr<uint8_t[]> &data, std::size_t size)>;
+
+        AsyncFileLoader(Platform &platform, std::size_t threadCount, std::size_t maxInFlight);
+        ~AsyncFileLoader();
+
+        FileLoadToken load(const char *filePath, LoadPriority priority, Completion &&completion);
+        bool cancel(FileLoadToken token);
+
+        // Calls completions of finished requests. Must be called from the run() thread
+        //
+        void dispatchCompletions();
+
+    private:
+        struct Request {
+            FileLoadToken token;
+            LoadPriority priority;
+            std::string filePath;
+            Completion completion;
+            bool cancelled = false;
+            bool loaded = false;
+            std::unique_ptr<uint8_t[]> data;
+            std::size_t size = 0;
+        };
+
+        // queue key: higher priority first, then FIFO
+        using QueueKey = std::pair<int, FileLoadToken>;
+
+        void _workerLoop();
+
+        Platform &_platform;
+        const std::size_t _maxInFlight;
+
+        std::mutex _guard;
+        std::condition_variable _wakeup;
+        std::map<QueueKey, std::unique_ptr<Request>> _queue;
+        std::unordered_map<FileLoadToken, Request *> _requests;
+        std::vector<std::unique_ptr<Request>> _completed;
+        std::vector<std::unique_ptr<Request>> _delivering;
+        std::vector<std::thread> _workers;
+        std::size_t _inFlight = 0;
+        FileLoadToken _lastToken = 0;
+        bool _stopped = false;
+    };
+}
@@ -0,0 +1,527 @@
+
+#include "async_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <ctime>
+
+namespace {
+    static constexpr std::size_t LOG_RECORD_MAX = 1024;     // longer messages are truncated
+    static constexpr std::size_t LOG_LINE_MAX = 2048;
+    static constexpr std::size_t LOG_SPEC_MAX = 64;
+    static constexpr std::size_t LOG_RECORD_ALIGNMENT = 8;
+    static constexpr auto LOG_FLUSH_PERIOD = std::chrono::milliseconds(10);
+
+    const char *LOG_LEVEL_NAMES[std::size_t(platform::LogLevel::_count)] = {
+        "Info",
+        "Warning",
+        "Error",
+    };
+
+    // Record in ring buffer: header, null-terminated format string, encoded arguments
+    // Header with zero size means that the rest of buffer is skipped and the next record is at the beginning.
+    // Only size field of such header is written, the rest of buffer may be shorter than header
+    //
+    struct RecordHeader {
+        std::uint32_t size;
+        std::uint32_t level;
+        std::int64_t timeMs;
+    };
+
+    // Conversion specification of format string: %[flags][width][.precision][length]conversion
+    //
+    struct FormatSpec {
+        const char *begin;          // points to '%'
+        const char *end;            // points after conversion char
+        bool widthArg;              // width is '*'
+        bool precisionArg;          // precision is '.*'
+        char length[3];
+        char conversion;
+    };
+
+    // @return false if specification is malformed
+    bool parseSpec(const char *percent, FormatSpec &spec) {
+        const char *p = percent + 1;
+
+        spec.begin = percent;
+        spec.widthArg = false;
+        spec.precisionArg = false;
+        spec.length[0] = spec.length[1] = spec.length[2] = 0;
+
+        while (*p && std::strchr("-+ #0", *p)) {
+            p++;
+        }
+
+        if (*p == '*') {
+            spec.widthArg = true;
+            p++;
+        }
+        else {
+            while (*p >= '0' && *p <= '9') p++;
+        }
+
+        if (*p == '.') {
+            p++;
+
+            if (*p == '*') {
+                spec.precisionArg = true;
+                p++;
+            }
+            else {
+                while (*p >= '0' && *p <= '9') p++;
+            }
+        }
+
+        for (std::size_t i = 0; i < 2 && *p && std::strchr("hljztL", *p); i++) {
+            spec.length[i] = *p++;
+        }
+
+        if (*p == 0 || std::strchr("diuoxXcfFeEgGaAspn%", *p) == nullptr) {
+            return false;
+        }
+
+        spec.conversion = *p++;
+        spec.end = p;
+        return true;
+    }
+
+    bool isLength(const FormatSpec &spec, const char *length) {
+        return std::strcmp(spec.length, length) == 0;
+    }
+
+    std::int64_t readSigned(const FormatSpec &spec, va_list &args) {
+        if (isLength(spec, "hh")) return static_cast<signed char>(va_arg(args, int));
+        if (isLength(spec, "h")) return static_cast<short>(va_arg(args, int));
+        if (isLength(spec, "l")) return va_arg(args, long);
+        if (isLength(spec, "ll")) return va_arg(args, long long);
+        if (isLength(spec, "j")) return va_arg(args, std::intmax_t);
+        if (isLength(spec, "z") || isLength(spec, "t")) return va_arg(args, std::ptrdiff_t);
+        return va_arg(args, int);
+    }
+
+    std::uint64_t readUnsigned(const FormatSpec &spec, va_list &args) {
+        if (isLength(spec, "hh")) return static_cast<unsigned char>(va_arg(args, unsigned));
+        if (isLength(spec, "h")) return static_cast<unsigned short>(va_arg(args, unsigned));
+        if (isLength(spec, "l")) return va_arg(args, unsigned long);
+        if (isLength(spec, "ll")) return va_arg(args, unsigned long long);
+        if (isLength(spec, "j")) return va_arg(args, std::uintmax_t);
+        if (isLength(spec, "z") || isLength(spec, "t")) return va_arg(args, std::size_t);
+        return va_arg(args, unsigned);
+    }
+
+    class Encoder {
+    public:
+        Encoder(std::uint8_t *data, std::size_t capacity) : _data(data), _capacity(capacity) {}
+
+        template<typename T> void put(const T &value) {
+            if (_size + sizeof(T) <= _capacity) {
+                std::memcpy(_data + _size, &value, sizeof(T));
+            }
+
+            _size += sizeof(T);
+        }
+
+        // strings are truncated to fit into record
+        void putString(const char *str) {
+            std::size_t length = str ? std::strlen(str) : 0;
+            std::size_t available = _capacity > _size + sizeof(std::uint32_t) + 1 ? _capacity - _size - sizeof(std::uint32_t) - 1 : 0;
+
+            length = std::min(length, available);
+            put(std::uint32_t(length));
+
+            if (_size + length + 1 <= _capacity) {
+                std::memcpy(_data + _size, str, length);
+                _data[_size + length] = 0;
+            }
+
+            _size += length + 1;
+        }
+
+        bool isOverflowed() const {
+            return _size > _capacity;
+        }
+
+        std::size_t getSize() const {
+            return _size;
+        }
+
+    private:
+        std::uint8_t *_data;
+        std::size_t _capacity;
+        std::size_t _size = 0;
+    };
+
+    class Decoder {
+    public:
+        Decoder(const std::uint8_t *data, std::size_t size) : _data(data), _size(size) {}
+
+        template<typename T> T get() {
+            T result = T();
+
+            if (_offset + sizeof(T) <= _size) {
+                std::memcpy(&result, _data + _offset, sizeof(T));
+            }
+
+            _offset += sizeof(T);
+            return result;
+        }
+
+        const char *getString() {
+            std::uint32_t length = get<std::uint32_t>();
+            const char *result = _offset + length < _size ? reinterpret_cast<const char *>(_data + _offset) : "";
+            _offset += length + 1;
+            return result;
+        }
+
+    private:
+        const std::uint8_t *_data;
+        std::size_t _size;
+        std::size_t _offset = 0;
+    };
+
+    // Arguments are stored in order of format string: 64-bit integers, doubles, pointers and strings with length
+    //
+    void encodeArgs(const char *fmt, va_list &args, Encoder &encoder) {
+        FormatSpec spec;
+
+        for (const char *p = std::strchr(fmt, '%'); p && parseSpec(p, spec); p = std::strchr(spec.end, '%')) {
+            if (spec.widthArg) {
+                encoder.put(std::int64_t(va_arg(args, int)));
+            }
+            if (spec.precisionArg) {
+                encoder.put(std::int64_t(va_arg(args, int)));
+            }
+
+            switch (spec.conversion) {
+                case 'd':
+                case 'i':
+                    encoder.put(readSigned(spec, args));
+                    break;
+                case 'u':
+                case 'o':
+                case 'x':
+                case 'X':
+                    encoder.put(readUnsigned(spec, args));
+                    break;
+                case 'c':
+                    encoder.put(std::int64_t(va_arg(args, int)));
+                    break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                    encoder.put(isLength(spec, "L") ? double(va_arg(args, long double)) : va_arg(args, double));
+                    break;
+                case 's':
+                    if (isLength(spec, "l")) {
+                        va_arg(args, void *);
+                        encoder.putString("(wide string)");
+                    }
+                    else {
+                        const char *str = va_arg(args, const char *);
+                        encoder.putString(str ? str : "(null)");
+                    }
+                    break;
+                case 'p':
+                case 'n':
+                    encoder.put(std::uint64_t(reinterpret_cast<std::uintptr_t>(va_arg(args, void *))));
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // Formats message stored by encodeArgs. Every conversion is formatted separately by snprintf with normalized length modifier
+    //
+    std::size_t decodeMessage(const char *fmt, Decoder &decoder, char *out, std::size_t capacity) {
+        std::size_t size = 0;
+        FormatSpec spec;
+
+        auto append = [&](const char *text, std::size_t length) {
+            length = std::min(length, capacity - 1 - size);
+            std::memcpy(out + size, text, length);
+            size += length;
+        };
+
+        const char *literal = fmt;
+
+        for (const char *p = std::strchr(fmt, '%'); p && parseSpec(p, spec); p = std::strchr(spec.end, '%')) {
+            append(literal, std::size_t(p - literal));
+            literal = spec.end;
+
+            char specText[LOG_SPEC_MAX];
+            std::size_t specLength = 0;
+
+            // flags, width and precision with '*' replaced by stored values
+            for (const char *s = spec.begin; s != spec.end - 1 - std::strlen(spec.length) && specLength < LOG_SPEC_MAX - 24; s++) {
+                if (*s == '*') {
+                    specLength += std::snprintf(specText + specLength, LOG_SPEC_MAX - specLength, "%lld", (long long)decoder.get<std::int64_t>());
+                }
+                else {
+                    specText[specLength++] = *s;
+                }
+            }
+
+            const bool isInteger = std::strchr("diuoxX", spec.conversion) != nullptr;
+
+            if (isInteger) {
+                specText[specLength++] = 'l';
+                specText[specLength++] = 'l';
+            }
+
+            specText[specLength++] = spec.conversion;
+            specText[specLength] = 0;
+
+            char *target = out + size;
+            const std::size_t available = capacity - size;
+            int written = 0;
+
+            switch (spec.conversion) {
+                case 'd':
+                case 'i':
+                    written = std::snprintf(target, available, specText, (long long)decoder.get<std::int64_t>());
+                    break;
+                case 'u':
+                case 'o':
+                case 'x':
+                case 'X':
+                    written = std::snprintf(target, available, specText, (unsigned long long)decoder.get<std::uint64_t>());
+                    break;
+                case 'c':
+                    written = std::snprintf(target, available, specText, int(decoder.get<std::int64_t>()));
+                    break;
+                case 's':
+                    written = std::snprintf(target, available, specText, decoder.getString());
+                    break;
+                case 'p':
+                    written = std::snprintf(target, available, specText, reinterpret_cast<void *>(std::uintptr_t(decoder.get<std::uint64_t>())));
+                    break;
+                case 'n':
+                    decoder.get<std::uint64_t>();
+                    break;
+                case '%':
+                    append("%", 1);
+                    break;
+                default:
+                    written = std::snprintf(target, available, specText, decoder.get<double>());
+                    break;
+            }
+
+            size += std::min(std::size_t(std::max(written, 0)), available - 1);
+        }
+
+        append(literal, std::strlen(literal));
+        out[size] = 0;
+        return size;
+    }
+}
+
+namespace platform {
+    AsyncLog::AsyncLog(Sink &&sink, std::size_t threadBufferSize) : _sink(std::move(sink)), _threadBufferSize([threadBufferSize] {
+        std::size_t result = 2 * LOG_RECORD_MAX;
+
+        while (result < threadBufferSize) {
+            result <<= 1;
+        }
+
+        return result;
+    }())
+    {
+        _thread = std::thread(&AsyncLog::_formatLoop, this);
+    }
+
+    AsyncLog::~AsyncLog() {
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+            _stopped = true;
+        }
+
+        _wakeup.notify_one();
+        _thread.join();
+        _drain();
+    }
+
+    void AsyncLog::write(LogLevel level, const char *fmt, va_list args) {
+        std::uint8_t record[LOG_RECORD_MAX];
+        Encoder encoder(record, LOG_RECORD_MAX);
+
+        const std::int64_t timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        encoder.put(RecordHeader{0, std::uint32_t(level), timeMs});
+        encoder.putString(fmt);
+
+        va_list argsCopy;
+        va_copy(argsCopy, args);
+        encodeArgs(fmt, argsCopy, encoder);
+        va_end(argsCopy);
+
+        ThreadBuffer &buffer = _getThreadBuffer();
+
+        if (encoder.isOverflowed()) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const std::size_t size = (encoder.getSize() + LOG_RECORD_ALIGNMENT - 1) / LOG_RECORD_ALIGNMENT * LOG_RECORD_ALIGNMENT;
+        const std::uint32_t recordSize = std::uint32_t(size);
+        std::memcpy(record + offsetof(RecordHeader, size), &recordSize, sizeof(recordSize));
+
+        const std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        const std::uint64_t tail = buffer.tail.load(std::memory_order_acquire);
+        const std::size_t offset = std::size_t(head & (buffer.capacity - 1));
+        const std::size_t contiguous = buffer.capacity - offset;
+        const std::size_t skipped = contiguous < size ? contiguous : 0;
+
+        if (head + skipped + size - tail > buffer.capacity) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (skipped) {
+            const std::uint32_t zero = 0;
+            std::memcpy(buffer.data.get() + offset, &zero, sizeof(zero));
+        }
+
+        std::memcpy(buffer.data.get() + (skipped ? 0 : offset), record, encoder.getSize());
+        buffer.head.store(head + skipped + size, std::memory_order_release);
+
+        if (level == LogLevel::ERROR) {
+            _wakeup.notify_one();
+        }
+    }
+
+    void AsyncLog::flush() {
+        _drain();
+    }
+
+    std::uint64_t AsyncLog::getDroppedCount() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    AsyncLog::ThreadBuffer &AsyncLog::_getThreadBuffer() {
+        struct Holder {
+            ~Holder() {
+                if (buffer) {
+                    buffer->abandoned = true;
+                }
+            }
+
+            const AsyncLog *owner = nullptr;
+            std::shared_ptr<ThreadBuffer> buffer;
+        };
+
+        static thread_local Holder holder;
+
+        if (holder.owner != this) {
+            if (holder.buffer) {
+                holder.buffer->abandoned = true;
+            }
+
+            holder.owner = this;
+            holder.buffer = std::make_shared<ThreadBuffer>(_threadBufferSize);
+
+            std::lock_guard<std::mutex> guard(_buffersGuard);
+            _buffers.emplace_back(holder.buffer);
+        }
+
+        return *holder.buffer;
+    }
+
+    void AsyncLog::_drain() {
+        std::lock_guard<std::mutex> drainGuard(_drainGuard);
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+        {
+            std::lock_guard<std::mutex> guard(_buffersGuard);
+            buffers = _buffers;
+        }
+
+        for (const auto &buffer : buffers) {
+            _drainBuffer(*buffer);
+        }
+
+        // buffers of exited threads are released when they are empty
+        std::lock_guard<std::mutex> guard(_buffersGuard);
+
+        for (auto index = _buffers.begin(); index != _buffers.end(); ) {
+            ThreadBuffer &buffer = **index;
+
+            if (buffer.abandoned && buffer.head.load(std::memory_order_acquire) == buffer.tail.load(std::memory_order_relaxed)) {
+                index = _buffers.erase(index);
+            }
+            else {
+                ++index;
+            }
+        }
+    }
+
+    void AsyncLog::_drainBuffer(ThreadBuffer &buffer) {
+        char message[LOG_LINE_MAX];
+        char line[LOG_LINE_MAX + 64];
+
+        auto output = [this, &line](LogLevel level, std::int64_t timeMs, const char *text) {
+            char timeText[32];
+            std::time_t t = std::time_t(timeMs / 1000);
+            std::strftime(timeText, sizeof(timeText), "%T", std::gmtime(&t));
+            std::snprintf(line, sizeof(line), "[%s %s] %s", timeText, LOG_LEVEL_NAMES[std::size_t(level)], text);
+            _sink(level, line);
+        };
+
+        const std::uint64_t head = buffer.head.load(std::memory_order_acquire);
+        std::uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+
+        while (tail != head) {
+            const std::uint8_t *record = buffer.data.get() + (tail & (buffer.capacity - 1));
+            std::uint32_t recordSize;
+            std::memcpy(&recordSize, record + offsetof(RecordHeader, size), sizeof(recordSize));
+
+            // skip marker may be closer to the end than full header
+            if (recordSize == 0) {
+                tail += buffer.capacity - (tail & (buffer.capacity - 1));
+                continue;
+            }
+
+            RecordHeader header;
+            std::memcpy(&header, record, sizeof(header));
+
+            Decoder decoder(record + sizeof(RecordHeader), header.size - sizeof(RecordHeader));
+            const char *fmt = decoder.getString();
+
+            decodeMessage(fmt, decoder, message, sizeof(message));
+            output(LogLevel(header.level), header.timeMs, message);
+
+            tail += header.size;
+            buffer.tail.store(tail, std::memory_order_release);
+        }
+
+        buffer.tail.store(tail, std::memory_order_release);
+
+        if (std::uint64_t dropped = buffer.dropped.exchange(0, std::memory_order_relaxed)) {
+            _dropped.fetch_add(dropped, std::memory_order_relaxed);
+
+            const std::int64_t timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            std::snprintf(message, sizeof(message), "[Platform] %llu log messages dropped", (unsigned long long)dropped);
+            output(LogLevel::WARNING, timeMs, message);
+        }
+    }
+
+    void AsyncLog::_formatLoop() {
+        std::unique_lock<std::mutex> lock(_guard);
+
+        while (_stopped == false) {
+            _wakeup.wait_for(lock, LOG_FLUSH_PERIOD);
+
+            lock.unlock();
+            _drain();
+            lock.lock();
+        }
+    }
+}
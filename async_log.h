@@ -0,0 +1,68 @@
+#pragma once
+
+#include "interfaces.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdarg>
+#include <condition_variable>
+
+namespace platform {
+    // Log with deferred formatting
+    // Each writing thread has its own ring buffer where write() stores format string and raw arguments without locking.
+    // Background thread formats messages and passes them to sink. If ring buffer of thread is full, message is dropped and counted
+    //
+    class AsyncLog {
+    public:
+        using Sink = std::function<void(LogLevel level, const char *line)>;
+
+        // @sink             - receives formatted lines like '[12:00:00 Info] text'. Called from background thread or flush()
+        // @threadBufferSize - size of ring buffer of every writing thread, rounded up to power of two
+        //
+        AsyncLog(Sink &&sink, std::size_t threadBufferSize);
+        ~AsyncLog();
+
+        // Stores message. Supports printf conversions except %n and wide strings
+        //
+        void write(LogLevel level, const char *fmt, va_list args);
+
+        // Writes all stored messages before returning
+        //
+        void flush();
+
+        // Count of messages dropped since start
+        //
+        std::uint64_t getDroppedCount() const;
+
+    private:
+        struct ThreadBuffer {
+            ThreadBuffer(std::size_t size) : data(new std::uint8_t[size]), capacity(size) {}
+
+            std::unique_ptr<std::uint8_t[]> data;
+            const std::size_t capacity;
+            std::atomic<std::uint64_t> head {0};    // written by owner thread
+            std::atomic<std::uint64_t> tail {0};    // written by formatting thread
+            std::atomic<std::uint64_t> dropped {0};
+            std::atomic<bool> abandoned {false};    // owner thread has exited
+        };
+
+        ThreadBuffer &_getThreadBuffer();
+        void _drain();
+        void _drainBuffer(ThreadBuffer &buffer);
+        void _formatLoop();
+
+        Sink _sink;
+        const std::size_t _threadBufferSize;
+
+        std::mutex _buffersGuard;
+        std::vector<std::shared_ptr<ThreadBuffer>> _buffers;
+
+        std::mutex _drainGuard;
+        std::mutex _guard;
+        std::condition_variable _wakeup;
+        std::thread _thread;
+        std::atomic<std::uint64_t> _dropped {0};
+        bool _stopped = false;
+    };
+}
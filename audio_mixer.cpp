@@ -0,0 +1,718 @@
+#include "audio_mixer.h"
+#include "audio_stream.h"
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MIXER_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MIXER_NEON 1
+#endif
+
+namespace {
+    constexpr std::uint32_t FILTER_TAPS_MAX = 32;
+    constexpr std::uint32_t FILTER_PHASE_BITS = 8;
+    constexpr std::uint32_t FILTER_PHASES = 1 << FILTER_PHASE_BITS;
+    constexpr std::uint32_t FILTER_BANKS = 12;          // bank b is for steps up to 1 + b / 4, higher steps alias slightly
+    constexpr double FILTER_CUTOFF = 0.9;               // of source Nyquist frequency for steps up to 1
+    constexpr std::uint32_t SOUND_PADDING = FILTER_TAPS_MAX;    // zero frames before and after sound data
+    constexpr std::uint32_t STREAM_PADDING = FILTER_TAPS_MAX / 2;   // frames of stream window before and after position
+    constexpr std::uint64_t FIXED_ONE = std::uint64_t(1) << 32;
+    constexpr float PITCH_MIN = 1.0f / 1024.0f;
+    constexpr float PITCH_MAX = 4.0f;
+    constexpr float LOAD_SMOOTHING = 0.05f;
+    constexpr double PI = 3.14159265358979323846;
+
+    std::size_t roundCapacity(std::size_t capacity) {
+        std::size_t result = 2;
+
+        while (result < capacity) {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+    // Filter of bank b spans more source frames as its step grows, so its cutoff stays sharp: 8, 16, 24 or 32 taps
+    // Taps are at -(taps / 2 - 1)..taps / 2 frames around position
+    std::uint32_t getBankTaps(std::uint32_t bank) {
+        return 8 * (1 + (bank + 3) / 4);
+    }
+
+    std::size_t getBankOffset(std::uint32_t bank) {
+        std::size_t offset = 0;
+
+        for (std::uint32_t b = 0; b < bank; b++) {
+            offset += std::size_t(FILTER_PHASES) * getBankTaps(b);
+        }
+
+        return offset;
+    }
+
+    // @taps - multiple of 8
+    float dot(const float *src, const float *coef, std::uint32_t taps) {
+    #if MIXER_SSE
+        __m128 sum = _mm_setzero_ps();
+
+        for (std::uint32_t k = 0; k < taps; k += 8) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + k), _mm_loadu_ps(coef + k)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + k + 4), _mm_loadu_ps(coef + k + 4)));
+        }
+
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum);
+    #elif MIXER_NEON
+        float32x4_t sum = vdupq_n_f32(0.0f);
+
+        for (std::uint32_t k = 0; k < taps; k += 8) {
+            sum = vmlaq_f32(sum, vld1q_f32(src + k), vld1q_f32(coef + k));
+            sum = vmlaq_f32(sum, vld1q_f32(src + k + 4), vld1q_f32(coef + k + 4));
+        }
+
+        #if defined(__aarch64__)
+        return vaddvq_f32(sum);
+        #else
+        const float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        return vget_lane_f32(vpadd_f32(pair, pair), 0);
+        #endif
+    #else
+        float sum = 0.0f;
+
+        for (std::uint32_t i = 0; i < taps; i++) {
+            sum += src[i] * coef[i];
+        }
+
+        return sum;
+    #endif
+    }
+
+    // bus[i] += src[i] * gain ramped linearly from @gain to @gain + @delta * count
+    void mixRamp(float *bus, const float *src, std::uint32_t count, float gain, float delta) {
+        std::uint32_t i = 0;
+
+    #if MIXER_SSE
+        __m128 current = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(_mm_set1_ps(delta), _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f)));
+        const __m128 increment = _mm_set1_ps(delta * 4.0f);
+
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(bus + i, _mm_add_ps(_mm_loadu_ps(bus + i), _mm_mul_ps(_mm_loadu_ps(src + i), current)));
+            current = _mm_add_ps(current, increment);
+        }
+    #elif MIXER_NEON
+        const float ramp[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+        float32x4_t current = vmlaq_n_f32(vdupq_n_f32(gain), vld1q_f32(ramp), delta);
+        const float32x4_t increment = vdupq_n_f32(delta * 4.0f);
+
+        for (; i + 4 <= count; i += 4) {
+            vst1q_f32(bus + i, vmlaq_f32(vld1q_f32(bus + i), vld1q_f32(src + i), current));
+            current = vaddq_f32(current, increment);
+        }
+    #endif
+
+        for (; i < count; i++) {
+            bus[i] += src[i] * (gain + delta * float(i + 1));
+        }
+    }
+
+    // Applies ramped master gain, clamps to [-1, 1] and interleaves planar bus to @output
+    void writeOutput(float *output, const float *left, const float *right, std::uint32_t count, float gain, float delta) {
+        std::uint32_t i = 0;
+
+    #if MIXER_SSE
+        __m128 current = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(_mm_set1_ps(delta), _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f)));
+        const __m128 increment = _mm_set1_ps(delta * 4.0f);
+        const __m128 low = _mm_set1_ps(-1.0f);
+        const __m128 high = _mm_set1_ps(1.0f);
+
+        for (; i + 4 <= count; i += 4) {
+            const __m128 l = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(left + i), current), low), high);
+            const __m128 r = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(right + i), current), low), high);
+            _mm_storeu_ps(output + i * 2, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(output + i * 2 + 4, _mm_unpackhi_ps(l, r));
+            current = _mm_add_ps(current, increment);
+        }
+    #elif MIXER_NEON
+        const float ramp[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+        float32x4_t current = vmlaq_n_f32(vdupq_n_f32(gain), vld1q_f32(ramp), delta);
+        const float32x4_t increment = vdupq_n_f32(delta * 4.0f);
+        const float32x4_t low = vdupq_n_f32(-1.0f);
+        const float32x4_t high = vdupq_n_f32(1.0f);
+
+        for (; i + 4 <= count; i += 4) {
+            float32x4x2_t frames;
+            frames.val[0] = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(left + i), current), low), high);
+            frames.val[1] = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(right + i), current), low), high);
+            vst2q_f32(output + i * 2, frames);
+            current = vaddq_f32(current, increment);
+        }
+    #endif
+
+        for (; i < count; i++) {
+            const float g = gain + delta * float(i + 1);
+            output[i * 2 + 0] = std::min(std::max(left[i] * g, -1.0f), 1.0f);
+            output[i * 2 + 1] = std::min(std::max(right[i] * g, -1.0f), 1.0f);
+        }
+    }
+
+    // Resamples @count frames of @channel to @out starting from @position, that is advanced
+    // @bank   - FILTER_PHASES filters of @taps taps
+    // @return - count of produced frames, less than @count if sound without loop has ended. The rest of @out is zeroed
+    //
+    std::uint32_t resample(
+        const float *channel,
+        std::uint32_t frameCount,
+        std::uint64_t &position,
+        std::uint64_t step,
+        const float *bank,
+        std::uint32_t taps,
+        bool loop,
+        float *out,
+        std::uint32_t count
+    ) {
+        const std::uint64_t end = std::uint64_t(frameCount) << 32;
+        std::uint32_t i = 0;
+
+        if (step == FIXED_ONE && (position & (FIXED_ONE - 1)) == 0) {
+            // sound of device rate without pitch is copied
+            while (i < count) {
+                if (position >= end) {
+                    if (loop == false) {
+                        break;
+                    }
+
+                    position %= end;
+                }
+
+                const std::uint32_t index = std::uint32_t(position >> 32);
+                const std::uint32_t length = std::min(count - i, frameCount - index);
+
+                std::memcpy(out + i, channel + index, length * sizeof(float));
+                position += std::uint64_t(length) << 32;
+                i += length;
+            }
+        }
+        else {
+            for (; i < count; i++) {
+                if (position >= end) {
+                    if (loop == false) {
+                        break;
+                    }
+
+                    position %= end;
+                }
+
+                const std::uint32_t index = std::uint32_t(position >> 32);
+                const std::uint32_t phase = std::uint32_t(position >> (32 - FILTER_PHASE_BITS)) & (FILTER_PHASES - 1);
+                const float *coef = bank + phase * taps;
+
+                if (loop && (index < taps / 2 - 1 || index + taps / 2 >= frameCount)) {
+                    // window crosses loop seam, taps are taken from the other end of sound
+                    float window[FILTER_TAPS_MAX];
+
+                    for (std::uint32_t k = 0; k < taps; k++) {
+                        const std::int64_t tap = std::int64_t(index) + std::int64_t(k) - std::int64_t(taps / 2 - 1);
+                        window[k] = channel[((tap % std::int64_t(frameCount)) + frameCount) % frameCount];
+                    }
+
+                    out[i] = dot(window, coef, taps);
+                }
+                else {
+                    out[i] = dot(channel + index - (taps / 2 - 1), coef, taps);
+                }
+
+                position += step;
+            }
+        }
+
+        if (i < count) {
+            std::memset(out + i, 0, (count - i) * sizeof(float));
+        }
+
+        return i;
+    }
+}
+
+namespace platform {
+    class SoundImp : public Sound {
+    public:
+        SoundImp(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate)
+        : _frameCount(frameCount)
+        , _channelCount(channelCount)
+        , _sampleRate(sampleRate)
+        , _stride(std::size_t(frameCount) + 2 * SOUND_PADDING)
+        , _data(new float[_stride * channelCount])
+        {
+            std::memset(_data.get(), 0, _stride * channelCount * sizeof(float));
+
+            for (std::uint32_t c = 0; c < channelCount; c++) {
+                float *channel = _data.get() + c * _stride + SOUND_PADDING;
+
+                for (std::uint32_t i = 0; i < frameCount; i++) {
+                    channel[i] = float(samples[std::size_t(i) * channelCount + c]) * (1.0f / 32768.0f);
+                }
+            }
+
+            MemoryTracker::allocated(MemoryCategory::AUDIO, _stride * channelCount * sizeof(float));
+        }
+
+        ~SoundImp() {
+            MemoryTracker::freed(MemoryCategory::AUDIO, _stride * _channelCount * sizeof(float));
+        }
+
+        // Planar samples of @channel. SOUND_PADDING zero frames before and after are readable
+        const float *getChannel(std::uint32_t channel) const {
+            return _data.get() + channel * _stride + SOUND_PADDING;
+        }
+
+        std::uint32_t getFrameCount() const {
+            return _frameCount;
+        }
+
+        std::uint32_t getChannelCount() const {
+            return _channelCount;
+        }
+
+        std::uint32_t getSampleRate() const {
+            return _sampleRate;
+        }
+
+    private:
+        const std::uint32_t _frameCount;
+        const std::uint32_t _channelCount;
+        const std::uint32_t _sampleRate;
+        const std::size_t _stride;
+        const std::unique_ptr<float[]> _data;
+    };
+
+    std::uint32_t Sound::getFrameCount() const {
+        return static_cast<const SoundImp *>(this)->getFrameCount();
+    }
+
+    std::uint32_t Sound::getChannelCount() const {
+        return static_cast<const SoundImp *>(this)->getChannelCount();
+    }
+
+    std::uint32_t Sound::getSampleRate() const {
+        return static_cast<const SoundImp *>(this)->getSampleRate();
+    }
+}
+
+namespace platform {
+    AudioMixer::AudioMixer(const AudioConfig &config)
+    : _config(config)
+    , _blockFrames((std::max(config.blockFrames, 16u) + 3) & ~3u)
+    , _commandMask(roundCapacity(std::max(std::size_t(config.voiceCount) * 4, std::size_t(1024))) - 1)
+    , _commands(new CommandCell[_commandMask + 1])
+    , _finishedMask(std::uint32_t(roundCapacity(config.voiceCount)) - 1)
+    , _finished(new std::uint32_t[_finishedMask + 1])
+    , _sounds(config.voiceCount)
+    , _streams(config.voiceCount)
+    , _generations(config.voiceCount, 0)
+    , _voices(new Voice[config.voiceCount])
+    , _activeSlots(new std::uint32_t[config.voiceCount])
+    , _filters(new float[getBankOffset(FILTER_BANKS)])
+    , _buffers(new float[_blockFrames * 4])
+    , _streamer(std::make_unique<AudioStreamer>())
+    {
+        for (std::size_t i = 0; i <= _commandMask; i++) {
+            _commands[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        _freeSlots.reserve(config.voiceCount);
+
+        for (std::uint32_t i = config.voiceCount; i > 0; i--) {
+            _freeSlots.emplace_back(i - 1);
+        }
+
+        std::memset(_voices.get(), 0, sizeof(Voice) * config.voiceCount);
+
+        // windowed sinc: bank b has cutoff FILTER_CUTOFF / (1 + b / 4), phase p is for position fraction p / FILTER_PHASES
+        for (std::uint32_t b = 0; b < FILTER_BANKS; b++) {
+            const double cutoff = FILTER_CUTOFF / (1.0 + 0.25 * double(b));
+            const std::uint32_t taps = getBankTaps(b);
+
+            for (std::uint32_t p = 0; p < FILTER_PHASES; p++) {
+                float *coef = _filters.get() + getBankOffset(b) + p * taps;
+                double values[FILTER_TAPS_MAX];
+                double sum = 0.0;
+
+                for (std::uint32_t k = 0; k < taps; k++) {
+                    const double t = double(k) - double(taps / 2 - 1) - double(p) / double(FILTER_PHASES);
+                    const double x = PI * t * cutoff;
+                    const double w = PI * t / double(taps / 2);
+                    const double window = 0.42 + 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+
+                    values[k] = (x == 0.0 ? 1.0 : std::sin(x) / x) * window;
+                    sum += values[k];
+                }
+
+                // unity gain at DC for every phase
+                for (std::uint32_t k = 0; k < taps; k++) {
+                    coef[k] = float(values[k] / sum);
+                }
+            }
+        }
+
+        _memorySize = (_commandMask + 1) * sizeof(CommandCell) + sizeof(Voice) * config.voiceCount + sizeof(float) * (getBankOffset(FILTER_BANKS) + _blockFrames * 4);
+        MemoryTracker::allocated(MemoryCategory::AUDIO, _memorySize);
+    }
+
+    AudioMixer::~AudioMixer() {
+        MemoryTracker::freed(MemoryCategory::AUDIO, _memorySize);
+    }
+
+    std::shared_ptr<Sound> AudioMixer::createSound(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate) {
+        if (samples == nullptr || frameCount == 0 || channelCount == 0 || channelCount > 2 || sampleRate == 0) {
+            return nullptr;
+        }
+
+        return std::make_shared<SoundImp>(samples, frameCount, channelCount, sampleRate);
+    }
+
+    std::shared_ptr<AudioStream> AudioMixer::createStream(const std::shared_ptr<FileView> &view, const StreamParams &params) {
+        std::shared_ptr<StreamImp> result = StreamImp::create(view, params, _config.sampleRate, _blockFrames, PITCH_MAX, STREAM_PADDING);
+
+        if (result) {
+            _streamer->add(result);
+        }
+
+        return result;
+    }
+
+    VoiceToken AudioMixer::play(const std::shared_ptr<Sound> &sound, const VoiceParams &params) {
+        return sound ? _play(sound, nullptr, params) : 0;
+    }
+
+    VoiceToken AudioMixer::playStream(const std::shared_ptr<AudioStream> &stream, const VoiceParams &params) {
+        return stream ? _play(nullptr, stream, params) : 0;
+    }
+
+    void AudioMixer::setVoiceParams(VoiceToken voice, const VoiceParams &params) {
+        const std::uint32_t slot = std::uint32_t(voice) - 1;
+
+        if (slot < _config.voiceCount) {
+            _push(Command{CommandType::PARAMS, slot, std::uint32_t(voice >> 32), nullptr, nullptr, params});
+        }
+    }
+
+    void AudioMixer::stop(VoiceToken voice) {
+        const std::uint32_t slot = std::uint32_t(voice) - 1;
+
+        if (slot < _config.voiceCount) {
+            _push(Command{CommandType::STOP, slot, std::uint32_t(voice >> 32), nullptr, nullptr, {}});
+        }
+    }
+
+    void AudioMixer::stopAll() {
+        _push(Command{CommandType::STOP_ALL, 0, 0, nullptr, nullptr, {}});
+    }
+
+    void AudioMixer::setMasterGain(float gain) {
+        VoiceParams params;
+        params.gain = gain;
+        _push(Command{CommandType::MASTER_GAIN, 0, 0, nullptr, nullptr, params});
+    }
+
+    bool AudioMixer::isPlaying(VoiceToken voice) {
+        const std::uint32_t slot = std::uint32_t(voice) - 1;
+
+        if (slot < _config.voiceCount) {
+            std::lock_guard<std::mutex> guard(_guard);
+            _collectFinished();
+            return _generations[slot] == std::uint32_t(voice >> 32) && (_sounds[slot] != nullptr || _streams[slot] != nullptr);
+        }
+
+        return false;
+    }
+
+    AudioStats AudioMixer::getStats() {
+        {
+            // sounds of finished voices are released even if application doesn't play new ones
+            std::lock_guard<std::mutex> guard(_guard);
+            _collectFinished();
+        }
+
+        AudioStats result;
+        result.activeVoices = _publishedActive.load(std::memory_order_relaxed);
+        result.rejectedVoices = _rejectedVoices.load(std::memory_order_relaxed);
+        result.droppedCommands = _droppedCommands.load(std::memory_order_relaxed);
+        result.streamUnderruns = _streamUnderruns.load(std::memory_order_relaxed);
+        result.mixLoad = _publishedLoad.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void AudioMixer::render(float *output, std::uint32_t frameCount) {
+        const auto startTime = std::chrono::steady_clock::now();
+
+    #if MIXER_SSE
+        // fading filters produce denormals, they are slow on x86
+        const unsigned int csr = _mm_getcsr();
+        _mm_setcsr(csr | 0x8040);
+    #endif
+
+        _applyCommands();
+
+        float *busLeft = _buffers.get();
+        float *busRight = _buffers.get() + _blockFrames;
+
+        for (std::uint32_t offset = 0; offset < frameCount; ) {
+            const std::uint32_t count = std::min(frameCount - offset, _blockFrames);
+
+            std::memset(busLeft, 0, count * sizeof(float));
+            std::memset(busRight, 0, count * sizeof(float));
+
+            for (std::uint32_t i = 0; i < _activeCount; ) {
+                const std::uint32_t slot = _activeSlots[i];
+
+                if (_mixVoice(_voices[slot], count)) {
+                    i++;
+                }
+                else {
+                    const std::uint32_t write = _finishedWrite.load(std::memory_order_relaxed);
+                    _finished[write & _finishedMask] = slot;
+                    _finishedWrite.store(write + 1, std::memory_order_release);
+
+                    _voices[slot].sound = nullptr;
+                    _voices[slot].stream = nullptr;
+                    _activeSlots[i] = _activeSlots[--_activeCount];
+                }
+            }
+
+            writeOutput(output + std::size_t(offset) * 2, busLeft, busRight, count, _masterGain, (_targetMasterGain - _masterGain) / float(count));
+            _masterGain = _targetMasterGain;
+            offset += count;
+        }
+
+    #if MIXER_SSE
+        _mm_setcsr(csr);
+    #endif
+
+        if (frameCount) {
+            const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            const double load = elapsedSec * double(_config.sampleRate) / double(frameCount);
+
+            _mixLoad += (float(load) - _mixLoad) * LOAD_SMOOTHING;
+            _publishedLoad.store(_mixLoad, std::memory_order_relaxed);
+        }
+
+        _publishedActive.store(_activeCount, std::memory_order_relaxed);
+    }
+
+    const AudioConfig &AudioMixer::getConfig() const {
+        return _config;
+    }
+
+    VoiceToken AudioMixer::_play(const std::shared_ptr<Sound> &sound, const std::shared_ptr<AudioStream> &stream, const VoiceParams &params) {
+        StreamImp *streamImp = static_cast<StreamImp *>(stream.get());
+        std::lock_guard<std::mutex> guard(_guard);
+        _collectFinished();
+
+        if (_freeSlots.empty()) {
+            _rejectedVoices.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+        if (streamImp && streamImp->start() == false) {
+            return 0;
+        }
+
+        const std::uint32_t slot = _freeSlots.back();
+        const std::uint32_t generation = _generations[slot] + 1;
+
+        if (_push(Command{CommandType::PLAY, slot, generation, static_cast<const SoundImp *>(sound.get()), streamImp, params}) == false) {
+            if (streamImp) {
+                streamImp->cancelStart();
+            }
+
+            return 0;
+        }
+
+        _freeSlots.pop_back();
+        _generations[slot] = generation;
+        _sounds[slot] = sound;
+        _streams[slot] = stream;
+        return (VoiceToken(generation) << 32) | (slot + 1);
+    }
+
+    bool AudioMixer::_push(const Command &command) {
+        std::size_t position = _pushPosition.load(std::memory_order_relaxed);
+
+        while (true) {
+            CommandCell &cell = _commands[position & _commandMask];
+            const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(position);
+
+            if (diff == 0) {
+                if (_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.command = command;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                _droppedCommands.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else {
+                position = _pushPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void AudioMixer::_applyCommands() {
+        while (true) {
+            CommandCell &cell = _commands[_popPosition & _commandMask];
+
+            if (cell.sequence.load(std::memory_order_acquire) != _popPosition + 1) {
+                break;
+            }
+
+            const Command command = cell.command;
+            cell.sequence.store(_popPosition + _commandMask + 1, std::memory_order_release);
+            _popPosition++;
+
+            Voice &voice = _voices[command.slot];
+
+            switch (command.type) {
+                case CommandType::PLAY:
+                    voice.sound = command.sound;
+                    voice.stream = command.stream;
+                    voice.sampleRate = command.sound ? command.sound->getSampleRate() : command.stream->getSampleRate();
+                    voice.channelCount = command.sound ? command.sound->getChannelCount() : command.stream->getChannelCount();
+                    voice.generation = command.generation;
+                    voice.position = 0;
+                    voice.stopping = false;
+                    _setParams(voice, command.params);
+                    voice.gains[0] = voice.targetGains[0];
+                    voice.gains[1] = voice.targetGains[1];
+                    _activeSlots[_activeCount++] = command.slot;
+                    break;
+                case CommandType::PARAMS:
+                    if ((voice.sound || voice.stream) && voice.generation == command.generation && voice.stopping == false) {
+                        _setParams(voice, command.params);
+                    }
+                    break;
+                case CommandType::STOP:
+                    if ((voice.sound || voice.stream) && voice.generation == command.generation) {
+                        voice.stopping = true;
+                        voice.targetGains[0] = voice.targetGains[1] = 0.0f;
+                    }
+                    break;
+                case CommandType::STOP_ALL:
+                    for (std::uint32_t i = 0; i < _activeCount; i++) {
+                        Voice &active = _voices[_activeSlots[i]];
+                        active.stopping = true;
+                        active.targetGains[0] = active.targetGains[1] = 0.0f;
+                    }
+                    break;
+                case CommandType::MASTER_GAIN:
+                    _targetMasterGain = std::max(command.params.gain, 0.0f);
+                    break;
+            }
+        }
+    }
+
+    void AudioMixer::_setParams(Voice &voice, const VoiceParams &params) {
+        const float gain = std::max(params.gain, 0.0f);
+        const float pan = std::min(std::max(params.pan, -1.0f), 1.0f);
+        const float pitch = std::min(std::max(params.pitch, PITCH_MIN), PITCH_MAX);
+        const double ratio = double(pitch) * double(voice.sampleRate) / double(_config.sampleRate);
+
+        if (voice.channelCount == 1) {
+            const float angle = (pan + 1.0f) * float(PI / 4.0);
+            voice.targetGains[0] = gain * std::cos(angle);
+            voice.targetGains[1] = gain * std::sin(angle);
+        }
+        else {
+            voice.targetGains[0] = gain * std::min(1.0f, 1.0f - pan);
+            voice.targetGains[1] = gain * std::min(1.0f, 1.0f + pan);
+        }
+
+        voice.step = std::max(std::uint64_t(ratio * double(FIXED_ONE) + 0.5), std::uint64_t(1));
+        voice.bank = ratio > 1.0 ? std::min(std::uint32_t(std::ceil((ratio - 1.0) * 4.0)), FILTER_BANKS - 1) : 0;
+        voice.loop = params.loop && voice.stream == nullptr;
+    }
+
+    bool AudioMixer::_mixVoice(Voice &voice, std::uint32_t frameCount) {
+        const float *bank = _filters.get() + getBankOffset(voice.bank);
+        const std::uint32_t taps = getBankTaps(voice.bank);
+        float *busLeft = _buffers.get();
+        float *busRight = _buffers.get() + _blockFrames;
+        float *voiceLeft = _buffers.get() + _blockFrames * 2;
+        float *voiceRight = _buffers.get() + _blockFrames * 3;
+
+        const float *channels[2];
+        std::uint32_t sourceFrames;
+        std::int64_t origin = 0;        // source frame at channels[c][0]
+        bool finished = true;
+
+        if (voice.stream) {
+            // stream window is a short sound that starts STREAM_PADDING - 1 frames before position
+            const std::int64_t firstFrame = std::int64_t(voice.position >> 32) - std::int64_t(STREAM_PADDING - 1);
+            const std::int64_t lastFrame = std::int64_t((voice.position + voice.step * (frameCount - 1)) >> 32) + STREAM_PADDING;
+            StreamWindow window = voice.stream->read(firstFrame, lastFrame);
+
+            // offline rendering isn't real time, missing frames are decoded here instead of underrun
+            while (_config.offline && window.finished == false && window.start + window.frameCount <= lastFrame && voice.stream->decode()) {
+                window = voice.stream->read(firstFrame, lastFrame);
+            }
+
+            channels[0] = window.channels[0];
+            channels[1] = window.channels[1];
+            sourceFrames = window.frameCount > STREAM_PADDING ? window.frameCount - STREAM_PADDING : 0;
+            origin = window.start;
+            finished = window.finished;
+        }
+        else {
+            channels[0] = voice.sound->getChannel(0);
+            channels[1] = voice.sound->getChannel(voice.channelCount - 1);
+            sourceFrames = voice.sound->getFrameCount();
+        }
+
+        // every channel starts from the same position
+        const std::uint64_t start = std::uint64_t(std::int64_t(voice.position) - origin * std::int64_t(FIXED_ONE));
+        std::uint64_t position = start;
+        std::uint32_t produced = resample(channels[0], sourceFrames, position, voice.step, bank, taps, voice.loop, voiceLeft, frameCount);
+
+        if (voice.channelCount > 1) {
+            position = start;
+            resample(channels[1], sourceFrames, position, voice.step, bank, taps, voice.loop, voiceRight, frameCount);
+        }
+        else {
+            voiceRight = voiceLeft;
+        }
+
+        if (produced < frameCount && finished == false) {
+            voice.stream->addUnderrun();
+            _streamUnderruns.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        const float scale = 1.0f / float(frameCount);
+        mixRamp(busLeft, voiceLeft, frameCount, voice.gains[0], (voice.targetGains[0] - voice.gains[0]) * scale);
+        mixRamp(busRight, voiceRight, frameCount, voice.gains[1], (voice.targetGains[1] - voice.gains[1]) * scale);
+
+        voice.position = std::uint64_t(std::int64_t(position) + origin * std::int64_t(FIXED_ONE));
+        voice.gains[0] = voice.targetGains[0];
+        voice.gains[1] = voice.targetGains[1];
+
+        // stream without decoded frames waits for them
+        return (produced == frameCount || finished == false) && voice.stopping == false;
+    }
+
+    void AudioMixer::_collectFinished() {
+        const std::uint32_t write = _finishedWrite.load(std::memory_order_acquire);
+
+        for (; _finishedRead != write; _finishedRead++) {
+            const std::uint32_t slot = _finished[_finishedRead & _finishedMask];
+            _sounds[slot] = nullptr;
+            _streams[slot] = nullptr;
+            _freeSlots.emplace_back(slot);
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "interfaces.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace platform {
+    class SoundImp;
+    class StreamImp;
+    class AudioStreamer;
+
+    // Software mixer of AudioDevice
+    // Game threads send POD commands through lock-free ring, audio thread applies them at the start of render() and mixes
+    // active voices with SIMD kernels into planar float bus. Voices are resampled by windowed sinc filters whose cutoff follows
+    // the resampling step, so pitched up sounds don't alias
+    // Audio thread never allocates, frees or locks: sounds of finished voices are returned to game threads and released there
+    // Streams are decoded by AudioStreamer thread ahead of playback, audio thread only copies decoded frames
+    //
+    class AudioMixer {
+    public:
+        AudioMixer(const AudioConfig &config);
+        ~AudioMixer();
+
+        // @return - nullptr if arguments are invalid
+        //
+        static std::shared_ptr<Sound> createSound(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate);
+
+        // @return - nullptr if file format is not supported or buffers don't fit @params.memoryLimit
+        //
+        std::shared_ptr<AudioStream> createStream(const std::shared_ptr<FileView> &view, const StreamParams &params);
+
+        // Game threads
+        //
+        VoiceToken play(const std::shared_ptr<Sound> &sound, const VoiceParams &params);
+        VoiceToken playStream(const std::shared_ptr<AudioStream> &stream, const VoiceParams &params);
+        void setVoiceParams(VoiceToken voice, const VoiceParams &params);
+        void stop(VoiceToken voice);
+        void stopAll();
+        void setMasterGain(float gain);
+        bool isPlaying(VoiceToken voice);
+        AudioStats getStats();
+
+        // Audio thread, or any single thread in offline mode. Mixes next @frameCount frames
+        // @output - interleaved stereo
+        //
+        void render(float *output, std::uint32_t frameCount);
+
+        const AudioConfig &getConfig() const;
+
+    private:
+        enum class CommandType : std::uint8_t {
+            PLAY = 0,
+            PARAMS,
+            STOP,
+            STOP_ALL,
+            MASTER_GAIN,
+        };
+
+        struct Command {
+            CommandType type;
+            std::uint32_t slot;
+            std::uint32_t generation;
+            const SoundImp *sound;
+            StreamImp *stream;
+            VoiceParams params;
+        };
+
+        struct CommandCell {
+            std::atomic<std::size_t> sequence;
+            Command command;
+        };
+
+        // State of voice on audio thread
+        struct Voice {
+            const SoundImp *sound;          // one of sound and stream is set for active voice
+            StreamImp *stream;
+            std::uint32_t sampleRate;
+            std::uint32_t channelCount;
+            std::uint32_t generation;
+            std::uint64_t position;         // frames in 32.32 fixed point
+            std::uint64_t step;
+            std::uint32_t bank;             // filter bank for the step
+            float gains[2];                 // gains of the previous block
+            float targetGains[2];
+            bool loop;
+            bool stopping;                  // fades out during the next block
+        };
+
+        VoiceToken _play(const std::shared_ptr<Sound> &sound, const std::shared_ptr<AudioStream> &stream, const VoiceParams &params);
+        bool _push(const Command &command);
+        void _applyCommands();
+        void _setParams(Voice &voice, const VoiceParams &params);
+        bool _mixVoice(Voice &voice, std::uint32_t frameCount);
+        void _collectFinished();
+
+        const AudioConfig _config;
+        const std::uint32_t _blockFrames;
+
+        // command ring, multiple producers, audio thread consumes
+        const std::size_t _commandMask;
+        std::unique_ptr<CommandCell[]> _commands;
+        alignas(64) std::atomic<std::size_t> _pushPosition {0};
+        alignas(64) std::size_t _popPosition = 0;
+
+        // slots of finished voices, audio thread produces, game threads consume under _guard
+        // Slot is reused only after it is taken from here, so the ring never overflows
+        const std::uint32_t _finishedMask;
+        std::unique_ptr<std::uint32_t[]> _finished;
+        alignas(64) std::atomic<std::uint32_t> _finishedWrite {0};
+        alignas(64) std::uint32_t _finishedRead = 0;
+
+        // game side of voices, slots are allocated by game threads
+        std::mutex _guard;
+        std::vector<std::shared_ptr<Sound>> _sounds;
+        std::vector<std::shared_ptr<AudioStream>> _streams;
+        std::vector<std::uint32_t> _generations;
+        std::vector<std::uint32_t> _freeSlots;
+
+        // audio thread
+        std::unique_ptr<Voice[]> _voices;
+        std::unique_ptr<std::uint32_t[]> _activeSlots;
+        std::uint32_t _activeCount = 0;
+        std::unique_ptr<float[]> _filters;
+        std::unique_ptr<float[]> _buffers;  // bus left, bus right, voice left, voice right
+        float _masterGain = 1.0f;
+        float _targetMasterGain = 1.0f;
+        float _mixLoad = 0.0f;
+
+        std::atomic<std::uint32_t> _publishedActive {0};
+        std::atomic<std::uint32_t> _rejectedVoices {0};
+        std::atomic<std::uint32_t> _droppedCommands {0};
+        std::atomic<std::uint32_t> _streamUnderruns {0};
+        std::atomic<float> _publishedLoad {0.0f};
+        std::size_t _memorySize;
+
+        std::unique_ptr<AudioStreamer> _streamer;
+    };
+}
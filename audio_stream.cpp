@@ -0,0 +1,491 @@
+#include "audio_stream.h"
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    constexpr std::uint32_t STREAM_BUFFER_FRAMES_MAX = 4096;
+    constexpr std::uint32_t STREAM_BUFFER_FRAMES_MIN = 512;     // smaller buffers are tried if larger ones don't fit memory limit
+    constexpr std::uint32_t STREAM_BUFFER_COUNT_MIN = 2;
+    constexpr std::size_t STREAM_RELEASE_GRANULARITY = 64 * 1024;
+    constexpr auto STREAMER_PERIOD = std::chrono::milliseconds(5);
+
+    constexpr std::uint16_t WAVE_FORMAT_PCM = 0x0001;
+    constexpr std::uint16_t WAVE_FORMAT_IMA_ADPCM = 0x0011;
+    constexpr std::uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+    const std::int16_t IMA_STEPS[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+        130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060,
+        1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+        7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+    };
+
+    const std::int8_t IMA_INDEX_STEPS[16] = {
+        -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8,
+    };
+
+    std::uint16_t readU16(const std::uint8_t *data) {
+        return std::uint16_t(data[0] | (data[1] << 8));
+    }
+
+    std::uint32_t readU32(const std::uint8_t *data) {
+        return std::uint32_t(data[0]) | (std::uint32_t(data[1]) << 8) | (std::uint32_t(data[2]) << 16) | (std::uint32_t(data[3]) << 24);
+    }
+
+    // Frames in @size bytes of IMA ADPCM block: one in header of every channel and 8 per 4 bytes of every channel
+    std::uint32_t getAdpcmFrames(std::size_t size, std::uint32_t channelCount) {
+        return size >= 4 * channelCount ? std::uint32_t((size - 4 * channelCount) / (4 * channelCount)) * 8 + 1 : 0;
+    }
+}
+
+namespace platform {
+    std::shared_ptr<StreamImp> StreamImp::create(
+        const std::shared_ptr<FileView> &view,
+        const StreamParams &params,
+        std::uint32_t outputRate,
+        std::uint32_t blockFrames,
+        float pitchMax,
+        std::uint32_t paddingFrames
+    ) {
+        Format format;
+
+        if (view == nullptr || _parseWave(view->getData(), view->getSize(), format) == false) {
+            return nullptr;
+        }
+
+        const double maxStep = double(pitchMax) * double(format.sampleRate) / double(outputRate);
+        const std::uint32_t windowCapacity = std::uint32_t(std::ceil(maxStep * double(blockFrames))) + paddingFrames * 3 + 2;
+        const std::size_t frameBytes = sizeof(float) * format.channelCount;
+        const std::size_t fixedBytes = frameBytes * (windowCapacity + (format.codec == Codec::IMA_ADPCM ? format.blockFrames : 0));
+
+        for (std::uint32_t bufferFrames = STREAM_BUFFER_FRAMES_MAX; bufferFrames >= STREAM_BUFFER_FRAMES_MIN; bufferFrames /= 2) {
+            const std::size_t bufferBytes = frameBytes * bufferFrames + sizeof(BufferInfo);
+
+            if (params.memoryLimit >= fixedBytes + bufferBytes * STREAM_BUFFER_COUNT_MIN) {
+                // ring longer than the file would never be filled
+                const std::size_t bufferCount = std::min((params.memoryLimit - fixedBytes) / bufferBytes, std::size_t(format.frameCount / bufferFrames + 2));
+                std::shared_ptr<StreamImp> result (new StreamImp(view, format, params.loop, bufferFrames, std::uint32_t(bufferCount), windowCapacity, paddingFrames));
+
+                result->decode();
+                return result;
+            }
+        }
+
+        return nullptr;
+    }
+
+    StreamImp::StreamImp(
+        const std::shared_ptr<FileView> &view,
+        const Format &format,
+        bool loop,
+        std::uint32_t bufferFrames,
+        std::uint32_t bufferCount,
+        std::uint32_t windowCapacity,
+        std::uint32_t paddingFrames
+    )
+    : _view(view)
+    , _format(format)
+    , _loop(loop)
+    , _bufferFrames(bufferFrames)
+    , _bufferCount(bufferCount)
+    , _windowCapacity(windowCapacity)
+    , _paddingFrames(paddingFrames)
+    , _memorySize(
+        sizeof(float) * format.channelCount * (std::size_t(bufferFrames) * bufferCount + windowCapacity + (format.codec == Codec::IMA_ADPCM ? format.blockFrames : 0)) +
+        sizeof(BufferInfo) * bufferCount
+    )
+    , _data(new float[(_memorySize - sizeof(BufferInfo) * bufferCount) / sizeof(float)])
+    , _buffers(new BufferInfo[bufferCount])
+    , _releasedOffset(format.dataOffset)
+    , _windowStart(-std::int64_t(paddingFrames))
+    , _windowFrames(paddingFrames)
+    {
+        float *window = _data.get() + std::size_t(_bufferFrames) * _bufferCount * _format.channelCount;
+
+        for (std::uint32_t c = 0; c < _format.channelCount; c++) {
+            std::memset(window + c * _windowCapacity, 0, _paddingFrames * sizeof(float));
+        }
+
+        MemoryTracker::allocated(MemoryCategory::AUDIO, _memorySize);
+    }
+
+    StreamImp::~StreamImp() {
+        MemoryTracker::freed(MemoryCategory::AUDIO, _memorySize);
+    }
+
+    bool StreamImp::decode() {
+        std::lock_guard<std::mutex> guard(_decodeGuard);
+        bool result = false;
+
+        while (_decodedAll == false) {
+            const std::uint32_t write = _writeCount.load(std::memory_order_relaxed);
+
+            if (write - _readCount.load(std::memory_order_acquire) >= _bufferCount) {
+                break;
+            }
+
+            const std::uint32_t slot = write % _bufferCount;
+            float *ring = _data.get() + std::size_t(slot) * _bufferFrames * _format.channelCount;
+            float *channels[2] = {ring, ring + _bufferFrames};
+            BufferInfo &info = _buffers[slot];
+
+            info.frameCount = 0;
+            info.last = false;
+
+            while (info.frameCount < _bufferFrames) {
+                if (_decodeFrame == _format.frameCount) {
+                    if (_loop == false) {
+                        info.last = true;
+                        break;
+                    }
+
+                    _releasePages(_format.dataOffset + _format.dataSize);
+                    _releasedOffset = _format.dataOffset;
+                    _decodeFrame = 0;
+                }
+
+                const std::uint32_t count = std::min(_bufferFrames - info.frameCount, _format.frameCount - _decodeFrame);
+                float *const target[2] = {channels[0] + info.frameCount, channels[1] + info.frameCount};
+
+                _decodeFrames(target, count);
+                info.frameCount += count;
+            }
+
+            // pages before the current block are not read until the next loop
+            if (_format.codec == Codec::IMA_ADPCM) {
+                _releasePages(_format.dataOffset + std::size_t(_decodeFrame / _format.blockFrames) * _format.blockAlign);
+            }
+            else {
+                _releasePages(_format.dataOffset + std::size_t(_decodeFrame) * _format.blockAlign);
+            }
+
+            _decodedAll = info.last;
+            _decodedFrames.fetch_add(info.frameCount, std::memory_order_relaxed);
+            _writeCount.store(write + 1, std::memory_order_release);
+            result = true;
+        }
+
+        return result;
+    }
+
+    bool StreamImp::start() {
+        return _started.exchange(true) == false;
+    }
+
+    void StreamImp::cancelStart() {
+        _started.store(false);
+    }
+
+    StreamWindow StreamImp::read(std::int64_t firstFrame, std::int64_t lastFrame) {
+        float *window = _data.get() + std::size_t(_bufferFrames) * _bufferCount * _format.channelCount;
+        float *channels[2] = {window, window + (_format.channelCount > 1 ? _windowCapacity : 0)};
+
+        if (firstFrame > _windowStart) {
+            const std::uint32_t drop = std::uint32_t(std::min(firstFrame - _windowStart, std::int64_t(_windowFrames)));
+
+            for (std::uint32_t c = 0; c < _format.channelCount; c++) {
+                std::memmove(channels[c], channels[c] + drop, (_windowFrames - drop) * sizeof(float));
+            }
+
+            _windowStart += drop;
+            _windowFrames -= drop;
+        }
+
+        // the end of window is reserved for padding
+        while (_ended == false && _windowStart + _windowFrames <= lastFrame && _windowFrames + _paddingFrames < _windowCapacity) {
+            const std::uint32_t read = _readCount.load(std::memory_order_relaxed);
+
+            if (read == _writeCount.load(std::memory_order_acquire)) {
+                break;
+            }
+
+            const std::uint32_t slot = read % _bufferCount;
+            const BufferInfo &info = _buffers[slot];
+            const float *ring = _data.get() + std::size_t(slot) * _bufferFrames * _format.channelCount;
+            const std::uint32_t count = std::uint32_t(std::min({
+                std::int64_t(info.frameCount - _readOffset),
+                lastFrame + 1 - (_windowStart + _windowFrames),
+                std::int64_t(_windowCapacity - _paddingFrames - _windowFrames)
+            }));
+
+            for (std::uint32_t c = 0; c < _format.channelCount; c++) {
+                std::memcpy(channels[c] + _windowFrames, ring + c * _bufferFrames + _readOffset, count * sizeof(float));
+            }
+
+            _windowFrames += count;
+            _readOffset += count;
+            _consumedFrames.fetch_add(count, std::memory_order_relaxed);
+
+            if (_readOffset == info.frameCount) {
+                _readOffset = 0;
+                _ended = info.last;
+                _readCount.store(read + 1, std::memory_order_release);
+            }
+        }
+
+        if (_ended && _padded == false) {
+            for (std::uint32_t c = 0; c < _format.channelCount; c++) {
+                std::memset(channels[c] + _windowFrames, 0, _paddingFrames * sizeof(float));
+            }
+
+            _windowFrames += _paddingFrames;
+            _padded = true;
+        }
+
+        return StreamWindow{{channels[0], channels[1]}, _windowStart, _windowFrames, _padded};
+    }
+
+    void StreamImp::addUnderrun() {
+        _underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint32_t StreamImp::getFrameCount() const {
+        return _format.frameCount;
+    }
+
+    std::uint32_t StreamImp::getChannelCount() const {
+        return _format.channelCount;
+    }
+
+    std::uint32_t StreamImp::getSampleRate() const {
+        return _format.sampleRate;
+    }
+
+    AudioStreamStats StreamImp::getStats() const {
+        const std::uint64_t consumed = _consumedFrames.load(std::memory_order_relaxed);
+        const std::uint64_t decoded = _decodedFrames.load(std::memory_order_relaxed);
+
+        AudioStreamStats result;
+        result.memoryBytes = std::uint32_t(_memorySize);
+        result.bufferedFrames = decoded > consumed ? std::uint32_t(decoded - consumed) : 0;
+        result.underrunCount = _underruns.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    bool StreamImp::_parseWave(const std::uint8_t *data, std::size_t size, Format &format) {
+        if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+            return false;
+        }
+
+        std::uint16_t formatTag = 0;
+        std::uint16_t bitsPerSample = 0;
+        std::uint32_t factFrames = 0;
+        bool hasFormat = false;
+        bool hasData = false;
+
+        format.blockFrames = 0;
+
+        for (std::size_t offset = 12; offset + 8 <= size && hasData == false; ) {
+            const std::uint8_t *chunk = data + offset;
+            const std::size_t chunkSize = std::min(std::size_t(readU32(chunk + 4)), size - offset - 8);
+
+            if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+                formatTag = readU16(chunk + 8);
+                format.channelCount = readU16(chunk + 10);
+                format.sampleRate = readU32(chunk + 12);
+                format.blockAlign = readU16(chunk + 20);
+                bitsPerSample = readU16(chunk + 22);
+                hasFormat = true;
+
+                if (formatTag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 40) {
+                    formatTag = readU16(chunk + 32);    // first bytes of sub-format GUID
+                }
+                if (formatTag == WAVE_FORMAT_IMA_ADPCM && chunkSize >= 20) {
+                    format.blockFrames = readU16(chunk + 26);
+                }
+            }
+            else if (std::memcmp(chunk, "fact", 4) == 0 && chunkSize >= 4) {
+                factFrames = readU32(chunk + 8);
+            }
+            else if (std::memcmp(chunk, "data", 4) == 0) {
+                format.dataOffset = offset + 8;
+                format.dataSize = chunkSize;
+                hasData = true;
+            }
+
+            // chunks are aligned to 2 bytes
+            offset += 8 + chunkSize + (chunkSize & 1);
+        }
+
+        if (hasFormat == false || hasData == false || format.channelCount == 0 || format.channelCount > 2 || format.sampleRate == 0) {
+            return false;
+        }
+
+        if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 16 && format.blockAlign == 2 * format.channelCount) {
+            format.codec = Codec::PCM16;
+            format.blockFrames = 1;
+            format.frameCount = std::uint32_t(std::min(format.dataSize / format.blockAlign, std::size_t(0xFFFFFFFF)));
+        }
+        else if (formatTag == WAVE_FORMAT_IMA_ADPCM && bitsPerSample == 4 && format.blockAlign > 4 * format.channelCount && (format.blockAlign % (4 * format.channelCount)) == 0) {
+            // samples per block of format chunk (if it's there) must agree with block size
+            if (format.blockFrames && format.blockFrames != getAdpcmFrames(format.blockAlign, format.channelCount)) {
+                return false;
+            }
+
+            format.blockFrames = getAdpcmFrames(format.blockAlign, format.channelCount);
+
+            const std::size_t blockCount = format.dataSize / format.blockAlign;
+            const std::size_t frameCount = blockCount * format.blockFrames + getAdpcmFrames(format.dataSize % format.blockAlign, format.channelCount);
+
+            // the last block is padded by encoder, fact chunk has the real length
+            format.codec = Codec::IMA_ADPCM;
+            format.frameCount = std::uint32_t(std::min(factFrames ? std::min(std::size_t(factFrames), frameCount) : frameCount, std::size_t(0xFFFFFFFF)));
+        }
+        else {
+            return false;
+        }
+
+        return format.frameCount > 0;
+    }
+
+    void StreamImp::_decodeFrames(float *const *channels, std::uint32_t frameCount) {
+        const std::uint8_t *data = _view->getData() + _format.dataOffset;
+
+        if (_format.codec == Codec::PCM16) {
+            const std::uint8_t *src = data + std::size_t(_decodeFrame) * _format.blockAlign;
+
+            for (std::uint32_t i = 0; i < frameCount; i++) {
+                for (std::uint32_t c = 0; c < _format.channelCount; c++, src += 2) {
+                    channels[c][i] = float(std::int16_t(readU16(src))) * (1.0f / 32768.0f);
+                }
+            }
+
+            _decodeFrame += frameCount;
+        }
+        else {
+            const float *block = _data.get() + (std::size_t(_bufferFrames) * _bufferCount + _windowCapacity) * _format.channelCount;
+
+            for (std::uint32_t i = 0; i < frameCount; ) {
+                const std::uint32_t blockIndex = _decodeFrame / _format.blockFrames;
+                const std::uint32_t offset = _decodeFrame % _format.blockFrames;
+                const std::uint32_t count = std::min(frameCount - i, _format.blockFrames - offset);
+
+                if (blockIndex != _blockIndex) {
+                    _decodeBlock(blockIndex);
+                }
+
+                for (std::uint32_t c = 0; c < _format.channelCount; c++) {
+                    std::memcpy(channels[c] + i, block + c * _format.blockFrames + offset, count * sizeof(float));
+                }
+
+                _decodeFrame += count;
+                i += count;
+            }
+        }
+    }
+
+    void StreamImp::_decodeBlock(std::uint32_t blockIndex) {
+        const std::uint32_t channelCount = _format.channelCount;
+        const std::size_t offset = std::size_t(blockIndex) * _format.blockAlign;
+        const std::size_t size = std::min(std::size_t(_format.blockAlign), _format.dataSize - offset);
+        const std::uint32_t frameCount = getAdpcmFrames(size, channelCount);
+        const std::uint8_t *src = _view->getData() + _format.dataOffset + offset;
+        float *block = _data.get() + (std::size_t(_bufferFrames) * _bufferCount + _windowCapacity) * channelCount;
+
+        for (std::uint32_t c = 0; c < channelCount; c++) {
+            float *out = block + c * _format.blockFrames;
+            std::int32_t predictor = std::int16_t(readU16(src + c * 4));
+            std::int32_t index = std::min(std::int32_t(src[c * 4 + 2]), 88);
+
+            out[0] = float(predictor) * (1.0f / 32768.0f);
+
+            // after headers every channel has 4 bytes (8 samples, low nibble first) in turn
+            for (std::uint32_t i = 1; i < frameCount; i++) {
+                const std::uint32_t sample = i - 1;
+                const std::uint8_t byte = src[4 * channelCount + ((sample / 8) * channelCount + c) * 4 + (sample % 8) / 2];
+                const std::uint8_t nibble = (sample & 1) ? byte >> 4 : byte & 0xF;
+                const std::int32_t step = IMA_STEPS[index];
+                std::int32_t diff = step >> 3;
+
+                if (nibble & 1) diff += step >> 2;
+                if (nibble & 2) diff += step >> 1;
+                if (nibble & 4) diff += step;
+
+                predictor = std::min(std::max(nibble & 8 ? predictor - diff : predictor + diff, -32768), 32767);
+                index = std::min(std::max(index + IMA_INDEX_STEPS[nibble], 0), 88);
+                out[i] = float(predictor) * (1.0f / 32768.0f);
+            }
+        }
+
+        _blockIndex = blockIndex;
+    }
+
+    void StreamImp::_releasePages(std::size_t offset) {
+        // partially decoded range is kept until its granule is done
+        const std::size_t end = offset & ~(STREAM_RELEASE_GRANULARITY - 1);
+
+        if (end > _releasedOffset) {
+            _view->releasePages(_releasedOffset, end - _releasedOffset);
+            _releasedOffset = end;
+        }
+    }
+
+    std::uint32_t AudioStream::getFrameCount() const {
+        return static_cast<const StreamImp *>(this)->getFrameCount();
+    }
+
+    std::uint32_t AudioStream::getChannelCount() const {
+        return static_cast<const StreamImp *>(this)->getChannelCount();
+    }
+
+    std::uint32_t AudioStream::getSampleRate() const {
+        return static_cast<const StreamImp *>(this)->getSampleRate();
+    }
+
+    AudioStreamStats AudioStream::getStats() const {
+        return static_cast<const StreamImp *>(this)->getStats();
+    }
+}
+
+namespace platform {
+    AudioStreamer::~AudioStreamer() {
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+            _stopped = true;
+        }
+
+        _wakeup.notify_all();
+
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    void AudioStreamer::add(const std::shared_ptr<StreamImp> &stream) {
+        std::lock_guard<std::mutex> guard(_guard);
+        _streams.emplace_back(stream);
+
+        if (_thread.joinable() == false) {
+            _thread = std::thread(&AudioStreamer::_decodeLoop, this);
+        }
+    }
+
+    void AudioStreamer::_decodeLoop() {
+        std::vector<std::shared_ptr<StreamImp>> streams;
+        std::unique_lock<std::mutex> lock(_guard);
+
+        while (_wakeup.wait_for(lock, STREAMER_PERIOD, [this] { return _stopped; }) == false) {
+            _streams.erase(std::remove_if(_streams.begin(), _streams.end(), [](const std::weak_ptr<StreamImp> &stream) { return stream.expired(); }), _streams.end());
+
+            for (const std::weak_ptr<StreamImp> &stream : _streams) {
+                if (std::shared_ptr<StreamImp> locked = stream.lock()) {
+                    streams.emplace_back(std::move(locked));
+                }
+            }
+
+            lock.unlock();
+
+            for (const std::shared_ptr<StreamImp> &stream : streams) {
+                stream->decode();
+            }
+
+            // the last reference to stream can be released here, outside of the lock
+            streams.clear();
+            lock.lock();
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "interfaces.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace platform {
+    // Frames of stream available to audio thread. channels[c][i] is frame start + i
+    //
+    struct StreamWindow {
+        const float *channels[2];
+        std::int64_t start;
+        std::uint32_t frameCount;
+        bool finished;                      // window ends with padding after the last frame of stream
+    };
+
+    // Sound decoded incrementally from mapped wave file (16-bit PCM or IMA ADPCM)
+    // Decoder fills ring of buffers, audio thread copies them to window that resampler reads. Ring, window and block buffer
+    // are allocated at creation and never grow. Decoded pages of file are released, so memory doesn't depend on file length
+    //
+    class StreamImp : public AudioStream {
+    public:
+        // Window holds frames that resampler of mixer reads for one block at the highest pitch
+        // @paddingFrames - zero frames before the first frame and after the last one, half of the longest filter
+        // @return        - nullptr if file format is not supported or buffers don't fit @params.memoryLimit
+        //
+        static std::shared_ptr<StreamImp> create(
+            const std::shared_ptr<FileView> &view,
+            const StreamParams &params,
+            std::uint32_t outputRate,
+            std::uint32_t blockFrames,
+            float pitchMax,
+            std::uint32_t paddingFrames
+        );
+
+        ~StreamImp();
+
+        // Decoder thread, or rendering thread of offline device. Fills free buffers of ring
+        // @return - false if there was nothing to decode
+        //
+        bool decode();
+
+        // Game threads. Stream is played once
+        // @return - false if stream has been played already
+        //
+        bool start();
+        void cancelStart();
+
+        // Audio thread. Drops frames before @firstFrame and appends decoded frames up to @lastFrame
+        //
+        StreamWindow read(std::int64_t firstFrame, std::int64_t lastFrame);
+        void addUnderrun();
+
+        std::uint32_t getFrameCount() const;
+        std::uint32_t getChannelCount() const;
+        std::uint32_t getSampleRate() const;
+        AudioStreamStats getStats() const;
+
+    private:
+        enum class Codec {
+            PCM16 = 0,
+            IMA_ADPCM,
+        };
+
+        struct Format {
+            Codec codec;
+            std::uint32_t channelCount;
+            std::uint32_t sampleRate;
+            std::uint32_t frameCount;
+            std::uint32_t blockAlign;       // bytes of frame (PCM) or block (ADPCM)
+            std::uint32_t blockFrames;      // frames of ADPCM block
+            std::size_t dataOffset;
+            std::size_t dataSize;
+        };
+
+        struct BufferInfo {
+            std::uint32_t frameCount;
+            bool last;                      // stream ends after this buffer
+        };
+
+        static bool _parseWave(const std::uint8_t *data, std::size_t size, Format &format);
+
+        StreamImp(const std::shared_ptr<FileView> &view, const Format &format, bool loop, std::uint32_t bufferFrames, std::uint32_t bufferCount, std::uint32_t windowCapacity, std::uint32_t paddingFrames);
+
+        void _decodeFrames(float *const *channels, std::uint32_t frameCount);
+        void _decodeBlock(std::uint32_t block);
+        void _releasePages(std::size_t offset);
+
+        const std::shared_ptr<FileView> _view;
+        const Format _format;
+        const bool _loop;
+        const std::uint32_t _bufferFrames;
+        const std::uint32_t _bufferCount;
+        const std::uint32_t _windowCapacity;
+        const std::uint32_t _paddingFrames;
+        const std::size_t _memorySize;
+        std::unique_ptr<float[]> _data;     // ring buffers, window, ADPCM block, all planar
+        std::unique_ptr<BufferInfo[]> _buffers;
+
+        // decoder, under _decodeGuard
+        std::mutex _decodeGuard;
+        std::uint32_t _decodeFrame = 0;
+        std::uint32_t _blockIndex = ~0u;    // ADPCM block decoded to block buffer
+        std::size_t _releasedOffset;
+        bool _decodedAll = false;
+
+        // ring, decoder writes, audio thread reads
+        std::atomic<std::uint32_t> _writeCount {0};
+        std::atomic<std::uint32_t> _readCount {0};
+
+        // audio thread
+        std::uint32_t _readOffset = 0;      // frames taken from the current buffer
+        std::int64_t _windowStart;
+        std::uint32_t _windowFrames;
+        bool _ended = false;                // the last buffer is taken
+        bool _padded = false;
+
+        std::atomic<std::uint64_t> _decodedFrames {0};
+        std::atomic<std::uint64_t> _consumedFrames {0};
+        std::atomic<std::uint32_t> _underruns {0};
+        std::atomic<bool> _started {false};
+    };
+
+    // Background thread that decodes all streams of AudioMixer. Thread is started with the first stream
+    //
+    class AudioStreamer {
+    public:
+        ~AudioStreamer();
+
+        void add(const std::shared_ptr<StreamImp> &stream);
+
+    private:
+        void _decodeLoop();
+
+        std::mutex _guard;
+        std::condition_variable _wakeup;
+        std::vector<std::weak_ptr<StreamImp>> _streams;     // stream is released by application and mixer
+        std::thread _thread;
+        bool _stopped = false;
+    };
+}
@@ -0,0 +1,297 @@
+#include "command_list.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+    constexpr std::size_t COMMAND_LIST_INITIAL_WORDS = 4096 / sizeof(std::uint64_t);
+    constexpr std::uint32_t SORT_DIGIT_BITS = 8;
+    constexpr std::uint32_t SORT_DIGIT_COUNT = 1 << SORT_DIGIT_BITS;
+    constexpr std::uint32_t SORT_PASS_COUNT = 64 / SORT_DIGIT_BITS;
+}
+
+namespace platform {
+    CommandListImp::CommandListImp() {}
+    CommandListImp::~CommandListImp() {}
+
+    void CommandListImp::applyShader(const std::shared_ptr<Shader> &shader, const void *constants) {
+        if (shader) {
+            const std::uint32_t constantsSize = constants ? shader->getConstBlockSize() : 0;
+            ApplyShaderCommand *command = _record<ApplyShaderCommand>(CommandType::APPLY_SHADER, constantsSize);
+
+            command->constantsSize = constantsSize;
+            command->shader = shader.get();
+
+            if (constantsSize) {
+                std::memcpy(getPayload(*command), constants, constantsSize);
+            }
+        }
+    }
+
+    void CommandListImp::applyTextures(const std::initializer_list<const Texture2D *> &textures) {
+        ApplyTexturesCommand *command = _record<ApplyTexturesCommand>(CommandType::APPLY_TEXTURES, textures.size() * sizeof(const Texture2D *));
+
+        command->count = std::uint32_t(textures.size());
+        std::copy(textures.begin(), textures.end(), static_cast<const Texture2D **>(getPayload(*command)));
+    }
+
+    void CommandListImp::drawGeometry(std::uint32_t vertexCount, Topology topology) {
+        DrawCommand *command = _record<DrawCommand>(CommandType::DRAW, 0);
+
+        command->topology = topology;
+        command->vertexCount = vertexCount;
+        command->instanceCount = 0;
+        command->sortKey = _sortKey;
+        command->vertexData = nullptr;
+        command->instanceData = nullptr;
+    }
+
+    void CommandListImp::drawGeometry(
+        const std::shared_ptr<StructuredData> &vertexData,
+        const std::shared_ptr<StructuredData> &instanceData,
+        std::uint32_t vertexCount,
+        std::uint32_t instanceCount,
+        Topology topology
+    ) {
+        DrawCommand *command = _record<DrawCommand>(CommandType::DRAW_INSTANCED, 0);
+
+        command->topology = topology;
+        command->vertexCount = vertexCount;
+        command->instanceCount = instanceCount;
+        command->sortKey = _sortKey;
+        command->vertexData = vertexData.get();
+        command->instanceData = instanceData.get();
+    }
+
+    void CommandListImp::setSortKey(std::uint64_t key) {
+        _sortKey = key;
+    }
+
+    void CommandListImp::reset() {
+        _size = 0;
+        _commandCount = 0;
+        _sortKey = 0;
+    }
+
+    std::uint32_t CommandListImp::getCommandCount() const {
+        return _commandCount;
+    }
+
+    std::size_t CommandListImp::getMemorySize() const {
+        return _data.size() * sizeof(std::uint64_t);
+    }
+
+    std::size_t CommandListImp::getConstantsSize(std::size_t alignment) const {
+        std::size_t result = 0;
+
+        execute([&result, alignment](const Command &command) {
+            if (command.type == CommandType::APPLY_SHADER) {
+                result += getAlignedSize(reinterpret_cast<const ApplyShaderCommand &>(command).constantsSize, alignment);
+            }
+        });
+
+        return result;
+    }
+
+    template<typename T> T *CommandListImp::_record(CommandType type, std::size_t payloadSize) {
+        const std::size_t words = _getWords(sizeof(T)) + _getWords(payloadSize);
+
+        // recorded commands are plain data, so growing array moves them as words
+        if (_size + words > _data.size()) {
+            _data.resize(std::max(std::max(_data.size() * 2, _size + words), COMMAND_LIST_INITIAL_WORDS));
+        }
+
+        T *result = new (_data.data() + _size) T;
+        result->header.type = type;
+        result->header.size = std::uint32_t(words);
+
+        _size += words;
+        _commandCount++;
+        return result;
+    }
+}
+
+namespace platform {
+    DrawSorter::DrawSorter(std::size_t constantsAlignment) : _constantsAlignment(constantsAlignment) {}
+
+    void DrawSorter::add(const std::shared_ptr<CommandList> &list) {
+        DrawItem state = {};
+
+        static_cast<const CommandListImp *>(list.get())->execute([this, &state](const CommandListImp::Command &command) {
+            switch (command.type) {
+                case CommandListImp::CommandType::APPLY_SHADER:
+                    state.shader = reinterpret_cast<const CommandListImp::ApplyShaderCommand *>(&command);
+                    state.constantsOffset = _constantsSize;
+                    _constantsSize += CommandListImp::getAlignedSize(state.shader->constantsSize, _constantsAlignment);
+                    break;
+                case CommandListImp::CommandType::APPLY_TEXTURES:
+                    state.textures = reinterpret_cast<const CommandListImp::ApplyTexturesCommand *>(&command);
+                    break;
+                case CommandListImp::CommandType::DRAW:
+                case CommandListImp::CommandType::DRAW_INSTANCED:
+                    state.draw = reinterpret_cast<const CommandListImp::DrawCommand *>(&command);
+                    _items.emplace_back(state);
+                    break;
+            }
+        });
+
+        _lists.emplace_back(list);
+    }
+
+    std::size_t DrawSorter::getConstantsSize() const {
+        return _constantsSize;
+    }
+
+    // Draws of the same shader command follow each other in _items, their constants are copied once
+    void DrawSorter::copyConstants(void *dst) const {
+        const CommandListImp::ApplyShaderCommand *last = nullptr;
+
+        for (const DrawItem &item : _items) {
+            if (item.shader && item.shader != last && item.shader->constantsSize) {
+                std::memcpy(static_cast<std::uint8_t *>(dst) + item.constantsOffset, CommandListImp::getPayload(*item.shader), item.shader->constantsSize);
+            }
+
+            last = item.shader;
+        }
+    }
+
+    bool DrawSorter::_isShaderApplied(const DrawItem &item, const DrawItem *last) {
+        if (item.shader == nullptr) {
+            return false;
+        }
+        if (last == nullptr) {
+            return true;
+        }
+
+        // the same shader without constants is already applied
+        return item.shader != last->shader && (item.shader->shader != last->shader->shader || item.shader->constantsSize != 0);
+    }
+
+    bool DrawSorter::_isTexturesApplied(const DrawItem &item, const DrawItem *last) {
+        if (item.textures == nullptr) {
+            return false;
+        }
+        if (last == nullptr) {
+            return true;
+        }
+        if (item.textures == last->textures) {
+            return false;
+        }
+
+        const Texture2D *const *textures = static_cast<const Texture2D *const *>(CommandListImp::getPayload(*item.textures));
+        const Texture2D *const *lastTextures = static_cast<const Texture2D *const *>(CommandListImp::getPayload(*last->textures));
+        return item.textures->count != last->textures->count || std::equal(textures, textures + item.textures->count, lastTextures) == false;
+    }
+
+    std::uint64_t DrawSorter::_countShaderChanges(bool sorted) const {
+        const Shader *current = nullptr;
+        std::uint64_t result = 0;
+
+        for (std::size_t i = 0; i < _items.size(); i++) {
+            const DrawItem &item = _items[sorted ? _entries[i].index : i];
+
+            if (item.shader && item.shader->shader != current) {
+                current = item.shader->shader;
+                result++;
+            }
+        }
+
+        return result;
+    }
+
+    std::uint64_t DrawSorter::_countTextureChanges(bool sorted) const {
+        const DrawItem *last = nullptr;
+        std::uint64_t result = 0;
+
+        for (std::size_t i = 0; i < _items.size(); i++) {
+            const DrawItem &item = _items[sorted ? _entries[i].index : i];
+
+            if (_isTexturesApplied(item, last)) {
+                last = &item;
+                result++;
+            }
+        }
+
+        return result;
+    }
+
+    // LSD radix sort by bytes of key. Histograms of all passes are built in one pass over keys, and passes where all keys
+    // have the same byte are skipped, so keys with few used bits take few passes
+    void DrawSorter::_sort() {
+        std::uint32_t histograms[SORT_PASS_COUNT][SORT_DIGIT_COUNT] = {};
+
+        _entries.resize(_items.size());
+        _sortBuffer.resize(_items.size());
+
+        for (std::uint32_t i = 0; i < std::uint32_t(_items.size()); i++) {
+            const std::uint64_t key = _items[i].draw->sortKey;
+
+            _entries[i].key = key;
+            _entries[i].index = i;
+
+            for (std::uint32_t pass = 0; pass < SORT_PASS_COUNT; pass++) {
+                histograms[pass][(key >> (pass * SORT_DIGIT_BITS)) & (SORT_DIGIT_COUNT - 1)]++;
+            }
+        }
+
+        for (std::uint32_t pass = 0; pass < SORT_PASS_COUNT; pass++) {
+            std::uint32_t *histogram = histograms[pass];
+            const std::uint32_t shift = pass * SORT_DIGIT_BITS;
+
+            if (histogram[(_entries[0].key >> shift) & (SORT_DIGIT_COUNT - 1)] != _entries.size()) {
+                for (std::uint32_t digit = 0, offset = 0; digit < SORT_DIGIT_COUNT; digit++) {
+                    const std::uint32_t count = histogram[digit];
+                    histogram[digit] = offset;
+                    offset += count;
+                }
+                for (const SortEntry &entry : _entries) {
+                    _sortBuffer[histogram[(entry.key >> shift) & (SORT_DIGIT_COUNT - 1)]++] = entry;
+                }
+
+                _entries.swap(_sortBuffer);
+            }
+        }
+    }
+}
+
+namespace platform {
+    void CommandList::applyShader(const std::shared_ptr<Shader> &shader, const void *constants) {
+        static_cast<CommandListImp *>(this)->applyShader(shader, constants);
+    }
+
+    void CommandList::applyTextures(const std::initializer_list<const Texture2D *> &textures) {
+        static_cast<CommandListImp *>(this)->applyTextures(textures);
+    }
+
+    void CommandList::drawGeometry(std::uint32_t vertexCount, Topology topology) {
+        static_cast<CommandListImp *>(this)->drawGeometry(vertexCount, topology);
+    }
+
+    void CommandList::drawGeometry(
+        const std::shared_ptr<StructuredData> &vertexData,
+        const std::shared_ptr<StructuredData> &instanceData,
+        std::uint32_t vertexCount,
+        std::uint32_t instanceCount,
+        Topology topology
+    )
+    {
+        static_cast<CommandListImp *>(this)->drawGeometry(vertexData, instanceData, vertexCount, instanceCount, topology);
+    }
+
+    void CommandList::setSortKey(std::uint64_t key) {
+        static_cast<CommandListImp *>(this)->setSortKey(key);
+    }
+
+    void CommandList::reset() {
+        static_cast<CommandListImp *>(this)->reset();
+    }
+
+    std::uint32_t CommandList::getCommandCount() const {
+        return static_cast<const CommandListImp *>(this)->getCommandCount();
+    }
+
+    std::size_t CommandList::getMemorySize() const {
+        return static_cast<const CommandListImp *>(this)->getMemorySize();
+    }
+}
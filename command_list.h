@@ -0,0 +1,193 @@
+#pragma once
+
+#include "interfaces.h"
+#include "memory_tracker.h"
+
+namespace platform {
+    // CommandList recorded to one growing array of 8-byte words
+    // Every command starts with Command header and is followed by its payload: constants of ApplyShaderCommand or pointers
+    // of ApplyTexturesCommand. Recording copies a few words and doesn't touch reference counters of recorded objects, so
+    // threads recording different lists don't share cache lines
+    //
+    class CommandListImp : public CommandList {
+    public:
+        enum class CommandType : std::uint8_t {
+            APPLY_SHADER = 0,
+            APPLY_TEXTURES,
+            DRAW,
+            DRAW_INSTANCED,
+        };
+
+        struct Command {
+            CommandType type;
+            std::uint32_t size;                 // words of command and its payload
+        };
+
+        struct ApplyShaderCommand {
+            Command header;
+            std::uint32_t constantsSize;        // bytes of constants after the command, 0 - constants are not set
+            const Shader *shader;
+        };
+
+        struct ApplyTexturesCommand {
+            Command header;
+            std::uint32_t count;                // texture pointers after the command, nullptr - slot is not set
+        };
+
+        struct DrawCommand {
+            Command header;
+            Topology topology;
+            std::uint32_t vertexCount;
+            std::uint32_t instanceCount;
+            std::uint64_t sortKey;
+            const StructuredData *vertexData;
+            const StructuredData *instanceData;
+        };
+
+        CommandListImp();
+        ~CommandListImp();
+
+        void applyShader(const std::shared_ptr<Shader> &shader, const void *constants);
+        void applyTextures(const std::initializer_list<const Texture2D *> &textures);
+        void drawGeometry(std::uint32_t vertexCount, Topology topology);
+        void drawGeometry(
+            const std::shared_ptr<StructuredData> &vertexData,
+            const std::shared_ptr<StructuredData> &instanceData,
+            std::uint32_t vertexCount,
+            std::uint32_t instanceCount,
+            Topology topology
+        );
+
+        void setSortKey(std::uint64_t key);
+        void reset();
+
+        std::uint32_t getCommandCount() const;
+        std::size_t getMemorySize() const;
+
+        // Bytes of constants of all shader commands when each of them starts at multiple of @alignment
+        //
+        std::size_t getConstantsSize(std::size_t alignment) const;
+
+        // Render thread. Calls @handler(const Command &) for every command in order of recording
+        //
+        template<typename Handler> void execute(Handler &&handler) const {
+            for (std::size_t offset = 0; offset < _size; ) {
+                const Command &command = *reinterpret_cast<const Command *>(_data.data() + offset);
+                handler(command);
+                offset += command.size;
+            }
+        }
+
+        // Payload that follows @command
+        //
+        template<typename T> static const void *getPayload(const T &command) {
+            return reinterpret_cast<const std::uint64_t *>(&command) + _getWords(sizeof(T));
+        }
+
+        template<typename T> static void *getPayload(T &command) {
+            return reinterpret_cast<std::uint64_t *>(&command) + _getWords(sizeof(T));
+        }
+
+        static constexpr std::size_t getAlignedSize(std::size_t size, std::size_t alignment) {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+    private:
+        static constexpr std::size_t _getWords(std::size_t bytes) {
+            return (bytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+        }
+
+        // @return - command with @payloadSize bytes of space after it, header is filled
+        //
+        template<typename T> T *_record(CommandType type, std::size_t payloadSize);
+
+        TrackedVector<std::uint64_t, MemoryCategory::COMMAND_LISTS> _data;
+        std::size_t _size = 0;                  // words of recorded commands
+        std::uint32_t _commandCount = 0;
+        std::uint64_t _sortKey = 0;
+    };
+
+    // Draws of command lists submitted with sorting during one frame
+    // Every draw keeps shader and textures applied before it in its list. Draws are ordered by LSD radix sort of their keys,
+    // which is stable, so draws with equal keys keep order of submission and recording
+    //
+    class DrawSorter {
+    public:
+        struct DrawItem {
+            const CommandListImp::ApplyShaderCommand *shader;       // nullptr - no shader applied before draw in its list
+            const CommandListImp::ApplyTexturesCommand *textures;   // nullptr - no textures applied before draw in its list
+            const CommandListImp::DrawCommand *draw;
+            std::size_t constantsOffset;                            // offset of shader constants in block written by copyConstants()
+        };
+
+        // @constantsAlignment - constants of every shader command in block of copyConstants() start at multiple of it
+        //
+        DrawSorter(std::size_t constantsAlignment = 1);
+
+        // Gathers draws of @list. List is kept alive until execute()
+        //
+        void add(const std::shared_ptr<CommandList> &list);
+
+        // Constants of all gathered shader commands, so device can upload them at once before execute()
+        // @dst - getConstantsSize() bytes, constants of DrawItem are written at its constantsOffset
+        //
+        std::size_t getConstantsSize() const;
+        void copyConstants(void *dst) const;
+
+        // Render thread. Sorts gathered draws and calls @handler(const DrawItem &, bool applyShader, bool applyTextures) for
+        // them in order of keys. Shader or textures are applied only when they differ from the ones of the previous draw
+        // Adds sorted draws and state changes saved by sorting to @stats, then forgets the lists
+        //
+        template<typename Handler> void execute(Handler &&handler, RenderStats &stats) {
+            if (_items.size()) {
+                const std::uint64_t shaderChanges = _countShaderChanges(false);
+                const std::uint64_t textureChanges = _countTextureChanges(false);
+
+                _sort();
+
+                const DrawItem *lastShader = nullptr;
+                const DrawItem *lastTextures = nullptr;
+
+                for (const SortEntry &entry : _entries) {
+                    const DrawItem &item = _items[entry.index];
+                    const bool applyShader = _isShaderApplied(item, lastShader);
+                    const bool applyTextures = _isTexturesApplied(item, lastTextures);
+
+                    lastShader = applyShader ? &item : lastShader;
+                    lastTextures = applyTextures ? &item : lastTextures;
+                    handler(item, applyShader, applyTextures);
+                }
+
+                stats.sortedDraws += _items.size();
+                stats.shaderChangesSaved += shaderChanges - _countShaderChanges(true);
+                stats.textureChangesSaved += textureChanges - _countTextureChanges(true);
+            }
+
+            _items.clear();
+            _lists.clear();
+            _constantsSize = 0;
+        }
+
+    private:
+        struct SortEntry {
+            std::uint64_t key;
+            std::uint32_t index;
+        };
+
+        static bool _isShaderApplied(const DrawItem &item, const DrawItem *last);
+        static bool _isTexturesApplied(const DrawItem &item, const DrawItem *last);
+
+        // @sorted - count in order of _entries, otherwise in order of submission
+        //
+        std::uint64_t _countShaderChanges(bool sorted) const;
+        std::uint64_t _countTextureChanges(bool sorted) const;
+        void _sort();
+
+        TrackedVector<std::shared_ptr<CommandList>, MemoryCategory::COMMAND_LISTS> _lists;
+        TrackedVector<DrawItem, MemoryCategory::COMMAND_LISTS> _items;
+        TrackedVector<SortEntry, MemoryCategory::COMMAND_LISTS> _entries;     // sorted by key after _sort()
+        TrackedVector<SortEntry, MemoryCategory::COMMAND_LISTS> _sortBuffer;
+        std::size_t _constantsAlignment;
+        std::size_t _constantsSize = 0;
+    };
+}
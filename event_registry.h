@@ -0,0 +1,164 @@
+#pragma once
+
+#include "interfaces.h"
+#include "memory_tracker.h"
+
+namespace platform {
+    // Event handlers of one kind stored in contiguous array
+    // Tokens are generational handles: kind of table, generation and slot index. Stale or foreign token is rejected in O(1)
+    // Handlers can be added and removed by handlers during dispatch. Added ones are called starting from the next dispatch,
+    // removed ones are not called anymore
+    //
+    template<typename Handlers> class EventHandlerTable {
+    public:
+        // @kind - unique index of table among tables sharing tokens, [0, 8)
+        // Table holds up to 65536 entries, add() returns nullptr if there is no free slot
+        //
+        EventHandlerTable(std::uint32_t kind) : _kind(kind) {}
+
+        EventHandlersToken add(Handlers &&handlers) {
+            std::uint32_t slot;
+
+            if (_freeSlots.size()) {
+                slot = _freeSlots.back();
+                _freeSlots.pop_back();
+            }
+            else if (_slots.size() <= SLOT_MASK) {
+                slot = std::uint32_t(_slots.size());
+                _slots.emplace_back(Slot{0, 1});
+            }
+            else {
+                return nullptr;
+            }
+
+            if (_dispatchDepth) {
+                _slots[slot].index = std::uint32_t(_pending.size()) | PENDING_BIT;
+                _pending.emplace_back(Entry{std::move(handlers), slot, true});
+            }
+            else {
+                _slots[slot].index = std::uint32_t(_entries.size());
+                _entries.emplace_back(Entry{std::move(handlers), slot, true});
+            }
+
+            const std::uintptr_t value = (std::uintptr_t(_kind) << KIND_SHIFT) | (std::uintptr_t(_slots[slot].generation) << GENERATION_SHIFT) | slot;
+            return reinterpret_cast<EventHandlersToken>(value);
+        }
+
+        // @return false if token doesn't belong to this table or handlers are already removed
+        //
+        bool remove(EventHandlersToken token) {
+            const std::uintptr_t value = reinterpret_cast<std::uintptr_t>(token);
+            const std::uint32_t slot = std::uint32_t(value & SLOT_MASK);
+            const std::uint32_t generation = std::uint32_t((value >> GENERATION_SHIFT) & GENERATION_MASK);
+
+            if (((value >> KIND_SHIFT) & KIND_MASK) != _kind || slot >= _slots.size() || _slots[slot].generation != generation) {
+                return false;
+            }
+
+            const std::uint32_t index = _slots[slot].index;
+
+            // generation is never 0, 0 means "token from nowhere"
+            _slots[slot].generation = (generation + 1) & GENERATION_MASK ? (generation + 1) & GENERATION_MASK : 1;
+            _freeSlots.emplace_back(slot);
+
+            if (index & PENDING_BIT) {
+                _pending[index & ~PENDING_BIT].alive = false;
+            }
+            else if (_dispatchDepth) {
+                _entries[index].alive = false;
+                _hasDead = true;
+            }
+            else {
+                _eraseEntry(index);
+            }
+
+            return true;
+        }
+
+        // Calls @call(const Handlers &) for every alive entry
+        //
+        template<typename Call> void dispatch(Call &&call) {
+            const std::size_t count = _entries.size();
+
+            _dispatchDepth++;
+
+            for (std::size_t i = 0; i < count; i++) {
+                if (_entries[i].alive) {
+                    call(_entries[i].handlers);
+                }
+            }
+
+            if (--_dispatchDepth == 0) {
+                _applyChanges();
+            }
+        }
+
+        bool empty() const {
+            return _entries.empty() && _pending.empty();
+        }
+
+    private:
+        static constexpr std::uint32_t PENDING_BIT = 0x80000000;
+        static constexpr std::uintptr_t SLOT_MASK = 0xffff;
+        static constexpr std::uintptr_t GENERATION_SHIFT = 16;
+        static constexpr std::uintptr_t GENERATION_MASK = 0x1fff;
+        static constexpr std::uintptr_t KIND_SHIFT = 29;
+        static constexpr std::uintptr_t KIND_MASK = 0x7;
+
+        struct Entry {
+            Handlers handlers;
+            std::uint32_t slot;
+            bool alive;
+        };
+
+        struct Slot {
+            std::uint32_t index;        // index in _entries or in _pending with PENDING_BIT
+            std::uint32_t generation;
+        };
+
+        void _eraseEntry(std::uint32_t index) {
+            if (index + 1 != _entries.size()) {
+                _entries[index] = std::move(_entries.back());
+
+                // slot of dead entry can be already reused
+                if (_entries[index].alive) {
+                    _slots[_entries[index].slot].index = index;
+                }
+            }
+
+            _entries.pop_back();
+        }
+
+        void _applyChanges() {
+            if (_hasDead) {
+                for (std::uint32_t i = 0; i < _entries.size(); ) {
+                    if (_entries[i].alive) {
+                        i++;
+                    }
+                    else {
+                        _eraseEntry(i);
+                    }
+                }
+
+                _hasDead = false;
+            }
+
+            for (Entry &entry : _pending) {
+                if (entry.alive) {
+                    _slots[entry.slot].index = std::uint32_t(_entries.size());
+                    _entries.emplace_back(std::move(entry));
+                }
+            }
+
+            _pending.clear();
+        }
+
+        const std::uint32_t _kind;
+        TrackedVector<Entry, MemoryCategory::EVENT_HANDLERS> _entries;
+        TrackedVector<Entry, MemoryCategory::EVENT_HANDLERS> _pending;
+        TrackedVector<Slot, MemoryCategory::EVENT_HANDLERS> _slots;
+        TrackedVector<std::uint32_t, MemoryCategory::EVENT_HANDLERS> _freeSlots;
+        std::uint32_t _dispatchDepth = 0;
+        bool _hasDead = false;
+    };
+}
@@ -0,0 +1,318 @@
+
+#include "file_index.h"
+#include "asset_archive.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace {
+    const char *normalizePath(const char *path, std::size_t &length) {
+        while (path[0] == '.' && path[1] == '/') {
+            path += 2;
+        }
+
+        length = std::strlen(path);
+
+        while (length && path[length - 1] == '/') {
+            length--;
+        }
+
+        return path;
+    }
+
+    // Lexicographic comparison of byte strings
+    int comparePaths(const char *a, std::size_t aLength, const char *b, std::size_t bLength) {
+        int cmp = std::memcmp(a, b, std::min(aLength, bLength));
+        return cmp ? cmp : (aLength < bLength ? -1 : (aLength > bLength ? 1 : 0));
+    }
+
+    // @recursive - nested directories of @dir are included
+    bool isInDirectory(const char *path, std::size_t pathLength, const char *dir, std::size_t dirLength, bool recursive) {
+        if (dirLength) {
+            if (pathLength <= dirLength || path[dirLength] != '/' || std::memcmp(path, dir, dirLength) != 0) {
+                return false;
+            }
+
+            path += dirLength + 1;
+            pathLength -= dirLength + 1;
+        }
+
+        return recursive || std::memchr(path, '/', pathLength) == nullptr;
+    }
+
+    bool matchGlob(const char *pattern, const char *name, std::size_t nameLength) {
+        const char *nameEnd = name + nameLength;
+        const char *starPattern = nullptr;
+        const char *starName = nullptr;
+
+        while (name != nameEnd) {
+            if (*pattern == '*') {
+                starPattern = ++pattern;
+                starName = name;
+            }
+            else if (*pattern && (*pattern == '?' || *pattern == *name)) {
+                pattern++;
+                name++;
+            }
+            else if (starPattern) {
+                pattern = starPattern;
+                name = ++starName;
+            }
+            else {
+                return false;
+            }
+        }
+
+        while (*pattern == '*') {
+            pattern++;
+        }
+
+        return *pattern == 0;
+    }
+}
+
+namespace platform {
+    FileIndex::FileIndex() : _sortedCount(0), _unusedStrings(0), _archiveCount(0) {}
+
+    void FileIndex::addDirectory(const char *rootPath, const char *dirPath, bool recursive) {
+        std::size_t length = 0;
+        const char *dir = normalizePath(dirPath, length);
+        const std::string relative (dir, length);
+
+        _remove(relative, recursive);
+        _scan(rootPath, relative, recursive);
+        _sort();
+
+        // directories covered by the new one are forgotten
+        for (auto index = _directories.begin(); index != _directories.end(); ) {
+            const bool covered = index->path == relative
+                ? recursive || index->recursive == false
+                : recursive && isInDirectory(index->path.data(), index->path.size(), dir, length, true);
+
+            if (covered) {
+                index = _directories.erase(index);
+            }
+            else {
+                ++index;
+            }
+        }
+
+        _directories.emplace_back(Directory{relative, recursive});
+    }
+
+    bool FileIndex::hasDirectory(const char *dirPath, bool recursive) const {
+        std::size_t length = 0;
+        const char *dir = normalizePath(dirPath, length);
+
+        for (const Directory &directory : _directories) {
+            const bool same = directory.path.size() == length && std::memcmp(directory.path.data(), dir, length) == 0;
+
+            if (same && (directory.recursive || recursive == false)) {
+                return true;
+            }
+            if (directory.recursive && isInDirectory(dir, length, directory.path.data(), directory.path.size(), true)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void FileIndex::addArchive(const AssetArchive &archive) {
+        _archiveCount++;
+
+        for (std::uint32_t i = 0; i < archive.getEntryCount(); i++) {
+            const AssetArchiveEntry &entry = archive.getEntry(i);
+            _add(archive.getPath(entry), entry.pathLength, entry.size, 0, _archiveCount);
+        }
+
+        _sort();
+    }
+
+    void FileIndex::clear() {
+        _records.clear();
+        _strings.clear();
+        _directories.clear();
+        _sortedCount = 0;
+        _unusedStrings = 0;
+        _archiveCount = 0;
+    }
+
+    bool FileIndex::find(const char *filePath, FileInfo &info) const {
+        std::size_t length = 0;
+        const char *path = normalizePath(filePath, length);
+
+        auto less = [this, path, length](const Record &record, int) {
+            return comparePaths(&_strings[record.pathOffset], record.pathLength, path, length) < 0;
+        };
+
+        auto index = std::lower_bound(_records.begin(), _records.end(), 0, less);
+
+        if (index != _records.end() && comparePaths(&_strings[index->pathOffset], index->pathLength, path, length) == 0) {
+            info = _info(*index);
+            return true;
+        }
+
+        return false;
+    }
+
+    void FileIndex::forEach(const char *dirPath, const char *pattern, bool recursive, const std::function<void(const FileInfo &)> &visitor) const {
+        std::size_t length = 0;
+        const char *dir = normalizePath(dirPath, length);
+        const std::size_t prefixLength = length ? length + 1 : 0;
+
+        // paths starting with 'dir/' are contiguous, the range begins at the first path that isn't less than 'dir/'
+        auto less = [this, dir, length](const Record &record, int) {
+            const char *path = &_strings[record.pathOffset];
+
+            if (record.pathLength <= length) {
+                return std::memcmp(path, dir, record.pathLength) <= 0;
+            }
+
+            int cmp = std::memcmp(path, dir, length);
+            return cmp ? cmp < 0 : std::uint8_t(path[length]) < std::uint8_t('/');
+        };
+
+        auto index = length ? std::lower_bound(_records.begin(), _records.end(), 0, less) : _records.begin();
+
+        for (; index != _records.end(); ++index) {
+            const char *path = &_strings[index->pathOffset];
+
+            if (index->pathLength <= prefixLength || std::memcmp(path, dir, length) != 0 || (length && path[length] != '/')) {
+                break;
+            }
+
+            const char *end = path + index->pathLength;
+            const char *name = end;
+
+            // glob is applied to file name only
+            while (name != path + prefixLength && name[-1] != '/') {
+                name--;
+            }
+
+            if (recursive == false && name != path + prefixLength) {
+                continue;
+            }
+            if (pattern && matchGlob(pattern, name, std::size_t(end - name)) == false) {
+                continue;
+            }
+
+            visitor(_info(*index));
+        }
+    }
+
+    void FileIndex::_add(const char *path, std::size_t length, std::uint64_t size, std::int64_t mtime, std::uint32_t source) {
+        _records.emplace_back(Record{std::uint32_t(_strings.size()), std::uint32_t(length), size, mtime, source});
+        _strings.insert(_strings.end(), path, path + length);
+        _strings.emplace_back(0);
+    }
+
+    void FileIndex::_remove(const std::string &dirPath, bool recursive) {
+        auto removed = [this, &dirPath, recursive](const Record &record) {
+            return record.source == 0 && isInDirectory(&_strings[record.pathOffset], record.pathLength, dirPath.data(), dirPath.size(), recursive);
+        };
+
+        for (const Record &record : _records) {
+            if (removed(record)) {
+                _unusedStrings += record.pathLength + 1;
+            }
+        }
+
+        // records stay sorted
+        _records.erase(std::remove_if(_records.begin(), _records.end(), removed), _records.end());
+        _sortedCount = _records.size();
+
+        if (_unusedStrings > _strings.size() / 2) {
+            _compact();
+        }
+    }
+
+    void FileIndex::_scan(const std::string &root, const std::string &relative, bool recursive) {
+        const std::string dirPath = relative.empty() ? root : root + "/" + relative;
+
+        if (DIR *dir = ::opendir(dirPath.c_str())) {
+            while (const dirent *entry = ::readdir(dir)) {
+                if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+                    continue;
+                }
+
+                const std::string path = relative.empty() ? std::string(entry->d_name) : relative + "/" + entry->d_name;
+                const std::string fullPath = root + "/" + path;
+                struct stat st;
+
+                if (::lstat(fullPath.c_str(), &st) != 0) {
+                    continue;
+                }
+                // links to directories aren't followed: they can form cycles
+                if (S_ISLNK(st.st_mode) && (::stat(fullPath.c_str(), &st) != 0 || S_ISDIR(st.st_mode))) {
+                    continue;
+                }
+                if (S_ISDIR(st.st_mode) && recursive) {
+                    _scan(root, path, recursive);
+                }
+                else if (S_ISREG(st.st_mode)) {
+                    _add(path.data(), path.size(), std::uint64_t(st.st_size), std::int64_t(st.st_mtime), 0);
+                }
+            }
+
+            ::closedir(dir);
+        }
+    }
+
+    void FileIndex::_sort() {
+        if (_sortedCount == _records.size()) {
+            return;
+        }
+
+        auto less = [this](const Record &a, const Record &b) {
+            const int cmp = comparePaths(&_strings[a.pathOffset], a.pathLength, &_strings[b.pathOffset], b.pathLength);
+            return cmp ? cmp < 0 : a.source < b.source;
+        };
+        auto equal = [this](const Record &a, const Record &b) {
+            return comparePaths(&_strings[a.pathOffset], a.pathLength, &_strings[b.pathOffset], b.pathLength) == 0;
+        };
+        auto stringsSize = [this]() {
+            std::size_t result = 0;
+
+            for (const Record &record : _records) {
+                result += record.pathLength + 1;
+            }
+
+            return result;
+        };
+
+        // only added records are sorted, then merged with the rest
+        std::stable_sort(_records.begin() + _sortedCount, _records.end(), less);
+        std::inplace_merge(_records.begin(), _records.begin() + _sortedCount, _records.end(), less);
+
+        // the last record of equal paths is kept: the latest archive, or the latest scan of directory
+        const std::size_t sizeBefore = stringsSize();
+        std::reverse(_records.begin(), _records.end());
+        _records.erase(std::unique(_records.begin(), _records.end(), equal), _records.end());
+        std::reverse(_records.begin(), _records.end());
+        _unusedStrings += sizeBefore - stringsSize();
+
+        _sortedCount = _records.size();
+    }
+
+    void FileIndex::_compact() {
+        TrackedVector<char, MemoryCategory::FILES> strings;
+        strings.reserve(_strings.size() - _unusedStrings);
+
+        for (Record &record : _records) {
+            const char *path = &_strings[record.pathOffset];
+            record.pathOffset = std::uint32_t(strings.size());
+            strings.insert(strings.end(), path, path + record.pathLength + 1);
+        }
+
+        _strings.swap(strings);
+        _unusedStrings = 0;
+    }
+
+    FileInfo FileIndex::_info(const Record &record) const {
+        return FileInfo{&_strings[record.pathOffset], record.pathLength, record.size, record.mtime};
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "interfaces.h"
+#include "memory_tracker.h"
+
+namespace platform {
+    class AssetArchive;
+
+    // Sorted index of files from directory tree and mounted archives
+    // Paths are stored in one contiguous block, so enumeration doesn't allocate memory per file
+    // Directories are added on demand and keep files they had when added. Archive entries replace files with the same paths
+    //
+    class FileIndex {
+    public:
+        FileIndex();
+
+        // Adds files of @dirPath, replacing ones added from it before, so files created or removed meanwhile are seen
+        // Symbolic links to files are added, symbolic links to directories are not followed
+        // @rootPath  - directory that paths are relative to
+        // @dirPath   - directory relative to root, "" for root. Example: "data/map1"
+        // @recursive - add files of nested directories too
+        //
+        void addDirectory(const char *rootPath, const char *dirPath = "", bool recursive = true);
+
+        // @return true if files of @dirPath (and its nested directories if @recursive) were added by addDirectory
+        //
+        bool hasDirectory(const char *dirPath, bool recursive) const;
+
+        // Adds entries of archive. Entries replace already added files with the same paths
+        //
+        void addArchive(const AssetArchive &archive);
+
+        void clear();
+
+        // Looks up file by path
+        // @return false if there is no such file
+        //
+        bool find(const char *filePath, FileInfo &info) const;
+
+        // Calls @visitor for files in @dirPath in order of paths
+        // @pattern   - glob for file name ('*' - any sequence, '?' - any char) or nullptr
+        // @recursive - visit files from nested directories too
+        //
+        void forEach(const char *dirPath, const char *pattern, bool recursive, const std::function<void(const FileInfo &)> &visitor) const;
+
+    private:
+        struct Record {
+            std::uint32_t pathOffset;   // offset in _strings, path is null-terminated
+            std::uint32_t pathLength;
+            std::uint64_t size;
+            std::int64_t mtime;
+            std::uint32_t source;       // 0 for files of directories, 1 + index of archive for archive entries
+        };
+
+        struct Directory {
+            std::string path;
+            bool recursive;
+        };
+
+        void _add(const char *path, std::size_t length, std::uint64_t size, std::int64_t mtime, std::uint32_t source);
+        void _remove(const std::string &dirPath, bool recursive);
+        void _scan(const std::string &root, const std::string &relative, bool recursive);
+        void _sort();
+        void _compact();
+        FileInfo _info(const Record &record) const;
+
+        TrackedVector<Record, MemoryCategory::FILES> _records;
+        TrackedVector<char, MemoryCategory::FILES> _strings;
+        std::vector<Directory> _directories;
+        std::size_t _sortedCount;       // records before this index are sorted, the rest are added after the last sort
+        std::size_t _unusedStrings;     // bytes of _strings that belong to removed records
+        std::uint32_t _archiveCount;
+    };
+}
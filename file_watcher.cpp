@@ -0,0 +1,314 @@
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace {
+#ifdef __linux__
+    // IN_CREATE is used for directories only: created file is reported when it is closed after writing
+    constexpr std::uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_DELETE;
+    constexpr std::size_t EVENT_BUFFER_SIZE = 4096;
+#else
+    constexpr std::chrono::milliseconds POLL_PERIOD (500);
+
+    // nanoseconds: file saved twice within a second must be reported twice
+    std::int64_t getModificationTime(const struct stat &st) {
+    #ifdef __APPLE__
+        return std::int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+    #else
+        return std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    #endif
+    }
+#endif
+
+    std::string normalizeDirPath(const char *path) {
+        while (path[0] == '.' && path[1] == '/') {
+            path += 2;
+        }
+
+        std::size_t length = std::strlen(path);
+
+        while (length && path[length - 1] == '/') {
+            length--;
+        }
+
+        return length == 1 && path[0] == '.' ? std::string() : std::string(path, length);
+    }
+
+    std::string joinPath(const std::string &dir, const char *name) {
+        return dir.empty() ? std::string(name) : dir + "/" + name;
+    }
+
+    // links to directories aren't followed: they can form cycles. Link to file gets state of its target
+    bool getEntryState(const std::string &fullPath, struct stat &st) {
+        if (::lstat(fullPath.c_str(), &st) != 0) {
+            return false;
+        }
+        if (S_ISLNK(st.st_mode)) {
+            return ::stat(fullPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode) == false;
+        }
+
+        return true;
+    }
+
+    void sortUnique(std::vector<std::string> &paths, std::size_t first) {
+        std::sort(paths.begin() + first, paths.end());
+        paths.erase(std::unique(paths.begin() + first, paths.end()), paths.end());
+    }
+}
+
+namespace platform {
+    bool FileWatcher::isInDirectory(const std::string &filePath, const char *dirPath) {
+        const std::string dir = normalizeDirPath(dirPath);
+        return dir.empty() || (filePath.size() > dir.size() && filePath[dir.size()] == '/' && filePath.compare(0, dir.size(), dir) == 0);
+    }
+
+    std::string FileWatcher::_fullPath(const std::string &relative) const {
+        return relative.empty() ? _rootPath : _rootPath + "/" + relative;
+    }
+
+#ifdef __linux__
+    FileWatcher::FileWatcher(const char *rootPath) : _rootPath(rootPath), _fd(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {}
+
+    FileWatcher::~FileWatcher() {
+        if (_fd >= 0) {
+            ::close(_fd);
+        }
+    }
+
+    bool FileWatcher::watch(const char *dirPath) {
+        const std::string relative = normalizeDirPath(dirPath);
+
+        if (_fd >= 0 && _addWatch(relative, nullptr)) {
+            if (std::find(_roots.begin(), _roots.end(), relative) == _roots.end()) {
+                _roots.emplace_back(relative);
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void FileWatcher::takeChanges(std::vector<std::string> &paths) {
+        const std::size_t first = paths.size();
+        alignas(inotify_event) char buffer[EVENT_BUFFER_SIZE];
+        ssize_t length;
+        bool overflowed = false;
+
+        while (_fd >= 0 && (length = ::read(_fd, buffer, sizeof(buffer))) > 0) {
+            for (const char *ptr = buffer; ptr < buffer + length; ) {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    overflowed = true;
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    _watchDirs.erase(event->wd);
+                    continue;
+                }
+
+                auto dir = _watchDirs.find(event->wd);
+
+                if (dir == _watchDirs.end() || event->len == 0) {
+                    continue;
+                }
+
+                const std::string path = joinPath(dir->second, event->name);
+
+                if ((event->mask & IN_ISDIR) == 0) {
+                    // file can be still empty when it is created, it is reported by the following IN_CLOSE_WRITE
+                    if ((event->mask & IN_CREATE) == 0) {
+                        paths.emplace_back(path);
+                    }
+                }
+                else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    // files can appear before the watch is added, they are reported as created
+                    _addWatch(path, &paths);
+                }
+                else if (event->mask & IN_MOVED_FROM) {
+                    // moved out directory keeps its watches, they would report stale paths
+                    for (auto index = _watchDirs.begin(); index != _watchDirs.end(); ) {
+                        if (index->second.compare(0, path.size(), path) == 0 && (index->second.size() == path.size() || index->second[path.size()] == '/')) {
+                            ::inotify_rm_watch(_fd, index->first);
+                            index = _watchDirs.erase(index);
+                        }
+                        else {
+                            ++index;
+                        }
+                    }
+                }
+            }
+        }
+
+        // events are lost: every file is reported, watches are added again for directories created meanwhile
+        if (overflowed) {
+            for (const std::string &root : _roots) {
+                _addWatch(root, &paths);
+            }
+        }
+
+        sortUnique(paths, first);
+    }
+
+    bool FileWatcher::_addWatch(const std::string &relative, std::vector<std::string> *createdFiles) {
+        const std::string fullPath = _fullPath(relative);
+        const int wd = ::inotify_add_watch(_fd, fullPath.c_str(), WATCH_MASK | IN_ONLYDIR);
+
+        if (wd < 0) {
+            return false;
+        }
+
+        _watchDirs[wd] = relative;
+
+        if (DIR *dir = ::opendir(fullPath.c_str())) {
+            while (const dirent *entry = ::readdir(dir)) {
+                if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+                    continue;
+                }
+
+                const std::string path = joinPath(relative, entry->d_name);
+                struct stat st;
+
+                if (getEntryState(_fullPath(path), st)) {
+                    if (S_ISDIR(st.st_mode)) {
+                        _addWatch(path, createdFiles);
+                    }
+                    else if (createdFiles && S_ISREG(st.st_mode)) {
+                        createdFiles->emplace_back(path);
+                    }
+                }
+            }
+
+            ::closedir(dir);
+        }
+
+        return true;
+    }
+#else
+    FileWatcher::FileWatcher(const char *rootPath) : _rootPath(rootPath) {}
+
+    FileWatcher::~FileWatcher() {
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+            _stopped = true;
+        }
+
+        _wakeup.notify_all();
+
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    bool FileWatcher::watch(const char *dirPath) {
+        const std::string relative = normalizeDirPath(dirPath);
+        struct stat st;
+
+        if (::stat(_fullPath(relative).c_str(), &st) != 0 || S_ISDIR(st.st_mode) == false) {
+            return false;
+        }
+
+        Snapshot snapshot;
+        _scan(relative, snapshot);
+
+        std::lock_guard<std::mutex> guard(_guard);
+
+        if (std::find(_dirs.begin(), _dirs.end(), relative) == _dirs.end()) {
+            _dirs.emplace_back(relative);
+            _snapshots.emplace_back(std::move(snapshot));
+
+            if (_thread.joinable() == false) {
+                _thread = std::thread(&FileWatcher::_pollLoop, this);
+            }
+        }
+
+        return true;
+    }
+
+    void FileWatcher::takeChanges(std::vector<std::string> &paths) {
+        const std::size_t first = paths.size();
+
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+            paths.insert(paths.end(), _changes.begin(), _changes.end());
+            _changes.clear();
+        }
+
+        sortUnique(paths, first);
+    }
+
+    void FileWatcher::_scan(const std::string &relative, Snapshot &snapshot) const {
+        if (DIR *dir = ::opendir(_fullPath(relative).c_str())) {
+            while (const dirent *entry = ::readdir(dir)) {
+                if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+                    continue;
+                }
+
+                const std::string path = joinPath(relative, entry->d_name);
+                struct stat st;
+
+                if (getEntryState(_fullPath(path), st)) {
+                    if (S_ISDIR(st.st_mode)) {
+                        _scan(path, snapshot);
+                    }
+                    else if (S_ISREG(st.st_mode)) {
+                        snapshot[path] = FileState{getModificationTime(st), std::uint64_t(st.st_size)};
+                    }
+                }
+            }
+
+            ::closedir(dir);
+        }
+    }
+
+    void FileWatcher::_pollLoop() {
+        std::unique_lock<std::mutex> lock(_guard);
+
+        while (_wakeup.wait_for(lock, POLL_PERIOD, [this] { return _stopped; }) == false) {
+            const std::vector<std::string> dirs = _dirs;
+            std::vector<Snapshot> snapshots(dirs.size());
+
+            // scanning doesn't block watch() and takeChanges()
+            lock.unlock();
+
+            for (std::size_t i = 0; i < dirs.size(); i++) {
+                _scan(dirs[i], snapshots[i]);
+            }
+
+            lock.lock();
+
+            // directories are only appended, so indices of scanned ones are still valid
+            for (std::size_t i = 0; i < dirs.size(); i++) {
+                const Snapshot &previous = _snapshots[i];
+
+                for (const auto &file : snapshots[i]) {
+                    auto index = previous.find(file.first);
+
+                    if (index == previous.end() || index->second.mtime != file.second.mtime || index->second.size != file.second.size) {
+                        _changes.emplace_back(file.first);
+                    }
+                }
+                for (const auto &file : previous) {
+                    if (snapshots[i].count(file.first) == 0) {
+                        _changes.emplace_back(file.first);
+                    }
+                }
+
+                _snapshots[i] = std::move(snapshots[i]);
+            }
+        }
+    }
+#endif
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "interfaces.h"
+
+#include <unordered_map>
+
+#ifndef __linux__
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#endif
+
+namespace platform {
+    // Reports changed files of watched directory trees
+    // Linux uses inotify, its events are read without blocking by takeChanges(). Other systems compare sizes and modification
+    // times of files on background thread, so changes are reported with a delay up to the polling period
+    //
+    class FileWatcher {
+    public:
+        // @rootPath - directory that watched and reported paths are relative to
+        //
+        FileWatcher(const char *rootPath);
+        ~FileWatcher();
+
+        // Starts watching @dirPath and nested directories. Directories created later are watched too, symbolic links to
+        // directories aren't followed
+        // @dirPath - directory relative to root, "" for root. Example: "data/shaders"
+        // @return  - false if directory cannot be watched
+        //
+        bool watch(const char *dirPath);
+
+        // Appends paths of files that were changed, created or removed since the previous call. Every path is appended once
+        // Created file is appended when it is closed after writing or moved into watched directory
+        // If inotify queue has overflowed, watched directories are rescanned and all their files are appended, files removed
+        // before the rescan are lost. Example of path: "data/shaders/sky.txt"
+        //
+        void takeChanges(std::vector<std::string> &paths);
+
+        // @return true if @filePath is in @dirPath or its nested directories. @dirPath has the same form as for watch()
+        //
+        static bool isInDirectory(const std::string &filePath, const char *dirPath);
+
+    private:
+        std::string _fullPath(const std::string &relative) const;
+
+        const std::string _rootPath;
+
+    #ifdef __linux__
+        bool _addWatch(const std::string &relative, std::vector<std::string> *createdFiles);
+
+        int _fd;
+        std::unordered_map<int, std::string> _watchDirs;    // watch descriptor -> relative path of directory
+        std::vector<std::string> _roots;                    // directories passed to watch()
+    #else
+        struct FileState {
+            std::int64_t mtime;
+            std::uint64_t size;
+        };
+
+        using Snapshot = std::unordered_map<std::string, FileState>;
+
+        void _scan(const std::string &relative, Snapshot &snapshot) const;
+        void _pollLoop();
+
+        std::mutex _guard;
+        std::condition_variable _wakeup;
+        std::vector<std::string> _dirs;
+        std::vector<Snapshot> _snapshots;                   // one per directory of _dirs
+        std::vector<std::string> _changes;
+        std::thread _thread;
+        bool _stopped = false;
+    #endif
+    };
+}
@@ -0,0 +1,175 @@
+#include "frame_arena.h"
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace {
+    constexpr std::size_t BLOCK_SIZE_MIN = 64 * 1024;
+    constexpr std::uint8_t POISON_BYTE = 0xDD;
+
+    std::size_t roundBlockSize(std::size_t size) {
+        std::size_t result = BLOCK_SIZE_MIN;
+
+        while (result < size) {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+    std::uint8_t *alignPointer(std::uint8_t *ptr, std::size_t alignment) {
+        return reinterpret_cast<std::uint8_t *>((reinterpret_cast<std::uintptr_t>(ptr) + alignment - 1) & ~std::uintptr_t(alignment - 1));
+    }
+
+    // Memory of one frame. Written by the owner thread only
+    //
+    struct ArenaBlock {
+        std::unique_ptr<std::uint8_t[]> data;
+        std::size_t capacity = 0;
+        std::size_t used = 0;
+        std::size_t overflowBytes = 0;      // bytes that didn't fit since the last reset
+        std::vector<std::pair<std::unique_ptr<std::uint8_t[]>, std::size_t>> overflow;
+    };
+
+    // Counters are cumulative and written by the owner thread only, FrameArena::nextFrame turns them into per-frame values
+    //
+    struct ThreadArena {
+        ArenaBlock blocks[2];
+        std::uint64_t frame = 0;            // frame of the current block
+        std::size_t current = 0;
+
+        std::atomic<std::uint64_t> allocatedBytes {0};
+        std::atomic<std::uint64_t> overflowCount {0};
+        std::atomic<std::uint64_t> overflowBytes {0};
+        std::atomic<std::uint64_t> capacityBytes {0};
+        std::atomic<std::uint32_t> growCount {0};
+
+        // previous values of counters, main thread only
+        std::uint64_t lastAllocatedBytes = 0;
+        std::uint64_t lastOverflowCount = 0;
+        std::uint64_t lastOverflowBytes = 0;
+
+        void add(std::atomic<std::uint64_t> &counter, std::uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        // Frees overflow of the previous use and enlarges block, so the same amount of memory fits without heap next time
+        void reset(ArenaBlock &block) {
+        #ifndef NDEBUG
+            if (block.data) {
+                std::memset(block.data.get(), POISON_BYTE, block.used);
+            }
+        #endif
+
+            for (const auto &chunk : block.overflow) {
+                platform::MemoryTracker::freed(platform::MemoryCategory::FRAME_ARENA, chunk.second);
+            }
+
+            block.overflow.clear();
+
+            if (block.overflowBytes || block.data == nullptr) {
+                const std::size_t capacity = roundBlockSize(block.used + block.overflowBytes);
+
+                if (block.data) {
+                    platform::MemoryTracker::freed(platform::MemoryCategory::FRAME_ARENA, block.capacity);
+                    growCount.store(growCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                }
+
+                add(capacityBytes, capacity - block.capacity);
+                block.data.reset(new std::uint8_t[capacity]);
+                block.capacity = capacity;
+                platform::MemoryTracker::allocated(platform::MemoryCategory::FRAME_ARENA, capacity);
+            }
+
+            block.used = 0;
+            block.overflowBytes = 0;
+        }
+
+        void *allocate(std::size_t size, std::size_t alignment, std::uint64_t currentFrame) {
+            if (frame != currentFrame) {
+                // the other block has data of the previous frame, this one is at least two frames old
+                current = std::size_t(currentFrame & 1);
+                frame = currentFrame;
+                reset(blocks[current]);
+            }
+
+            ArenaBlock &block = blocks[current];
+            std::uint8_t *begin = block.data.get();
+            std::uint8_t *result = alignPointer(begin + block.used, alignment);
+
+            add(allocatedBytes, size);
+
+            if (std::size_t(result - begin) + size <= block.capacity) {
+                block.used = std::size_t(result - begin) + size;
+                return result;
+            }
+
+            const std::size_t chunkSize = size + alignment;
+            block.overflow.emplace_back(std::unique_ptr<std::uint8_t[]>(new std::uint8_t[chunkSize]), chunkSize);
+            block.overflowBytes += chunkSize;
+            platform::MemoryTracker::allocated(platform::MemoryCategory::FRAME_ARENA, chunkSize);
+
+            add(overflowCount, 1);
+            add(overflowBytes, size);
+            return alignPointer(block.overflow.back().first.get(), alignment);
+        }
+    };
+
+    // Arenas live until exit, threads can finish at any time
+    std::mutex _arenasGuard;
+    std::vector<std::unique_ptr<ThreadArena>> _arenas;
+
+    ThreadArena &getThreadArena() {
+        static thread_local ThreadArena *arena = nullptr;
+
+        if (arena == nullptr) {
+            std::unique_ptr<ThreadArena> created (new ThreadArena);
+            arena = created.get();
+
+            std::lock_guard<std::mutex> guard(_arenasGuard);
+            _arenas.emplace_back(std::move(created));
+        }
+
+        return *arena;
+    }
+}
+
+namespace platform {
+    void *FrameArena::allocate(std::size_t size, std::size_t alignment) {
+        return getThreadArena().allocate(size, alignment, _frame.load(std::memory_order_relaxed));
+    }
+
+    void FrameArena::nextFrame() {
+        FrameArenaStats stats {};
+
+        {
+            std::lock_guard<std::mutex> guard(_arenasGuard);
+
+            for (const auto &arena : _arenas) {
+                const std::uint64_t allocatedBytes = arena->allocatedBytes.load(std::memory_order_relaxed);
+                const std::uint64_t overflowCount = arena->overflowCount.load(std::memory_order_relaxed);
+                const std::uint64_t overflowBytes = arena->overflowBytes.load(std::memory_order_relaxed);
+
+                stats.capacityBytes += arena->capacityBytes.load(std::memory_order_relaxed);
+                stats.frameBytes += allocatedBytes - arena->lastAllocatedBytes;
+                stats.overflowCount += std::uint32_t(overflowCount - arena->lastOverflowCount);
+                stats.overflowBytes += overflowBytes - arena->lastOverflowBytes;
+                stats.growCount += arena->growCount.load(std::memory_order_relaxed);
+
+                arena->lastAllocatedBytes = allocatedBytes;
+                arena->lastOverflowCount = overflowCount;
+                arena->lastOverflowBytes = overflowBytes;
+            }
+        }
+
+        stats.peakFrameBytes = std::max(_stats.peakFrameBytes, stats.frameBytes);
+        _stats = stats;
+        _frame.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    FrameArenaStats FrameArena::getStats() const {
+        return _stats;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "interfaces.h"
+
+#include <atomic>
+
+namespace platform {
+    // Per-thread double-buffered bump allocator for Platform::allocFrameMemory
+    // Every thread owns two blocks and switches them itself when it allocates in a new frame, so allocation never locks and
+    // run() only advances the frame counter
+    //
+    class FrameArena {
+    public:
+        // Thread-safe
+        //
+        void *allocate(std::size_t size, std::size_t alignment);
+
+        // Called by run() before every frame. Starts the next frame and collects statistics of the previous one
+        //
+        void nextFrame();
+
+        FrameArenaStats getStats() const;
+
+    private:
+        std::atomic<std::uint64_t> _frame {1};
+        FrameArenaStats _stats {};
+    };
+}
@@ -0,0 +1,177 @@
+
+#include "frame_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace {
+    // sleep can overshoot by scheduler quantum, the rest of waiting is done with yield
+    constexpr double SLEEP_MARGIN_SEC = 0.001;
+
+    // gap between predicted end of work and the end of display interval in low latency mode
+    constexpr double LOW_LATENCY_MARGIN_SEC = 0.002;
+
+    // predicted work time follows longer frames at once and shorter ones slowly
+    constexpr double WORK_PREDICTION_DECAY = 0.05;
+}
+
+namespace platform {
+    FrameScheduler::FrameScheduler() : _lastActivity(Clock::now().time_since_epoch().count()) {
+        getHistogram(true);
+    }
+
+    void FrameScheduler::setPacing(const FramePacing &pacing) {
+        _pacing = pacing;
+
+        if (_pacing.fixedStepSec <= 0.0f) {
+            _pacing.fixedStepSec = FramePacing().fixedStepSec;
+        }
+
+        notifyActivity();
+    }
+
+    const FramePacing &FrameScheduler::getPacing() const {
+        return _pacing;
+    }
+
+    void FrameScheduler::notifyActivity() {
+        _lastActivity.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    float FrameScheduler::getFrameRate() const {
+        if (_pacing.idleFrameRate > 0.0f) {
+            const Clock::duration idleTime = Clock::now().time_since_epoch() - Clock::duration(_lastActivity.load(std::memory_order_relaxed));
+
+            if (std::chrono::duration<float>(idleTime).count() > _pacing.idleDelaySec) {
+                return _pacing.targetFrameRate > 0.0f ? std::min(_pacing.targetFrameRate, _pacing.idleFrameRate) : _pacing.idleFrameRate;
+            }
+        }
+
+        return _pacing.targetFrameRate;
+    }
+
+    void FrameScheduler::waitForFrame() {
+        const float frameRate = getFrameRate();
+        const double periodSec = frameRate > 0.0f ? 1.0 / frameRate : 0.0;
+        const Clock::time_point now = Clock::now();
+        const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(periodSec));
+
+        if (_started == false || periodSec <= 0.0 || _pacing.virtualDtSec > 0.0f) {
+            return;
+        }
+
+        // frames are aligned to slots of period length. After a stall the slots restart from now instead of catching up
+        _slot += period;
+
+        if (_slot + period < now) {
+            _slot = now;
+        }
+
+        Clock::time_point start = _slot;
+
+        if (_pacing.latencyMode == FrameLatencyMode::LOW) {
+            start += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_getLowLatencyDelaySec(periodSec)));
+        }
+
+        _sleepUntil(start);
+    }
+
+    float FrameScheduler::beginFrame() {
+        const Clock::time_point now = Clock::now();
+        float dtSec = 0.0f;
+
+        if (_started) {
+            dtSec = std::chrono::duration<float>(now - _frameStart).count();
+
+            const std::size_t bucket = std::min(std::size_t(dtSec / FrameTimeHistogram::BUCKET_SEC), std::size_t(FrameTimeHistogram::BUCKET_COUNT - 1));
+
+            _histogram.buckets[bucket]++;
+            _histogram.minSec = _histogram.frameCount ? std::min(_histogram.minSec, dtSec) : dtSec;
+            _histogram.maxSec = std::max(_histogram.maxSec, dtSec);
+            _histogram.frameCount++;
+            _intervalSumSec += dtSec;
+        }
+        else {
+            _started = true;
+            _slot = now;
+        }
+
+        _frameStart = now;
+        return _pacing.virtualDtSec > 0.0f ? _pacing.virtualDtSec : dtSec;
+    }
+
+    void FrameScheduler::endFrame() {
+        const double workSec = std::chrono::duration<double>(Clock::now() - _frameStart).count();
+
+        if (workSec > _predictedWorkSec) {
+            _predictedWorkSec = workSec;
+        }
+        else {
+            _predictedWorkSec += (workSec - _predictedWorkSec) * WORK_PREDICTION_DECAY;
+        }
+
+        _workSumSec += workSec;
+        _workCount++;
+    }
+
+    std::uint32_t FrameScheduler::takeFixedSteps(float dtSec) {
+        const double stepSec = _pacing.fixedStepSec;
+        _accumulatorSec += dtSec;
+
+        std::uint32_t stepCount = std::uint32_t(_accumulatorSec / stepSec);
+
+        if (stepCount > _pacing.maxFixedSteps) {
+            // simulation can't keep up, the time that isn't simulated is dropped
+            stepCount = _pacing.maxFixedSteps;
+            _accumulatorSec = std::fmod(_accumulatorSec, stepSec);
+        }
+        else {
+            _accumulatorSec -= stepCount * stepSec;
+        }
+
+        return stepCount;
+    }
+
+    float FrameScheduler::getInterpolationAlpha() const {
+        return std::min(float(_accumulatorSec / _pacing.fixedStepSec), 1.0f - std::numeric_limits<float>::epsilon());
+    }
+
+    FrameTimeHistogram FrameScheduler::getHistogram(bool reset) {
+        FrameTimeHistogram result = _histogram;
+
+        result.meanSec = result.frameCount ? float(_intervalSumSec / double(result.frameCount)) : 0.0f;
+        result.meanWorkSec = _workCount ? float(_workSumSec / double(_workCount)) : 0.0f;
+
+        if (reset) {
+            std::memset(_histogram.buckets, 0, sizeof(_histogram.buckets));
+            _histogram.frameCount = 0;
+            _histogram.minSec = 0.0f;
+            _histogram.maxSec = 0.0f;
+            _histogram.meanSec = 0.0f;
+            _histogram.meanWorkSec = 0.0f;
+            _intervalSumSec = 0.0;
+            _workSumSec = 0.0;
+            _workCount = 0;
+        }
+
+        return result;
+    }
+
+    void FrameScheduler::_sleepUntil(Clock::time_point time) {
+        const Clock::time_point sleepEnd = time - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SLEEP_MARGIN_SEC));
+
+        if (Clock::now() < sleepEnd) {
+            std::this_thread::sleep_until(sleepEnd);
+        }
+        while (Clock::now() < time) {
+            std::this_thread::yield();
+        }
+    }
+
+    double FrameScheduler::_getLowLatencyDelaySec(double periodSec) const {
+        return std::max(periodSec - _predictedWorkSec - LOW_LATENCY_MARGIN_SEC, 0.0);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "interfaces.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace platform {
+    // Frame pacing for run(): waiting for frame start, fixed timestep accumulation and frame time statistics
+    // Methods except notifyActivity() are called on the thread that runs run()
+    //
+    class FrameScheduler {
+    public:
+        FrameScheduler();
+
+        void setPacing(const FramePacing &pacing);
+        const FramePacing &getPacing() const;
+
+        // Thread-safe
+        //
+        void notifyActivity();
+
+        // Target or idle frame rate, 0 - unlimited
+        //
+        float getFrameRate() const;
+
+        // Sleeps until the next frame should start. Frames with virtual delta time don't wait
+        // Not used when frame interval is controlled by display
+        //
+        void waitForFrame();
+
+        // Histogram gets real time anyway
+        // @return - time since start of the previous frame in seconds (0 for the first frame) or virtual delta time
+        //
+        float beginFrame();
+        void endFrame();
+
+        // Adds @dtSec to simulation time
+        // @return - count of fixed steps to simulate now, time less than a step is left for the next frame
+        //
+        std::uint32_t takeFixedSteps(float dtSec);
+        float getInterpolationAlpha() const;
+
+        FrameTimeHistogram getHistogram(bool reset);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void _sleepUntil(Clock::time_point time);
+        double _getLowLatencyDelaySec(double periodSec) const;
+
+        FramePacing _pacing;
+        std::atomic<Clock::rep> _lastActivity;
+        Clock::time_point _slot;
+        Clock::time_point _frameStart;
+        bool _started = false;
+        double _predictedWorkSec = 0.0;
+        double _accumulatorSec = 0.0;
+
+        FrameTimeHistogram _histogram;
+        double _intervalSumSec = 0.0;
+        double _workSumSec = 0.0;
+        std::uint64_t _workCount = 0;
+    };
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace platform {
+    template<typename Signature, std::size_t CAPACITY> class InplaceFunction;
+
+    // Move-only callable wrapper that stores callable object in internal buffer of @CAPACITY bytes
+    // Callables that don't fit or can throw while moving are allocated on heap
+    //
+    template<typename R, typename... Args, std::size_t CAPACITY> class InplaceFunction<R(Args...), CAPACITY> {
+    public:
+        InplaceFunction() = default;
+        InplaceFunction(std::nullptr_t) {}
+
+        template<typename F, typename = typename std::enable_if<std::is_same<typename std::decay<F>::type, InplaceFunction>::value == false>::type>
+        InplaceFunction(F &&f) {
+            using Callable = typename std::decay<F>::type;
+
+            if (_isEmpty(f) == false) {
+                _init<Callable>(std::forward<F>(f), std::integral_constant<bool, _isInplace<Callable>()>());
+            }
+        }
+
+        InplaceFunction(InplaceFunction &&other) {
+            _moveFrom(other);
+        }
+
+        InplaceFunction &operator =(InplaceFunction &&other) {
+            if (this != &other) {
+                _reset();
+                _moveFrom(other);
+            }
+
+            return *this;
+        }
+
+        InplaceFunction &operator =(std::nullptr_t) {
+            _reset();
+            return *this;
+        }
+
+        ~InplaceFunction() {
+            _reset();
+        }
+
+        explicit operator bool() const {
+            return _vtable != nullptr;
+        }
+
+        R operator()(Args... args) const {
+            return _vtable->call(const_cast<void *>(static_cast<const void *>(&_storage)), std::forward<Args>(args)...);
+        }
+
+    private:
+        InplaceFunction(const InplaceFunction &) = delete;
+        InplaceFunction &operator =(const InplaceFunction &) = delete;
+
+        struct VTable {
+            R (*call)(void *storage, Args &&... args);
+            void (*move)(void *dst, void *src);
+            void (*destroy)(void *storage);
+        };
+
+        template<typename Callable> static constexpr bool _isInplace() {
+            return sizeof(Callable) <= CAPACITY && alignof(Callable) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<Callable>::value;
+        }
+
+        template<typename F> static bool _isEmpty(const F &) {
+            return false;
+        }
+        template<typename S> static bool _isEmpty(const std::function<S> &f) {
+            return !f;
+        }
+        template<typename T> static bool _isEmpty(T *f) {
+            return f == nullptr;
+        }
+
+        template<typename Callable, typename F> void _init(F &&f, std::true_type) {
+            static const VTable vtable = {
+                [](void *storage, Args &&... args) -> R {
+                    return (*static_cast<Callable *>(storage))(std::forward<Args>(args)...);
+                },
+                [](void *dst, void *src) {
+                    new (dst) Callable(std::move(*static_cast<Callable *>(src)));
+                    static_cast<Callable *>(src)->~Callable();
+                },
+                [](void *storage) {
+                    static_cast<Callable *>(storage)->~Callable();
+                },
+            };
+
+            new (&_storage) Callable(std::forward<F>(f));
+            _vtable = &vtable;
+        }
+
+        template<typename Callable, typename F> void _init(F &&f, std::false_type) {
+            static const VTable vtable = {
+                [](void *storage, Args &&... args) -> R {
+                    return (**static_cast<Callable **>(storage))(std::forward<Args>(args)...);
+                },
+                [](void *dst, void *src) {
+                    *static_cast<Callable **>(dst) = *static_cast<Callable **>(src);
+                },
+                [](void *storage) {
+                    delete *static_cast<Callable **>(storage);
+                },
+            };
+
+            *reinterpret_cast<Callable **>(&_storage) = new Callable(std::forward<F>(f));
+            _vtable = &vtable;
+        }
+
+        void _moveFrom(InplaceFunction &other) {
+            if (other._vtable) {
+                other._vtable->move(&_storage, &other._storage);
+                _vtable = other._vtable;
+                other._vtable = nullptr;
+            }
+        }
+
+        void _reset() {
+            if (_vtable) {
+                _vtable->destroy(&_storage);
+                _vtable = nullptr;
+            }
+        }
+
+        typename std::aligned_storage<CAPACITY < sizeof(void *) ? sizeof(void *) : CAPACITY, alignof(std::max_align_t)>::type _storage;
+        const VTable *_vtable = nullptr;
+    };
+}
@@ -0,0 +1,50 @@
+
+#include "input_queue.h"
+
+#include <algorithm>
+
+namespace platform {
+    void InputQueue::push(const InputEvent &event) {
+        _queued.emplace_back(event);
+    }
+
+    InputBatch InputQueue::flush() {
+        _raw.swap(_queued);
+        _queued.clear();
+        _events.clear();
+        _openMoves.clear();
+
+        for (const InputEvent &event : _raw) {
+            const bool isTouch = event.type == InputEventType::TOUCH_START || event.type == InputEventType::TOUCH_MOVE || event.type == InputEventType::TOUCH_FINISH;
+            const bool isMouse = event.type == InputEventType::MOUSE_PRESS || event.type == InputEventType::MOUSE_MOVE || event.type == InputEventType::MOUSE_RELEASE;
+
+            if (isTouch || isMouse) {
+                const std::size_t touchID = isTouch ? event.touch.touchID : 0;
+                auto open = std::find_if(_openMoves.begin(), _openMoves.end(), [isMouse, touchID](const OpenMove &item) {
+                    return item.mouse == isMouse && item.touchID == touchID;
+                });
+
+                if (event.type == InputEventType::TOUCH_MOVE || event.type == InputEventType::MOUSE_MOVE) {
+                    if (open != _openMoves.end()) {
+                        InputEvent &merged = _events[open->index];
+                        const std::uint32_t count = merged.coalescedCount + event.coalescedCount;
+
+                        merged = event;
+                        merged.coalescedCount = count;
+                        continue;
+                    }
+
+                    _openMoves.emplace_back(OpenMove{isMouse, touchID, _events.size()});
+                }
+                else if (open != _openMoves.end()) {
+                    // start/finish/press/release keeps the order of moves around it
+                    _openMoves.erase(open);
+                }
+            }
+
+            _events.emplace_back(event);
+        }
+
+        return InputBatch{_events.data(), _events.size(), _raw.data(), _raw.size()};
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "interfaces.h"
+#include "memory_tracker.h"
+
+namespace platform {
+    // Queue of input events for batched input mode
+    // Consecutive move events of the same touch or mouse are merged into one event that has the latest position and time.
+    // Events of other touches between them don't break merging
+    //
+    class InputQueue {
+    public:
+        void push(const InputEvent &event);
+
+        // Forms batch from events pushed since the previous call. Batch is valid until the next call
+        // Events pushed while batch is handled go to the next batch
+        //
+        InputBatch flush();
+
+    private:
+        // pointer (touch or mouse) that has merged move event in _events
+        struct OpenMove {
+            bool mouse;
+            std::size_t touchID;
+            std::size_t index;
+        };
+
+        TrackedVector<InputEvent, MemoryCategory::INPUT> _queued;
+        TrackedVector<InputEvent, MemoryCategory::INPUT> _raw;
+        TrackedVector<InputEvent, MemoryCategory::INPUT> _events;
+        TrackedVector<OpenMove, MemoryCategory::INPUT> _openMoves;
+    };
+}
@@ -0,0 +1,161 @@
+
+#include "input_record.h"
+
+#include <cstring>
+
+namespace {
+    const char INPUT_RECORD_MAGIC[4] = {'I', 'N', 'R', 'C'};
+    constexpr std::uint32_t INPUT_RECORD_VERSION = 1;
+
+    constexpr std::uint8_t MODIFIER_ALT = 1;
+    constexpr std::uint8_t MODIFIER_SHIFT = 2;
+    constexpr std::uint8_t MODIFIER_CTRL = 4;
+    constexpr std::uint8_t BUTTON_LEFT = 1;
+    constexpr std::uint8_t BUTTON_RIGHT = 2;
+}
+
+namespace platform {
+    InputRecorder::InputRecorder(const char *filePath) : _stream(filePath, std::ios::binary | std::ios::out | std::ios::trunc), _startTime(std::chrono::steady_clock::now()) {
+        _buffer.insert(_buffer.end(), INPUT_RECORD_MAGIC, INPUT_RECORD_MAGIC + sizeof(INPUT_RECORD_MAGIC));
+        _put(INPUT_RECORD_VERSION);
+    }
+
+    bool InputRecorder::isValid() const {
+        return _stream.good();
+    }
+
+    float InputRecorder::getTimeSec() const {
+        return std::chrono::duration<float>(std::chrono::steady_clock::now() - _startTime).count();
+    }
+
+    void InputRecorder::write(const InputRecord &record) {
+        _put(record.type);
+
+        if (record.type != InputRecordType::FRAME) {
+            _put(record.timeSec);
+        }
+
+        switch (record.type) {
+            case InputRecordType::FRAME:
+                _put(record.dtSec);
+                break;
+            case InputRecordType::KEY_DOWN:
+            case InputRecordType::KEY_UP:
+                _put(std::uint8_t(record.keyboard.key));
+                _put(std::uint8_t((record.keyboard.alt ? MODIFIER_ALT : 0) | (record.keyboard.shift ? MODIFIER_SHIFT : 0) | (record.keyboard.ctrl ? MODIFIER_CTRL : 0)));
+                break;
+            case InputRecordType::INPUT:
+                _buffer.insert(_buffer.end(), record.utf8char, record.utf8char + 4);
+                break;
+            case InputRecordType::MOUSE_PRESS:
+            case InputRecordType::MOUSE_MOVE:
+            case InputRecordType::MOUSE_RELEASE:
+                _put(record.mouse.coordinateX);
+                _put(record.mouse.coordinateY);
+                _put(std::uint8_t((record.mouse.isLeftButtonPressed ? BUTTON_LEFT : 0) | (record.mouse.isRightButtonPressed ? BUTTON_RIGHT : 0)));
+                break;
+            case InputRecordType::TOUCH_START:
+            case InputRecordType::TOUCH_MOVE:
+            case InputRecordType::TOUCH_FINISH:
+                _put(record.touch.coordinateX);
+                _put(record.touch.coordinateY);
+                _put(std::uint64_t(record.touch.touchID));
+                break;
+            default:
+                break;
+        }
+
+        if (record.type == InputRecordType::FRAME && _stream.good()) {
+            _stream.write(reinterpret_cast<const char *>(_buffer.data()), _buffer.size());
+            _stream.flush();
+            _buffer.clear();
+        }
+    }
+
+    template<typename T> void InputRecorder::_put(const T &value) {
+        const std::uint8_t *bytes = reinterpret_cast<const std::uint8_t *>(&value);
+        _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    InputReplay::InputReplay(std::unique_ptr<std::uint8_t[]> &&data, std::size_t size) : _data(std::move(data)), _size(size), _offset(0), _valid(false) {
+        char magic[sizeof(INPUT_RECORD_MAGIC)];
+        std::uint32_t version = 0;
+
+        if (_get(magic) && _get(version)) {
+            _valid = std::memcmp(magic, INPUT_RECORD_MAGIC, sizeof(magic)) == 0 && version == INPUT_RECORD_VERSION;
+        }
+    }
+
+    bool InputReplay::isValid() const {
+        return _valid;
+    }
+
+    bool InputReplay::nextFrame(float &dtSec, const std::function<void(const InputRecord &)> &visitor) {
+        InputRecord record;
+        std::uint8_t value = 0;
+
+        while (_valid && _get(record.type)) {
+            if (record.type == InputRecordType::FRAME) {
+                return _get(dtSec);
+            }
+            if (record.type >= InputRecordType::_count || _get(record.timeSec) == false) {
+                break;
+            }
+
+            bool complete = true;
+
+            switch (record.type) {
+                case InputRecordType::KEY_DOWN:
+                case InputRecordType::KEY_UP:
+                    complete = _get(value);
+                    record.keyboard.key = KeyboardKey(value);
+                    complete = complete && _get(value);
+                    record.keyboard.alt = (value & MODIFIER_ALT) != 0;
+                    record.keyboard.shift = (value & MODIFIER_SHIFT) != 0;
+                    record.keyboard.ctrl = (value & MODIFIER_CTRL) != 0;
+                    break;
+                case InputRecordType::INPUT:
+                    complete = _get(record.utf8char);
+                    break;
+                case InputRecordType::MOUSE_PRESS:
+                case InputRecordType::MOUSE_MOVE:
+                case InputRecordType::MOUSE_RELEASE:
+                    complete = _get(record.mouse.coordinateX) && _get(record.mouse.coordinateY) && _get(value);
+                    record.mouse.isLeftButtonPressed = (value & BUTTON_LEFT) != 0;
+                    record.mouse.isRightButtonPressed = (value & BUTTON_RIGHT) != 0;
+                    break;
+                case InputRecordType::TOUCH_START:
+                case InputRecordType::TOUCH_MOVE:
+                case InputRecordType::TOUCH_FINISH:
+                {
+                    std::uint64_t touchID = 0;
+                    complete = _get(record.touch.coordinateX) && _get(record.touch.coordinateY) && _get(touchID);
+                    record.touch.touchID = std::size_t(touchID);
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            if (complete == false) {
+                break;
+            }
+
+            visitor(record);
+        }
+
+        // replay ends after the last record or on truncated one
+        _valid = false;
+        return false;
+    }
+
+    template<typename T> bool InputReplay::_get(T &value) {
+        if (_offset + sizeof(T) <= _size) {
+            std::memcpy(&value, _data.get() + _offset, sizeof(T));
+            _offset += sizeof(T);
+            return true;
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "interfaces.h"
+#include "memory_tracker.h"
+
+#include <chrono>
+#include <fstream>
+
+// Input record layout (little-endian):
+//
+//     char[4] "INRC", std::uint32_t version
+//     records                        - std::uint8_t type, then payload of the type:
+//         FRAME                      - float dtSec. Events before the record are dispatched before updateAndDraw of the frame
+//         KEY_DOWN, KEY_UP           - float timeSec, std::uint8_t key, std::uint8_t modifiers (1 - alt, 2 - shift, 4 - ctrl)
+//         INPUT                      - float timeSec, char[4] utf8char
+//         BACKSPACE                  - float timeSec
+//         MOUSE_*                    - float timeSec, float x, float y, std::uint8_t buttons (1 - left, 2 - right)
+//         TOUCH_*                    - float timeSec, float x, float y, std::uint64_t touchID
+//
+// timeSec is time since start of recording. Frame index of event is the count of FRAME records before it
+
+namespace platform {
+    enum class InputRecordType : std::uint8_t {
+        FRAME = 0,
+        KEY_DOWN,
+        KEY_UP,
+        INPUT,
+        BACKSPACE,
+        MOUSE_PRESS,
+        MOUSE_MOVE,
+        MOUSE_RELEASE,
+        TOUCH_START,
+        TOUCH_MOVE,
+        TOUCH_FINISH,
+        _count
+    };
+
+    struct InputRecord {
+        InputRecordType type;
+        float timeSec;                      // not used by FRAME
+
+        union {
+            float dtSec;                    // FRAME
+            KeyboardEventArgs keyboard;     // KEY_*
+            char utf8char[4];               // INPUT
+            MouseEventArgs mouse;           // MOUSE_*
+            TouchEventArgs touch;           // TOUCH_*
+        };
+    };
+
+    // Writes input records to file
+    //
+    class InputRecorder {
+    public:
+        InputRecorder(const char *filePath);
+
+        bool isValid() const;
+
+        // Time for InputRecord::timeSec
+        //
+        float getTimeSec() const;
+
+        // Records are buffered in memory and written to file by every FRAME record
+        //
+        void write(const InputRecord &record);
+
+    private:
+        template<typename T> void _put(const T &value);
+
+        std::ofstream _stream;
+        TrackedVector<std::uint8_t, MemoryCategory::INPUT> _buffer;
+        std::chrono::steady_clock::time_point _startTime;
+    };
+
+    // Reads input records from file contents written by InputRecorder
+    //
+    class InputReplay {
+    public:
+        InputReplay(std::unique_ptr<std::uint8_t[]> &&data, std::size_t size);
+
+        bool isValid() const;
+
+        // Calls @visitor for events of the next frame
+        // @dtSec  - recorded delta time of the frame
+        // @return - false if there are no more frames
+        //
+        bool nextFrame(float &dtSec, const std::function<void(const InputRecord &)> &visitor);
+
+    private:
+        template<typename T> bool _get(T &value);
+
+        std::unique_ptr<std::uint8_t[]> _data;
+        std::size_t _size;
+        std::size_t _offset;
+        bool _valid;
+    };
+}
@@ -1,15 +1,60 @@
 #pragma once
 
 // TODO: graphic state control
-// TODO: sound
 // TODO: joystick
 // TODO: tests
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
 #include <functional>
+#include <initializer_list>
+
+#include "inplace_function.h"
+
+// Log messages with level below PLATFORM_LOG_LEVEL are removed at compile time
+// 0 - all messages, 1 - warnings and errors, 2 - errors, 3 - nothing
+#ifndef PLATFORM_LOG_LEVEL
+#define PLATFORM_LOG_LEVEL 0
+#endif
+
+// Logging through pointer to platform. Example: PLATFORM_LOG_ERROR(_platform, "File %s is not found", path)
+// Below PLATFORM_LOG_LEVEL macro expands to no-op, so its arguments are not evaluated
+#if PLATFORM_LOG_LEVEL <= 0
+#define PLATFORM_LOG_INFO(instance, ...) (instance)->logInfo(__VA_ARGS__)
+#else
+#define PLATFORM_LOG_INFO(instance, ...) ((void)0)
+#endif
+
+#if PLATFORM_LOG_LEVEL <= 1
+#define PLATFORM_LOG_WARNING(instance, ...) (instance)->logWarning(__VA_ARGS__)
+#else
+#define PLATFORM_LOG_WARNING(instance, ...) ((void)0)
+#endif
+
+#if PLATFORM_LOG_LEVEL <= 2
+#define PLATFORM_LOG_ERROR(instance, ...) (instance)->logError(__VA_ARGS__)
+#else
+#define PLATFORM_LOG_ERROR(instance, ...) ((void)0)
+#endif
+
+// Profiling zones are compiled only with PLATFORM_PROFILER=1. Otherwise PLATFORM_PROFILE_ZONE expands to nothing
+#ifndef PLATFORM_PROFILER
+#define PLATFORM_PROFILER 0
+#endif
+
+#define PLATFORM_CONCAT_IMPL(a, b) a##b
+#define PLATFORM_CONCAT(a, b) PLATFORM_CONCAT_IMPL(a, b)
+
+#if PLATFORM_PROFILER
+#define PLATFORM_PROFILE_ZONE(name) platform::ProfileZone PLATFORM_CONCAT(_profileZone, __LINE__) (name)
+#define PLATFORM_COUNTER_ZONE(name) platform::CounterZone PLATFORM_CONCAT(_counterZone, __LINE__) (name)
+#else
+#define PLATFORM_PROFILE_ZONE(name)
+#define PLATFORM_COUNTER_ZONE(name)
+#endif
 
 namespace platform {
     struct Base {
@@ -56,29 +101,395 @@ namespace platform {
     struct GamepadEventArgs {
     };
     
+    enum class InputEventType {
+        TOUCH_START = 0,
+        TOUCH_MOVE,
+        TOUCH_FINISH,
+        MOUSE_PRESS,
+        MOUSE_MOVE,
+        MOUSE_RELEASE,
+        KEY_DOWN,
+        KEY_UP,
+        _count
+    };
+    
+    // Input event of batched input mode
+    //
+    struct InputEvent {
+        InputEventType type;
+        std::uint32_t coalescedCount;       // count of raw events merged into this one, 1 for not merged event
+        double timeSec;                     // monotonic time of the event (of the latest merged one) in seconds
+        
+        union {
+            TouchEventArgs touch;           // TOUCH_*
+            MouseEventArgs mouse;           // MOUSE_*
+            KeyboardEventArgs keyboard;     // KEY_*
+        };
+    };
+    
+    // Input events received during the previous frame
+    //
+    struct InputBatch {
+        const InputEvent *events;           // consecutive move events of the same touch or mouse are merged
+        std::size_t count;
+        const InputEvent *rawEvents;        // all events in order of arrival
+        std::size_t rawCount;
+    };
+    
+    enum class FrameLatencyMode {
+        DEFAULT = 0,    // frame starts as soon as the previous frame interval ends
+        LOW,            // frame starts as late as predicted work time allows, input is sampled closer to presentation. POSIX only, iOS uses DEFAULT
+    };
+    
+    // Frame pacing of run()
+    //
+    struct FramePacing {
+        float targetFrameRate = 60.0f;      // frames per second, 0 - unlimited (POSIX) or maximum of display (iOS)
+        float fixedStepSec = 1.0f / 60.0f;  // time step of fixed timestep run()
+        std::uint32_t maxFixedSteps = 8;    // fixed steps per frame limit, simulation falls behind after longer stalls
+        FrameLatencyMode latencyMode = FrameLatencyMode::DEFAULT;
+        float idleFrameRate = 0.0f;         // frame rate when there is no activity, 0 - no idle throttling
+        float idleDelaySec = 2.0f;          // time without input or notifyActivity() after which frame rate is throttled
+        float virtualDtSec = 0.0f;          // if positive, every frame gets this delta time. POSIX runs such frames without waiting
+        float postBudgetSec = 0.002f;       // time per frame for tasks of Platform::post, the rest waits for the next frames
+    };
+    
+    // Statistics of intervals between frames
+    //
+    struct FrameTimeHistogram {
+        static constexpr std::size_t BUCKET_COUNT = 64;
+        static constexpr float BUCKET_SEC = 0.0005f;
+        
+        std::uint32_t buckets[BUCKET_COUNT];    // bucket i counts intervals in [i, i + 1) * BUCKET_SEC, the last one counts longer ones too
+        std::uint64_t frameCount;
+        float minSec;
+        float maxSec;
+        float meanSec;
+        float meanWorkSec;                      // mean time from start of frame to the end of updateAndDraw
+    };
+    
     using EventHandlersToken = unsigned char *;
     
+    // Callable for event handlers. Lambdas with captures up to 48 bytes are stored without heap allocation
+    //
+    template<typename Signature> using EventHandler = InplaceFunction<Signature, 48>;
+    
+    enum class LogLevel {
+        INFO = 0,
+        WARNING,
+        ERROR,
+        _count
+    };
+    
+    // Expected access pattern of mapped file. Used as a hint for OS read-ahead
+    //
+    enum class FileAccess {
+        SEQUENTIAL = 0,     // file is read from begin to end, aggressive read-ahead
+        RANDOM,             // file is read in arbitrary order, read-ahead is disabled
+        _count
+    };
+    
+    // Priority of asynchronous file load request. Requests with higher priority are read first
+    //
+    enum class LoadPriority {
+        LOW = 0,
+        NORMAL,
+        HIGH,
+        _count
+    };
+    
+    using FileLoadToken = std::uint64_t;
+    
+    // Read-only view of file mapped to memory. Pages are loaded on first access
+    // File stays mapped while at least one std::shared_ptr to the view exists
+    //
+    class FileView : public Base {
+    public:
+        const std::uint8_t *getData() const;
+        std::size_t getSize() const;
+        
+        // Drops loaded pages of range from memory of the process, they are loaded again on next access
+        // Used by sequential readers of long files. Does nothing for views that are not mapped (decompressed archive entries)
+        //
+        void releasePages(std::size_t offset, std::size_t size) const;
+        
+    protected:
+        FileView() = default;
+    };
+    
+    // Callable executed by job worker threads. Lambdas with captures up to 48 bytes are stored without heap allocation
+    //
+    using Job = InplaceFunction<void(), 48>;
+    
+    // Group of jobs executed by worker threads of Platform. Created by Platform::createJobGroup
+    // Group is finished when it is committed, all its jobs are done and continuation is called
+    //
+    class JobGroup : public Base {
+    public:
+        // Adds job. Thread-safe. Can be called before commit() or by jobs of the group
+        //
+        void add(Job &&job);
+        
+        // Sets job that is called on worker thread after all jobs of the group are done. Must be called before commit()
+        //
+        void setContinuation(Job &&continuation);
+        
+        // Declares that all jobs are added. Platform::waitJobGroup commits group implicitly
+        //
+        void commit();
+        
+        bool isFinished() const;
+        
+    protected:
+        JobGroup() = default;
+    };
+    
+    // Scoped profiling zone, recorded only while Platform::captureProfile is in progress. Use PLATFORM_PROFILE_ZONE to create it
+    // Zone is written to buffer of the calling thread without locks. Cost is two clock reads when capturing and one atomic load otherwise
+    // @name - string literal or other string that lives until the end of capture
+    //
+    class ProfileZone {
+    public:
+        ProfileZone(const char *name) : _name(name), _startNs(begin()) {}
+        ~ProfileZone() {
+            if (_startNs) {
+                end(_name, _startNs);
+            }
+        }
+        
+    private:
+        ProfileZone(const ProfileZone &) = delete;
+        ProfileZone &operator =(const ProfileZone &) = delete;
+        
+        // @return - timestamp in nanoseconds or 0 if there is no capture
+        static std::uint64_t begin();
+        static void end(const char *name, std::uint64_t startNs);
+        
+        const char *_name;
+        const std::uint64_t _startNs;
+    };
+    
+    // Hardware performance counters sampled by counter zones
+    //
+    enum class PerfCounter {
+        CYCLES = 0,
+        INSTRUCTIONS,
+        L1D_MISSES,         // L1 data cache read misses
+        LLC_MISSES,         // last level cache misses
+        BRANCH_MISSES,
+        _count
+    };
+    
+    enum class PerfCounterFormat {
+        TEXT = 0,           // table for log and console
+        JSON,
+        _count
+    };
+    
+    // Counters of one zone name accumulated over a frame
+    //
+    struct PerfCounterStats {
+        const char *zoneName;
+        std::uint32_t calls;
+        std::uint64_t values[std::size_t(PerfCounter::_count)];    // indexed by PerfCounter, 0 for counters that CPU doesn't have
+    };
+    
+    // Scoped zone that samples hardware counters while Platform::enablePerfCounters is on. Use PLATFORM_COUNTER_ZONE to create it
+    // Counters are read with one system call at the start and at the end, so counter zones are for coarse hot paths, not for inner loops
+    // @name - string literal or other string that lives while the counters are enabled
+    //
+    class CounterZone {
+    public:
+        CounterZone(const char *name) : _name(name), _active(begin(_start)) {}
+        ~CounterZone() {
+            if (_active) {
+                end(_name, _start);
+            }
+        }
+        
+    private:
+        CounterZone(const CounterZone &) = delete;
+        CounterZone &operator =(const CounterZone &) = delete;
+        
+        // @return - false if counters are disabled or unavailable for the calling thread
+        static bool begin(std::uint64_t (&start)[std::size_t(PerfCounter::_count)]);
+        static void end(const char *name, const std::uint64_t (&start)[std::size_t(PerfCounter::_count)]);
+        
+        const char *_name;
+        std::uint64_t _start[std::size_t(PerfCounter::_count)];
+        const bool _active;
+    };
+    
+    // Categories of tagged allocations. Render categories hold estimated sizes of GPU resources, see Texture2D::getGpuSize
+    //
+    enum class MemoryCategory {
+        TEXTURES = 0,       // Texture2D, all mips
+        GEOMETRY,           // StructuredData
+        SHADERS,            // programs (size of translated sources), permanent and streamed constant buffers
+        EVENT_HANDLERS,     // tables of event handlers
+        INPUT,              // input queues and input recording
+        FILES,              // mapped files, decompressed archive entries, file index
+        TASKS,              // jobs and tasks posted to the main thread
+        FRAME_ARENA,        // blocks of per-frame arenas and their overflow
+        AUDIO,              // sounds and mixer buffers
+        COMMAND_LISTS,      // recorded render commands
+        _count
+    };
+    
+    struct MemoryStats {
+        std::uint64_t liveBytes;
+        std::uint64_t peakBytes;            // maximum of liveBytes since start
+        std::uint64_t liveAllocations;
+        std::uint32_t frameAllocations;     // allocations made during the previous frame
+    };
+    
+    // Usage of per-frame arenas of all threads, see Platform::allocFrameMemory
+    //
+    struct FrameArenaStats {
+        std::uint64_t capacityBytes;        // blocks of all threads
+        std::uint64_t frameBytes;           // allocated during the previous frame
+        std::uint64_t peakFrameBytes;       // maximum of frameBytes since start
+        std::uint64_t overflowBytes;        // allocated during the previous frame from heap because blocks were full
+        std::uint32_t overflowCount;
+        std::uint32_t growCount;            // blocks enlarged since start. Stops growing when frames are steady
+    };
+    
+    // Description of file found by file enumeration
+    //
+    struct FileInfo {
+        const char *path;           // null-terminated path. Example: "data/map1/test.png"
+        std::size_t pathLength;
+        std::uint64_t size;         // size of file contents (decompressed size for compressed archive entries)
+        std::int64_t mtime;         // modification time in seconds since epoch, 0 for archive entries
+    };
+    
     // Interface provides low-level core methods
     //
     class Platform : public Base {
     public:
-        // Thread-safe logging
-        void logInfo(const char *fmt, ...);
-        void logWarning(const char *fmt, ...);
-        void logError(const char *fmt, ...);
+        // Thread-safe logging with printf-like format
+        // Calling thread only stores arguments in its own buffer, messages are formatted and written by background thread
+        // Direct calls below PLATFORM_LOG_LEVEL write nothing but still evaluate arguments, PLATFORM_LOG_* macros skip both
+        //
+        template<typename... Args> void logInfo(const char *fmt, Args... args) {
+            if (PLATFORM_LOG_LEVEL <= int(LogLevel::INFO)) writeLog(LogLevel::INFO, fmt, args...);
+        }
+        template<typename... Args> void logWarning(const char *fmt, Args... args) {
+            if (PLATFORM_LOG_LEVEL <= int(LogLevel::WARNING)) writeLog(LogLevel::WARNING, fmt, args...);
+        }
+        template<typename... Args> void logError(const char *fmt, Args... args) {
+            if (PLATFORM_LOG_LEVEL <= int(LogLevel::ERROR)) writeLog(LogLevel::ERROR, fmt, args...);
+        }
+        
+        // Stores log message of @level. Used by logInfo/logWarning/logError
+        //
+        void writeLog(LogLevel level, const char *fmt, ...);
         
-        // Forms std::vector of file paths in @dirPath
+        // Forms std::vector of file paths in @dirPath. Nested directories are not included
+        // Directory is read again on every call, so files created since the previous call are listed
         // @dirPath  - target directory. Example: "data/map1"
-        // @return   - vector of paths
+        // @return   - vector of paths. Example: "data/map1/test.png"
         //
         std::vector<std::string> formFileList(const char *dirPath);
         
+        // Calls @visitor for every file in @dirPath without allocating memory per file
+        // Files are taken from index. Directory is scanned by the first call that needs it and is a snapshot since then: it is
+        // scanned again by formFileList, after mountArchive or after changes in directories watched by addFileChangeHandler.
+        // Symbolic links to directories are not followed
+        // @dirPath   - target directory, "" for root. Example: "data/map1"
+        // @pattern   - glob for file names ('*' - any sequence, '?' - any char) or nullptr for all files. Example: "*.png"
+        // @recursive - visit files from nested directories too
+        // @visitor   - called in order of paths. FileInfo::path is valid until the next call of formFileList, enumerateFiles or
+        //              getFileInfo, and until the index is rebuilt
+        //
+        void enumerateFiles(const char *dirPath, const char *pattern, bool recursive, const std::function<void(const FileInfo &)> &visitor);
+        
+        // Looks up file in the index used by enumerateFiles, directory of the file is scanned if it isn't in the index yet
+        // @filePath - file path. Example: "data/map1/test.png"
+        // @return   - true if file is found
+        //
+        bool getFileInfo(const char *filePath, FileInfo &info);
+        
         // Loads file to memory
         // @filePath - file path. Example: "data/map1/test.png"
         // @return   - true if file successfully loaded. Items returned by formFileList should be successfully loaded.
         //
         bool loadFile(const char *filePath, std::unique_ptr<uint8_t[]> &data, std::size_t &size);
         
+        // Loads file to caller's memory. Compressed archive entries are decoded directly into @buffer
+        // Can be used to decode texture mips into memory later passed as mipsData to RenderingDevice::createTexture
+        // @filePath - file path. Example: "data/map1/test.png"
+        // @capacity - size of @buffer. If it is less than file size nothing is loaded (zero capacity can be used to get file size)
+        // @size     - size of file
+        // @return   - true if file successfully loaded
+        //
+        bool loadFile(const char *filePath, std::uint8_t *buffer, std::size_t capacity, std::size_t &size);
+        
+        // Maps file to memory without copying
+        // @filePath - file path. Example: "data/map1/test.png"
+        // @access   - expected access pattern
+        // @return   - view of file contents or nullptr if file cannot be mapped. Empty file is mapped to view with zero size
+        //
+        std::shared_ptr<FileView> mapFile(const char *filePath, FileAccess access = FileAccess::SEQUENTIAL);
+        
+        // Mounts asset archive built by tools/asset_packer. Must be called before loading files
+        // formFileList, loadFile, loadFileAsync and mapFile look for paths in mounted archives first (the latest mounted is the first)
+        // and fall back to file system if path is not found
+        // @archivePath - path to archive file. Example: "data.pak"
+        // @return      - true if archive is mounted
+        //
+        bool mountArchive(const char *archivePath);
+        
+        // Loads file to memory on I/O worker thread without blocking the caller
+        // @filePath   - file path. Example: "data/map1/test.png"
+        // @priority   - requests with higher priority are read first
+        // @completion - called on the thread that runs run() at the start of the next frame after loading is finished.
+        //               @loaded is false if file cannot be loaded. Not called for cancelled requests
+        // @return     - token of the request
+        //
+        FileLoadToken loadFileAsync(
+            const char *filePath,
+            LoadPriority priority,
+            std::function<void(bool loaded, std::unique_ptr<uint8_t[]> &data, std::size_t size)> &&completion
+        );
+        
+        // Cancels request made by loadFileAsync
+        // @return     - true if request was cancelled before its completion was called
+        //
+        bool cancelFileLoad(FileLoadToken token);
+        
+        // Set handler for changes of files in @dirPath and nested directories. Used to reload assets without restarting the application
+        // @dirPath - watched directory, same as for formFileList. Example: "data/shaders"
+        // @changed - called on the thread that runs run() at the start of frame for every file that was changed, created or removed
+        //            since the previous frame. Path has the same form as paths returned by formFileList. Example: "data/shaders/sky.txt"
+        // @return nullptr if directory cannot be watched or watching is not supported
+        //
+        EventHandlersToken addFileChangeHandler(const char *dirPath, EventHandler<void(const char *filePath)> &&changed);
+        
+        // Queues @task to be called on the thread that runs run() at the start of the next frame, before updateAndDraw
+        // Tasks are called in order of posting within FramePacing::postBudgetSec per frame (at least one task per frame)
+        // Thread-safe and lock-free. Tasks with captures up to 48 bytes don't allocate memory
+        //
+        void post(Job &&task);
+        
+        // Creates group of jobs for worker threads. There is one worker per CPU core, each with its own lock-free job deque
+        // Idle workers steal jobs from others
+        // @dependencies - groups that must be finished before jobs of the new group start
+        //
+        std::shared_ptr<JobGroup> createJobGroup(std::initializer_list<std::shared_ptr<JobGroup>> dependencies = {});
+        
+        // Commits @group and returns when it is finished. Calling thread executes jobs while waiting,
+        // so it can be called from updateAndDraw and from jobs
+        //
+        void waitJobGroup(const std::shared_ptr<JobGroup> &group);
+        
+        // Calls @body for subranges of [0, @count) on worker threads and the calling thread. Returns when all calls are done
+        // @grainSize - minimal length of subrange
+        //
+        void parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t begin, std::size_t end)> &body);
+        
+        std::size_t getJobWorkerCount() const;
+        
         // Returns native screen size in pixels
         //
         float getNativeScreenWidth() const;
@@ -102,16 +513,16 @@ namespace platform {
         // @return nullptr if is not supported
         //
         EventHandlersToken addKeyboardEventHandlers(
-            std::function<void(const KeyboardEventArgs &)> &&down,
-            std::function<void(const KeyboardEventArgs &)> &&up
+            EventHandler<void(const KeyboardEventArgs &)> &&down,
+            EventHandler<void(const KeyboardEventArgs &)> &&up
         );
         
         // Set handlers for User's input (physical or virtual keyboard)
         // @return nullptr if is not supported
         //
         EventHandlersToken addInputEventHandlers(
-            std::function<void(const char (&utf8char)[4])> &&input,
-            std::function<void()> &&backspace
+            EventHandler<void(const char (&utf8char)[4])> &&input,
+            EventHandler<void()> &&backspace
         );
         
         // Set handlers for PC mouse
@@ -119,34 +530,121 @@ namespace platform {
         // @return nullptr if is not supported
         //
         EventHandlersToken addMouseEventHandlers(
-            std::function<void(const MouseEventArgs &)> &&press,
-            std::function<void(const MouseEventArgs &)> &&move,
-            std::function<void(const MouseEventArgs &)> &&release
+            EventHandler<void(const MouseEventArgs &)> &&press,
+            EventHandler<void(const MouseEventArgs &)> &&move,
+            EventHandler<void(const MouseEventArgs &)> &&release
         );
         
         // Set handlers for touch
         // @return nullptr if is not supported
         //
         EventHandlersToken addTouchEventHandlers(
-            std::function<void(const TouchEventArgs &)> &&start,
-            std::function<void(const TouchEventArgs &)> &&move,
-            std::function<void(const TouchEventArgs &)> &&finish
+            EventHandler<void(const TouchEventArgs &)> &&start,
+            EventHandler<void(const TouchEventArgs &)> &&move,
+            EventHandler<void(const TouchEventArgs &)> &&finish
         );
         
+        // Set handler for batched input. Touch, mouse and keyboard events are queued with timestamps and passed to @batch
+        // as one array at the start of every frame before updateAndDraw. Cost of input handling doesn't depend on sensor rate
+        // Handlers set by addTouchEventHandlers and others are still called for every event
+        // @return nullptr if is not supported
+        //
+        EventHandlersToken addInputBatchHandler(EventHandler<void(const InputBatch &)> &&batch);
+        
+        // Queues input event as if it was received from device. Queued events are dispatched at the start of the next frame
+        // Used by automated runs on headless platform. coalescedCount of @event is ignored
+        //
+        void injectInputEvent(const InputEvent &event);
+        
         // Set handlers for gamepad
         // @return nullptr if is not supported
         //
         EventHandlersToken addGamepadEventHandlers(
-            std::function<void(const GamepadEventArgs &)> &&buttonPress,
-            std::function<void(const GamepadEventArgs &)> &&buttonRelease
+            EventHandler<void(const GamepadEventArgs &)> &&buttonPress,
+            EventHandler<void(const GamepadEventArgs &)> &&buttonRelease
         );
         
+        // Records input events and delta times of frames to file until application exit. Replay of the file repeats the run
+        // @filePath - path of file to create. On iOS it must be in writable directory (Documents)
+        // @return   - false if file cannot be created
+        //
+        bool startInputRecording(const char *filePath);
+        
+        // Replays file written by startInputRecording. Must be called before run()
+        // Recorded events are dispatched before updateAndDraw of the frames they were received in, updateAndDraw gets recorded delta times
+        // Device events are ignored during replay. POSIX platform doesn't wait for wall clock and run() returns after the last frame
+        // @filePath - path of recording, loaded like loadFile. Example: "bench/level1.rec"
+        // @return   - false if file cannot be loaded or has unknown format
+        //
+        bool startInputReplay(const char *filePath);
+        
+        // Sets frame rate, fixed timestep, latency mode and idle throttling of run()
+        // Frames wait with sleep instead of busy loop. Can be called at any time
+        //
+        void setFramePacing(const FramePacing &pacing);
+        
+        // Resets idle timer. Input events reset it implicitly
+        // Should be called when picture is changed without input (animations, loaded assets)
+        //
+        void notifyActivity();
+        
+        // Histogram of frame intervals since start or the previous reset
+        // @reset - start collecting from scratch after the call
+        //
+        FrameTimeHistogram getFrameTimeHistogram(bool reset);
+        
+        // Records profiling zones of all threads during the next @frameCount frames and writes them to @filePath in Chrome trace
+        // event format (chrome://tracing, ui.perfetto.dev). Frames are zones named "Frame"
+        // Platform instruments input dispatch, file loading, shader building and drawing. Application adds its zones with PLATFORM_PROFILE_ZONE
+        // @filePath - path of file to create. On iOS it must be in writable directory (Documents)
+        // @return   - false if capture is already in progress or library is built without PLATFORM_PROFILER
+        //
+        bool captureProfile(std::uint32_t frameCount, const char *filePath);
+        
+        // Enables sampling of hardware counters (see PerfCounter) in zones of PLATFORM_COUNTER_ZONE. Zones are compiled with PLATFORM_PROFILER=1
+        // Linux only: counters are opened with perf_event_open for every thread that enters a counter zone and count user space only
+        // @return - false if counters are not available (other OS, kernel.perf_event_paranoid above 2, virtual machine without PMU)
+        //
+        bool enablePerfCounters(bool enable);
+        
+        // Counters of zones accumulated during the previous frame, one entry per zone name
+        // Counts of nested counter zones are not included in the enclosing zone
+        //
+        std::vector<PerfCounterStats> getPerfCounterStats() const;
+        
+        // Formats result of getPerfCounterStats with IPC and misses per thousand instructions
+        //
+        std::string formatPerfCounterStats(PerfCounterFormat format) const;
+        
+        // Memory of tagged platform and render allocations. Counters are always on and can be read from any thread
+        // Buffers returned by loadFile and loadFileAsync belong to application and are not counted
+        //
+        MemoryStats getMemoryStats(MemoryCategory category) const;
+        
+        // Allocates transient memory from per-frame arena of the calling thread. Can be called from any thread
+        // Memory stays valid until the end of the next frame and is released automatically, there is no free
+        // Every thread has two blocks that it switches on its first allocation in a new frame, allocation is a pointer bump
+        // without locks. Allocations that don't fit go to heap and the block is enlarged on its next use, so steady frames don't
+        // call malloc. In debug builds released memory is filled with 0xDD. Use FrameAllocator for containers
+        // @alignment - power of two
+        //
+        void *allocFrameMemory(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+        
+        FrameArenaStats getFrameArenaStats() const;
+        
         // Start platform update cycle
         // This method blocks execution until application exit
         // Argument of @updateAndDraw is delta time in seconds
         //
         void run(std::function<void(float)> &&updateAndDraw);
         
+        // Start platform update cycle with fixed timestep simulation
+        // This method blocks execution until application exit
+        // @update - called zero or more times per frame, argument is FramePacing::fixedStepSec
+        // @draw   - called once per frame after updates, argument is interpolation alpha in [0, 1) between the last two simulation states
+        //
+        void run(std::function<void(float)> &&update, std::function<void(float)> &&draw);
+        
         // Remove handlers of any type
         //
         void removeEventHandlers(EventHandlersToken token);
@@ -159,10 +657,163 @@ namespace platform {
         Platform() = default;
     };
     
+    // STL allocator over Platform::allocFrameMemory. Deallocation does nothing, so reserve capacity of growing containers
+    // Container must not be used after the end of the next frame. Example: FrameVector<int> ids (FrameAllocator<int>{*platform});
+    //
+    template<typename T> class FrameAllocator {
+    public:
+        using value_type = T;
+        
+        FrameAllocator(Platform &platform) : _platform(&platform) {}
+        template<typename U> FrameAllocator(const FrameAllocator<U> &other) : _platform(other.getPlatform()) {}
+        
+        T *allocate(std::size_t count) {
+            return static_cast<T *>(_platform->allocFrameMemory(count * sizeof(T), alignof(T)));
+        }
+        
+        void deallocate(T *, std::size_t) {}
+        
+        Platform *getPlatform() const {
+            return _platform;
+        }
+        
+        template<typename U> bool operator ==(const FrameAllocator<U> &other) const {
+            return _platform == other.getPlatform();
+        }
+        
+        template<typename U> bool operator !=(const FrameAllocator<U> &other) const {
+            return _platform != other.getPlatform();
+        }
+    
+    private:
+        Platform *_platform;
+    };
+    
+    template<typename T> using FrameVector = std::vector<T, FrameAllocator<T>>;
+    
+    // Settings of AudioDevice, fixed at creation
+    //
+    struct AudioConfig {
+        std::uint32_t sampleRate = 48000;   // output rate, sounds of other rates are resampled
+        std::uint32_t voiceCount = 256;     // maximum of simultaneously playing voices
+        std::uint32_t blockFrames = 256;    // frames mixed at once. Parameter changes are smoothed over one block
+        bool offline = false;               // no output, audio is produced by AudioDevice::render. POSIX is always offline
+    };
+    
+    // Parameters of playing voice
+    //
+    struct VoiceParams {
+        float gain = 1.0f;                  // linear
+        float pan = 0.0f;                   // [-1 left, 1 right], constant power. Balance for stereo sounds
+        float pitch = 1.0f;                 // playback rate multiplier, (0, 4]
+        bool loop = false;
+    };
+    
+    struct AudioStats {
+        std::uint32_t activeVoices;
+        std::uint32_t rejectedVoices;       // play() calls without free voice since start
+        std::uint32_t droppedCommands;      // commands lost since start because the queue was full
+        std::uint32_t streamUnderruns;      // blocks of stream voices mixed without decoded frames since start
+        float mixLoad;                      // mixing time divided by duration of mixed audio, smoothed
+    };
+    
+    // Identifier of playing voice, 0 - invalid
+    //
+    using VoiceToken = std::uint64_t;
+    
+    // Immutable PCM data. Sound stays alive while it plays, even if application releases its handle
+    //
+    class Sound : public Base {
+    public:
+        std::uint32_t getFrameCount() const;
+        std::uint32_t getChannelCount() const;
+        std::uint32_t getSampleRate() const;
+        
+    protected:
+        Sound() = default;
+    };
+    
+    // Settings of AudioStream, fixed at creation
+    //
+    struct StreamParams {
+        std::uint32_t memoryLimit = 256 * 1024; // bytes of decode buffers. Stream isn't created if its minimal buffers don't fit
+        bool loop = false;
+    };
+    
+    struct AudioStreamStats {
+        std::uint32_t memoryBytes;          // decode buffers, not above StreamParams::memoryLimit
+        std::uint32_t bufferedFrames;       // decoded frames waiting for playback
+        std::uint32_t underrunCount;        // blocks mixed without decoded frames since start
+    };
+    
+    // Sound decoded from file while it plays. Memory doesn't depend on length of file
+    //
+    class AudioStream : public Base {
+    public:
+        std::uint32_t getFrameCount() const;
+        std::uint32_t getChannelCount() const;
+        std::uint32_t getSampleRate() const;
+        AudioStreamStats getStats() const;
+    
+    protected:
+        AudioStream() = default;
+    };
+    
     // Interface provides Audio control methods
+    // Voices are mixed by software mixer on audio thread. Methods can be called from any thread, they send commands that are
+    // applied at the start of the next mixed block
     //
     class AudioDevice : public Base {
     public:
+        // Create sound from 16-bit PCM
+        // @samples      - interleaved samples, @frameCount * @channelCount values
+        // @channelCount - 1 or 2
+        // @return       - nullptr if arguments are invalid
+        //
+        std::shared_ptr<Sound> createSound(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate);
+        
+        // Create stream of wave file with 16-bit PCM or IMA ADPCM data, 1 or 2 channels. Used for music and long ambience
+        // File is mapped and decoded by background thread to ring of buffers, decoded pages of file are released
+        // The first buffers are decoded by the caller, so stream can be played right away
+        // Keep streamed files uncompressed in archives, compressed entry is decompressed to memory entirely
+        // @filePath - file path, same as for Platform::mapFile. Example: "music/level1.wav"
+        // @return   - nullptr if file cannot be mapped, has unsupported format or its buffers don't fit @params.memoryLimit
+        //
+        std::shared_ptr<AudioStream> createStream(const char *filePath, const StreamParams &params = {});
+        
+        // Start playing @sound on a free voice
+        // @return - 0 if all voices are busy
+        //
+        VoiceToken play(const std::shared_ptr<Sound> &sound, const VoiceParams &params = {});
+        
+        // Start playing @stream on a free voice. Stream is played once, loop is set by StreamParams (VoiceParams::loop is ignored)
+        // Stream that has no decoded frames in time plays silence and counts underrun
+        // @return - 0 if all voices are busy or stream has been played already
+        //
+        VoiceToken playStream(const std::shared_ptr<AudioStream> &stream, const VoiceParams &params = {});
+        
+        // Change parameters of playing voice. Finished voice is ignored
+        //
+        void setVoiceParams(VoiceToken voice, const VoiceParams &params);
+        
+        // Stop voice with short fade out. Finished voice is ignored
+        //
+        void stop(VoiceToken voice);
+        void stopAll();
+        
+        void setMasterGain(float gain);
+        
+        // @return - false if voice has finished. Stopped voice finishes after fade out
+        //
+        bool isPlaying(VoiceToken voice);
+        
+        AudioStats getStats();
+        
+        // Mix next @frameCount frames to @output. Offline device only (see AudioConfig::offline)
+        // Used for tests, benchmarks and rendering to file
+        // @output - interleaved stereo, @frameCount * 2 values
+        //
+        void render(float *output, std::uint32_t frameCount);
         
     protected:
         AudioDevice() = default;
@@ -198,6 +849,11 @@ namespace platform {
     };
     
     class Shader : public Base {
+    public:
+        // Size of 'const' block in bytes. It's the amount of data read from constants by applyShader
+        //
+        std::uint32_t getConstBlockSize() const;
+    
     protected:
         Shader() = default;
     };
@@ -215,6 +871,10 @@ namespace platform {
         std::uint32_t getHeight() const;
         std::uint32_t getMipCount() const;
         Texture2D::Format getFormat() const;
+        
+        // Estimated size of texture in video memory: all mips, 3-channel formats are padded to 4 bytes per pixel
+        //
+        std::size_t getGpuSize() const;
     
     protected:
         Texture2D() = default;
@@ -225,10 +885,82 @@ namespace platform {
         std::uint32_t getCount() const;
         std::uint32_t getStride() const;
         
+        // Size of buffer in video memory, count * stride
+        //
+        std::size_t getGpuSize() const;
+        
     protected:
         StructuredData() = default;
     };
     
+    // Render commands recorded for later submission by RenderingDevice::submitCommandList
+    // Different lists can be recorded by different threads at the same time, one list is used by one thread at a time
+    // Commands are compact records in linear memory, constants are copied at record time. Shaders, textures and data
+    // referenced by commands are not retained and must stay alive until presentFrame of the frame the list is submitted in
+    // (sorted lists execute their draws there)
+    //
+    class CommandList : public Base {
+    public:
+        // Same as RenderingDevice methods with the same names
+        //
+        void applyShader(const std::shared_ptr<Shader> &shader, const void *constants = nullptr);
+        void applyTextures(const std::initializer_list<const Texture2D *> &textures);
+        void drawGeometry(std::uint32_t vertexCount, Topology topology = Topology::TRIANGLES);
+        void drawGeometry(
+            const std::shared_ptr<StructuredData> &vertexData,
+            const std::shared_ptr<StructuredData> &instanceData,
+            std::uint32_t vertexCount,
+            std::uint32_t instanceCount,
+            Topology topology = Topology::TRIANGLES
+        );
+        
+        // Set sort key of the following draws. Used when list is submitted with sorting, 0 after creation and reset
+        //
+        void setSortKey(std::uint64_t key);
+        
+        // Sort key of common layout. Draws with the same layer are grouped by shader, then by textures, then ordered by depth
+        // Other layouts can be used, e.g. depth before shader for back to front order of transparent draws
+        // @layer    - draws of lower layers are executed first
+        // @shader   - application id of shader
+        // @textures - application id of texture set
+        // @depth    - 24 bits of quantized depth, lower is executed first
+        //
+        static constexpr std::uint64_t makeSortKey(std::uint8_t layer, std::uint16_t shader, std::uint16_t textures, std::uint32_t depth) {
+            return std::uint64_t(layer) << 56 | std::uint64_t(shader) << 40 | std::uint64_t(textures) << 24 | (depth & 0xffffff);
+        }
+        
+        // Remove recorded commands. Memory is kept for the next recording
+        //
+        void reset();
+        
+        std::uint32_t getCommandCount() const;
+        
+        // Bytes reserved for commands. List grows while recording and never shrinks
+        //
+        std::size_t getMemorySize() const;
+    
+    protected:
+        CommandList() = default;
+    };
+    
+    // Counters of RenderingDevice since start
+    //
+    struct RenderStats {
+        std::uint64_t shaderApplies;
+        std::uint64_t textureApplies;
+        std::uint64_t drawCalls;
+        std::uint64_t submittedLists;
+        std::uint64_t submittedCommands;    // commands of submitted lists
+        std::uint64_t sortedDraws;          // draws of lists submitted with sorting
+        std::uint64_t shaderChangesSaved;   // shader changes avoided by sorting, compared to order of submission
+        std::uint64_t textureChangesSaved;  // texture set changes avoided by sorting
+        std::uint64_t stateCallsIssued;     // native calls that changed bindings of shader, constant buffers and textures
+        std::uint64_t stateCallsSkipped;    // native calls skipped because the binding was set already
+        std::uint64_t vertexArraysCreated;  // vertex arrays set up for new combination of shader and data
+        std::uint64_t vertexArraysReused;   // draws that set up vertex input by binding of cached vertex array
+        std::uint64_t constantUploads;      // mappings of constant buffer: by apply with constants, by unsorted list, by frame of sorted draws
+    };
+    
     // Interface provides 3D-visualization methods
     //
     class RenderingDevice {
@@ -291,6 +1023,35 @@ namespace platform {
             const std::initializer_list<const std::uint8_t *> &mipsData = {}
         );
         
+        // Create texture from binary data. Same as above for mip count that is known at runtime only
+        // @mipsData    - array of @mipCount pointers. Each [i] pointer represents binary data for i'th mip and cannot be nullptr
+        //
+        std::shared_ptr<Texture2D> createTexture(
+            Texture2D::Format format,
+            std::uint32_t width,
+            std::uint32_t height,
+            const std::uint8_t *const *mipsData,
+            std::uint32_t mipCount
+        );
+        
+        // Rebuild shader from new source text in place. Handle stays valid, vertex and instance layouts are kept
+        // @prmnt  - data for the block of permanent constants, nullptr to keep data of the current shader
+        // @return - false if new source cannot be compiled. Shader is left unchanged in that case
+        //
+        bool reloadShader(const std::shared_ptr<Shader> &shader, const char *shadersrc, const void *prmnt = nullptr);
+        
+        // Replace contents of texture in place. Handle stays valid, size and format can differ from the current ones
+        // @mipsData    - array of @mipCount pointers. Each [i] pointer represents binary data for i'th mip and cannot be nullptr
+        //
+        void reloadTexture(
+            const std::shared_ptr<Texture2D> &texture,
+            Texture2D::Format format,
+            std::uint32_t width,
+            std::uint32_t height,
+            const std::uint8_t *const *mipsData,
+            std::uint32_t mipCount
+        );
+        
         // Create geometry
         // @data        - pointer to data (array of structures)
         // @count       - count of structures in array
@@ -329,6 +1090,21 @@ namespace platform {
 
         // TODO: draw indexed geometry
         
+        // Create empty command list. Can be called from any thread
+        //
+        std::shared_ptr<CommandList> createCommandList();
+        
+        // Execute commands of @list as if the methods were called here. Lists are executed in order of submission
+        // Call between prepareFrame and presentFrame, after recording of @list is finished. List isn't changed and can be
+        // submitted again or reset
+        // @sorted - draws of @list are deferred to presentFrame and executed there together with draws of other sorted lists
+        //           of the frame, in order of sort keys (see CommandList::setSortKey). Every draw is executed with shader and
+        //           textures applied before it in its list, shader or textures equal to the ones of the previous draw are not
+        //           applied again. Draws with equal keys keep order of submission. List must not be changed and objects it
+        //           references must stay alive until presentFrame
+        //
+        void submitCommandList(const std::shared_ptr<CommandList> &list, bool sorted = false);
+        
         void prepareFrame();
         void presentFrame(float dtSec);
         
@@ -337,12 +1113,14 @@ namespace platform {
         //
         void getFrameBufferData(std::uint8_t *imgFrame);
         
+        RenderStats getStats() const;
+        
     protected:
         RenderingDevice() = default;
     };
     
     std::shared_ptr<Platform> getPlatformInstance();
-    std::shared_ptr<AudioDevice> getAudioDeviceInstance(const std::shared_ptr<Platform> &platform);
+    std::shared_ptr<AudioDevice> getAudioDeviceInstance(const std::shared_ptr<Platform> &platform, const AudioConfig &config = {});
     std::shared_ptr<RenderingDevice> getRenderingDeviceInstance(const std::shared_ptr<Platform> &platform);
 }
 
@@ -0,0 +1,78 @@
+#pragma once
+
+#import <AudioToolbox/AudioToolbox.h>
+
+namespace platform {
+    class AudioMixer;
+    
+    // Mixer output goes to RemoteIO unit, its render callback runs the mixer on the system audio thread
+    //
+    class IOSAudio : public AudioDevice {
+    public:
+        IOSAudio(const std::shared_ptr<Platform> &platform, const AudioConfig &config);
+        ~IOSAudio();
+        
+        std::shared_ptr<Sound> createSound(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate);
+        std::shared_ptr<AudioStream> createStream(const char *filePath, const StreamParams &params);
+        VoiceToken play(const std::shared_ptr<Sound> &sound, const VoiceParams &params);
+        VoiceToken playStream(const std::shared_ptr<AudioStream> &stream, const VoiceParams &params);
+        void setVoiceParams(VoiceToken voice, const VoiceParams &params);
+        void stop(VoiceToken voice);
+        void stopAll();
+        void setMasterGain(float gain);
+        bool isPlaying(VoiceToken voice);
+        AudioStats getStats();
+        void render(float *output, std::uint32_t frameCount);
+        
+    private:
+        bool _startOutput(const AudioConfig &config);
+        
+        std::shared_ptr<Platform> _platform;
+        std::unique_ptr<AudioMixer> _mixer;
+        AudioComponentInstance _unit;
+    };
+
+    std::shared_ptr<Sound> AudioDevice::createSound(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate) {
+        return static_cast<IOSAudio *>(this)->createSound(samples, frameCount, channelCount, sampleRate);
+    }
+
+    std::shared_ptr<AudioStream> AudioDevice::createStream(const char *filePath, const StreamParams &params) {
+        return static_cast<IOSAudio *>(this)->createStream(filePath, params);
+    }
+
+    VoiceToken AudioDevice::play(const std::shared_ptr<Sound> &sound, const VoiceParams &params) {
+        return static_cast<IOSAudio *>(this)->play(sound, params);
+    }
+
+    VoiceToken AudioDevice::playStream(const std::shared_ptr<AudioStream> &stream, const VoiceParams &params) {
+        return static_cast<IOSAudio *>(this)->playStream(stream, params);
+    }
+
+    void AudioDevice::setVoiceParams(VoiceToken voice, const VoiceParams &params) {
+        static_cast<IOSAudio *>(this)->setVoiceParams(voice, params);
+    }
+
+    void AudioDevice::stop(VoiceToken voice) {
+        static_cast<IOSAudio *>(this)->stop(voice);
+    }
+
+    void AudioDevice::stopAll() {
+        static_cast<IOSAudio *>(this)->stopAll();
+    }
+
+    void AudioDevice::setMasterGain(float gain) {
+        static_cast<IOSAudio *>(this)->setMasterGain(gain);
+    }
+
+    bool AudioDevice::isPlaying(VoiceToken voice) {
+        return static_cast<IOSAudio *>(this)->isPlaying(voice);
+    }
+
+    AudioStats AudioDevice::getStats() {
+        return static_cast<IOSAudio *>(this)->getStats();
+    }
+
+    void AudioDevice::render(float *output, std::uint32_t frameCount) {
+        static_cast<IOSAudio *>(this)->render(output, frameCount);
+    }
+}
@@ -0,0 +1,164 @@
+#include "interfaces.h"
+#include "ios_audio.h"
+#include "audio_mixer.h"
+
+#import <AVFoundation/AVFoundation.h>
+
+namespace {
+    std::shared_ptr<platform::IOSAudio> _audio;
+    
+    // Called on the system audio thread
+    OSStatus renderCallback(void *context, AudioUnitRenderActionFlags *flags, const AudioTimeStamp *time, UInt32 bus, UInt32 frameCount, AudioBufferList *buffers) {
+        static_cast<platform::AudioMixer *>(context)->render(static_cast<float *>(buffers->mBuffers[0].mData), frameCount);
+        return noErr;
+    }
+}
+
+namespace platform {
+    IOSAudio::IOSAudio(const std::shared_ptr<Platform> &platform, const AudioConfig &config) : _platform(platform), _mixer(std::make_unique<AudioMixer>(config)), _unit(nullptr) {
+        if (config.offline) {
+            PLATFORM_LOG_INFO(_platform, "[Audio] Offline mixer: %u Hz, %u voices", config.sampleRate, config.voiceCount);
+        }
+        else if (_startOutput(config)) {
+            PLATFORM_LOG_INFO(_platform, "[Audio] RemoteIO output: %u Hz, %u voices", config.sampleRate, config.voiceCount);
+        }
+        else {
+            PLATFORM_LOG_ERROR(_platform, "[Audio] Failed to start RemoteIO output");
+        }
+    }
+    
+    IOSAudio::~IOSAudio() {
+        if (_unit) {
+            AudioOutputUnitStop(_unit);
+            AudioUnitUninitialize(_unit);
+            AudioComponentInstanceDispose(_unit);
+        }
+    }
+    
+    std::shared_ptr<Sound> IOSAudio::createSound(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate) {
+        std::shared_ptr<Sound> result = AudioMixer::createSound(samples, frameCount, channelCount, sampleRate);
+        
+        if (result == nullptr) {
+            PLATFORM_LOG_ERROR(_platform, "[Audio] Invalid sound: %u frames, %u channels, %u Hz", frameCount, channelCount, sampleRate);
+        }
+        
+        return result;
+    }
+    
+    std::shared_ptr<AudioStream> IOSAudio::createStream(const char *filePath, const StreamParams &params) {
+        std::shared_ptr<FileView> view = _platform->mapFile(filePath, FileAccess::SEQUENTIAL);
+        
+        if (view == nullptr) {
+            return nullptr;
+        }
+        
+        std::shared_ptr<AudioStream> result = _mixer->createStream(view, params);
+        
+        if (result == nullptr) {
+            PLATFORM_LOG_ERROR(_platform, "[Audio] Stream %s is not 16-bit PCM or IMA ADPCM wave, or its buffers don't fit %u bytes", filePath, params.memoryLimit);
+        }
+        
+        return result;
+    }
+    
+    VoiceToken IOSAudio::play(const std::shared_ptr<Sound> &sound, const VoiceParams &params) {
+        return _mixer->play(sound, params);
+    }
+    
+    VoiceToken IOSAudio::playStream(const std::shared_ptr<AudioStream> &stream, const VoiceParams &params) {
+        return _mixer->playStream(stream, params);
+    }
+    
+    void IOSAudio::setVoiceParams(VoiceToken voice, const VoiceParams &params) {
+        _mixer->setVoiceParams(voice, params);
+    }
+    
+    void IOSAudio::stop(VoiceToken voice) {
+        _mixer->stop(voice);
+    }
+    
+    void IOSAudio::stopAll() {
+        _mixer->stopAll();
+    }
+    
+    void IOSAudio::setMasterGain(float gain) {
+        _mixer->setMasterGain(gain);
+    }
+    
+    bool IOSAudio::isPlaying(VoiceToken voice) {
+        return _mixer->isPlaying(voice);
+    }
+    
+    AudioStats IOSAudio::getStats() {
+        return _mixer->getStats();
+    }
+    
+    void IOSAudio::render(float *output, std::uint32_t frameCount) {
+        if (_mixer->getConfig().offline) {
+            _mixer->render(output, frameCount);
+        }
+        else {
+            PLATFORM_LOG_ERROR(_platform, "[Audio] render() is for offline device only");
+        }
+    }
+    
+    bool IOSAudio::_startOutput(const AudioConfig &config) {
+        AVAudioSession *session = [AVAudioSession sharedInstance];
+        [session setCategory:AVAudioSessionCategoryAmbient error:nil];
+        [session setPreferredSampleRate:double(config.sampleRate) error:nil];
+        [session setPreferredIOBufferDuration:double(config.blockFrames) / double(config.sampleRate) error:nil];
+        [session setActive:YES error:nil];
+        
+        AudioComponentDescription description = {};
+        description.componentType = kAudioUnitType_Output;
+        description.componentSubType = kAudioUnitSubType_RemoteIO;
+        description.componentManufacturer = kAudioUnitManufacturer_Apple;
+        
+        AudioComponent component = AudioComponentFindNext(nullptr, &description);
+        
+        if (component == nullptr || AudioComponentInstanceNew(component, &_unit) != noErr) {
+            _unit = nullptr;
+            return false;
+        }
+        
+        // interleaved float stereo, unit converts it to hardware rate and format
+        AudioStreamBasicDescription format = {};
+        format.mSampleRate = double(config.sampleRate);
+        format.mFormatID = kAudioFormatLinearPCM;
+        format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked;
+        format.mChannelsPerFrame = 2;
+        format.mBitsPerChannel = 32;
+        format.mFramesPerPacket = 1;
+        format.mBytesPerFrame = 2 * sizeof(float);
+        format.mBytesPerPacket = 2 * sizeof(float);
+        
+        AURenderCallbackStruct callback = {renderCallback, _mixer.get()};
+        
+        if (AudioUnitSetProperty(_unit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0, &format, sizeof(format)) != noErr ||
+            AudioUnitSetProperty(_unit, kAudioUnitProperty_SetRenderCallback, kAudioUnitScope_Input, 0, &callback, sizeof(callback)) != noErr ||
+            AudioUnitInitialize(_unit) != noErr)
+        {
+            AudioComponentInstanceDispose(_unit);
+            _unit = nullptr;
+            return false;
+        }
+        if (AudioOutputUnitStart(_unit) != noErr) {
+            AudioUnitUninitialize(_unit);
+            AudioComponentInstanceDispose(_unit);
+            _unit = nullptr;
+            return false;
+        }
+        
+        return true;
+    }
+}
+
+namespace platform {
+    std::shared_ptr<AudioDevice> getAudioDeviceInstance(const std::shared_ptr<Platform> &platform, const AudioConfig &config) {
+        if (_audio == nullptr) {
+            _audio = std::make_shared<IOSAudio>(platform, config);
+        }
+        
+        return _audio;
+    }
+}
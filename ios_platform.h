@@ -1,13 +1,42 @@
 #pragma once
 
 namespace platform {
+    class AsyncFileLoader;
+    class AssetArchive;
+    class FileIndex;
+    class FileWatcher;
+    class JobSystem;
+    class ProfileCapture;
+    class PerfCounterCollector;
+    class FrameArena;
+    
     class IOSPlatform : public Platform {
     public:
         IOSPlatform();
         ~IOSPlatform();
 
         std::vector<std::string> formFileList(const char *dirPath);
+        void enumerateFiles(const char *dirPath, const char *pattern, bool recursive, const std::function<void(const FileInfo &)> &visitor);
+        bool getFileInfo(const char *filePath, FileInfo &info);
         bool loadFile(const char *filePath, std::unique_ptr<unsigned char []> &data, std::size_t &size);
+        bool loadFile(const char *filePath, std::uint8_t *buffer, std::size_t capacity, std::size_t &size);
+        std::shared_ptr<FileView> mapFile(const char *filePath, FileAccess access);
+        bool mountArchive(const char *archivePath);
+        
+        FileLoadToken loadFileAsync(
+            const char *filePath,
+            LoadPriority priority,
+            std::function<void(bool, std::unique_ptr<uint8_t[]> &, std::size_t)> &&completion
+        );
+        
+        bool cancelFileLoad(FileLoadToken token);
+        EventHandlersToken addFileChangeHandler(const char *dirPath, EventHandler<void(const char *filePath)> &&changed);
+
+        void post(Job &&task);
+        std::shared_ptr<JobGroup> createJobGroup(std::initializer_list<std::shared_ptr<JobGroup>> dependencies);
+        void waitJobGroup(const std::shared_ptr<JobGroup> &group);
+        void parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t begin, std::size_t end)> &body);
+        std::size_t getJobWorkerCount() const;
 
         float getNativeScreenWidth() const;
         float getNativeScreenHeight() const;
@@ -20,52 +49,148 @@ namespace platform {
         void hideKeyboard();
         
         EventHandlersToken addKeyboardEventHandlers(
-            std::function<void(const KeyboardEventArgs &)> &&down,
-            std::function<void(const KeyboardEventArgs &)> &&up
+            EventHandler<void(const KeyboardEventArgs &)> &&down,
+            EventHandler<void(const KeyboardEventArgs &)> &&up
         );
 
         EventHandlersToken addInputEventHandlers(
-            std::function<void(const char (&utf8char)[4])> &&input,
-            std::function<void()> &&backspace
+            EventHandler<void(const char (&utf8char)[4])> &&input,
+            EventHandler<void()> &&backspace
         );
 
         EventHandlersToken addMouseEventHandlers(
-            std::function<void(const MouseEventArgs &)> &&press,
-            std::function<void(const MouseEventArgs &)> &&move,
-            std::function<void(const MouseEventArgs &)> &&release
+            EventHandler<void(const MouseEventArgs &)> &&press,
+            EventHandler<void(const MouseEventArgs &)> &&move,
+            EventHandler<void(const MouseEventArgs &)> &&release
         );
 
         EventHandlersToken addTouchEventHandlers(
-            std::function<void(const TouchEventArgs &)> &&start,
-            std::function<void(const TouchEventArgs &)> &&move,
-            std::function<void(const TouchEventArgs &)> &&release
+            EventHandler<void(const TouchEventArgs &)> &&start,
+            EventHandler<void(const TouchEventArgs &)> &&move,
+            EventHandler<void(const TouchEventArgs &)> &&release
         );
 
         EventHandlersToken addGamepadEventHandlers(
-            std::function<void(const GamepadEventArgs &)> &&buttonPress,
-            std::function<void(const GamepadEventArgs &)> &&buttonRelease
+            EventHandler<void(const GamepadEventArgs &)> &&buttonPress,
+            EventHandler<void(const GamepadEventArgs &)> &&buttonRelease
         );
 
+        EventHandlersToken addInputBatchHandler(EventHandler<void(const InputBatch &)> &&batch);
+        void injectInputEvent(const InputEvent &event);
+
+        bool startInputRecording(const char *filePath);
+        bool startInputReplay(const char *filePath);
+
+        void setFramePacing(const FramePacing &pacing);
+        void notifyActivity();
+        FrameTimeHistogram getFrameTimeHistogram(bool reset);
+        bool captureProfile(std::uint32_t frameCount, const char *filePath);
+        bool enablePerfCounters(bool enable);
+        std::vector<PerfCounterStats> getPerfCounterStats() const;
+        std::string formatPerfCounterStats(PerfCounterFormat format) const;
+        MemoryStats getMemoryStats(MemoryCategory category) const;
+        void *allocFrameMemory(std::size_t size, std::size_t alignment);
+        FrameArenaStats getFrameArenaStats() const;
+
         void run(std::function<void(float)> &&updateAndDraw);
+        void run(std::function<void(float)> &&update, std::function<void(float)> &&draw);
         void removeEventHandlers(EventHandlersToken token);
         void exit();
         
     public:
         std::function<void(float)> updateAndDrawHandler;
+        
+        // Called by view controller before each updateAndDrawHandler
+        // @dtSec  - measured delta time
+        // @return - delta time for updateAndDraw
+        float beginFrame(float dtSec);
+        
+        // Called by view controller before each frame, starts and finishes profile capture, collects counters of the previous frame
+        // and starts the next frame of frame arenas
+        void nextProfileFrame();
     
     private:
         float _nativeScreenWidth;
         float _nativeScreenHeight;
+        
+        std::unique_ptr<AsyncFileLoader> _fileLoader;
+        std::vector<std::unique_ptr<AssetArchive>> _archives;
+        std::unique_ptr<FileIndex> _fileIndex;   // directories are added on demand, reset by mountArchive and file changes
+        std::unique_ptr<JobSystem> _jobSystem;
+        std::unique_ptr<FileWatcher> _fileWatcher;  // created by the first addFileChangeHandler
+        std::unique_ptr<ProfileCapture> _profileCapture;
+        std::unique_ptr<PerfCounterCollector> _perfCounters;
+        std::unique_ptr<FrameArena> _frameArena;
+        
+        // @return index with files of @dirPath. @refresh - scan directory even if it's already in the index
+        const FileIndex &_getFileIndex(const char *dirPath, bool recursive, bool refresh);
     };
     
     std::vector<std::string> Platform::formFileList(const char *dirPath) {
         return static_cast<IOSPlatform *>(this)->formFileList(dirPath);
     }
 
+    void Platform::enumerateFiles(const char *dirPath, const char *pattern, bool recursive, const std::function<void(const FileInfo &)> &visitor) {
+        static_cast<IOSPlatform *>(this)->enumerateFiles(dirPath, pattern, recursive, visitor);
+    }
+
+    bool Platform::getFileInfo(const char *filePath, FileInfo &info) {
+        return static_cast<IOSPlatform *>(this)->getFileInfo(filePath, info);
+    }
+
     bool Platform::loadFile(const char *filePath, std::unique_ptr<unsigned char []> &data, std::size_t &size) {
         return static_cast<IOSPlatform *>(this)->loadFile(filePath, data, size);
     }
 
+    bool Platform::loadFile(const char *filePath, std::uint8_t *buffer, std::size_t capacity, std::size_t &size) {
+        return static_cast<IOSPlatform *>(this)->loadFile(filePath, buffer, capacity, size);
+    }
+
+    std::shared_ptr<FileView> Platform::mapFile(const char *filePath, FileAccess access) {
+        return static_cast<IOSPlatform *>(this)->mapFile(filePath, access);
+    }
+
+    bool Platform::mountArchive(const char *archivePath) {
+        return static_cast<IOSPlatform *>(this)->mountArchive(archivePath);
+    }
+
+    FileLoadToken Platform::loadFileAsync(
+        const char *filePath,
+        LoadPriority priority,
+        std::function<void(bool, std::unique_ptr<uint8_t[]> &, std::size_t)> &&completion
+    )
+    {
+        return static_cast<IOSPlatform *>(this)->loadFileAsync(filePath, priority, std::move(completion));
+    }
+
+    bool Platform::cancelFileLoad(FileLoadToken token) {
+        return static_cast<IOSPlatform *>(this)->cancelFileLoad(token);
+    }
+
+    EventHandlersToken Platform::addFileChangeHandler(const char *dirPath, EventHandler<void(const char *filePath)> &&changed) {
+        return static_cast<IOSPlatform *>(this)->addFileChangeHandler(dirPath, std::move(changed));
+    }
+
+    void Platform::post(Job &&task) {
+        static_cast<IOSPlatform *>(this)->post(std::move(task));
+    }
+
+    std::shared_ptr<JobGroup> Platform::createJobGroup(std::initializer_list<std::shared_ptr<JobGroup>> dependencies) {
+        return static_cast<IOSPlatform *>(this)->createJobGroup(dependencies);
+    }
+
+    void Platform::waitJobGroup(const std::shared_ptr<JobGroup> &group) {
+        static_cast<IOSPlatform *>(this)->waitJobGroup(group);
+    }
+
+    void Platform::parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t begin, std::size_t end)> &body) {
+        static_cast<IOSPlatform *>(this)->parallelFor(count, grainSize, body);
+    }
+
+    std::size_t Platform::getJobWorkerCount() const {
+        return static_cast<const IOSPlatform *>(this)->getJobWorkerCount();
+    }
+
     float Platform::getNativeScreenWidth() const {
         return static_cast<const IOSPlatform *>(this)->getNativeScreenWidth();
     }
@@ -95,50 +220,110 @@ namespace platform {
     }
 
     EventHandlersToken Platform::addKeyboardEventHandlers(
-        std::function<void(const KeyboardEventArgs &)> &&down,
-        std::function<void(const KeyboardEventArgs &)> &&up
+        EventHandler<void(const KeyboardEventArgs &)> &&down,
+        EventHandler<void(const KeyboardEventArgs &)> &&up
     )
     {
         return static_cast<IOSPlatform *>(this)->addKeyboardEventHandlers(std::move(down), std::move(up));
     }
     
     EventHandlersToken Platform::addInputEventHandlers(
-        std::function<void(const char (&utf8char)[4])> &&input,
-        std::function<void()> &&backspace
+        EventHandler<void(const char (&utf8char)[4])> &&input,
+        EventHandler<void()> &&backspace
     )
     {
         return static_cast<IOSPlatform *>(this)->addInputEventHandlers(std::move(input), std::move(backspace));
     }
 
     EventHandlersToken Platform::addMouseEventHandlers(
-        std::function<void(const MouseEventArgs &)> &&press,
-        std::function<void(const MouseEventArgs &)> &&move,
-        std::function<void(const MouseEventArgs &)> &&release
+        EventHandler<void(const MouseEventArgs &)> &&press,
+        EventHandler<void(const MouseEventArgs &)> &&move,
+        EventHandler<void(const MouseEventArgs &)> &&release
     )
     {
         return static_cast<IOSPlatform *>(this)->addMouseEventHandlers(std::move(press), std::move(move), std::move(release));
     }
 
     EventHandlersToken Platform::addTouchEventHandlers(
-        std::function<void(const TouchEventArgs &)> &&start,
-        std::function<void(const TouchEventArgs &)> &&move,
-        std::function<void(const TouchEventArgs &)> &&release
+        EventHandler<void(const TouchEventArgs &)> &&start,
+        EventHandler<void(const TouchEventArgs &)> &&move,
+        EventHandler<void(const TouchEventArgs &)> &&release
     )
     {
         return static_cast<IOSPlatform *>(this)->addTouchEventHandlers(std::move(start), std::move(move), std::move(release));
     }
 
     EventHandlersToken Platform::addGamepadEventHandlers(
-        std::function<void(const GamepadEventArgs &)> &&buttonPress,
-        std::function<void(const GamepadEventArgs &)> &&buttonRelease
+        EventHandler<void(const GamepadEventArgs &)> &&buttonPress,
+        EventHandler<void(const GamepadEventArgs &)> &&buttonRelease
     )
     {
         return static_cast<IOSPlatform *>(this)->addGamepadEventHandlers(std::move(buttonPress), std::move(buttonRelease));
     }
 
+    EventHandlersToken Platform::addInputBatchHandler(EventHandler<void(const InputBatch &)> &&batch) {
+        return static_cast<IOSPlatform *>(this)->addInputBatchHandler(std::move(batch));
+    }
+
+    void Platform::injectInputEvent(const InputEvent &event) {
+        static_cast<IOSPlatform *>(this)->injectInputEvent(event);
+    }
+
+    bool Platform::startInputRecording(const char *filePath) {
+        return static_cast<IOSPlatform *>(this)->startInputRecording(filePath);
+    }
+
+    bool Platform::startInputReplay(const char *filePath) {
+        return static_cast<IOSPlatform *>(this)->startInputReplay(filePath);
+    }
+
+    void Platform::setFramePacing(const FramePacing &pacing) {
+        static_cast<IOSPlatform *>(this)->setFramePacing(pacing);
+    }
+
+    void Platform::notifyActivity() {
+        static_cast<IOSPlatform *>(this)->notifyActivity();
+    }
+
+    FrameTimeHistogram Platform::getFrameTimeHistogram(bool reset) {
+        return static_cast<IOSPlatform *>(this)->getFrameTimeHistogram(reset);
+    }
+
+    bool Platform::captureProfile(std::uint32_t frameCount, const char *filePath) {
+        return static_cast<IOSPlatform *>(this)->captureProfile(frameCount, filePath);
+    }
+
+    bool Platform::enablePerfCounters(bool enable) {
+        return static_cast<IOSPlatform *>(this)->enablePerfCounters(enable);
+    }
+
+    std::vector<PerfCounterStats> Platform::getPerfCounterStats() const {
+        return static_cast<const IOSPlatform *>(this)->getPerfCounterStats();
+    }
+
+    std::string Platform::formatPerfCounterStats(PerfCounterFormat format) const {
+        return static_cast<const IOSPlatform *>(this)->formatPerfCounterStats(format);
+    }
+
+    MemoryStats Platform::getMemoryStats(MemoryCategory category) const {
+        return static_cast<const IOSPlatform *>(this)->getMemoryStats(category);
+    }
+
+    void *Platform::allocFrameMemory(std::size_t size, std::size_t alignment) {
+        return static_cast<IOSPlatform *>(this)->allocFrameMemory(size, alignment);
+    }
+
+    FrameArenaStats Platform::getFrameArenaStats() const {
+        return static_cast<const IOSPlatform *>(this)->getFrameArenaStats();
+    }
+
     void Platform::run(std::function<void(float)> &&updateAndDraw) {
         static_cast<IOSPlatform *>(this)->run(std::move(updateAndDraw));
     }
+
+    void Platform::run(std::function<void(float)> &&update, std::function<void(float)> &&draw) {
+        static_cast<IOSPlatform *>(this)->run(std::move(update), std::move(draw));
+    }
     
     void Platform::removeEventHandlers(EventHandlersToken token) {
         static_cast<IOSPlatform *>(this)->removeEventHandlers(token);
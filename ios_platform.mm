@@ -1,12 +1,30 @@
 
 #include "interfaces.h"
 #include "ios_platform.h"
+#include "async_loader.h"
+#include "asset_archive.h"
+#include "file_index.h"
+#include "file_watcher.h"
+#include "async_log.h"
+#include "event_registry.h"
+#include "input_queue.h"
+#include "input_record.h"
+#include "frame_scheduler.h"
+#include "job_system.h"
+#include "post_queue.h"
+#include "profiler.h"
+#include "perf_counters.h"
+#include "memory_tracker.h"
+#include "frame_arena.h"
 
-#include <mutex>
 #include <chrono>
+#include <cstring>
 #include <fstream>
-#include <unordered_map>
 #include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define GLES_SILENCE_DEPRECATION
 
@@ -17,55 +35,192 @@
 
 namespace {
     struct KeyboardEventHandler {
-        std::function<void(const platform::KeyboardEventArgs &)> down;
-        std::function<void(const platform::KeyboardEventArgs &)> up;
+        platform::EventHandler<void(const platform::KeyboardEventArgs &)> down;
+        platform::EventHandler<void(const platform::KeyboardEventArgs &)> up;
     };
 
     struct InputEventHandler {
-        std::function<void(const char (&utf8char)[4])> input;
-        std::function<void()> backspace;
+        platform::EventHandler<void(const char (&utf8char)[4])> input;
+        platform::EventHandler<void()> backspace;
     };
 
     struct MouseEventHandler {
-        std::function<void(const platform::MouseEventArgs &)> press;
-        std::function<void(const platform::MouseEventArgs &)> move;
-        std::function<void(const platform::MouseEventArgs &)> release;
+        platform::EventHandler<void(const platform::MouseEventArgs &)> press;
+        platform::EventHandler<void(const platform::MouseEventArgs &)> move;
+        platform::EventHandler<void(const platform::MouseEventArgs &)> release;
     };
 
     struct TouchEventHandler {
-        std::function<void(const platform::TouchEventArgs &)> start;
-        std::function<void(const platform::TouchEventArgs &)> move;
-        std::function<void(const platform::TouchEventArgs &)> release;
+        platform::EventHandler<void(const platform::TouchEventArgs &)> start;
+        platform::EventHandler<void(const platform::TouchEventArgs &)> move;
+        platform::EventHandler<void(const platform::TouchEventArgs &)> release;
     };
 
     struct GamepadEventHandler {
-        std::function<void(const platform::GamepadEventArgs &)> buttonPress;
-        std::function<void(const platform::GamepadEventArgs &)> buttonRelease;
+        platform::EventHandler<void(const platform::GamepadEventArgs &)> buttonPress;
+        platform::EventHandler<void(const platform::GamepadEventArgs &)> buttonRelease;
     };
     
-    platform::EventHandlersToken _lastTokenGen = reinterpret_cast<platform::EventHandlersToken>(0x1);
+    struct InputBatchHandler {
+        platform::EventHandler<void(const platform::InputBatch &)> batch;
+    };
+    
+    struct FileChangeHandler {
+        std::string dirPath;
+        platform::EventHandler<void(const char *)> changed;
+    };
     
-    std::unordered_map<platform::EventHandlersToken, KeyboardEventHandler> _keyboardEventHandlers;
-    std::unordered_map<platform::EventHandlersToken, InputEventHandler> _inputEventHandlers;
-    std::unordered_map<platform::EventHandlersToken, MouseEventHandler> _mouseEventHandlers;
-    std::unordered_map<platform::EventHandlersToken, TouchEventHandler> _touchEventHandlers;
-    std::unordered_map<platform::EventHandlersToken, GamepadEventHandler> _gamepadEventHandlers;
+    constexpr std::size_t ASYNC_LOAD_THREAD_COUNT = 2;
+    constexpr std::size_t ASYNC_LOAD_IN_FLIGHT_MAX = 16;
+    constexpr std::size_t LOG_THREAD_BUFFER_SIZE = 64 * 1024;
+    constexpr std::size_t POST_QUEUE_CAPACITY = 4096;
+    
+    platform::EventHandlerTable<KeyboardEventHandler> _keyboardEventHandlers (0);
+    platform::EventHandlerTable<InputEventHandler> _inputEventHandlers (1);
+    platform::EventHandlerTable<MouseEventHandler> _mouseEventHandlers (2);
+    platform::EventHandlerTable<TouchEventHandler> _touchEventHandlers (3);
+    platform::EventHandlerTable<GamepadEventHandler> _gamepadEventHandlers (4);
+    platform::EventHandlerTable<InputBatchHandler> _inputBatchHandlers (5);
+    platform::EventHandlerTable<FileChangeHandler> _fileChangeHandlers (6);
+    platform::InputQueue _inputQueue;
+    platform::FrameScheduler _frameScheduler;
+    platform::PostQueue _postQueue (POST_QUEUE_CAPACITY);
+    std::vector<platform::InputEvent> _injectedEvents;
+    std::vector<platform::InputEvent> _injectedFrameEvents;
+    std::unique_ptr<platform::InputRecorder> _inputRecorder;
+    std::unique_ptr<platform::InputReplay> _inputReplay;
+    std::vector<std::string> _changedFiles;
     
     double _nativeScreenScale;
     std::shared_ptr<platform::IOSPlatform> _platform;
     void *_glContext;
     
-    void writeLog(const char *type, const char *fmt, va_list args) {
-        static std::mutex _logGuard;
-        std::lock_guard<std::mutex> guard(_logGuard);
+    platform::AsyncLog &getLog() {
+        static platform::AsyncLog log ([](platform::LogLevel, const char *line) { std::printf("%s\n", line); }, LOG_THREAD_BUFFER_SIZE);
+        
+        return log;
+    }
+    
+    // Passes event to handlers, recorder and batched input queue. Used for both device and replayed events
+    // @timeSec - time of the event for batched input
+    void dispatchInputRecord(const platform::InputRecord &record, double timeSec) {
+        PLATFORM_PROFILE_ZONE("Platform::dispatchInput");
+        PLATFORM_COUNTER_ZONE("Platform::dispatchInput");
+        
+        _frameScheduler.notifyActivity();
+        
+        if (_inputRecorder) {
+            platform::InputRecord recorded = record;
+            recorded.timeSec = _inputRecorder->getTimeSec();
+            _inputRecorder->write(recorded);
+        }
+        
+        platform::InputEvent event;
+        event.coalescedCount = 1;
+        event.timeSec = timeSec;
+        
+        switch (record.type) {
+            case platform::InputRecordType::KEY_DOWN:
+            case platform::InputRecordType::KEY_UP:
+                _keyboardEventHandlers.dispatch([&record](const KeyboardEventHandler &handlers) {
+                    const auto &handler = record.type == platform::InputRecordType::KEY_DOWN ? handlers.down : handlers.up;
+                    
+                    if (handler) {
+                        handler(record.keyboard);
+                    }
+                });
+                
+                event.type = record.type == platform::InputRecordType::KEY_DOWN ? platform::InputEventType::KEY_DOWN : platform::InputEventType::KEY_UP;
+                event.keyboard = record.keyboard;
+                break;
+            case platform::InputRecordType::INPUT:
+                _inputEventHandlers.dispatch([&record](const InputEventHandler &handlers) {
+                    if (handlers.input) {
+                        handlers.input(record.utf8char);
+                    }
+                });
+                return;
+            case platform::InputRecordType::BACKSPACE:
+                _inputEventHandlers.dispatch([](const InputEventHandler &handlers) {
+                    if (handlers.backspace) {
+                        handlers.backspace();
+                    }
+                });
+                return;
+            case platform::InputRecordType::MOUSE_PRESS:
+            case platform::InputRecordType::MOUSE_MOVE:
+            case platform::InputRecordType::MOUSE_RELEASE:
+                _mouseEventHandlers.dispatch([&record](const MouseEventHandler &handlers) {
+                    const auto &handler = record.type == platform::InputRecordType::MOUSE_PRESS ? handlers.press : (record.type == platform::InputRecordType::MOUSE_MOVE ? handlers.move : handlers.release);
+                    
+                    if (handler) {
+                        handler(record.mouse);
+                    }
+                });
+                
+                event.type = platform::InputEventType(int(platform::InputEventType::MOUSE_PRESS) + int(record.type) - int(platform::InputRecordType::MOUSE_PRESS));
+                event.mouse = record.mouse;
+                break;
+            case platform::InputRecordType::TOUCH_START:
+            case platform::InputRecordType::TOUCH_MOVE:
+            case platform::InputRecordType::TOUCH_FINISH:
+                _touchEventHandlers.dispatch([&record](const TouchEventHandler &handlers) {
+                    const auto &handler = record.type == platform::InputRecordType::TOUCH_START ? handlers.start : (record.type == platform::InputRecordType::TOUCH_MOVE ? handlers.move : handlers.release);
+                    
+                    if (handler) {
+                        handler(record.touch);
+                    }
+                });
+                
+                event.type = platform::InputEventType(int(platform::InputEventType::TOUCH_START) + int(record.type) - int(platform::InputRecordType::TOUCH_START));
+                event.touch = record.touch;
+                break;
+            default:
+                return;
+        }
+        
+        // events are queued only while batched input mode has handlers
+        if (_inputBatchHandlers.empty() == false) {
+            _inputQueue.push(event);
+        }
+    }
+    
+    // Injected event goes the same way as device one
+    void dispatchInjectedEvent(const platform::InputEvent &event) {
+        platform::InputRecord record;
         
-        char buffer[32];
-        std::time_t t = std::time(nullptr);
-        std::strftime(buffer, sizeof(buffer), "%T", std::gmtime(&t));
+        switch (event.type) {
+            case platform::InputEventType::KEY_DOWN:
+            case platform::InputEventType::KEY_UP:
+                record.type = event.type == platform::InputEventType::KEY_DOWN ? platform::InputRecordType::KEY_DOWN : platform::InputRecordType::KEY_UP;
+                record.keyboard = event.keyboard;
+                break;
+            case platform::InputEventType::MOUSE_PRESS:
+            case platform::InputEventType::MOUSE_MOVE:
+            case platform::InputEventType::MOUSE_RELEASE:
+                record.type = platform::InputRecordType(int(platform::InputRecordType::MOUSE_PRESS) + int(event.type) - int(platform::InputEventType::MOUSE_PRESS));
+                record.mouse = event.mouse;
+                break;
+            case platform::InputEventType::TOUCH_START:
+            case platform::InputEventType::TOUCH_MOVE:
+            case platform::InputEventType::TOUCH_FINISH:
+                record.type = platform::InputRecordType(int(platform::InputRecordType::TOUCH_START) + int(event.type) - int(platform::InputEventType::TOUCH_START));
+                record.touch = event.touch;
+                break;
+            default:
+                return;
+        }
         
-        std::printf("[%s %s] ", buffer, type);
-        std::vprintf(fmt, args);
-        std::printf("\n");
+        dispatchInputRecord(record, event.timeSec);
+    }
+    
+    void handleTouch(platform::InputRecordType type, const platform::TouchEventArgs &args, double timeSec) {
+        if (_inputReplay == nullptr) {
+            platform::InputRecord record;
+            record.type = type;
+            record.touch = args;
+            dispatchInputRecord(record, timeSec);
+        }
     }
 }
 
@@ -102,9 +257,6 @@ RootViewController *controller; // global
 @end
 
 @implementation RootViewController
-{
-    std::chrono::time_point<std::chrono::high_resolution_clock> _lastTime;
-}
 
 - (void)viewDidLoad {
     [super viewDidLoad];
@@ -127,9 +279,7 @@ RootViewController *controller; // global
     #endif
     
     self.inputEnabled = NO;
-    self.preferredFramesPerSecond = 60;
-    
-    _lastTime = std::chrono::high_resolution_clock::now();
+    [self updateFrameRate];
 }
 - (BOOL)hasText { return NO; }
 - (BOOL)canBecomeFirstResponder { return self.inputEnabled; }
@@ -145,15 +295,28 @@ RootViewController *controller; // global
 
 }
 
-- (void)glkView:(GLKView *)view drawInRect:(CGRect)rect {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto dtSec = double(std::chrono::duration_cast<std::chrono::microseconds>(now - _lastTime).count()) / 1000000.0;
+- (void)updateFrameRate {
+    const float frameRate = _frameScheduler.getFrameRate();
+    const NSInteger framesPerSecond = frameRate > 0.0f ? NSInteger(frameRate + 0.5f) : [UIScreen mainScreen].maximumFramesPerSecond;
+    
+    if (self.preferredFramesPerSecond != framesPerSecond) {
+        self.preferredFramesPerSecond = framesPerSecond;
+    }
+}
 
+- (void)glkView:(GLKView *)view drawInRect:(CGRect)rect {
     if (_platform != nullptr && _platform->updateAndDrawHandler) {
-        _platform->updateAndDrawHandler(float(dtSec));
+        _platform->nextProfileFrame();
+        
+        {
+            PLATFORM_PROFILE_ZONE("Frame");
+            _platform->updateAndDrawHandler(_platform->beginFrame(_frameScheduler.beginFrame()));
+            _frameScheduler.endFrame();
+        }
     }
 
-    _lastTime = now;
+    // target frame rate and idle throttling are applied through display link
+    [self updateFrameRate];
 }
 
 // TODO: copypasta!
@@ -174,11 +337,7 @@ RootViewController *controller; // global
         args.coordinateX *= _nativeScreenScale;
         args.coordinateY *= _nativeScreenScale;
 
-        for (auto &index : _touchEventHandlers) {
-            if (index.second.start) {
-                index.second.start(args);
-            }
-        }
+        handleTouch(platform::InputRecordType::TOUCH_START, args, [item timestamp]);
     }
 }
 
@@ -198,11 +357,7 @@ RootViewController *controller; // global
         args.coordinateX *= _nativeScreenScale;
         args.coordinateY *= _nativeScreenScale;
 
-        for (auto &index : _touchEventHandlers) {
-            if (index.second.move) {
-                index.second.move(args);
-            }
-        }
+        handleTouch(platform::InputRecordType::TOUCH_MOVE, args, [item timestamp]);
     }
 }
 
@@ -222,11 +377,7 @@ RootViewController *controller; // global
         args.coordinateX *= _nativeScreenScale;
         args.coordinateY *= _nativeScreenScale;
 
-        for (auto &index : _touchEventHandlers) {
-            if (index.second.release) {
-                index.second.release(args);
-            }
-        }
+        handleTouch(platform::InputRecordType::TOUCH_FINISH, args, [item timestamp]);
     }
 }
 
@@ -246,11 +397,7 @@ RootViewController *controller; // global
         args.coordinateX *= _nativeScreenScale;
         args.coordinateY *= _nativeScreenScale;
 
-        for (auto &index : _touchEventHandlers) {
-            if (index.second.release) {
-                index.second.release(args);
-            }
-        }
+        handleTouch(platform::InputRecordType::TOUCH_FINISH, args, [item timestamp]);
     }
 }
 
@@ -258,6 +405,71 @@ RootViewController *controller; // global
 
 //--------------------------------------------------------------------------------------------------------------------------------
 
+namespace platform {
+    class FileViewImp : public FileView {
+    public:
+        FileViewImp(void *data, std::size_t size) : _data(data), _size(size) {
+            if (_data) {
+                MemoryTracker::allocated(MemoryCategory::FILES, size);
+            }
+        }
+        FileViewImp(const std::shared_ptr<FileView> &owner, const std::uint8_t *data, std::size_t size) : _owner(owner), _data(const_cast<std::uint8_t *>(data)), _size(size) {}
+        FileViewImp(std::unique_ptr<std::uint8_t[]> &&storage, std::size_t size) : _storage(std::move(storage)), _data(_storage.get()), _size(size) {
+            if (_data) {
+                MemoryTracker::allocated(MemoryCategory::FILES, size);
+            }
+        }
+        ~FileViewImp() {
+            // slices share memory of their owner
+            if (_data && _owner == nullptr) {
+                MemoryTracker::freed(MemoryCategory::FILES, _size);
+            }
+            if (_data && _owner == nullptr && _storage == nullptr) {
+                ::munmap(_data, _size);
+            }
+        }
+        
+        const std::uint8_t *getData() const {
+            return static_cast<const std::uint8_t *>(_data);
+        }
+        
+        std::size_t getSize() const {
+            return _size;
+        }
+        
+        void releasePages(std::size_t offset, std::size_t size) const {
+            // decompressed entries live in heap, they have nothing to drop
+            if (_storage == nullptr && _data && offset < _size) {
+                const std::uintptr_t pageSize = std::uintptr_t(::getpagesize());
+                const std::uintptr_t begin = (std::uintptr_t(_data) + offset + pageSize - 1) & ~(pageSize - 1);
+                const std::uintptr_t end = (std::uintptr_t(_data) + offset + std::min(size, _size - offset)) & ~(pageSize - 1);
+                
+                if (begin < end) {
+                    ::madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+                }
+            }
+        }
+        
+    private:
+        std::shared_ptr<FileView> _owner;   // archive mapping for slices
+        std::unique_ptr<std::uint8_t[]> _storage;   // decompressed archive entry
+        void *_data;
+        std::size_t _size;
+    };
+    
+    const std::uint8_t *FileView::getData() const {
+        return static_cast<const FileViewImp *>(this)->getData();
+    }
+    
+    std::size_t FileView::getSize() const {
+        return static_cast<const FileViewImp *>(this)->getSize();
+    }
+    
+    void FileView::releasePages(std::size_t offset, std::size_t size) const {
+        static_cast<const FileViewImp *>(this)->releasePages(offset, size);
+    }
+}
+
 namespace platform {
     IOSPlatform::IOSPlatform() {
         CGRect bounds = [[UIScreen mainScreen] bounds];
@@ -271,52 +483,54 @@ namespace platform {
         _nativeScreenHeight = float(bounds.size.height * _nativeScreenScale);
         #endif
         
-        logInfo("[Platform] Platform: OK");
+        _fileLoader = std::make_unique<AsyncFileLoader>(*this, ASYNC_LOAD_THREAD_COUNT, ASYNC_LOAD_IN_FLIGHT_MAX);
+        _profileCapture = std::make_unique<ProfileCapture>(*this);
+        _perfCounters = std::make_unique<PerfCounterCollector>();
+        _frameArena = std::make_unique<FrameArena>();
+        _jobSystem = std::make_unique<JobSystem>(0);
+        PLATFORM_LOG_INFO(this, "[Platform] Platform: OK");
     }
     
     IOSPlatform::~IOSPlatform() {
     
     }
     
-    void Platform::logInfo(const char *fmt, ...) {
-        va_list args;
-        va_start(args, fmt);
-        writeLog("Info", fmt, args);
-        va_end(args);
-    }
-    
-    void Platform::logWarning(const char *fmt, ...) {
+    void Platform::writeLog(LogLevel level, const char *fmt, ...) {
         va_list args;
         va_start(args, fmt);
-        writeLog("Warning", fmt, args);
-        va_end(args);
-    }
-    
-    void Platform::logError(const char *fmt, ...) {
-        va_list args;
-        va_start(args, fmt);
-        writeLog("Error", fmt, args);
+        getLog().write(level, fmt, args);
         va_end(args);
     }
     
     std::vector<std::string> IOSPlatform::formFileList(const char *dirPath) {
         std::vector<std::string> result;
         
-        @autoreleasepool {
-            NSString *basedir = [[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:@(dirPath)];
-            NSArray  *list = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:basedir error:nil];
+        _getFileIndex(dirPath, false, true).forEach(dirPath, nullptr, false, [&result](const FileInfo &info) {
+            result.emplace_back(info.path, info.pathLength);
+        });
+        
+        return result;
+    }
     
-            auto &resultref = result;
-            
-            [list enumerateObjectsUsingBlock:^(NSString *entry, NSUInteger idx, BOOL *stop) {
-                resultref.emplace_back(std::string([entry fileSystemRepresentation], [entry length]));
-            }];
-        }
+    void IOSPlatform::enumerateFiles(const char *dirPath, const char *pattern, bool recursive, const std::function<void(const FileInfo &)> &visitor) {
+        _getFileIndex(dirPath, recursive, false).forEach(dirPath, pattern, recursive, visitor);
+    }
     
-        return result;
+    bool IOSPlatform::getFileInfo(const char *filePath, FileInfo &info) {
+        const char *separator = std::strrchr(filePath, '/');
+        const std::string dirPath = separator ? std::string(filePath, separator) : std::string();
+        return _getFileIndex(dirPath.c_str(), false, false).find(filePath, info);
     }
     
     bool IOSPlatform::loadFile(const char *filePath, std::unique_ptr<uint8_t[]> &data, std::size_t &size) {
+        PLATFORM_PROFILE_ZONE("Platform::loadFile");
+        
+        for (auto index = _archives.rbegin(); index != _archives.rend(); ++index) {
+            if (const AssetArchiveEntry *entry = (*index)->find(filePath)) {
+                return (*index)->load(*entry, data, size);
+            }
+        }
+        
         std::string fullPath;
         
         @autoreleasepool {
@@ -336,12 +550,190 @@ namespace platform {
             return stream.gcount() == size;
         }
         else {
-            logError("[Platform] File %s is not found", filePath);
+            PLATFORM_LOG_ERROR(this, "[Platform] File %s is not found", filePath);
+        }
+        
+        return false;
+    }
+    
+    bool IOSPlatform::loadFile(const char *filePath, std::uint8_t *buffer, std::size_t capacity, std::size_t &size) {
+        PLATFORM_PROFILE_ZONE("Platform::loadFile");
+        
+        for (auto index = _archives.rbegin(); index != _archives.rend(); ++index) {
+            if (const AssetArchiveEntry *entry = (*index)->find(filePath)) {
+                size = std::size_t(entry->size);
+                return size <= capacity && (*index)->read(*entry, buffer);
+            }
+        }
+        
+        std::string fullPath;
+        
+        @autoreleasepool {
+            fullPath = [[[NSBundle mainBundle] resourcePath] cStringUsingEncoding:NSUTF8StringEncoding];
+            fullPath += "/";
+            fullPath += filePath;
+        }
+        
+        std::ifstream stream (fullPath, std::ios::binary | std::ios::ate);
+        
+        if (stream.is_open()) {
+            stream.clear();
+            size = stream.tellg();
+            
+            if (size <= capacity) {
+                stream.seekg(0);
+                stream.read(reinterpret_cast<char *>(buffer), size);
+                return stream.gcount() == size;
+            }
+        }
+        else {
+            PLATFORM_LOG_ERROR(this, "[Platform] File %s is not found", filePath);
+        }
+        
+        return false;
+    }
+    
+    std::shared_ptr<FileView> IOSPlatform::mapFile(const char *filePath, FileAccess access) {
+        for (auto index = _archives.rbegin(); index != _archives.rend(); ++index) {
+            if (const AssetArchiveEntry *entry = (*index)->find(filePath)) {
+                if (entry->flags & ASSET_ARCHIVE_ENTRY_COMPRESSED) {
+                    std::unique_ptr<std::uint8_t[]> data;
+                    std::size_t size = 0;
+                    
+                    if ((*index)->load(*entry, data, size)) {
+                        return std::make_shared<FileViewImp>(std::move(data), size);
+                    }
+                    
+                    PLATFORM_LOG_ERROR(this, "[Platform] File %s cannot be decompressed", filePath);
+                    return nullptr;
+                }
+                
+                return std::make_shared<FileViewImp>((*index)->getView(), (*index)->getData(*entry), std::size_t(entry->size));
+            }
+        }
+        
+        std::string fullPath;
+        
+        @autoreleasepool {
+            fullPath = [[[NSBundle mainBundle] resourcePath] cStringUsingEncoding:NSUTF8StringEncoding];
+            fullPath += "/";
+            fullPath += filePath;
+        }
+        
+        int fd = ::open(fullPath.c_str(), O_RDONLY);
+        
+        if (fd < 0) {
+            PLATFORM_LOG_ERROR(this, "[Platform] File %s is not found", filePath);
+            return nullptr;
+        }
+        
+        std::shared_ptr<FileView> result;
+        struct stat st;
+        
+        if (::fstat(fd, &st) == 0) {
+            std::size_t size = std::size_t(st.st_size);
+            
+            if (size) {
+                void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                
+                if (data != MAP_FAILED) {
+                    ::posix_madvise(data, size, access == FileAccess::RANDOM ? POSIX_MADV_RANDOM : POSIX_MADV_SEQUENTIAL);
+                    result = std::make_shared<FileViewImp>(data, size);
+                }
+                else {
+                    PLATFORM_LOG_ERROR(this, "[Platform] File %s cannot be mapped", filePath);
+                }
+            }
+            else {
+                result = std::make_shared<FileViewImp>(nullptr, 0);
+            }
+        }
+        
+        ::close(fd);
+        return result;
+    }
+    
+    bool IOSPlatform::mountArchive(const char *archivePath) {
+        std::unique_ptr<AssetArchive> archive = std::make_unique<AssetArchive>(mapFile(archivePath, FileAccess::RANDOM));
+        
+        if (archive->isValid()) {
+            _archives.emplace_back(std::move(archive));
+            _fileIndex = nullptr;
+            return true;
         }
         
+        PLATFORM_LOG_ERROR(this, "[Platform] File %s is not a valid archive", archivePath);
         return false;
     }
     
+    const FileIndex &IOSPlatform::_getFileIndex(const char *dirPath, bool recursive, bool refresh) {
+        if (_fileIndex == nullptr) {
+            _fileIndex = std::make_unique<FileIndex>();
+            
+            for (const auto &archive : _archives) {
+                _fileIndex->addArchive(*archive);
+            }
+        }
+        
+        // only requested directories are scanned
+        if (refresh || _fileIndex->hasDirectory(dirPath, recursive) == false) {
+            @autoreleasepool {
+                _fileIndex->addDirectory([[[NSBundle mainBundle] resourcePath] fileSystemRepresentation], dirPath, recursive);
+            }
+        }
+        
+        return *_fileIndex;
+    }
+    
+    FileLoadToken IOSPlatform::loadFileAsync(
+        const char *filePath,
+        LoadPriority priority,
+        std::function<void(bool, std::unique_ptr<uint8_t[]> &, std::size_t)> &&completion
+    )
+    {
+        return _fileLoader->load(filePath, priority, std::move(completion));
+    }
+    
+    bool IOSPlatform::cancelFileLoad(FileLoadToken token) {
+        return _fileLoader->cancel(token);
+    }
+    
+    EventHandlersToken IOSPlatform::addFileChangeHandler(const char *dirPath, EventHandler<void(const char *filePath)> &&changed) {
+        if (_fileWatcher == nullptr) {
+            // bundle resources can be changed in simulator builds, device bundle is read-only
+            @autoreleasepool {
+                _fileWatcher = std::make_unique<FileWatcher>([[[NSBundle mainBundle] resourcePath] fileSystemRepresentation]);
+            }
+        }
+        
+        if (_fileWatcher->watch(dirPath) == false) {
+            PLATFORM_LOG_ERROR(this, "[Platform] Can't watch directory '%s'", dirPath);
+            return nullptr;
+        }
+        
+        return _fileChangeHandlers.add(FileChangeHandler{ dirPath, std::move(changed) });
+    }
+    
+    void IOSPlatform::post(Job &&task) {
+        _postQueue.post(std::move(task));
+    }
+    
+    std::shared_ptr<JobGroup> IOSPlatform::createJobGroup(std::initializer_list<std::shared_ptr<JobGroup>> dependencies) {
+        return _jobSystem->createGroup(dependencies);
+    }
+    
+    void IOSPlatform::waitJobGroup(const std::shared_ptr<JobGroup> &group) {
+        _jobSystem->wait(group);
+    }
+    
+    void IOSPlatform::parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t begin, std::size_t end)> &body) {
+        _jobSystem->parallelFor(count, grainSize, body);
+    }
+    
+    std::size_t IOSPlatform::getJobWorkerCount() const {
+        return _jobSystem->getWorkerCount();
+    }
+    
     float IOSPlatform::getNativeScreenWidth() const {
         return _nativeScreenWidth;
     }
@@ -378,58 +770,135 @@ namespace platform {
     }
     
     EventHandlersToken IOSPlatform::addKeyboardEventHandlers(
-        std::function<void(const KeyboardEventArgs &)> &&down,
-        std::function<void(const KeyboardEventArgs &)> &&up
+        EventHandler<void(const KeyboardEventArgs &)> &&down,
+        EventHandler<void(const KeyboardEventArgs &)> &&up
     )
     {
-        _keyboardEventHandlers.emplace(++_lastTokenGen, KeyboardEventHandler{ std::move(down), std::move(up) });
-        return _lastTokenGen;
+        return _keyboardEventHandlers.add(KeyboardEventHandler{ std::move(down), std::move(up) });
     }
     
     EventHandlersToken IOSPlatform::addInputEventHandlers(
-        std::function<void(const char (&utf8char)[4])> &&input,
-        std::function<void()> &&backspace
+        EventHandler<void(const char (&utf8char)[4])> &&input,
+        EventHandler<void()> &&backspace
     )
     {
-        _inputEventHandlers.emplace(++_lastTokenGen, InputEventHandler{ std::move(input), std::move(backspace) });
-        return _lastTokenGen;
+        return _inputEventHandlers.add(InputEventHandler{ std::move(input), std::move(backspace) });
     }
     
     EventHandlersToken IOSPlatform::addMouseEventHandlers(
-        std::function<void(const MouseEventArgs &)> &&press,
-        std::function<void(const MouseEventArgs &)> &&move,
-        std::function<void(const MouseEventArgs &)> &&release
+        EventHandler<void(const MouseEventArgs &)> &&press,
+        EventHandler<void(const MouseEventArgs &)> &&move,
+        EventHandler<void(const MouseEventArgs &)> &&release
     )
     {
-        _mouseEventHandlers.emplace(++_lastTokenGen, MouseEventHandler{ std::move(press), std::move(move), std::move(release) });
-        return _lastTokenGen;
+        return _mouseEventHandlers.add(MouseEventHandler{ std::move(press), std::move(move), std::move(release) });
     }
     
     EventHandlersToken IOSPlatform::addTouchEventHandlers(
-        std::function<void(const TouchEventArgs &)> &&start,
-        std::function<void(const TouchEventArgs &)> &&move,
-        std::function<void(const TouchEventArgs &)> &&release
+        EventHandler<void(const TouchEventArgs &)> &&start,
+        EventHandler<void(const TouchEventArgs &)> &&move,
+        EventHandler<void(const TouchEventArgs &)> &&release
     )
     {
-        _touchEventHandlers.emplace(++_lastTokenGen, TouchEventHandler{ std::move(start), std::move(move), std::move(release) });
-        return _lastTokenGen;
+        return _touchEventHandlers.add(TouchEventHandler{ std::move(start), std::move(move), std::move(release) });
     }
     
     EventHandlersToken IOSPlatform::addGamepadEventHandlers(
-        std::function<void(const GamepadEventArgs &)> &&buttonPress,
-        std::function<void(const GamepadEventArgs &)> &&buttonRelease
+        EventHandler<void(const GamepadEventArgs &)> &&buttonPress,
+        EventHandler<void(const GamepadEventArgs &)> &&buttonRelease
     )
     {
-        _gamepadEventHandlers.emplace(++_lastTokenGen, GamepadEventHandler{ std::move(buttonPress), std::move(buttonRelease) });
-        return _lastTokenGen;
+        return _gamepadEventHandlers.add(GamepadEventHandler{ std::move(buttonPress), std::move(buttonRelease) });
+    }
+    
+    EventHandlersToken IOSPlatform::addInputBatchHandler(EventHandler<void(const InputBatch &)> &&batch) {
+        return _inputBatchHandlers.add(InputBatchHandler{ std::move(batch) });
+    }
+    
+    bool IOSPlatform::startInputRecording(const char *filePath) {
+        std::unique_ptr<InputRecorder> recorder (new InputRecorder (filePath));
+        
+        if (recorder->isValid() == false) {
+            PLATFORM_LOG_ERROR(this, "[Platform] Can't create input recording '%s'", filePath);
+            return false;
+        }
+        
+        _inputRecorder = std::move(recorder);
+        return true;
+    }
+    
+    bool IOSPlatform::startInputReplay(const char *filePath) {
+        std::unique_ptr<uint8_t[]> data;
+        std::size_t size = 0;
+        
+        if (loadFile(filePath, data, size)) {
+            std::unique_ptr<InputReplay> replay (new InputReplay (std::move(data), size));
+            
+            if (replay->isValid()) {
+                _inputReplay = std::move(replay);
+                return true;
+            }
+        }
+        
+        PLATFORM_LOG_ERROR(this, "[Platform] Can't load input recording '%s'", filePath);
+        return false;
+    }
+    
+    void IOSPlatform::injectInputEvent(const InputEvent &event) {
+        _injectedEvents.emplace_back(event);
     }
     
     void IOSPlatform::removeEventHandlers(EventHandlersToken token) {
-        _keyboardEventHandlers.erase(token);
-        _inputEventHandlers.erase(token);
-        _mouseEventHandlers.erase(token);
-        _touchEventHandlers.erase(token);
-        _gamepadEventHandlers.erase(token);
+        // token belongs to one table, others reject it by its kind bits
+        _keyboardEventHandlers.remove(token) || _inputEventHandlers.remove(token) || _mouseEventHandlers.remove(token) || _touchEventHandlers.remove(token) || _gamepadEventHandlers.remove(token) || _inputBatchHandlers.remove(token) || _fileChangeHandlers.remove(token);
+    }
+    
+    void IOSPlatform::setFramePacing(const FramePacing &pacing) {
+        FramePacing supported = pacing;
+        
+        // frame is drawn in display callback after touches have been delivered by run loop, delaying it adds latency
+        if (supported.latencyMode == FrameLatencyMode::LOW) {
+            PLATFORM_LOG_WARNING(this, "[Platform] Low latency mode isn't supported, default mode is used");
+            supported.latencyMode = FrameLatencyMode::DEFAULT;
+        }
+        
+        _frameScheduler.setPacing(supported);
+    }
+    
+    void IOSPlatform::notifyActivity() {
+        _frameScheduler.notifyActivity();
+    }
+    
+    FrameTimeHistogram IOSPlatform::getFrameTimeHistogram(bool reset) {
+        return _frameScheduler.getHistogram(reset);
+    }
+    
+    bool IOSPlatform::captureProfile(std::uint32_t frameCount, const char *filePath) {
+        return _profileCapture->start(frameCount, filePath);
+    }
+    
+    bool IOSPlatform::enablePerfCounters(bool enable) {
+        return _perfCounters->enable(enable);
+    }
+    
+    std::vector<PerfCounterStats> IOSPlatform::getPerfCounterStats() const {
+        return _perfCounters->getStats();
+    }
+    
+    std::string IOSPlatform::formatPerfCounterStats(PerfCounterFormat format) const {
+        return _perfCounters->format(format);
+    }
+    
+    MemoryStats IOSPlatform::getMemoryStats(MemoryCategory category) const {
+        return MemoryTracker::getStats(category);
+    }
+    
+    void *IOSPlatform::allocFrameMemory(std::size_t size, std::size_t alignment) {
+        return _frameArena->allocate(size, alignment);
+    }
+    
+    FrameArenaStats IOSPlatform::getFrameArenaStats() const {
+        return _frameArena->getStats();
     }
     
     void IOSPlatform::run(std::function<void(float)> &&updateAndDraw) {
@@ -441,10 +910,89 @@ namespace platform {
         }
     }
     
+    void IOSPlatform::run(std::function<void(float)> &&update, std::function<void(float)> &&draw) {
+        run([update = std::move(update), draw = std::move(draw)](float dtSec) {
+            const std::uint32_t stepCount = _frameScheduler.takeFixedSteps(dtSec);
+            
+            for (std::uint32_t i = 0; i < stepCount; i++) {
+                update(_frameScheduler.getPacing().fixedStepSec);
+            }
+            
+            draw(_frameScheduler.getInterpolationAlpha());
+        });
+    }
+    
     void IOSPlatform::exit() {
     
     }
     
+    void IOSPlatform::nextProfileFrame() {
+        _profileCapture->nextFrame();
+        _perfCounters->nextFrame();
+        MemoryTracker::nextFrame();
+        _frameArena->nextFrame();
+    }
+    
+    float IOSPlatform::beginFrame(float dtSec) {
+        PLATFORM_PROFILE_ZONE("Platform::beginFrame");
+        
+        _fileLoader->dispatchCompletions();
+        _postQueue.run(_frameScheduler.getPacing().postBudgetSec);
+        
+        if (_fileWatcher) {
+            _changedFiles.clear();
+            _fileWatcher->takeChanges(_changedFiles);
+            
+            if (_changedFiles.size()) {
+                // index doesn't know about created and removed files
+                _fileIndex = nullptr;
+            }
+            
+            for (const std::string &path : _changedFiles) {
+                _fileChangeHandlers.dispatch([&path](const FileChangeHandler &handlers) {
+                    if (handlers.changed && FileWatcher::isInDirectory(path, handlers.dirPath.c_str())) {
+                        handlers.changed(path.c_str());
+                    }
+                });
+            }
+        }
+        
+        if (_inputReplay && _inputReplay->nextFrame(dtSec, [](const InputRecord &record) { dispatchInputRecord(record, record.timeSec); }) == false) {
+            // device input is used after the end of replay
+            _inputReplay = nullptr;
+        }
+        
+        // events injected by handlers go to the next frame
+        _injectedEvents.swap(_injectedFrameEvents);
+        
+        for (const InputEvent &event : _injectedFrameEvents) {
+            dispatchInjectedEvent(event);
+        }
+        
+        _injectedFrameEvents.clear();
+        
+        if (_inputRecorder) {
+            InputRecord record;
+            record.type = InputRecordType::FRAME;
+            record.dtSec = dtSec;
+            _inputRecorder->write(record);
+        }
+        
+        const InputBatch batch = _inputQueue.flush();
+        
+        if (batch.rawCount) {
+            PLATFORM_PROFILE_ZONE("Platform::dispatchInputBatch");
+            
+            _inputBatchHandlers.dispatch([&batch](const InputBatchHandler &handlers) {
+                if (handlers.batch) {
+                    handlers.batch(batch);
+                }
+            });
+        }
+        
+        return dtSec;
+    }
+    
     std::shared_ptr<Platform> getPlatformInstance() {
         if (_platform == nullptr) {
             _platform = std::make_shared<platform::IOSPlatform>();
@@ -3,7 +3,14 @@
 #define GLES_SILENCE_DEPRECATION
 #import <GLKit/GLKit.h>
 
+#include <unordered_map>
+
 namespace platform {
+    class ShaderImp;
+    class StructuredDataImp;
+    class CommandListImp;
+    class DrawSorter;
+    
     class IOSRender : public RenderingDevice {
     public:
         IOSRender(const std::shared_ptr<Platform> &platform);
@@ -18,6 +25,8 @@ namespace platform {
             const void *prmnt
         );
         
+        bool reloadShader(const std::shared_ptr<Shader> &shader, const char *shadersrc, const void *prmnt);
+        
         std::shared_ptr<Texture2D> createTexture(
             Texture2D::Format format,
             std::uint32_t width,
@@ -25,6 +34,23 @@ namespace platform {
             const std::initializer_list<const std::uint8_t *> &mipsData
         );
         
+        std::shared_ptr<Texture2D> createTexture(
+            Texture2D::Format format,
+            std::uint32_t width,
+            std::uint32_t height,
+            const std::uint8_t *const *mipsData,
+            std::uint32_t mipCount
+        );
+        
+        void reloadTexture(
+            const std::shared_ptr<Texture2D> &texture,
+            Texture2D::Format format,
+            std::uint32_t width,
+            std::uint32_t height,
+            const std::uint8_t *const *mipsData,
+            std::uint32_t mipCount
+        );
+        
         std::shared_ptr<StructuredData> createData(const void *data, std::uint32_t count, std::uint32_t stride);
         
         void applyShader(const std::shared_ptr<Shader> &shader, const void *constants);
@@ -39,11 +65,65 @@ namespace platform {
             Topology topology
         );
         
+        std::shared_ptr<CommandList> createCommandList();
+        void submitCommandList(const std::shared_ptr<CommandList> &list, bool sorted);
+        
         void prepareFrame();
         void presentFrame(float dtSec);
         void getFrameBufferData(std::uint8_t *imgFrame);
+        
+        RenderStats getStats() const;
+        
+        // Called by destructors of GL objects. GL unbinds deleted objects itself
+        void forgetProgram(GLuint program, GLuint permanentConstBlockBuffer);
+        void forgetTexture(GLuint texture);
+        
+        // Called by destructors of shaders and data, cached vertex arrays that use them are deleted
+        void forgetShader(const ShaderImp *shader);
+        void forgetData(GLuint buffer);
 
     private:
+        std::shared_ptr<ShaderImp> _buildShader(
+            const char *shadersrc,
+            std::vector<ShaderInput> &&vertex,
+            std::vector<ShaderInput> &&instance,
+            const void *prmnt
+        );
+        
+        void _executeSortedDraws();
+        
+        // Constants are sub-allocated from part of ring that belongs to current frame, ring grows if the part is full
+        // @return - offset of constants in ring
+        std::size_t _allocateConstants(std::size_t size);
+        std::size_t _uploadConstants(const void *constants, std::size_t size);
+        std::size_t _uploadConstants(const CommandListImp &list);
+        void *_mapConstants(std::size_t offset, std::size_t size);
+        void _unmapConstants();
+        void _resizeConstRing(std::size_t partSize);
+        void _advanceConstRing();
+        void _bindConstants(std::size_t offset, std::size_t size);
+        
+        // Bind through shadow state, binding equal to the current one is skipped
+        void _useProgram(GLuint program);
+        void _bindUniformBuffer(std::size_t index, GLuint buffer);
+        void _bindTexture(GLuint slot, GLuint texture);
+        void _bindVertexArray(GLuint vertexArray);
+        
+        // Vertex array with attributes of shader layout set to buffers of data, created on first use
+        GLuint _getVertexArray(const ShaderImp *shader, const StructuredDataImp *vertexData, const StructuredDataImp *instanceData);
+        void _deleteVertexArray(GLuint vertexArray);
+        
+        // Shared by immediate methods and submitted command lists
+        void _applyShader(const ShaderImp *shader, std::size_t constantsOffset, std::size_t constantsSize);
+        void _applyTextures(const Texture2D *const *textures, std::size_t count);
+        void _drawGeometry(
+            const StructuredDataImp *vertexData,
+            const StructuredDataImp *instanceData,
+            std::uint32_t vertexCount,
+            std::uint32_t instanceCount,
+            Topology topology
+        );
+        
         struct FrameData {
             float viewProjMatrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
             float cameraPosition[4] = {0, 0, 0, 0};
@@ -53,11 +133,58 @@ namespace platform {
         _frameData;
         
         std::shared_ptr<Platform> _platform;
-        std::shared_ptr<Shader> _currentShader;
+        std::shared_ptr<const ShaderImp> _currentShader;
         
         GLuint _shaderFrameDataBuffer;
-        GLuint _shaderConstStreamBuffer;
-        std::size_t _shaderConstStreamOffset;
+        
+        static constexpr std::size_t CONST_RING_FRAME_COUNT = 3;
+        
+        // Constants of applied shaders. Every frame in flight writes its own part of buffer, the part is written again when
+        // fence of the frame that used it before is passed
+        struct ConstRing {
+            GLuint buffer = 0;
+            std::size_t partSize = 0;
+            std::size_t partIndex = 0;                              // part of current frame
+            std::size_t offset = 0;                                 // free space of current part starts here
+            GLsync fences[CONST_RING_FRAME_COUNT] = {};
+        }
+        _constRing;
+        
+        std::size_t _constAlignment;                                // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+        
+        static constexpr std::size_t UNIFORM_BINDING_COUNT = 3;
+        static constexpr std::size_t TEXTURE_SLOT_COUNT = 8;
+        
+        // Bindings of GL context set by this device
+        struct BindingState {
+            GLuint program = 0;
+            GLuint uniformBuffers[UNIFORM_BINDING_COUNT] = {};    // by SHADER_BIND_ index
+            GLuint activeTexture = 0;                               // index of texture unit
+            GLuint textures[TEXTURE_SLOT_COUNT] = {};
+            GLuint vertexArray = 0;
+        }
+        _bindings;
+        
+        struct VertexArrayKey {
+            const ShaderImp *shader;    // owner of attribute layout
+            GLuint vertexBuffer;
+            GLuint instanceBuffer;
+            
+            bool operator ==(const VertexArrayKey &other) const {
+                return shader == other.shader && vertexBuffer == other.vertexBuffer && instanceBuffer == other.instanceBuffer;
+            }
+        };
+        
+        struct VertexArrayKeyHash {
+            std::size_t operator()(const VertexArrayKey &key) const {
+                return (std::hash<const void *>()(key.shader) * 31 + key.vertexBuffer) * 31 + key.instanceBuffer;
+            }
+        };
+        
+        std::unordered_map<VertexArrayKey, GLuint, VertexArrayKeyHash> _vertexArrays;
+        
+        RenderStats _stats;
+        std::unique_ptr<DrawSorter> _drawSorter;
     };
 
     void RenderingDevice::updateCameraTransform(const float (&camPos)[3], const float(&camDir)[3], const float(&camVP)[16]) {
@@ -74,6 +201,10 @@ namespace platform {
         return static_cast<IOSRender *>(this)->createShader(shadersrc, vertex, instance, prmnt);
     }
 
+    bool RenderingDevice::reloadShader(const std::shared_ptr<Shader> &shader, const char *shadersrc, const void *prmnt) {
+        return static_cast<IOSRender *>(this)->reloadShader(shader, shadersrc, prmnt);
+    }
+
     std::shared_ptr<Texture2D> RenderingDevice::createTexture(
         Texture2D::Format format,
         std::uint32_t width,
@@ -84,6 +215,29 @@ namespace platform {
         return static_cast<IOSRender *>(this)->createTexture(format, width, height, mipsData);
     }
 
+    std::shared_ptr<Texture2D> RenderingDevice::createTexture(
+        Texture2D::Format format,
+        std::uint32_t width,
+        std::uint32_t height,
+        const std::uint8_t *const *mipsData,
+        std::uint32_t mipCount
+    )
+    {
+        return static_cast<IOSRender *>(this)->createTexture(format, width, height, mipsData, mipCount);
+    }
+
+    void RenderingDevice::reloadTexture(
+        const std::shared_ptr<Texture2D> &texture,
+        Texture2D::Format format,
+        std::uint32_t width,
+        std::uint32_t height,
+        const std::uint8_t *const *mipsData,
+        std::uint32_t mipCount
+    )
+    {
+        static_cast<IOSRender *>(this)->reloadTexture(texture, format, width, height, mipsData, mipCount);
+    }
+
     std::shared_ptr<StructuredData> RenderingDevice::createData(const void *data, std::uint32_t count, std::uint32_t stride) {
         return static_cast<IOSRender *>(this)->createData(data, count, stride);
     }
@@ -111,6 +265,14 @@ namespace platform {
         static_cast<IOSRender *>(this)->drawGeometry(vertexData, instanceData, vertexCount, instanceCount, topology);
     }
 
+    std::shared_ptr<CommandList> RenderingDevice::createCommandList() {
+        return static_cast<IOSRender *>(this)->createCommandList();
+    }
+    
+    void RenderingDevice::submitCommandList(const std::shared_ptr<CommandList> &list, bool sorted) {
+        static_cast<IOSRender *>(this)->submitCommandList(list, sorted);
+    }
+
     void RenderingDevice::prepareFrame() {
         static_cast<IOSRender *>(this)->prepareFrame();
     }
@@ -122,4 +284,8 @@ namespace platform {
     void RenderingDevice::getFrameBufferData(std::uint8_t *imgFrame) {
         static_cast<IOSRender *>(this)->getFrameBufferData(imgFrame);
     }
+    
+    RenderStats RenderingDevice::getStats() const {
+        return static_cast<const IOSRender *>(this)->getStats();
+    }
 }
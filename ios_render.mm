@@ -1,6 +1,9 @@
 #include "interfaces.h"
 #include "ios_render.h"
+#include "memory_tracker.h"
+#include "command_list.h"
 
+#include <algorithm>
 #include <numeric>
 #include <sstream>
 #include <iomanip>
@@ -10,11 +13,13 @@
 #import  <OpenGLES/ES3/gl.h>
 #import  <OpenGLES/ES3/glext.h>
 
-#define GLCHECK(...) __VA_ARGS__; if (auto error = glGetError()) { _platform->logError("[Render] GL Error : 0x%X at %s(%d)", error, __FUNCTION__, __LINE__); }
+#define GLCHECK(...) __VA_ARGS__; if (auto error = glGetError()) { PLATFORM_LOG_ERROR(_platform, "[Render] GL Error : 0x%X at %s(%d)", error, __FUNCTION__, __LINE__); }
 
 namespace {
     static constexpr std::size_t SHADER_LINES_MAX = 1024;
-    static constexpr std::size_t SHADER_CONST_STREAM_BUFFER_SIZE = 64 * 1024;
+    static constexpr std::size_t CONST_RING_PART_SIZE = 64 * 1024;
+    static constexpr GLbitfield CONST_RING_MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    static constexpr GLuint64 CONST_RING_WAIT_NS = 1000000000;
     static constexpr std::size_t SHADER_BIND_FRAME_DATA = 0;
     static constexpr std::size_t SHADER_BIND_PERMANENT_CONST = 1;
     static constexpr std::size_t SHADER_BIND_CONSTANTS = 2;
@@ -31,11 +36,12 @@ namespace {
     struct NativeTexturFormat {
         GLint  internalFormat;
         GLenum format;
+        std::uint32_t gpuBytesPerPixel;     // drivers store rgb textures as rgba
     }
     _nativeTextureFormatMap[unsigned(platform::Texture2D::Format::_count)] = {
-        {GL_RGBA8, GL_RGBA},
-        {GL_RGB8, GL_RGB},
-        {GL_R8, GL_RED}
+        {GL_RGBA8, GL_RGBA, 4},
+        {GL_RGB8, GL_RGB, 4},
+        {GL_R8, GL_RED, 1}
     };
     
     struct NativeVertexAttribFormat {
@@ -66,7 +72,7 @@ namespace {
 }
 
 namespace platform {
-    class ShaderImp : public Shader {
+    class ShaderImp : public Shader, public std::enable_shared_from_this<ShaderImp> {
     public:
         ShaderImp(
             const std::shared_ptr<Platform> &platform,
@@ -83,16 +89,24 @@ namespace platform {
         , _instanceLayout(std::move(instanceLayout))
         , _permanentConstBlockSize(permanentConstBlockSize)
         , _constantsBlockSize(constantsBlockSize)
+        , _vshader(0)
+        , _fshader(0)
+        , _program(0)
+        , _permanentConstBlockBuffer(0)
+        , _gpuSize(0)
         {
+            PLATFORM_PROFILE_ZONE("Render::compileShader");
+            PLATFORM_COUNTER_ZONE("Render::compileShader");
+            
             struct fn {
                 static void printLinedShader(const std::shared_ptr<Platform> &platform, const char **src, GLint *len, std::size_t cnt) {
-                    platform->logError("[Render] --------------------------------");
+                    PLATFORM_LOG_ERROR(platform, "[Render] --------------------------------");
                     for (std::size_t i = 0; i < cnt; i++) {
                         char buffer[256] = {0};
                         std::memcpy(buffer, src[i], len[i] - 1);
-                        platform->logError("%03zu |%s", i + 1, buffer);
+                        PLATFORM_LOG_ERROR(platform, "%03zu |%s", i + 1, buffer);
                     }
-                    platform->logError("-----------------------------------------");
+                    PLATFORM_LOG_ERROR(platform, "-----------------------------------------");
                 }
             };
             
@@ -159,39 +173,84 @@ namespace platform {
                         GLCHECK(glBufferData(GL_UNIFORM_BUFFER, _permanentConstBlockSize, permanentConstBlockData, GL_STATIC_DRAW));
                         GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
                         
+                        // driver keeps sources of shaders attached to program
+                        _gpuSize = std::accumulate(vlen, vlen + vcnt, std::size_t(0)) + std::accumulate(flen, flen + fcnt, std::size_t(0)) + _permanentConstBlockSize;
+                        MemoryTracker::allocated(MemoryCategory::SHADERS, _gpuSize);
                         return;
                     }
                     else {
                         GLCHECK(glGetProgramInfoLog(program, BUFFER_MAX - 1, &length, errorBuffer));
                         fn::printLinedShader(platform, vsrc, vlen, vcnt);
                         fn::printLinedShader(platform, fsrc, flen, fcnt);
-                        _platform->logError("[Render] shader linking failed: %s", errorBuffer);
+                        PLATFORM_LOG_ERROR(_platform, "[Render] shader linking failed: %s", errorBuffer);
                     }
                 }
                 else {
                     GLCHECK(glGetShaderInfoLog(fshader, BUFFER_MAX - 1, &length, errorBuffer));
                     fn::printLinedShader(platform, fsrc, flen, fcnt);
-                    _platform->logError("[Render] fragment shader compilation failed: %s", errorBuffer);
+                    PLATFORM_LOG_ERROR(_platform, "[Render] fragment shader compilation failed: %s", errorBuffer);
                 }
             }
             else {
                 GLCHECK(glGetShaderInfoLog(vshader, BUFFER_MAX - 1, &length, errorBuffer));
                 fn::printLinedShader(platform, vsrc, vlen, vcnt);
-                _platform->logError("[Render] vertex shader compilation failed: %s", errorBuffer);
+                PLATFORM_LOG_ERROR(_platform, "[Render] vertex shader compilation failed: %s", errorBuffer);
             }
             
-            GLCHECK(glDeleteShader(program));
+            GLCHECK(glDeleteProgram(program));
             GLCHECK(glDeleteShader(vshader));
             GLCHECK(glDeleteShader(fshader));
         }
         
         ~ShaderImp() {
+            if (_render) {
+                _render->forgetShader(this);
+            }
+            if (_program) {
+                MemoryTracker::freed(MemoryCategory::SHADERS, _gpuSize);
+                
+                if (_render) {
+                    _render->forgetProgram(_program, _permanentConstBlockBuffer);
+                }
+            }
+            
             GLCHECK(glDeleteBuffers(1, &_permanentConstBlockBuffer));
-            GLCHECK(glDeleteShader(_program));
+            GLCHECK(glDeleteProgram(_program));
             GLCHECK(glDeleteShader(_vshader));
             GLCHECK(glDeleteShader(_fshader));
         }
         
+        // false if compilation or linking failed
+        bool isValid() const {
+            return _program != 0;
+        }
+        
+        // Exchanges GL objects with @other. Used by reload to keep the same handle
+        void swap(ShaderImp &other) {
+            std::swap(_vertexLayout, other._vertexLayout);
+            std::swap(_instanceLayout, other._instanceLayout);
+            std::swap(_permanentConstBlockSize, other._permanentConstBlockSize);
+            std::swap(_constantsBlockSize, other._constantsBlockSize);
+            std::swap(_vshader, other._vshader);
+            std::swap(_fshader, other._fshader);
+            std::swap(_program, other._program);
+            std::swap(_permanentConstBlockBuffer, other._permanentConstBlockBuffer);
+            std::swap(_gpuSize, other._gpuSize);
+        }
+        
+        // Copies permanent constants of @source without reading them back to CPU
+        void copyPermanentConstBlock(const ShaderImp &source) {
+            const std::size_t size = std::min(_permanentConstBlockSize, source._permanentConstBlockSize);
+            
+            if (size) {
+                GLCHECK(glBindBuffer(GL_COPY_READ_BUFFER, source._permanentConstBlockBuffer));
+                GLCHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, _permanentConstBlockBuffer));
+                GLCHECK(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, GLsizeiptr(size)));
+                GLCHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+                GLCHECK(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+            }
+        }
+        
         const std::vector<ShaderInput> &getVertexLayout() const {
             return _vertexLayout;
         }
@@ -227,7 +286,12 @@ namespace platform {
         GLuint _fshader;
         GLuint _program;
         GLuint _permanentConstBlockBuffer;
+        std::size_t _gpuSize;
     };
+    
+    std::uint32_t Shader::getConstBlockSize() const {
+        return std::uint32_t(static_cast<const ShaderImp *>(this)->getConstBlockSize());
+    }
 }
 
 namespace platform {
@@ -239,39 +303,61 @@ namespace platform {
             std::uint32_t w,
             std::uint32_t h,
             const NativeTexturFormat &nativeFormat,
-            const std::initializer_list<const std::uint8_t *> &imgMipsData
-            
+            const std::uint8_t *const *imgMipsData,
+            std::uint32_t mipCount
         )
         : _platform(platform)
         , _format(format)
         , _width(w)
         , _height(h)
-        , _mipCount(std::uint32_t(imgMipsData.size()))
+        , _mipCount(mipCount)
+        , _gpuSize(0)
         {
             GLCHECK(glGenTextures(1, &_texture));
             GLCHECK(glBindTexture(GL_TEXTURE_2D, _texture));
             GLCHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
             GLCHECK(glTexImage2D(GL_TEXTURE_2D, 0, nativeFormat.internalFormat, w, h, 0, nativeFormat.format, GL_UNSIGNED_BYTE, nullptr));
             
-            GLCHECK(glTexStorage2D(GL_TEXTURE_2D, std::uint32_t(imgMipsData.size()), nativeFormat.internalFormat, w, h));
+            GLCHECK(glTexStorage2D(GL_TEXTURE_2D, mipCount, nativeFormat.internalFormat, w, h));
             GLCHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
             GLCHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
             
             GLCHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
             GLCHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
             
-            for(std::uint32_t i = 0; i < imgMipsData.size(); i++) {
+            for(std::uint32_t i = 0; i < mipCount; i++) {
                 std::uint32_t curWidth  = w >> i;
                 std::uint32_t curHeight = h >> i;
                 
-                GLCHECK(glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, curWidth, curHeight, nativeFormat.format, GL_UNSIGNED_BYTE, imgMipsData.begin()[i] ));
+                GLCHECK(glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, curWidth, curHeight, nativeFormat.format, GL_UNSIGNED_BYTE, imgMipsData[i] ));
             }
             
             GLCHECK(glBindTexture(GL_TEXTURE_2D, 0));
+            
+            for (std::uint32_t i = 0; i < mipCount; i++) {
+                _gpuSize += std::size_t(std::max(w >> i, 1u)) * std::size_t(std::max(h >> i, 1u)) * nativeFormat.gpuBytesPerPixel;
+            }
+            
+            MemoryTracker::allocated(MemoryCategory::TEXTURES, _gpuSize);
         }
         
         ~Texture2DImp() {
+            MemoryTracker::freed(MemoryCategory::TEXTURES, _gpuSize);
+            
+            if (_render) {
+                _render->forgetTexture(_texture);
+            }
+            GLCHECK(glDeleteTextures(1, &_texture));
+        }
         
+        // Exchanges GL texture and its description with @other. Used by reload to keep the same handle
+        void swap(Texture2DImp &other) {
+            std::swap(_mipCount, other._mipCount);
+            std::swap(_width, other._width);
+            std::swap(_height, other._height);
+            std::swap(_format, other._format);
+            std::swap(_texture, other._texture);
+            std::swap(_gpuSize, other._gpuSize);
         }
         
         std::uint32_t getWidth() const {
@@ -290,6 +376,10 @@ namespace platform {
             return _format;
         }
         
+        std::size_t getGpuSize() const {
+            return _gpuSize;
+        }
+        
         GLuint getTexture() const {
             return _texture;
         }
@@ -300,6 +390,7 @@ namespace platform {
         std::uint32_t _height;
         Texture2D::Format _format;
         GLuint _texture;
+        std::size_t _gpuSize;
     };
     
     std::uint32_t Texture2D::getWidth() const {
@@ -317,6 +408,10 @@ namespace platform {
     Texture2D::Format Texture2D::getFormat() const {
         return static_cast<const Texture2DImp *>(this)->getFormat();
     }
+    
+    std::size_t Texture2D::getGpuSize() const {
+        return static_cast<const Texture2DImp *>(this)->getGpuSize();
+    }
 }
 
 namespace platform {
@@ -336,9 +431,16 @@ namespace platform {
             GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, _vbo));
             GLCHECK(glBufferData(GL_ARRAY_BUFFER, count * stride, data, GL_STATIC_DRAW));
             GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+            
+            MemoryTracker::allocated(MemoryCategory::GEOMETRY, getGpuSize());
         }
         
         ~StructuredDataImp() {
+            if (_render) {
+                _render->forgetData(_vbo);
+            }
+            
+            MemoryTracker::freed(MemoryCategory::GEOMETRY, getGpuSize());
             GLCHECK(glDeleteBuffers(1, &_vbo));
         }
         
@@ -350,6 +452,10 @@ namespace platform {
             return _stride;
         }
         
+        std::size_t getGpuSize() const {
+            return std::size_t(_count) * _stride;
+        }
+        
         GLuint getBuffer() const {
             return _vbo;
         }
@@ -367,10 +473,14 @@ namespace platform {
     std::uint32_t StructuredData::getStride() const {
         return static_cast<const StructuredDataImp *>(this)->getStride();
     }
+    
+    std::size_t StructuredData::getGpuSize() const {
+        return static_cast<const StructuredDataImp *>(this)->getGpuSize();
+    }
 }
 
 namespace platform {
-    IOSRender::IOSRender(const std::shared_ptr<Platform> &platform) : _platform(platform), _frameData(), _shaderConstStreamOffset(0) {
+    IOSRender::IOSRender(const std::shared_ptr<Platform> &platform) : _platform(platform), _frameData(), _stats() {
         GLCHECK(glEnable(GL_DEPTH_TEST));
         GLCHECK(glDepthFunc(GL_GREATER));
         GLCHECK(glClearDepthf(0.0f));
@@ -380,15 +490,32 @@ namespace platform {
         GLCHECK(glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW));
         GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
 
-        GLCHECK(glGenBuffers(1, &_shaderConstStreamBuffer));
-        GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, _shaderConstStreamBuffer));
-        GLCHECK(glBufferData(GL_UNIFORM_BUFFER, SHADER_CONST_STREAM_BUFFER_SIZE, nullptr, GL_DYNAMIC_DRAW));
-        GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+        GLint alignment = 0;
+        GLCHECK(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+        
+        _constAlignment = std::size_t(std::max(alignment, 1));
+        _resizeConstRing(CommandListImp::getAlignedSize(CONST_RING_PART_SIZE, _constAlignment));
+        _drawSorter = std::make_unique<DrawSorter>(_constAlignment);
+        
+        MemoryTracker::allocated(MemoryCategory::SHADERS, sizeof(FrameData));
     }
     
     IOSRender::~IOSRender() {
+        _currentShader = nullptr;
+        
+        for (const auto &entry : _vertexArrays) {
+            GLCHECK(glDeleteVertexArrays(1, &entry.second));
+        }
+        
+        for (GLsync fence : _constRing.fences) {
+            if (fence) {
+                GLCHECK(glDeleteSync(fence));
+            }
+        }
+        
+        MemoryTracker::freed(MemoryCategory::SHADERS, sizeof(FrameData) + _constRing.partSize * CONST_RING_FRAME_COUNT);
         GLCHECK(glDeleteBuffers(1, &_shaderFrameDataBuffer));
-        GLCHECK(glDeleteBuffers(1, &_shaderConstStreamBuffer));
+        GLCHECK(glDeleteBuffers(1, &_constRing.buffer));
     }
     
     void IOSRender::updateCameraTransform(const float (&camPos)[3], const float(&camDir)[3], const float(&camVP)[16]) {
@@ -491,7 +618,49 @@ namespace platform {
         const std::initializer_list<ShaderInput> &instance,
         const void *prmnt
     ) {
-        std::shared_ptr<Shader> result;
+        return _buildShader(shadersrc, std::vector<ShaderInput>(vertex), std::vector<ShaderInput>(instance), prmnt);
+    }
+    
+    bool IOSRender::reloadShader(const std::shared_ptr<Shader> &shader, const char *shadersrc, const void *prmnt) {
+        ShaderImp *shaderImp = static_cast<ShaderImp *>(shader.get());
+        std::shared_ptr<ShaderImp> rebuilt = _buildShader(
+            shadersrc,
+            std::vector<ShaderInput>(shaderImp->getVertexLayout()),
+            std::vector<ShaderInput>(shaderImp->getInstanceLayout()),
+            prmnt
+        );
+        
+        if (rebuilt == nullptr || rebuilt->isValid() == false) {
+            PLATFORM_LOG_ERROR(_platform, "[Render] shader reload failed, previous version is kept");
+            return false;
+        }
+        if (prmnt == nullptr) {
+            rebuilt->copyPermanentConstBlock(*shaderImp);
+        }
+        
+        // previous GL objects are released with 'rebuilt'. Locations of instance attributes are chosen by linker, so vertex
+        // arrays are set up again for the new program
+        shaderImp->swap(*rebuilt);
+        forgetShader(shaderImp);
+        
+        if (_currentShader.get() == shaderImp) {
+            _useProgram(shaderImp->getProgram());
+            _bindUniformBuffer(SHADER_BIND_PERMANENT_CONST, shaderImp->getPermanentConstBlockBuffer());
+        }
+        
+        return true;
+    }
+    
+    std::shared_ptr<ShaderImp> IOSRender::_buildShader(
+        const char *shadersrc,
+        std::vector<ShaderInput> &&vertex,
+        std::vector<ShaderInput> &&instance,
+        const void *prmnt
+    ) {
+        PLATFORM_PROFILE_ZONE("Render::createShader");
+        PLATFORM_COUNTER_ZONE("Render::translateShader");
+        
+        std::shared_ptr<ShaderImp> result;
         
         std::string varname, arg;
         std::string shaderConsts;
@@ -567,20 +736,20 @@ namespace platform {
                             if (out2) out2->append("mediump " + arg + " " + varname + ";\n");
                         }
                         else {
-                            _platform->logError("[Render] shader : unknown type of constant '%s'", varname.c_str());
+                            PLATFORM_LOG_ERROR(_platform, "[Render] shader : unknown type of constant '%s'", varname.c_str());
                             error = true;
                             break;
                         }
                     }
                     else {
-                        _platform->logError("[Render] shader : constant block syntax error");
+                        PLATFORM_LOG_ERROR(_platform, "[Render] shader : constant block syntax error");
                         error = true;
                         break;
                     }
                 }
             }
             else {
-                _platform->logError("[Render] shader : only one '%s' block is allowed", blockName);
+                PLATFORM_LOG_ERROR(_platform, "[Render] shader : only one '%s' block is allowed", blockName);
                 error = true;
             }
             
@@ -602,7 +771,7 @@ namespace platform {
                             braceCounter--;
                         }
                         else {
-                            _platform->logError("[Render] shader '%s' : unexpected '}'", blockName);
+                            PLATFORM_LOG_ERROR(_platform, "[Render] shader '%s' : unexpected '}'", blockName);
                             error = true;
                             return false;
                         }
@@ -616,7 +785,7 @@ namespace platform {
                         dest += ch;
                     }
                     else {
-                        _platform->logError("[Render] shader '%s' : stream error", blockName);
+                        PLATFORM_LOG_ERROR(_platform, "[Render] shader '%s' : stream error", blockName);
                         error = true;
                         return false;
                     }
@@ -637,7 +806,7 @@ namespace platform {
                 return true;
             }
             else {
-                _platform->logError("[Render] shader : only one '%s' block is allowed", blockName);
+                PLATFORM_LOG_ERROR(_platform, "[Render] shader : only one '%s' block is allowed", blockName);
                 error = true;
                 return false;
             }
@@ -675,7 +844,7 @@ namespace platform {
                 }
             }
             else {
-                _platform->logError("[Render] shader : undefined block");
+                PLATFORM_LOG_ERROR(_platform, "[Render] shader : undefined block");
                 break;
             }
         }
@@ -709,8 +878,8 @@ namespace platform {
                 _platform,
                 vsrc, vslen, vsLineCounter,
                 fsrc, fslen, fsLineCounter,
-                std::vector<ShaderInput>(vertex.begin(), vertex.end()),
-                std::vector<ShaderInput>(instance.begin(), instance.end()),
+                std::move(vertex),
+                std::move(instance),
                 prmnt,
                 shaderPrmntSize,
                 shaderConstSize
@@ -721,7 +890,29 @@ namespace platform {
     }
     
     std::shared_ptr<Texture2D> IOSRender::createTexture(Texture2D::Format format, std::uint32_t w, std::uint32_t h, const std::initializer_list<const std::uint8_t *> &mipsData) {
-        return std::make_unique<Texture2DImp>(_platform, format, w, h, _nativeTextureFormatMap[std::size_t(format)], mipsData);
+        return createTexture(format, w, h, mipsData.begin(), std::uint32_t(mipsData.size()));
+    }
+    
+    std::shared_ptr<Texture2D> IOSRender::createTexture(Texture2D::Format format, std::uint32_t w, std::uint32_t h, const std::uint8_t *const *mipsData, std::uint32_t mipCount) {
+        std::shared_ptr<Texture2D> result = std::make_unique<Texture2DImp>(_platform, format, w, h, _nativeTextureFormatMap[std::size_t(format)], mipsData, mipCount);
+        
+        // texture is uploaded through the active unit, which is left without texture
+        _bindings.textures[_bindings.activeTexture] = 0;
+        return result;
+    }
+    
+    void IOSRender::reloadTexture(
+        const std::shared_ptr<Texture2D> &texture,
+        Texture2D::Format format,
+        std::uint32_t w,
+        std::uint32_t h,
+        const std::uint8_t *const *mipsData,
+        std::uint32_t mipCount
+    ) {
+        // previous GL texture is released with 'rebuilt'
+        Texture2DImp rebuilt (_platform, format, w, h, _nativeTextureFormatMap[std::size_t(format)], mipsData, mipCount);
+        static_cast<Texture2DImp *>(texture.get())->swap(rebuilt);
+        _bindings.textures[_bindings.activeTexture] = 0;
     }
     
     std::shared_ptr<StructuredData> IOSRender::createData(const void *data, std::uint32_t count, std::uint32_t stride) {
@@ -729,51 +920,27 @@ namespace platform {
     }
     
     void IOSRender::applyShader(const std::shared_ptr<Shader> &shader, const void *constants) {
-        const ShaderImp *platformShader = static_cast<const ShaderImp *>(shader.get());
+        const ShaderImp *shaderImp = static_cast<const ShaderImp *>(shader.get());
         
-        if (platformShader) {
-            GLCHECK(glUseProgram(platformShader->getProgram()));
-            
-            if (constants) {
-                if (_shaderConstStreamOffset + platformShader->getConstBlockSize() > SHADER_CONST_STREAM_BUFFER_SIZE) {
-                    _shaderConstStreamOffset = 0;
-                }
-                
-                GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, _shaderConstStreamBuffer));
-                if (char *mapPtr = (char *)glMapBufferRange(GL_UNIFORM_BUFFER, _shaderConstStreamOffset, platformShader->getConstBlockSize(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)) {
-                    memcpy(mapPtr, constants, platformShader->getConstBlockSize()); //
-                    GLCHECK(glUnmapBuffer(GL_UNIFORM_BUFFER));
-                }
-                else {
-                    _platform->logError("[Render] Unable to map uniform buffer");
-                }
-                GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
-                //GLCHECK(glBindBufferRange(GL_UNIFORM_BUFFER, SHADER_BIND_CONSTANTS, _shaderConstStreamBuffer, 0, platformShader->getConstBlockSize()));
-                //_shaderConstStreamOffset += platformShader->getConstBlockSize();
-            }
-            
-            GLCHECK(glBindBufferBase(GL_UNIFORM_BUFFER, SHADER_BIND_CONSTANTS, _shaderConstStreamBuffer));
-            GLCHECK(glBindBufferBase(GL_UNIFORM_BUFFER, SHADER_BIND_FRAME_DATA, _shaderFrameDataBuffer));
-            GLCHECK(glBindBufferBase(GL_UNIFORM_BUFFER, SHADER_BIND_PERMANENT_CONST, platformShader->getPermanentConstBlockBuffer()));
-            
-            _currentShader = shader;
+        if (shaderImp && constants) {
+            const std::size_t constantsSize = shaderImp->getConstBlockSize();
+            _applyShader(shaderImp, _uploadConstants(constants, constantsSize), constantsSize);
+        }
+        else {
+            _applyShader(shaderImp, 0, 0);
         }
     }
     
     void IOSRender::applyTextures(const std::initializer_list<const Texture2D *> &textures) {
-        for (std::size_t i = 0; i < textures.size(); i++) {
-            const Texture2DImp *currentTexture = static_cast<const Texture2DImp *>(textures.begin()[i]);
-            
-            if (currentTexture) {
-                GLCHECK(glActiveTexture(GL_TEXTURE0 + GLenum(i)));
-                GLCHECK(glBindTexture(GL_TEXTURE_2D, currentTexture->getTexture()));
-            }
-        }
+        _applyTextures(textures.begin(), textures.size());
     }
     
     void IOSRender::drawGeometry(std::uint32_t vertexCount, Topology topology) {
-        GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+        PLATFORM_PROFILE_ZONE("Render::drawGeometry");
+        
+        _bindVertexArray(0);
         GLCHECK(glDrawArrays(_topologyMap[unsigned(topology)], 0, vertexCount));
+        _stats.drawCalls++;
     }
     
     void IOSRender::drawGeometry(
@@ -783,54 +950,173 @@ namespace platform {
         std::uint32_t instanceCount,
         Topology topology
     ) {
-        if (_currentShader) {
-            const ShaderImp *shaderImp = static_cast<const ShaderImp *>(_currentShader.get());
-            const std::vector<ShaderInput> &vertexDesc = shaderImp->getVertexLayout();
-            const std::vector<ShaderInput> &instanceDesc = shaderImp->getInstanceLayout();
-            
-            GLuint index = 0;
+        _drawGeometry(static_cast<const StructuredDataImp *>(vertexData.get()), static_cast<const StructuredDataImp *>(instanceData.get()), vertexCount, instanceCount, topology);
+    }
+    
+    std::shared_ptr<CommandList> IOSRender::createCommandList() {
+        return std::make_shared<CommandListImp>();
+    }
+    
+    void IOSRender::submitCommandList(const std::shared_ptr<CommandList> &list, bool sorted) {
+        PLATFORM_PROFILE_ZONE("Render::submitCommandList");
+        
+        const CommandListImp *listImp = static_cast<const CommandListImp *>(list.get());
+        
+        if (sorted) {
+            _drawSorter->add(list);
+        }
+        else {
+            // constants of the whole list are uploaded at once and follow each other in order of recording
+            std::size_t constantsOffset = _uploadConstants(*listImp);
             
-            if (const StructuredDataImp *vertexDataImp = static_cast<const StructuredDataImp *>(vertexData.get())) {
-                GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, vertexDataImp->getBuffer()));
-                
-                const char *offset = 0;
-                for (GLuint i = 0; i < vertexDesc.size(); i++) {
-                    if (vertexDesc[i].format != ShaderInput::Format::VERTEX_ID) {
-                        auto &format = _nativeVertexAttribFormat[unsigned(vertexDesc[i].format)];
-                        GLCHECK(glVertexAttribPointer(index, format.componentCount, format.componentType, format.normalized, vertexDataImp->getStride(), offset));
-                        GLCHECK(glVertexAttribDivisor(index, 0));
-                        GLCHECK(glEnableVertexAttribArray(index));
-                        offset += format.size;
-                        index++;
+            listImp->execute([this, &constantsOffset](const CommandListImp::Command &command) {
+                switch (command.type) {
+                    case CommandListImp::CommandType::APPLY_SHADER: {
+                        const auto &apply = reinterpret_cast<const CommandListImp::ApplyShaderCommand &>(command);
+                        _applyShader(static_cast<const ShaderImp *>(apply.shader), constantsOffset, apply.constantsSize);
+                        constantsOffset += CommandListImp::getAlignedSize(apply.constantsSize, _constAlignment);
+                        break;
+                    }
+                    case CommandListImp::CommandType::APPLY_TEXTURES: {
+                        const auto &apply = reinterpret_cast<const CommandListImp::ApplyTexturesCommand &>(command);
+                        _applyTextures(static_cast<const Texture2D *const *>(CommandListImp::getPayload(apply)), apply.count);
+                        break;
+                    }
+                    case CommandListImp::CommandType::DRAW: {
+                        const auto &draw = reinterpret_cast<const CommandListImp::DrawCommand &>(command);
+                        drawGeometry(draw.vertexCount, draw.topology);
+                        break;
+                    }
+                    case CommandListImp::CommandType::DRAW_INSTANCED: {
+                        const auto &draw = reinterpret_cast<const CommandListImp::DrawCommand &>(command);
+                        _drawGeometry(
+                            static_cast<const StructuredDataImp *>(draw.vertexData),
+                            static_cast<const StructuredDataImp *>(draw.instanceData),
+                            draw.vertexCount,
+                            draw.instanceCount,
+                            draw.topology
+                        );
+                        break;
                     }
                 }
+            });
+        }
+        
+        _stats.submittedLists++;
+        _stats.submittedCommands += listImp->getCommandCount();
+    }
+    
+    void IOSRender::_executeSortedDraws() {
+        PLATFORM_PROFILE_ZONE("Render::executeSortedDraws");
+        
+        // constants of all sorted draws of frame are uploaded at once
+        const std::size_t constantsSize = _drawSorter->getConstantsSize();
+        std::size_t constantsOffset = 0;
+        
+        if (constantsSize) {
+            constantsOffset = _allocateConstants(constantsSize);
+            
+            if (void *mapPtr = _mapConstants(constantsOffset, constantsSize)) {
+                _drawSorter->copyConstants(mapPtr);
+                _unmapConstants();
             }
+        }
+        
+        _drawSorter->execute([this, constantsOffset](const DrawSorter::DrawItem &item, bool applyShader, bool applyTextures) {
+            if (applyShader) {
+                _applyShader(static_cast<const ShaderImp *>(item.shader->shader), constantsOffset + item.constantsOffset, item.shader->constantsSize);
+            }
+            if (applyTextures) {
+                _applyTextures(static_cast<const Texture2D *const *>(CommandListImp::getPayload(*item.textures)), item.textures->count);
+            }
+            if (item.draw->header.type == CommandListImp::CommandType::DRAW) {
+                drawGeometry(item.draw->vertexCount, item.draw->topology);
+            }
+            else {
+                _drawGeometry(
+                    static_cast<const StructuredDataImp *>(item.draw->vertexData),
+                    static_cast<const StructuredDataImp *>(item.draw->instanceData),
+                    item.draw->vertexCount,
+                    item.draw->instanceCount,
+                    item.draw->topology
+                );
+            }
+        }, _stats);
+    }
+    
+    void IOSRender::_applyShader(const ShaderImp *platformShader, std::size_t constantsOffset, std::size_t constantsSize) {
+        PLATFORM_PROFILE_ZONE("Render::applyShader");
+        
+        if (platformShader) {
+            _useProgram(platformShader->getProgram());
             
-            if (const StructuredDataImp *instanceDataImp = static_cast<const StructuredDataImp *>(instanceData.get())) {
-                GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, instanceDataImp->getBuffer()));
-                
-                const char *offset = 0;
-                for (GLuint i = 0; i < instanceDesc.size(); i++) {
-                    if (instanceDesc[i].format != ShaderInput::Format::VERTEX_ID) {
-                        auto &format = _nativeVertexAttribFormat[unsigned(instanceDesc[i].format)];
-                        GLCHECK(glVertexAttribPointer(index, format.componentCount, format.componentType, format.normalized, instanceDataImp->getStride(), offset));
-                        GLCHECK(glVertexAttribDivisor(index, 1));
-                        GLCHECK(glEnableVertexAttribArray(index));
-                        offset += format.size;
-                        index++;
-                    }
-                }
+            // every apply with constants has its own range of ring, without constants the previous range stays bound
+            if (constantsSize) {
+                _bindConstants(constantsOffset, constantsSize);
+            }
+            else {
+                _stats.stateCallsSkipped++;
+            }
+            
+            _bindUniformBuffer(SHADER_BIND_FRAME_DATA, _shaderFrameDataBuffer);
+            _bindUniformBuffer(SHADER_BIND_PERMANENT_CONST, platformShader->getPermanentConstBlockBuffer());
+            
+            if (_currentShader.get() != platformShader) {
+                _currentShader = platformShader->shared_from_this();
+            }
+            
+            _stats.shaderApplies++;
+        }
+    }
+    
+    void IOSRender::_applyTextures(const Texture2D *const *textures, std::size_t count) {
+        PLATFORM_PROFILE_ZONE("Render::applyTextures");
+        
+        if (count > TEXTURE_SLOT_COUNT) {
+            PLATFORM_LOG_WARNING(_platform, "[Render] applyTextures : only %zu texture slots are available", TEXTURE_SLOT_COUNT);
+            count = TEXTURE_SLOT_COUNT;
+        }
+        
+        for (std::size_t i = 0; i < count; i++) {
+            const Texture2DImp *currentTexture = static_cast<const Texture2DImp *>(textures[i]);
+            
+            if (currentTexture) {
+                _bindTexture(GLuint(i), currentTexture->getTexture());
+            }
+        }
+        
+        _stats.textureApplies++;
+    }
+    
+    void IOSRender::_drawGeometry(
+        const StructuredDataImp *vertexDataImp,
+        const StructuredDataImp *instanceDataImp,
+        std::uint32_t vertexCount,
+        std::uint32_t instanceCount,
+        Topology topology
+    ) {
+        PLATFORM_PROFILE_ZONE("Render::drawGeometry");
+        
+        if (_currentShader) {
+            // draw without data uses default vertex array, it has no attributes enabled
+            if (vertexDataImp || instanceDataImp) {
+                _bindVertexArray(_getVertexArray(_currentShader.get(), vertexDataImp, instanceDataImp));
+            }
+            else {
+                _bindVertexArray(0);
             }
             
-            GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
             GLCHECK(glDrawArraysInstanced(_topologyMap[unsigned(topology)], 0, vertexCount, instanceCount));
+            _stats.drawCalls++;
         }
         else {
-            _platform->logWarning("[Render] drawGeometry requires shader set");
+            PLATFORM_LOG_WARNING(_platform, "[Render] drawGeometry requires shader set");
         }
     }
     
     void IOSRender::prepareFrame() {
+        PLATFORM_PROFILE_ZONE("Render::prepareFrame");
+        
         GLCHECK(glClearColor(0.7f, 0.7f, 0.7f, 1.0f));
         GLCHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
         
@@ -843,7 +1129,8 @@ namespace platform {
     }
     
     void IOSRender::presentFrame(float dtSec) {
-        
+        _executeSortedDraws();
+        _advanceConstRing();
     }
     
     void IOSRender::getFrameBufferData(std::uint8_t *imgFrame) {
@@ -851,18 +1138,310 @@ namespace platform {
         GLCHECK(glReadPixels(0, 0, _platform->getNativeScreenWidth(), _platform->getNativeScreenHeight(), GL_RGBA, GL_UNSIGNED_BYTE, imgFrame));
     }
     
+    RenderStats IOSRender::getStats() const {
+        return _stats;
+    }
+    
+    void IOSRender::forgetProgram(GLuint program, GLuint permanentConstBlockBuffer) {
+        if (_bindings.program == program) {
+            _bindings.program = 0;
+        }
+        if (_bindings.uniformBuffers[SHADER_BIND_PERMANENT_CONST] == permanentConstBlockBuffer) {
+            _bindings.uniformBuffers[SHADER_BIND_PERMANENT_CONST] = 0;
+        }
+    }
+    
+    void IOSRender::forgetTexture(GLuint texture) {
+        for (GLuint &binding : _bindings.textures) {
+            if (binding == texture) {
+                binding = 0;
+            }
+        }
+    }
+    
+    void IOSRender::forgetShader(const ShaderImp *shader) {
+        for (auto entry = _vertexArrays.begin(); entry != _vertexArrays.end(); ) {
+            if (entry->first.shader == shader) {
+                _deleteVertexArray(entry->second);
+                entry = _vertexArrays.erase(entry);
+            }
+            else {
+                ++entry;
+            }
+        }
+    }
+    
+    void IOSRender::forgetData(GLuint buffer) {
+        for (auto entry = _vertexArrays.begin(); entry != _vertexArrays.end(); ) {
+            if (entry->first.vertexBuffer == buffer || entry->first.instanceBuffer == buffer) {
+                _deleteVertexArray(entry->second);
+                entry = _vertexArrays.erase(entry);
+            }
+            else {
+                ++entry;
+            }
+        }
+    }
+    
+    void IOSRender::_useProgram(GLuint program) {
+        if (_bindings.program != program) {
+            GLCHECK(glUseProgram(program));
+            _bindings.program = program;
+            _stats.stateCallsIssued++;
+        }
+        else {
+            _stats.stateCallsSkipped++;
+        }
+    }
+    
+    void IOSRender::_bindUniformBuffer(std::size_t index, GLuint buffer) {
+        if (_bindings.uniformBuffers[index] != buffer) {
+            GLCHECK(glBindBufferBase(GL_UNIFORM_BUFFER, GLuint(index), buffer));
+            _bindings.uniformBuffers[index] = buffer;
+            _stats.stateCallsIssued++;
+        }
+        else {
+            _stats.stateCallsSkipped++;
+        }
+    }
+    
+    // Unit is switched only for texture that isn't bound yet, so glActiveTexture is filtered too
+    void IOSRender::_bindTexture(GLuint slot, GLuint texture) {
+        if (_bindings.textures[slot] != texture) {
+            if (_bindings.activeTexture != slot) {
+                GLCHECK(glActiveTexture(GL_TEXTURE0 + slot));
+                _bindings.activeTexture = slot;
+                _stats.stateCallsIssued++;
+            }
+            else {
+                _stats.stateCallsSkipped++;
+            }
+            
+            GLCHECK(glBindTexture(GL_TEXTURE_2D, texture));
+            _bindings.textures[slot] = texture;
+            _stats.stateCallsIssued++;
+        }
+        else {
+            _stats.stateCallsSkipped += 2;
+        }
+    }
+    
+    void IOSRender::_bindConstants(std::size_t offset, std::size_t size) {
+        GLCHECK(glBindBufferRange(GL_UNIFORM_BUFFER, SHADER_BIND_CONSTANTS, _constRing.buffer, GLintptr(offset), GLsizeiptr(size)));
+        _bindings.uniformBuffers[SHADER_BIND_CONSTANTS] = _constRing.buffer;
+        _stats.stateCallsIssued++;
+    }
+    
+    void IOSRender::_bindVertexArray(GLuint vertexArray) {
+        if (_bindings.vertexArray != vertexArray) {
+            GLCHECK(glBindVertexArray(vertexArray));
+            _bindings.vertexArray = vertexArray;
+        }
+    }
+    
+    // Attributes are set once per combination of shader and buffers, next draws with it only bind the vertex array
+    GLuint IOSRender::_getVertexArray(const ShaderImp *shader, const StructuredDataImp *vertexData, const StructuredDataImp *instanceData) {
+        const VertexArrayKey key = {shader, vertexData ? vertexData->getBuffer() : 0, instanceData ? instanceData->getBuffer() : 0};
+        const auto cached = _vertexArrays.find(key);
+        
+        if (cached != _vertexArrays.end()) {
+            _stats.vertexArraysReused++;
+            return cached->second;
+        }
+        
+        PLATFORM_COUNTER_ZONE("Render::setupVertexAttributes");
+        
+        const std::vector<ShaderInput> &vertexDesc = shader->getVertexLayout();
+        const std::vector<ShaderInput> &instanceDesc = shader->getInstanceLayout();
+        
+        GLuint vertexArray = 0;
+        GLuint index = 0;
+        
+        GLCHECK(glGenVertexArrays(1, &vertexArray));
+        _bindVertexArray(vertexArray);
+        
+        if (vertexData) {
+            GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, vertexData->getBuffer()));
+            
+            const char *offset = 0;
+            for (GLuint i = 0; i < vertexDesc.size(); i++) {
+                if (vertexDesc[i].format != ShaderInput::Format::VERTEX_ID) {
+                    auto &format = _nativeVertexAttribFormat[unsigned(vertexDesc[i].format)];
+                    GLCHECK(glVertexAttribPointer(index, format.componentCount, format.componentType, format.normalized, vertexData->getStride(), offset));
+                    GLCHECK(glVertexAttribDivisor(index, 0));
+                    GLCHECK(glEnableVertexAttribArray(index));
+                    offset += format.size;
+                    index++;
+                }
+            }
+        }
+        
+        if (instanceData) {
+            GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, instanceData->getBuffer()));
+            
+            const char *offset = 0;
+            for (GLuint i = 0; i < instanceDesc.size(); i++) {
+                if (instanceDesc[i].format != ShaderInput::Format::VERTEX_ID) {
+                    auto &format = _nativeVertexAttribFormat[unsigned(instanceDesc[i].format)];
+                    GLCHECK(glVertexAttribPointer(index, format.componentCount, format.componentType, format.normalized, instanceData->getStride(), offset));
+                    GLCHECK(glVertexAttribDivisor(index, 1));
+                    GLCHECK(glEnableVertexAttribArray(index));
+                    offset += format.size;
+                    index++;
+                }
+            }
+        }
+        
+        GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+        
+        _vertexArrays.emplace(key, vertexArray);
+        _stats.vertexArraysCreated++;
+        return vertexArray;
+    }
+    
+    std::size_t IOSRender::_allocateConstants(std::size_t size) {
+        const std::size_t alignedSize = CommandListImp::getAlignedSize(size, _constAlignment);
+        
+        if (_constRing.offset + alignedSize > _constRing.partSize) {
+            _resizeConstRing(CommandListImp::getAlignedSize(std::max(_constRing.partSize * 2, alignedSize), _constAlignment));
+        }
+        
+        const std::size_t result = _constRing.partIndex * _constRing.partSize + _constRing.offset;
+        _constRing.offset += alignedSize;
+        return result;
+    }
+    
+    std::size_t IOSRender::_uploadConstants(const void *constants, std::size_t size) {
+        const std::size_t offset = _allocateConstants(size);
+        
+        if (void *mapPtr = _mapConstants(offset, size)) {
+            std::memcpy(mapPtr, constants, size);
+            _unmapConstants();
+        }
+        
+        return offset;
+    }
+    
+    std::size_t IOSRender::_uploadConstants(const CommandListImp &list) {
+        const std::size_t size = list.getConstantsSize(_constAlignment);
+        std::size_t offset = 0;
+        
+        if (size) {
+            offset = _allocateConstants(size);
+            
+            if (std::uint8_t *mapPtr = static_cast<std::uint8_t *>(_mapConstants(offset, size))) {
+                list.execute([this, &mapPtr](const CommandListImp::Command &command) {
+                    if (command.type == CommandListImp::CommandType::APPLY_SHADER) {
+                        const auto &apply = reinterpret_cast<const CommandListImp::ApplyShaderCommand &>(command);
+                        
+                        if (apply.constantsSize) {
+                            std::memcpy(mapPtr, CommandListImp::getPayload(apply), apply.constantsSize);
+                        }
+                        
+                        mapPtr += CommandListImp::getAlignedSize(apply.constantsSize, _constAlignment);
+                    }
+                });
+                
+                _unmapConstants();
+            }
+        }
+        
+        return offset;
+    }
+    
+    // Range belongs to current frame and isn't read by GPU, so mapping doesn't wait for it
+    void *IOSRender::_mapConstants(std::size_t offset, std::size_t size) {
+        GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, _constRing.buffer));
+        void *result = glMapBufferRange(GL_UNIFORM_BUFFER, GLintptr(offset), GLsizeiptr(size), CONST_RING_MAP_FLAGS);
+        
+        if (result == nullptr) {
+            PLATFORM_LOG_ERROR(_platform, "[Render] Unable to map uniform buffer");
+            GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+        }
+        
+        _stats.constantUploads++;
+        return result;
+    }
+    
+    void IOSRender::_unmapConstants() {
+        GLCHECK(glUnmapBuffer(GL_UNIFORM_BUFFER));
+        GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+    }
+    
+    // Draws issued already keep the previous buffer alive until GPU has done with them. New buffer isn't used by GPU yet,
+    // so fences of previous frames aren't needed anymore
+    void IOSRender::_resizeConstRing(std::size_t partSize) {
+        if (_constRing.buffer) {
+            PLATFORM_LOG_INFO(_platform, "[Render] Constant ring grows to %zu KB per frame", partSize / 1024);
+            MemoryTracker::freed(MemoryCategory::SHADERS, _constRing.partSize * CONST_RING_FRAME_COUNT);
+            GLCHECK(glDeleteBuffers(1, &_constRing.buffer));
+            
+            if (_bindings.uniformBuffers[SHADER_BIND_CONSTANTS] == _constRing.buffer) {
+                _bindings.uniformBuffers[SHADER_BIND_CONSTANTS] = 0;
+            }
+        }
+        
+        for (GLsync &fence : _constRing.fences) {
+            if (fence) {
+                GLCHECK(glDeleteSync(fence));
+                fence = nullptr;
+            }
+        }
+        
+        GLCHECK(glGenBuffers(1, &_constRing.buffer));
+        GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, _constRing.buffer));
+        GLCHECK(glBufferData(GL_UNIFORM_BUFFER, partSize * CONST_RING_FRAME_COUNT, nullptr, GL_DYNAMIC_DRAW));
+        GLCHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+        
+        MemoryTracker::allocated(MemoryCategory::SHADERS, partSize * CONST_RING_FRAME_COUNT);
+        
+        _constRing.partSize = partSize;
+        _constRing.offset = 0;
+    }
+    
+    // Fence marks the end of constants of this frame. Next part is written when the frame that used it before is done
+    void IOSRender::_advanceConstRing() {
+        PLATFORM_PROFILE_ZONE("Render::advanceConstRing");
+        
+        _constRing.fences[_constRing.partIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        _constRing.partIndex = (_constRing.partIndex + 1) % CONST_RING_FRAME_COUNT;
+        _constRing.offset = 0;
+        
+        if (GLsync fence = _constRing.fences[_constRing.partIndex]) {
+            GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, CONST_RING_WAIT_NS);
+            
+            while (result == GL_TIMEOUT_EXPIRED) {
+                result = glClientWaitSync(fence, 0, CONST_RING_WAIT_NS);
+            }
+            if (result == GL_WAIT_FAILED) {
+                PLATFORM_LOG_ERROR(_platform, "[Render] Wait for constant ring failed");
+            }
+            
+            GLCHECK(glDeleteSync(fence));
+            _constRing.fences[_constRing.partIndex] = nullptr;
+        }
+    }
+    
+    void IOSRender::_deleteVertexArray(GLuint vertexArray) {
+        GLCHECK(glDeleteVertexArrays(1, &vertexArray));
+        
+        if (_bindings.vertexArray == vertexArray) {
+            _bindings.vertexArray = 0;
+        }
+    }
+    
     std::shared_ptr<RenderingDevice> getRenderingDeviceInstance(const std::shared_ptr<Platform> &platform) {
         if (_render == nullptr) {
             EAGLContext *glContext = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES3];
         
             if (glContext) {
                 platform->setNativeRenderingContext((__bridge_retained void *)(glContext));
-                platform->logInfo("[Render] ES context: OK");
+                PLATFORM_LOG_INFO(platform, "[Render] ES context: OK");
                 
                 [EAGLContext setCurrentContext:glContext];
             }
             else {
-                platform->logError("[Render] Failed to create ES context");
+                PLATFORM_LOG_ERROR(platform, "[Render] Failed to create ES context");
             }
             
             _render = std::make_shared<platform::IOSRender>(platform);
@@ -0,0 +1,478 @@
+
+#include "job_system.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+    constexpr std::size_t PARALLEL_FOR_JOBS_PER_THREAD = 4;
+    constexpr std::uint32_t IDLE_SPIN_COUNT = 64;
+    constexpr std::size_t TASK_CACHE_MAX = 64;          // free tasks kept by thread, surplus goes to shared list
+
+    // Deque of the current thread
+    struct ThreadSlot {
+        const platform::JobSystem *system = nullptr;
+        std::size_t dequeIndex = 0;
+    };
+
+    ThreadSlot &getThreadSlot() {
+        static thread_local ThreadSlot slot;
+        return slot;
+    }
+
+    void pinToCore(std::thread &thread, std::size_t core) {
+    #ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(int(core % CPU_SETSIZE), &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+    #endif
+    }
+}
+
+namespace platform {
+    JobDeque::JobDeque() : _top(0), _bottom(0), _tasks(new std::atomic<JobTask *>[CAPACITY]) {}
+
+    bool JobDeque::push(JobTask *task) {
+        const std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+        const std::int64_t top = _top.load(std::memory_order_acquire);
+
+        if (bottom - top >= std::int64_t(CAPACITY)) {
+            return false;
+        }
+
+        _tasks[std::size_t(bottom) & (CAPACITY - 1)].store(task, std::memory_order_relaxed);
+        _bottom.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    JobTask *JobDeque::pop() {
+        const std::int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(bottom, std::memory_order_seq_cst);
+        std::int64_t top = _top.load(std::memory_order_seq_cst);
+
+        if (top > bottom) {
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        JobTask *task = _tasks[std::size_t(bottom) & (CAPACITY - 1)].load(std::memory_order_relaxed);
+
+        if (top == bottom) {
+            // the last task, thieves compete for it
+            if (_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false) {
+                task = nullptr;
+            }
+
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return task;
+    }
+
+    JobTask *JobDeque::steal() {
+        std::int64_t top = _top.load(std::memory_order_seq_cst);
+        const std::int64_t bottom = _bottom.load(std::memory_order_seq_cst);
+
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        JobTask *task = _tasks[std::size_t(top) & (CAPACITY - 1)].load(std::memory_order_relaxed);
+
+        if (_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false) {
+            return nullptr;
+        }
+
+        return task;
+    }
+
+    JobGroupImp::JobGroupImp(JobSystem &system) : _system(system) {}
+
+    void JobGroupImp::add(Job &&job) {
+        _pending.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+
+            if (_released == false) {
+                _heldJobs.emplace_back(std::move(job));
+                return;
+            }
+        }
+
+        _system.submit(std::move(job), shared_from_this());
+    }
+
+    void JobGroupImp::setContinuation(Job &&continuation) {
+        _continuation = std::move(continuation);
+    }
+
+    void JobGroupImp::commit() {
+        if (_committed.exchange(true) == false) {
+            onJobDone();
+        }
+    }
+
+    bool JobGroupImp::isFinished() const {
+        return _finished.load(std::memory_order_acquire);
+    }
+
+    void JobGroupImp::addDependency(JobGroupImp &dependency) {
+        std::lock_guard<std::mutex> guard(dependency._guard);
+
+        if (dependency._finished.load(std::memory_order_acquire) == false) {
+            _dependencies.fetch_add(1, std::memory_order_relaxed);
+            dependency._dependents.emplace_back(shared_from_this());
+        }
+    }
+
+    void JobGroupImp::endDependencies() {
+        _onDependencyFinished();
+    }
+
+    void JobGroupImp::onJobDone() {
+        if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            _finish();
+        }
+    }
+
+    void JobGroupImp::_onDependencyFinished() {
+        if (_dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::vector<Job> jobs;
+
+            {
+                std::lock_guard<std::mutex> guard(_guard);
+                _released = true;
+                jobs.swap(_heldJobs);
+            }
+
+            for (Job &job : jobs) {
+                _system.submit(std::move(job), shared_from_this());
+            }
+        }
+    }
+
+    void JobGroupImp::_finish() {
+        if (_continuation) {
+            _continuation();
+            _continuation = nullptr;
+        }
+
+        std::vector<std::shared_ptr<JobGroupImp>> dependents;
+
+        {
+            std::lock_guard<std::mutex> guard(_guard);
+            _finished.store(true, std::memory_order_release);
+            dependents.swap(_dependents);
+        }
+
+        for (const auto &dependent : dependents) {
+            dependent->_onDependencyFinished();
+        }
+    }
+
+    void JobGroup::add(Job &&job) {
+        static_cast<JobGroupImp *>(this)->add(std::move(job));
+    }
+
+    void JobGroup::setContinuation(Job &&continuation) {
+        static_cast<JobGroupImp *>(this)->setContinuation(std::move(continuation));
+    }
+
+    void JobGroup::commit() {
+        static_cast<JobGroupImp *>(this)->commit();
+    }
+
+    bool JobGroup::isFinished() const {
+        return static_cast<const JobGroupImp *>(this)->isFinished();
+    }
+
+    JobSystem::JobSystem(std::size_t workerCount) {
+        if (workerCount == 0) {
+            workerCount = std::max(std::size_t(std::thread::hardware_concurrency()), std::size_t(1));
+        }
+
+        for (std::size_t i = 0; i <= workerCount; i++) {
+            _deques.emplace_back(std::make_unique<JobDeque>());
+        }
+
+        _taskCaches = std::make_unique<TaskCache[]>(workerCount + 1);
+
+        ThreadSlot &slot = getThreadSlot();
+        slot.system = this;
+        slot.dequeIndex = workerCount;
+
+        for (std::size_t i = 0; i < workerCount; i++) {
+            _workers.emplace_back(&JobSystem::_workerLoop, this, i);
+            pinToCore(_workers.back(), i);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard<std::mutex> guard(_sleepGuard);
+            _stopped = true;
+        }
+
+        _wakeup.notify_all();
+
+        for (std::thread &worker : _workers) {
+            worker.join();
+        }
+
+        // jobs that nobody waited for are discarded
+        for (std::size_t i = 0; i < _deques.size(); i++) {
+            while (JobTask *task = _deques[i]->steal()) {
+                delete task;
+            }
+        }
+        for (JobTask *task : _shared) {
+            delete task;
+        }
+        for (std::size_t i = 0; i < _deques.size(); i++) {
+            while (JobTask *task = _taskCaches[i].head) {
+                _taskCaches[i].head = task->next;
+                delete task;
+            }
+        }
+        while (JobTask *task = _freeTasks) {
+            _freeTasks = task->next;
+            delete task;
+        }
+
+        ThreadSlot &slot = getThreadSlot();
+
+        if (slot.system == this) {
+            slot.system = nullptr;
+        }
+    }
+
+    std::shared_ptr<JobGroup> JobSystem::createGroup(std::initializer_list<std::shared_ptr<JobGroup>> dependencies) {
+        std::shared_ptr<JobGroupImp> group = std::make_shared<JobGroupImp>(*this);
+
+        for (const auto &dependency : dependencies) {
+            if (dependency) {
+                group->addDependency(*std::static_pointer_cast<JobGroupImp>(dependency));
+            }
+        }
+
+        group->endDependencies();
+        return group;
+    }
+
+    void JobSystem::wait(const std::shared_ptr<JobGroup> &group) {
+        const ThreadSlot &slot = getThreadSlot();
+        const std::size_t dequeIndex = slot.system == this ? slot.dequeIndex : _deques.size();
+
+        group->commit();
+
+        while (group->isFinished() == false) {
+            if (JobTask *task = _findTask(dequeIndex)) {
+                _execute(task, dequeIndex);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t, std::size_t)> &body) {
+        if (count == 0) {
+            return;
+        }
+
+        const std::size_t maxJobCount = (_workers.size() + 1) * PARALLEL_FOR_JOBS_PER_THREAD;
+        const std::size_t chunkSize = std::max(std::max(grainSize, std::size_t(1)), (count + maxJobCount - 1) / maxJobCount);
+
+        if (chunkSize >= count) {
+            body(0, count);
+            return;
+        }
+
+        std::shared_ptr<JobGroup> group = createGroup({});
+        const std::function<void(std::size_t, std::size_t)> *target = &body;
+
+        // the first chunk is done by calling thread
+        for (std::size_t begin = chunkSize; begin < count; begin += chunkSize) {
+            const std::size_t end = std::min(begin + chunkSize, count);
+            group->add([target, begin, end] {
+                (*target)(begin, end);
+            });
+        }
+
+        body(0, chunkSize);
+        wait(group);
+    }
+
+    std::size_t JobSystem::getWorkerCount() const {
+        return _workers.size();
+    }
+
+    void JobSystem::submit(Job &&job, const std::shared_ptr<JobGroupImp> &group) {
+        const ThreadSlot &slot = getThreadSlot();
+        const std::size_t dequeIndex = slot.system == this ? slot.dequeIndex : _deques.size();
+
+        JobTask *task = _allocateTask(dequeIndex);
+        task->job = std::move(job);
+        task->group = group;
+
+        _queued.fetch_add(1, std::memory_order_seq_cst);
+
+        if (dequeIndex == _deques.size() || _deques[dequeIndex]->push(task) == false) {
+            std::lock_guard<std::mutex> guard(_sharedGuard);
+            _shared.emplace_back(task);
+        }
+
+        if (_sleeping.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> guard(_sleepGuard);
+            _wakeup.notify_one();
+        }
+    }
+
+    JobTask *JobSystem::_allocateTask(std::size_t dequeIndex) {
+        JobTask *task = nullptr;
+
+        if (dequeIndex < _deques.size()) {
+            TaskCache &cache = _taskCaches[dequeIndex];
+
+            if (cache.head == nullptr) {
+                std::lock_guard<std::mutex> guard(_freeGuard);
+
+                // takes a batch, so the lock is taken once per TASK_CACHE_MAX tasks
+                while (_freeTasks && cache.count < TASK_CACHE_MAX) {
+                    JobTask *freeTask = _freeTasks;
+                    _freeTasks = freeTask->next;
+                    freeTask->next = cache.head;
+                    cache.head = freeTask;
+                    cache.count++;
+                }
+            }
+            if (cache.head) {
+                task = cache.head;
+                cache.head = task->next;
+                cache.count--;
+            }
+        }
+        else {
+            std::lock_guard<std::mutex> guard(_freeGuard);
+
+            if (_freeTasks) {
+                task = _freeTasks;
+                _freeTasks = task->next;
+            }
+        }
+
+        if (task) {
+            task->next = nullptr;
+            return task;
+        }
+
+        return new JobTask;
+    }
+
+    void JobSystem::_freeTask(JobTask *task, std::size_t dequeIndex) {
+        if (dequeIndex < _deques.size()) {
+            TaskCache &cache = _taskCaches[dequeIndex];
+            task->next = cache.head;
+            cache.head = task;
+
+            if (++cache.count > TASK_CACHE_MAX) {
+                JobTask *last = cache.head;
+
+                while (last->next) {
+                    last = last->next;
+                }
+
+                std::lock_guard<std::mutex> guard(_freeGuard);
+                last->next = _freeTasks;
+                _freeTasks = cache.head;
+                cache.head = nullptr;
+                cache.count = 0;
+            }
+        }
+        else {
+            std::lock_guard<std::mutex> guard(_freeGuard);
+            task->next = _freeTasks;
+            _freeTasks = task;
+        }
+    }
+
+    JobTask *JobSystem::_findTask(std::size_t dequeIndex) {
+        JobTask *task = dequeIndex < _deques.size() ? _deques[dequeIndex]->pop() : nullptr;
+
+        // neighbours first: with pinned workers they are likely to share cache
+        for (std::size_t i = 1; task == nullptr && i <= _deques.size(); i++) {
+            const std::size_t victim = (dequeIndex + i) % _deques.size();
+
+            if (victim != dequeIndex) {
+                task = _deques[victim]->steal();
+            }
+        }
+
+        if (task == nullptr && _queued.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> guard(_sharedGuard);
+
+            if (_shared.size()) {
+                task = _shared.front();
+                _shared.pop_front();
+            }
+        }
+
+        if (task) {
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        return task;
+    }
+
+    void JobSystem::_execute(JobTask *task, std::size_t dequeIndex) {
+        {
+            PLATFORM_PROFILE_ZONE("Job");
+            task->job();
+        }
+
+        // captures of the job are released before the group is notified, as if the task was deleted
+        std::shared_ptr<JobGroupImp> group = std::move(task->group);
+        task->job = nullptr;
+        _freeTask(task, dequeIndex);
+        group->onJobDone();
+    }
+
+    void JobSystem::_workerLoop(std::size_t index) {
+        ThreadSlot &slot = getThreadSlot();
+        slot.system = this;
+        slot.dequeIndex = index;
+
+        std::uint32_t idleCount = 0;
+
+        while (true) {
+            if (JobTask *task = _findTask(index)) {
+                _execute(task, index);
+                idleCount = 0;
+                continue;
+            }
+
+            if (++idleCount < IDLE_SPIN_COUNT) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(_sleepGuard);
+            _sleeping.fetch_add(1, std::memory_order_seq_cst);
+            _wakeup.wait(lock, [this] {
+                return _stopped || _queued.load(std::memory_order_seq_cst) > 0;
+            });
+            _sleeping.fetch_sub(1, std::memory_order_relaxed);
+            idleCount = 0;
+
+            if (_stopped) {
+                break;
+            }
+        }
+    }
+}
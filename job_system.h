@@ -0,0 +1,144 @@
+#pragma once
+
+#include "interfaces.h"
+#include "memory_tracker.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace platform {
+    class JobSystem;
+    class JobGroupImp;
+
+    struct JobTask {
+        Job job;
+        std::shared_ptr<JobGroupImp> group;
+        JobTask *next = nullptr;        // link in free list
+
+        // tasks are tagged, so memory of jobs in flight and of free lists is seen in Platform::getMemoryStats
+        static void *operator new(std::size_t size) {
+            void *result = ::operator new(size);
+            MemoryTracker::allocated(MemoryCategory::TASKS, size);
+            return result;
+        }
+
+        static void operator delete(void *ptr, std::size_t size) {
+            MemoryTracker::freed(MemoryCategory::TASKS, size);
+            ::operator delete(ptr);
+        }
+    };
+
+    // Chase-Lev deque of fixed capacity. Owner thread pushes and pops at the bottom, other threads steal from the top
+    //
+    class JobDeque {
+    public:
+        JobDeque();
+
+        // Owner thread only
+        // @return - false if deque is full
+        //
+        bool push(JobTask *task);
+        JobTask *pop();
+
+        // Any thread. Returns nullptr if deque is empty or another thread has taken the same task
+        //
+        JobTask *steal();
+
+    private:
+        static constexpr std::size_t CAPACITY = 4096;
+
+        alignas(64) std::atomic<std::int64_t> _top;
+        alignas(64) std::atomic<std::int64_t> _bottom;
+        std::unique_ptr<std::atomic<JobTask *>[]> _tasks;
+    };
+
+    class JobGroupImp : public JobGroup, public std::enable_shared_from_this<JobGroupImp> {
+    public:
+        JobGroupImp(JobSystem &system);
+
+        void add(Job &&job);
+        void setContinuation(Job &&continuation);
+        void commit();
+        bool isFinished() const;
+
+        // Jobs of group are held until @dependency is finished
+        //
+        void addDependency(JobGroupImp &dependency);
+        void endDependencies();
+
+        // Called by JobSystem when job of the group is done
+        //
+        void onJobDone();
+
+    private:
+        void _onDependencyFinished();
+        void _finish();
+
+        JobSystem &_system;
+        std::atomic<std::uint32_t> _pending {1};        // jobs that aren't done + 1 until commit
+        std::atomic<std::uint32_t> _dependencies {1};   // unfinished dependencies + 1 until endDependencies
+        std::atomic<bool> _committed {false};
+        std::atomic<bool> _finished {false};
+
+        std::mutex _guard;
+        bool _released = false;                         // dependencies are finished, jobs go to workers
+        std::vector<Job> _heldJobs;
+        std::vector<std::shared_ptr<JobGroupImp>> _dependents;
+        Job _continuation;
+    };
+
+    // Work-stealing scheduler
+    // Every worker and the thread that created the system have their own deques. Jobs added from other threads go to shared queue
+    // Workers are pinned to cores on Linux. Idle workers steal from neighbours first and sleep when there is nothing to steal
+    //
+    class JobSystem {
+    public:
+        // @workerCount - count of worker threads, 0 - one per CPU core
+        //
+        JobSystem(std::size_t workerCount);
+        ~JobSystem();
+
+        std::shared_ptr<JobGroup> createGroup(std::initializer_list<std::shared_ptr<JobGroup>> dependencies);
+        void wait(const std::shared_ptr<JobGroup> &group);
+        void parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t, std::size_t)> &body);
+        std::size_t getWorkerCount() const;
+
+        // Used by JobGroupImp
+        //
+        void submit(Job &&job, const std::shared_ptr<JobGroupImp> &group);
+
+    private:
+        // Free tasks of thread that owns deque, touched only by that thread
+        //
+        struct alignas(64) TaskCache {
+            JobTask *head = nullptr;
+            std::size_t count = 0;
+        };
+
+        JobTask *_allocateTask(std::size_t dequeIndex);
+        void _freeTask(JobTask *task, std::size_t dequeIndex);
+        JobTask *_findTask(std::size_t dequeIndex);
+        void _execute(JobTask *task, std::size_t dequeIndex);
+        void _workerLoop(std::size_t index);
+
+        std::vector<std::unique_ptr<JobDeque>> _deques;     // workers, then the owner thread
+        std::vector<std::thread> _workers;
+
+        // Tasks are reused: threads with deques keep local free lists and exchange surplus through shared list in batches
+        std::unique_ptr<TaskCache[]> _taskCaches;           // one per deque
+        std::mutex _freeGuard;
+        JobTask *_freeTasks = nullptr;
+
+        std::mutex _sharedGuard;
+        std::deque<JobTask *> _shared;
+
+        std::atomic<std::int64_t> _queued {0};
+        std::atomic<std::uint32_t> _sleeping {0};
+        std::mutex _sleepGuard;
+        std::condition_variable _wakeup;
+        bool _stopped = false;
+    };
+}
@@ -0,0 +1,207 @@
+
+#include "lz4_block.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    static constexpr std::size_t MIN_MATCH = 4;
+    static constexpr std::size_t LAST_LITERALS = 5;     // last bytes of block are always literals
+    static constexpr std::size_t MATCH_FIND_LIMIT = 12; // last match starts at least 12 bytes before the end
+    static constexpr std::size_t MAX_OFFSET = 65535;
+    static constexpr unsigned HASH_LOG = 14;
+    static constexpr std::size_t COPY_CHUNK = 16;
+
+    inline std::uint32_t read32(const std::uint8_t *ptr) {
+        std::uint32_t result;
+        std::memcpy(&result, ptr, sizeof(result));
+        return result;
+    }
+
+    inline std::uint32_t hash32(std::uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_LOG);
+    }
+
+    // writes 15 + 255 + 255 + ... + rest
+    inline bool writeLength(std::uint8_t *&op, const std::uint8_t *oend, std::size_t length) {
+        for (; length >= 255; length -= 255) {
+            if (op >= oend) return false;
+            *op++ = 255;
+        }
+
+        if (op >= oend) return false;
+        *op++ = std::uint8_t(length);
+        return true;
+    }
+
+    inline bool readLength(const std::uint8_t *&ip, const std::uint8_t *iend, std::size_t &length) {
+        std::uint8_t current;
+
+        do {
+            if (ip >= iend) return false;
+            current = *ip++;
+            length += current;
+        }
+        while (current == 255);
+
+        return true;
+    }
+
+    bool writeSequence(std::uint8_t *&op, const std::uint8_t *oend, const std::uint8_t *literals, std::size_t literalCount, std::size_t offset, std::size_t matchLength) {
+        if (op >= oend) {
+            return false;
+        }
+
+        std::uint8_t *token = op++;
+        *token = std::uint8_t(std::min(literalCount, std::size_t(15)) << 4);
+
+        if (literalCount >= 15 && writeLength(op, oend, literalCount - 15) == false) {
+            return false;
+        }
+        if (std::size_t(oend - op) < literalCount) {
+            return false;
+        }
+
+        std::memcpy(op, literals, literalCount);
+        op += literalCount;
+
+        // the last sequence has literals only
+        if (matchLength) {
+            if (oend - op < 2) {
+                return false;
+            }
+
+            *op++ = std::uint8_t(offset);
+            *op++ = std::uint8_t(offset >> 8);
+
+            std::size_t extra = matchLength - MIN_MATCH;
+            *token |= std::uint8_t(std::min(extra, std::size_t(15)));
+
+            if (extra >= 15 && writeLength(op, oend, extra - 15) == false) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+namespace platform {
+    std::size_t lz4Compress(const std::uint8_t *src, std::size_t srcSize, std::uint8_t *dst, std::size_t dstCapacity) {
+        const std::uint8_t *ip = src;
+        const std::uint8_t *anchor = src;
+        const std::uint8_t *iend = src + srcSize;
+        std::uint8_t *op = dst;
+        const std::uint8_t *oend = dst + dstCapacity;
+
+        if (srcSize > MATCH_FIND_LIMIT) {
+            const std::uint8_t *mflimit = iend - MATCH_FIND_LIMIT;
+            const std::uint8_t *matchlimit = iend - LAST_LITERALS;
+            std::uint32_t table[1 << HASH_LOG] = {0};
+
+            ip++;
+
+            while (ip < mflimit) {
+                const std::uint32_t sequence = read32(ip);
+                const std::uint32_t hash = hash32(sequence);
+                const std::uint8_t *ref = src + table[hash];
+
+                table[hash] = std::uint32_t(ip - src);
+
+                if (ref < ip && std::size_t(ip - ref) <= MAX_OFFSET && read32(ref) == sequence) {
+                    std::size_t matchLength = MIN_MATCH;
+
+                    while (ip + matchLength < matchlimit && ref[matchLength] == ip[matchLength]) {
+                        matchLength++;
+                    }
+
+                    if (writeSequence(op, oend, anchor, std::size_t(ip - anchor), std::size_t(ip - ref), matchLength) == false) {
+                        return 0;
+                    }
+
+                    ip += matchLength;
+                    anchor = ip;
+
+                    if (ip < mflimit) {
+                        table[hash32(read32(ip - 2))] = std::uint32_t(ip - 2 - src);
+                    }
+                }
+                else {
+                    ip++;
+                }
+            }
+        }
+
+        if (writeSequence(op, oend, anchor, std::size_t(iend - anchor), 0, 0) == false) {
+            return 0;
+        }
+
+        return std::size_t(op - dst);
+    }
+
+    bool lz4Decompress(const std::uint8_t *src, std::size_t srcSize, std::uint8_t *dst, std::size_t dstSize) {
+        const std::uint8_t *ip = src;
+        const std::uint8_t *iend = src + srcSize;
+        std::uint8_t *op = dst;
+        std::uint8_t *oend = dst + dstSize;
+
+        while (ip < iend) {
+            const std::uint8_t token = *ip++;
+            std::size_t literalCount = token >> 4;
+
+            if (literalCount == 15 && readLength(ip, iend, literalCount) == false) {
+                return false;
+            }
+            if (literalCount > std::size_t(iend - ip) || literalCount > std::size_t(oend - op)) {
+                return false;
+            }
+
+            std::memcpy(op, ip, literalCount);
+            op += literalCount;
+            ip += literalCount;
+
+            if (ip == iend) {
+                break;
+            }
+            if (iend - ip < 2) {
+                return false;
+            }
+
+            const std::size_t offset = std::size_t(ip[0]) | (std::size_t(ip[1]) << 8);
+            std::size_t matchLength = token & 15;
+
+            ip += 2;
+
+            if (matchLength == 15 && readLength(ip, iend, matchLength) == false) {
+                return false;
+            }
+
+            matchLength += MIN_MATCH;
+
+            if (offset == 0 || offset > std::size_t(op - dst) || matchLength > std::size_t(oend - op)) {
+                return false;
+            }
+
+            const std::uint8_t *match = op - offset;
+
+            if (offset >= COPY_CHUNK) {
+                // chunks don't overlap, fixed-size memcpy compiles to vector loads/stores
+                std::uint8_t *end = op + matchLength;
+
+                for (; std::size_t(end - op) >= COPY_CHUNK; op += COPY_CHUNK, match += COPY_CHUNK) {
+                    std::memcpy(op, match, COPY_CHUNK);
+                }
+
+                std::memcpy(op, match, std::size_t(end - op));
+                op = end;
+            }
+            else {
+                for (std::size_t i = 0; i < matchLength; i++) {
+                    *op++ = *match++;
+                }
+            }
+        }
+
+        return op == oend;
+    }
+}
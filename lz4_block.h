@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// LZ4 block format compression (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md)
+// Blocks are independent, so they can be decoded in parallel
+
+namespace platform {
+    // Maximum size of compressed data for @srcSize bytes of input
+    //
+    inline std::size_t lz4CompressBound(std::size_t srcSize) {
+        return srcSize + srcSize / 255 + 16;
+    }
+
+    // Compresses @src into @dst
+    // @return - compressed size or 0 if @dstCapacity is not enough
+    //
+    std::size_t lz4Compress(const std::uint8_t *src, std::size_t srcSize, std::uint8_t *dst, std::size_t dstCapacity);
+
+    // Decompresses block into @dst. Input is validated, malformed block never writes outside of @dst
+    // @dstSize - exact size of decompressed data
+    // @return  - true if block is decoded and its size is @dstSize
+    //
+    bool lz4Decompress(const std::uint8_t *src, std::size_t srcSize, std::uint8_t *dst, std::size_t dstSize);
+}
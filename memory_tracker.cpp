@@ -0,0 +1,60 @@
+#include "memory_tracker.h"
+
+#include <atomic>
+
+namespace {
+    constexpr std::size_t CATEGORY_COUNT = std::size_t(platform::MemoryCategory::_count);
+
+    struct alignas(64) CategoryCounters {
+        std::atomic<std::uint64_t> liveBytes {0};
+        std::atomic<std::uint64_t> peakBytes {0};
+        std::atomic<std::uint64_t> liveAllocations {0};
+        std::atomic<std::uint32_t> currentFrameAllocations {0};
+        std::atomic<std::uint32_t> lastFrameAllocations {0};
+    };
+
+    // Constant-initialized, so allocations of static objects are counted regardless of initialization order
+    CategoryCounters _counters[CATEGORY_COUNT];
+}
+
+namespace platform {
+    void MemoryTracker::allocated(MemoryCategory category, std::size_t bytes) {
+        CategoryCounters &counters = _counters[std::size_t(category)];
+        const std::uint64_t live = counters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        std::uint64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+
+        while (live > peak && counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed) == false) {}
+
+        counters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+        counters.currentFrameAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void MemoryTracker::freed(MemoryCategory category, std::size_t bytes) {
+        CategoryCounters &counters = _counters[std::size_t(category)];
+        counters.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        counters.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    MemoryStats MemoryTracker::getStats(MemoryCategory category) {
+        const CategoryCounters &counters = _counters[std::size_t(category)];
+        MemoryStats result;
+
+        result.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+        result.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+        result.liveAllocations = counters.liveAllocations.load(std::memory_order_relaxed);
+        result.frameAllocations = counters.lastFrameAllocations.load(std::memory_order_relaxed);
+
+        // counters are read one by one, concurrent allocation can be seen in live bytes before peak
+        if (result.peakBytes < result.liveBytes) {
+            result.peakBytes = result.liveBytes;
+        }
+
+        return result;
+    }
+
+    void MemoryTracker::nextFrame() {
+        for (CategoryCounters &counters : _counters) {
+            counters.lastFrameAllocations.store(counters.currentFrameAllocations.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+}
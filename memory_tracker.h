@@ -0,0 +1,56 @@
+#pragma once
+
+#include "interfaces.h"
+
+namespace platform {
+    // Counters of tagged allocations for Platform::getMemoryStats
+    // Every category has its own cache line of relaxed atomics, so tagging costs a few uncontended atomic operations per
+    // allocation and is always on
+    //
+    class MemoryTracker {
+    public:
+        static void allocated(MemoryCategory category, std::size_t bytes);
+        static void freed(MemoryCategory category, std::size_t bytes);
+
+        static MemoryStats getStats(MemoryCategory category);
+
+        // Called by run() before every frame. Latches allocation counts of the previous frame
+        //
+        static void nextFrame();
+    };
+
+    // STL allocator that tags memory of container with @Category
+    //
+    template<typename T, MemoryCategory Category> class TrackedAllocator {
+    public:
+        using value_type = T;
+
+        template<typename U> struct rebind {
+            using other = TrackedAllocator<U, Category>;
+        };
+
+        TrackedAllocator() = default;
+        template<typename U> TrackedAllocator(const TrackedAllocator<U, Category> &) {}
+
+        T *allocate(std::size_t count) {
+            T *result = std::allocator<T>().allocate(count);
+            MemoryTracker::allocated(Category, count * sizeof(T));
+            return result;
+        }
+
+        void deallocate(T *ptr, std::size_t count) {
+            MemoryTracker::freed(Category, count * sizeof(T));
+            std::allocator<T>().deallocate(ptr, count);
+        }
+
+        template<typename U> bool operator ==(const TrackedAllocator<U, Category> &) const {
+            return true;
+        }
+
+        template<typename U> bool operator !=(const TrackedAllocator<U, Category> &) const {
+            return false;
+        }
+    };
+
+    template<typename T, MemoryCategory Category> using TrackedVector = std::vector<T, TrackedAllocator<T, Category>>;
+}
@@ -0,0 +1,305 @@
+#include "perf_counters.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace {
+    constexpr std::size_t COUNTER_COUNT = std::size_t(platform::PerfCounter::_count);
+    constexpr std::uint32_t ZONE_DEPTH_MAX = 32;    // deeper zones are counted without excluding nested ones
+
+    const char *COUNTER_NAMES[COUNTER_COUNT] = {
+        "cycles",
+        "instructions",
+        "l1dMisses",
+        "llcMisses",
+        "branchMisses",
+    };
+
+    // Counters of one thread. Zones are accumulated by the owner thread, collector takes them once per frame
+    //
+    struct ThreadCounters {
+        int fds[COUNTER_COUNT];
+        int slots[COUNTER_COUNT];               // index of counter in group read, -1 if CPU doesn't have it
+        std::size_t slotCount = 0;
+        bool opened = false;
+        bool failed = false;
+
+        std::uint32_t depth = 0;
+        std::uint64_t nested[ZONE_DEPTH_MAX][COUNTER_COUNT];    // counts of finished nested zones of every open zone
+
+        std::mutex guard;
+        std::vector<platform::PerfCounterStats> zones;
+
+        ThreadCounters() {
+            for (std::size_t i = 0; i < COUNTER_COUNT; i++) {
+                fds[i] = -1;
+                slots[i] = -1;
+            }
+        }
+
+        ~ThreadCounters() {
+        #ifdef __linux__
+            for (int fd : fds) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+        #endif
+        }
+
+        // Opens counters as one group, so all of them are read by one system call
+        bool open() {
+        #ifdef __linux__
+            static const std::uint32_t types[COUNTER_COUNT] = {
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HW_CACHE,
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE,
+            };
+            static const std::uint64_t configs[COUNTER_COUNT] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES,
+            };
+
+            opened = true;
+
+            for (std::size_t i = 0; i < COUNTER_COUNT; i++) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = types[i];
+                attr.config = configs[i];
+                attr.read_format = PERF_FORMAT_GROUP;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+
+                // cycles are the group leader, without them there is nothing to attribute
+                const int leader = slotCount ? fds[0] : -1;
+                const int fd = int(::syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+
+                if (fd >= 0) {
+                    fds[i] = fd;
+                    slots[i] = int(slotCount++);
+                }
+                else if (i == 0) {
+                    failed = true;
+                    return false;
+                }
+            }
+
+            return true;
+        #else
+            opened = true;
+            failed = true;
+            return false;
+        #endif
+        }
+
+        bool read(std::uint64_t (&values)[COUNTER_COUNT]) {
+        #ifdef __linux__
+            std::uint64_t data[COUNTER_COUNT + 1];
+            const std::size_t size = (slotCount + 1) * sizeof(std::uint64_t);
+
+            if (::read(fds[0], data, size) != ssize_t(size)) {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < COUNTER_COUNT; i++) {
+                values[i] = slots[i] >= 0 ? data[1 + slots[i]] : 0;
+            }
+
+            return true;
+        #else
+            return false;
+        #endif
+        }
+    };
+
+    std::atomic<bool> _enabled {false};
+
+    // Counters live until exit, their threads can finish at any time
+    std::mutex _threadsGuard;
+    std::vector<std::unique_ptr<ThreadCounters>> _threads;
+
+    ThreadCounters &getThreadCounters() {
+        static thread_local ThreadCounters *counters = nullptr;
+
+        if (counters == nullptr) {
+            std::unique_ptr<ThreadCounters> created (new ThreadCounters);
+            counters = created.get();
+
+            std::lock_guard<std::mutex> guard(_threadsGuard);
+            _threads.emplace_back(std::move(created));
+        }
+
+        return *counters;
+    }
+
+    void accumulate(std::vector<platform::PerfCounterStats> &stats, const platform::PerfCounterStats &zone) {
+        for (platform::PerfCounterStats &current : stats) {
+            // the same literal can have different addresses in different translation units
+            if (current.zoneName == zone.zoneName || std::strcmp(current.zoneName, zone.zoneName) == 0) {
+                current.calls += zone.calls;
+
+                for (std::size_t i = 0; i < COUNTER_COUNT; i++) {
+                    current.values[i] += zone.values[i];
+                }
+
+                return;
+            }
+        }
+
+        stats.emplace_back(zone);
+    }
+
+    double perThousand(std::uint64_t value, std::uint64_t instructions) {
+        return instructions ? double(value) * 1000.0 / double(instructions) : 0.0;
+    }
+}
+
+namespace platform {
+    bool CounterZone::begin(std::uint64_t (&start)[std::size_t(PerfCounter::_count)]) {
+        if (_enabled.load(std::memory_order_relaxed) == false) {
+            return false;
+        }
+
+        ThreadCounters &counters = getThreadCounters();
+
+        if (counters.opened == false) {
+            counters.open();
+        }
+        if (counters.failed || counters.read(start) == false) {
+            return false;
+        }
+
+        if (counters.depth < ZONE_DEPTH_MAX) {
+            std::memset(counters.nested[counters.depth], 0, sizeof(counters.nested[counters.depth]));
+        }
+
+        counters.depth++;
+        return true;
+    }
+
+    void CounterZone::end(const char *name, const std::uint64_t (&start)[std::size_t(PerfCounter::_count)]) {
+        ThreadCounters &counters = getThreadCounters();
+        std::uint64_t now[COUNTER_COUNT];
+
+        if (counters.read(now) == false) {
+            std::memcpy(now, start, sizeof(now));
+        }
+
+        const std::uint32_t depth = --counters.depth;
+        PerfCounterStats zone {name, 1, {}};
+
+        for (std::size_t i = 0; i < COUNTER_COUNT; i++) {
+            const std::uint64_t total = now[i] - start[i];
+            const std::uint64_t nested = depth < ZONE_DEPTH_MAX ? counters.nested[depth][i] : 0;
+
+            zone.values[i] = total > nested ? total - nested : 0;
+
+            if (depth && depth - 1 < ZONE_DEPTH_MAX) {
+                counters.nested[depth - 1][i] += total;
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(counters.guard);
+        accumulate(counters.zones, zone);
+    }
+
+    bool PerfCounterCollector::enable(bool enable) {
+        if (enable && getThreadCounters().opened == false) {
+            getThreadCounters().open();
+        }
+        if (enable && getThreadCounters().failed) {
+            return false;
+        }
+
+        _enabled.store(enable, std::memory_order_relaxed);
+        return true;
+    }
+
+    void PerfCounterCollector::nextFrame() {
+        _frameStats.clear();
+
+        std::lock_guard<std::mutex> guard(_threadsGuard);
+
+        for (const auto &counters : _threads) {
+            std::lock_guard<std::mutex> threadGuard(counters->guard);
+
+            for (const PerfCounterStats &zone : counters->zones) {
+                accumulate(_frameStats, zone);
+            }
+
+            counters->zones.clear();
+        }
+    }
+
+    std::vector<PerfCounterStats> PerfCounterCollector::getStats() const {
+        return _frameStats;
+    }
+
+    std::string PerfCounterCollector::format(PerfCounterFormat format) const {
+        const std::size_t cycles = std::size_t(PerfCounter::CYCLES);
+        const std::size_t instructions = std::size_t(PerfCounter::INSTRUCTIONS);
+
+        std::string out;
+        char line[512];
+
+        if (format == PerfCounterFormat::JSON) {
+            out += "{\"zones\":[";
+
+            for (std::size_t i = 0; i < _frameStats.size(); i++) {
+                const PerfCounterStats &zone = _frameStats[i];
+
+                out += i ? ",{\"name\":\"" : "{\"name\":\"";
+                out += zone.zoneName;
+                std::snprintf(line, sizeof(line), "\",\"calls\":%u", zone.calls);
+                out += line;
+
+                for (std::size_t c = 0; c < COUNTER_COUNT; c++) {
+                    std::snprintf(line, sizeof(line), ",\"%s\":%llu", COUNTER_NAMES[c], (unsigned long long)zone.values[c]);
+                    out += line;
+                }
+
+                std::snprintf(line, sizeof(line), ",\"ipc\":%.3f}", zone.values[cycles] ? double(zone.values[instructions]) / double(zone.values[cycles]) : 0.0);
+                out += line;
+            }
+
+            out += "]}\n";
+        }
+        else {
+            std::snprintf(line, sizeof(line), "%-32s %8s %14s %14s %6s %10s %10s %10s\n", "zone", "calls", "cycles", "instructions", "IPC", "L1D MPKI", "LLC MPKI", "BR MPKI");
+            out += line;
+
+            for (const PerfCounterStats &zone : _frameStats) {
+                std::snprintf(
+                    line, sizeof(line), "%-32s %8u %14llu %14llu %6.2f %10.2f %10.2f %10.2f\n",
+                    zone.zoneName,
+                    zone.calls,
+                    (unsigned long long)zone.values[cycles],
+                    (unsigned long long)zone.values[instructions],
+                    zone.values[cycles] ? double(zone.values[instructions]) / double(zone.values[cycles]) : 0.0,
+                    perThousand(zone.values[std::size_t(PerfCounter::L1D_MISSES)], zone.values[instructions]),
+                    perThousand(zone.values[std::size_t(PerfCounter::LLC_MISSES)], zone.values[instructions]),
+                    perThousand(zone.values[std::size_t(PerfCounter::BRANCH_MISSES)], zone.values[instructions])
+                );
+                out += line;
+            }
+        }
+
+        return out;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "interfaces.h"
+
+namespace platform {
+    // Aggregates counters of CounterZone for Platform::getPerfCounterStats
+    // Every thread accumulates its zones in its own table, tables are merged once per frame
+    //
+    class PerfCounterCollector {
+    public:
+        // Checks that counters can be opened for the calling thread before enabling them
+        // @return - false if counters are not available
+        //
+        bool enable(bool enable);
+
+        // Called by run() before every frame. Merges counters of all threads collected during the previous frame
+        //
+        void nextFrame();
+
+        std::vector<PerfCounterStats> getStats() const;
+        std::string format(PerfCounterFormat format) const;
+
+    private:
+        std::vector<PerfCounterStats> _frameStats;
+    };
+}
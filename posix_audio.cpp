@@ -0,0 +1,87 @@
+#include "interfaces.h"
+#include "posix_audio.h"
+#include "audio_mixer.h"
+
+namespace {
+    std::shared_ptr<platform::PosixAudio> _audio;
+}
+
+namespace platform {
+    PosixAudio::PosixAudio(const std::shared_ptr<Platform> &platform, const AudioConfig &config) : _platform(platform), _mixer(std::make_unique<AudioMixer>(config)) {
+        PLATFORM_LOG_INFO(_platform, "[Audio] Offline mixer: %u Hz, %u voices", config.sampleRate, config.voiceCount);
+    }
+
+    PosixAudio::~PosixAudio() {}
+
+    std::shared_ptr<Sound> PosixAudio::createSound(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate) {
+        std::shared_ptr<Sound> result = AudioMixer::createSound(samples, frameCount, channelCount, sampleRate);
+
+        if (result == nullptr) {
+            PLATFORM_LOG_ERROR(_platform, "[Audio] Invalid sound: %u frames, %u channels, %u Hz", frameCount, channelCount, sampleRate);
+        }
+
+        return result;
+    }
+
+    std::shared_ptr<AudioStream> PosixAudio::createStream(const char *filePath, const StreamParams &params) {
+        std::shared_ptr<FileView> view = _platform->mapFile(filePath, FileAccess::SEQUENTIAL);
+
+        if (view == nullptr) {
+            return nullptr;
+        }
+
+        std::shared_ptr<AudioStream> result = _mixer->createStream(view, params);
+
+        if (result == nullptr) {
+            PLATFORM_LOG_ERROR(_platform, "[Audio] Stream %s is not 16-bit PCM or IMA ADPCM wave, or its buffers don't fit %u bytes", filePath, params.memoryLimit);
+        }
+
+        return result;
+    }
+
+    VoiceToken PosixAudio::play(const std::shared_ptr<Sound> &sound, const VoiceParams &params) {
+        return _mixer->play(sound, params);
+    }
+
+    VoiceToken PosixAudio::playStream(const std::shared_ptr<AudioStream> &stream, const VoiceParams &params) {
+        return _mixer->playStream(stream, params);
+    }
+
+    void PosixAudio::setVoiceParams(VoiceToken voice, const VoiceParams &params) {
+        _mixer->setVoiceParams(voice, params);
+    }
+
+    void PosixAudio::stop(VoiceToken voice) {
+        _mixer->stop(voice);
+    }
+
+    void PosixAudio::stopAll() {
+        _mixer->stopAll();
+    }
+
+    void PosixAudio::setMasterGain(float gain) {
+        _mixer->setMasterGain(gain);
+    }
+
+    bool PosixAudio::isPlaying(VoiceToken voice) {
+        return _mixer->isPlaying(voice);
+    }
+
+    AudioStats PosixAudio::getStats() {
+        return _mixer->getStats();
+    }
+
+    void PosixAudio::render(float *output, std::uint32_t frameCount) {
+        _mixer->render(output, frameCount);
+    }
+}
+
+namespace platform {
+    std::shared_ptr<AudioDevice> getAudioDeviceInstance(const std::shared_ptr<Platform> &platform, const AudioConfig &config) {
+        if (_audio == nullptr) {
+            _audio = std::make_shared<PosixAudio>(platform, config);
+        }
+
+        return _audio;
+    }
+}
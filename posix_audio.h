@@ -0,0 +1,73 @@
+#pragma once
+
+namespace platform {
+    class AudioMixer;
+
+    // POSIX has no output, audio is produced by render() only
+    //
+    class PosixAudio : public AudioDevice {
+    public:
+        PosixAudio(const std::shared_ptr<Platform> &platform, const AudioConfig &config);
+        ~PosixAudio();
+
+        std::shared_ptr<Sound> createSound(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate);
+        std::shared_ptr<AudioStream> createStream(const char *filePath, const StreamParams &params);
+        VoiceToken play(const std::shared_ptr<Sound> &sound, const VoiceParams &params);
+        VoiceToken playStream(const std::shared_ptr<AudioStream> &stream, const VoiceParams &params);
+        void setVoiceParams(VoiceToken voice, const VoiceParams &params);
+        void stop(VoiceToken voice);
+        void stopAll();
+        void setMasterGain(float gain);
+        bool isPlaying(VoiceToken voice);
+        AudioStats getStats();
+        void render(float *output, std::uint32_t frameCount);
+
+    private:
+        std::shared_ptr<Platform> _platform;
+        std::unique_ptr<AudioMixer> _mixer;
+    };
+
+    std::shared_ptr<Sound> AudioDevice::createSound(const std::int16_t *samples, std::uint32_t frameCount, std::uint32_t channelCount, std::uint32_t sampleRate) {
+        return static_cast<PosixAudio *>(this)->createSound(samples, frameCount, channelCount, sampleRate);
+    }
+
+    std::shared_ptr<AudioStream> AudioDevice::createStream(const char *filePath, const StreamParams &params) {
+        return static_cast<PosixAudio *>(this)->createStream(filePath, params);
+    }
+
+    VoiceToken AudioDevice::play(const std::shared_ptr<Sound> &sound, const VoiceParams &params) {
+        return static_cast<PosixAudio *>(this)->play(sound, params);
+    }
+
+    VoiceToken AudioDevice::playStream(const std::shared_ptr<AudioStream> &stream, const VoiceParams &params) {
+        return static_cast<PosixAudio *>(this)->playStream(stream, params);
+    }
+
+    void AudioDevice::setVoiceParams(VoiceToken voice, const VoiceParams &params) {
+        static_cast<PosixAudio *>(this)->setVoiceParams(voice, params);
+    }
+
+    void AudioDevice::stop(VoiceToken voice) {
+        static_cast<PosixAudio *>(this)->stop(voice);
+    }
+
+    void AudioDevice::stopAll() {
+        static_cast<PosixAudio *>(this)->stopAll();
+    }
+
+    void AudioDevice::setMasterGain(float gain) {
+        static_cast<PosixAudio *>(this)->setMasterGain(gain);
+    }
+
+    bool AudioDevice::isPlaying(VoiceToken voice) {
+        return static_cast<PosixAudio *>(this)->isPlaying(voice);
+    }
+
+    AudioStats AudioDevice::getStats() {
+        return static_cast<PosixAudio *>(this)->getStats();
+    }
+
+    void AudioDevice::render(float *output, std::uint32_t frameCount) {
+        static_cast<PosixAudio *>(this)->render(output, frameCount);
+    }
+}
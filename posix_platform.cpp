@@ -0,0 +1,797 @@
+
+#include "interfaces.h"
+#include "posix_platform.h"
+#include "async_loader.h"
+#include "asset_archive.h"
+#include "file_index.h"
+#include "file_watcher.h"
+#include "async_log.h"
+#include "event_registry.h"
+#include "input_queue.h"
+#include "input_record.h"
+#include "frame_scheduler.h"
+#include "job_system.h"
+#include "post_queue.h"
+#include "profiler.h"
+#include "perf_counters.h"
+#include "memory_tracker.h"
+#include "frame_arena.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Headless platform for Linux and other POSIX systems. There is no window, input or rendering context.
+// File paths are relative to the current working directory
+
+namespace {
+    struct KeyboardEventHandler {
+        platform::EventHandler<void(const platform::KeyboardEventArgs &)> down;
+        platform::EventHandler<void(const platform::KeyboardEventArgs &)> up;
+    };
+
+    struct InputEventHandler {
+        platform::EventHandler<void(const char (&utf8char)[4])> input;
+        platform::EventHandler<void()> backspace;
+    };
+
+    struct MouseEventHandler {
+        platform::EventHandler<void(const platform::MouseEventArgs &)> press;
+        platform::EventHandler<void(const platform::MouseEventArgs &)> move;
+        platform::EventHandler<void(const platform::MouseEventArgs &)> release;
+    };
+
+    struct TouchEventHandler {
+        platform::EventHandler<void(const platform::TouchEventArgs &)> start;
+        platform::EventHandler<void(const platform::TouchEventArgs &)> move;
+        platform::EventHandler<void(const platform::TouchEventArgs &)> release;
+    };
+
+    struct GamepadEventHandler {
+        platform::EventHandler<void(const platform::GamepadEventArgs &)> buttonPress;
+        platform::EventHandler<void(const platform::GamepadEventArgs &)> buttonRelease;
+    };
+
+    struct InputBatchHandler {
+        platform::EventHandler<void(const platform::InputBatch &)> batch;
+    };
+
+    struct FileChangeHandler {
+        std::string dirPath;
+        platform::EventHandler<void(const char *)> changed;
+    };
+
+    constexpr float DEFAULT_SCREEN_WIDTH = 1280.0f;
+    constexpr float DEFAULT_SCREEN_HEIGHT = 720.0f;
+
+    constexpr std::size_t ASYNC_LOAD_THREAD_COUNT = 2;
+    constexpr std::size_t ASYNC_LOAD_IN_FLIGHT_MAX = 16;
+    constexpr std::size_t LOG_THREAD_BUFFER_SIZE = 64 * 1024;
+    constexpr std::size_t POST_QUEUE_CAPACITY = 4096;
+
+    platform::EventHandlerTable<KeyboardEventHandler> _keyboardEventHandlers (0);
+    platform::EventHandlerTable<InputEventHandler> _inputEventHandlers (1);
+    platform::EventHandlerTable<MouseEventHandler> _mouseEventHandlers (2);
+    platform::EventHandlerTable<TouchEventHandler> _touchEventHandlers (3);
+    platform::EventHandlerTable<GamepadEventHandler> _gamepadEventHandlers (4);
+    platform::EventHandlerTable<InputBatchHandler> _inputBatchHandlers (5);
+    platform::EventHandlerTable<FileChangeHandler> _fileChangeHandlers (6);
+    platform::InputQueue _inputQueue;
+    platform::FrameScheduler _frameScheduler;
+    platform::PostQueue _postQueue (POST_QUEUE_CAPACITY);
+    std::vector<platform::InputEvent> _injectedEvents;
+    std::vector<platform::InputEvent> _injectedFrameEvents;
+    std::unique_ptr<platform::InputRecorder> _inputRecorder;
+    std::unique_ptr<platform::InputReplay> _inputReplay;
+    std::vector<std::string> _changedFiles;
+
+    std::shared_ptr<platform::PosixPlatform> _platform;
+
+    platform::AsyncLog &getLog() {
+        static platform::AsyncLog log ([](platform::LogLevel, const char *line) { std::printf("%s\n", line); }, LOG_THREAD_BUFFER_SIZE);
+
+        return log;
+    }
+
+    // Passes event to handlers, recorder and batched input queue. Used for both device and replayed events
+    // @timeSec - time of the event for batched input
+    void dispatchInputRecord(const platform::InputRecord &record, double timeSec) {
+        PLATFORM_PROFILE_ZONE("Platform::dispatchInput");
+        PLATFORM_COUNTER_ZONE("Platform::dispatchInput");
+
+        _frameScheduler.notifyActivity();
+
+        if (_inputRecorder) {
+            platform::InputRecord recorded = record;
+            recorded.timeSec = _inputRecorder->getTimeSec();
+            _inputRecorder->write(recorded);
+        }
+
+        platform::InputEvent event;
+        event.coalescedCount = 1;
+        event.timeSec = timeSec;
+
+        switch (record.type) {
+            case platform::InputRecordType::KEY_DOWN:
+            case platform::InputRecordType::KEY_UP:
+                _keyboardEventHandlers.dispatch([&record](const KeyboardEventHandler &handlers) {
+                    const auto &handler = record.type == platform::InputRecordType::KEY_DOWN ? handlers.down : handlers.up;
+
+                    if (handler) {
+                        handler(record.keyboard);
+                    }
+                });
+
+                event.type = record.type == platform::InputRecordType::KEY_DOWN ? platform::InputEventType::KEY_DOWN : platform::InputEventType::KEY_UP;
+                event.keyboard = record.keyboard;
+                break;
+            case platform::InputRecordType::INPUT:
+                _inputEventHandlers.dispatch([&record](const InputEventHandler &handlers) {
+                    if (handlers.input) {
+                        handlers.input(record.utf8char);
+                    }
+                });
+                return;
+            case platform::InputRecordType::BACKSPACE:
+                _inputEventHandlers.dispatch([](const InputEventHandler &handlers) {
+                    if (handlers.backspace) {
+                        handlers.backspace();
+                    }
+                });
+                return;
+            case platform::InputRecordType::MOUSE_PRESS:
+            case platform::InputRecordType::MOUSE_MOVE:
+            case platform::InputRecordType::MOUSE_RELEASE:
+                _mouseEventHandlers.dispatch([&record](const MouseEventHandler &handlers) {
+                    const auto &handler = record.type == platform::InputRecordType::MOUSE_PRESS ? handlers.press : (record.type == platform::InputRecordType::MOUSE_MOVE ? handlers.move : handlers.release);
+
+                    if (handler) {
+                        handler(record.mouse);
+                    }
+                });
+
+                event.type = platform::InputEventType(int(platform::InputEventType::MOUSE_PRESS) + int(record.type) - int(platform::InputRecordType::MOUSE_PRESS));
+                event.mouse = record.mouse;
+                break;
+            case platform::InputRecordType::TOUCH_START:
+            case platform::InputRecordType::TOUCH_MOVE:
+            case platform::InputRecordType::TOUCH_FINISH:
+                _touchEventHandlers.dispatch([&record](const TouchEventHandler &handlers) {
+                    const auto &handler = record.type == platform::InputRecordType::TOUCH_START ? handlers.start : (record.type == platform::InputRecordType::TOUCH_MOVE ? handlers.move : handlers.release);
+
+                    if (handler) {
+                        handler(record.touch);
+                    }
+                });
+
+                event.type = platform::InputEventType(int(platform::InputEventType::TOUCH_START) + int(record.type) - int(platform::InputRecordType::TOUCH_START));
+                event.touch = record.touch;
+                break;
+            default:
+                return;
+        }
+
+        // events are queued only while batched input mode has handlers
+        if (_inputBatchHandlers.empty() == false) {
+            _inputQueue.push(event);
+        }
+    }
+
+    // Injected event goes the same way as device one
+    void dispatchInjectedEvent(const platform::InputEvent &event) {
+        platform::InputRecord record;
+
+        switch (event.type) {
+            case platform::InputEventType::KEY_DOWN:
+            case platform::InputEventType::KEY_UP:
+                record.type = event.type == platform::InputEventType::KEY_DOWN ? platform::InputRecordType::KEY_DOWN : platform::InputRecordType::KEY_UP;
+                record.keyboard = event.keyboard;
+                break;
+            case platform::InputEventType::MOUSE_PRESS:
+            case platform::InputEventType::MOUSE_MOVE:
+            case platform::InputEventType::MOUSE_RELEASE:
+                record.type = platform::InputRecordType(int(platform::InputRecordType::MOUSE_PRESS) + int(event.type) - int(platform::InputEventType::MOUSE_PRESS));
+                record.mouse = event.mouse;
+                break;
+            case platform::InputEventType::TOUCH_START:
+            case platform::InputEventType::TOUCH_MOVE:
+            case platform::InputEventType::TOUCH_FINISH:
+                record.type = platform::InputRecordType(int(platform::InputRecordType::TOUCH_START) + int(event.type) - int(platform::InputEventType::TOUCH_START));
+                record.touch = event.touch;
+                break;
+            default:
+                return;
+        }
+
+        dispatchInputRecord(record, event.timeSec);
+    }
+
+    bool readAll(int fd, std::uint8_t *dst, std::size_t size) {
+        std::size_t done = 0;
+
+        while (done < size) {
+            ssize_t count = ::read(fd, dst + done, size - done);
+
+            if (count <= 0) {
+                break;
+            }
+
+            done += std::size_t(count);
+        }
+
+        return done == size;
+    }
+}
+
+namespace platform {
+    class FileViewImp : public FileView {
+    public:
+        FileViewImp(void *data, std::size_t size) : _data(data), _size(size) {
+            if (_data) {
+                MemoryTracker::allocated(MemoryCategory::FILES, size);
+            }
+        }
+        FileViewImp(const std::shared_ptr<FileView> &owner, const std::uint8_t *data, std::size_t size) : _owner(owner), _data(const_cast<std::uint8_t *>(data)), _size(size) {}
+        FileViewImp(std::unique_ptr<std::uint8_t[]> &&storage, std::size_t size) : _storage(std::move(storage)), _data(_storage.get()), _size(size) {
+            if (_data) {
+                MemoryTracker::allocated(MemoryCategory::FILES, size);
+            }
+        }
+        ~FileViewImp() {
+            // slices share memory of their owner
+            if (_data && _owner == nullptr) {
+                MemoryTracker::freed(MemoryCategory::FILES, _size);
+            }
+            if (_data && _owner == nullptr && _storage == nullptr) {
+                ::munmap(_data, _size);
+            }
+        }
+
+        const std::uint8_t *getData() const {
+            return static_cast<const std::uint8_t *>(_data);
+        }
+
+        std::size_t getSize() const {
+            return _size;
+        }
+
+        void releasePages(std::size_t offset, std::size_t size) const {
+            // decompressed entries live in heap, they have nothing to drop
+            if (_storage == nullptr && _data && offset < _size) {
+                const std::uintptr_t pageSize = std::uintptr_t(::getpagesize());
+                const std::uintptr_t begin = (std::uintptr_t(_data) + offset + pageSize - 1) & ~(pageSize - 1);
+                const std::uintptr_t end = (std::uintptr_t(_data) + offset + std::min(size, _size - offset)) & ~(pageSize - 1);
+
+                if (begin < end) {
+                    ::madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+                }
+            }
+        }
+
+    private:
+        std::shared_ptr<FileView> _owner;   // archive mapping for slices
+        std::unique_ptr<std::uint8_t[]> _storage;   // decompressed archive entry
+        void *_data;
+        std::size_t _size;
+    };
+
+    const std::uint8_t *FileView::getData() const {
+        return static_cast<const FileViewImp *>(this)->getData();
+    }
+
+    std::size_t FileView::getSize() const {
+        return static_cast<const FileViewImp *>(this)->getSize();
+    }
+
+    void FileView::releasePages(std::size_t offset, std::size_t size) const {
+        static_cast<const FileViewImp *>(this)->releasePages(offset, size);
+    }
+}
+
+namespace platform {
+    PosixPlatform::PosixPlatform() : _nativeScreenWidth(DEFAULT_SCREEN_WIDTH), _nativeScreenHeight(DEFAULT_SCREEN_HEIGHT), _killed(false) {
+        const char *width = std::getenv("PLATFORM_SCREEN_WIDTH");
+        const char *height = std::getenv("PLATFORM_SCREEN_HEIGHT");
+
+        if (width && std::atof(width) > 0.0) {
+            _nativeScreenWidth = float(std::atof(width));
+        }
+        if (height && std::atof(height) > 0.0) {
+            _nativeScreenHeight = float(std::atof(height));
+        }
+
+        _fileLoader = std::make_unique<AsyncFileLoader>(*this, ASYNC_LOAD_THREAD_COUNT, ASYNC_LOAD_IN_FLIGHT_MAX);
+        _profileCapture = std::make_unique<ProfileCapture>(*this);
+        _perfCounters = std::make_unique<PerfCounterCollector>();
+        _frameArena = std::make_unique<FrameArena>();
+        _jobSystem = std::make_unique<JobSystem>(0);
+        PLATFORM_LOG_INFO(this, "[Platform] Platform: OK");
+    }
+
+    PosixPlatform::~PosixPlatform() {
+
+    }
+
+    void Platform::writeLog(LogLevel level, const char *fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        getLog().write(level, fmt, args);
+        va_end(args);
+    }
+
+    std::vector<std::string> PosixPlatform::formFileList(const char *dirPath) {
+        std::vector<std::string> result;
+
+        _getFileIndex(dirPath, false, true).forEach(dirPath, nullptr, false, [&result](const FileInfo &info) {
+            result.emplace_back(info.path, info.pathLength);
+        });
+
+        return result;
+    }
+
+    void PosixPlatform::enumerateFiles(const char *dirPath, const char *pattern, bool recursive, const std::function<void(const FileInfo &)> &visitor) {
+        _getFileIndex(dirPath, recursive, false).forEach(dirPath, pattern, recursive, visitor);
+    }
+
+    bool PosixPlatform::getFileInfo(const char *filePath, FileInfo &info) {
+        const char *separator = std::strrchr(filePath, '/');
+        const std::string dirPath = separator ? std::string(filePath, separator) : std::string();
+        return _getFileIndex(dirPath.c_str(), false, false).find(filePath, info);
+    }
+
+    bool PosixPlatform::loadFile(const char *filePath, std::unique_ptr<uint8_t[]> &data, std::size_t &size) {
+        PLATFORM_PROFILE_ZONE("Platform::loadFile");
+
+        for (auto index = _archives.rbegin(); index != _archives.rend(); ++index) {
+            if (const AssetArchiveEntry *entry = (*index)->find(filePath)) {
+                return (*index)->load(*entry, data, size);
+            }
+        }
+
+        int fd = ::open(filePath, O_RDONLY);
+
+        if (fd < 0) {
+            PLATFORM_LOG_ERROR(this, "[Platform] File %s is not found", filePath);
+            return false;
+        }
+
+        bool result = false;
+        struct stat st;
+
+        if (::fstat(fd, &st) == 0) {
+            size = std::size_t(st.st_size);
+            data = std::make_unique<uint8_t[]>(size);
+            result = readAll(fd, data.get(), size);
+        }
+
+        ::close(fd);
+        return result;
+    }
+
+    bool PosixPlatform::loadFile(const char *filePath, std::uint8_t *buffer, std::size_t capacity, std::size_t &size) {
+        PLATFORM_PROFILE_ZONE("Platform::loadFile");
+
+        for (auto index = _archives.rbegin(); index != _archives.rend(); ++index) {
+            if (const AssetArchiveEntry *entry = (*index)->find(filePath)) {
+                size = std::size_t(entry->size);
+                return size <= capacity && (*index)->read(*entry, buffer);
+            }
+        }
+
+        int fd = ::open(filePath, O_RDONLY);
+
+        if (fd < 0) {
+            PLATFORM_LOG_ERROR(this, "[Platform] File %s is not found", filePath);
+            return false;
+        }
+
+        bool result = false;
+        struct stat st;
+
+        if (::fstat(fd, &st) == 0) {
+            size = std::size_t(st.st_size);
+            result = size <= capacity && readAll(fd, buffer, size);
+        }
+
+        ::close(fd);
+        return result;
+    }
+
+    std::shared_ptr<FileView> PosixPlatform::mapFile(const char *filePath, FileAccess access) {
+        for (auto index = _archives.rbegin(); index != _archives.rend(); ++index) {
+            if (const AssetArchiveEntry *entry = (*index)->find(filePath)) {
+                if (entry->flags & ASSET_ARCHIVE_ENTRY_COMPRESSED) {
+                    std::unique_ptr<std::uint8_t[]> data;
+                    std::size_t size = 0;
+
+                    if ((*index)->load(*entry, data, size)) {
+                        return std::make_shared<FileViewImp>(std::move(data), size);
+                    }
+
+                    PLATFORM_LOG_ERROR(this, "[Platform] File %s cannot be decompressed", filePath);
+                    return nullptr;
+                }
+
+                return std::make_shared<FileViewImp>((*index)->getView(), (*index)->getData(*entry), std::size_t(entry->size));
+            }
+        }
+
+        int fd = ::open(filePath, O_RDONLY);
+
+        if (fd < 0) {
+            PLATFORM_LOG_ERROR(this, "[Platform] File %s is not found", filePath);
+            return nullptr;
+        }
+
+        std::shared_ptr<FileView> result;
+        struct stat st;
+
+        if (::fstat(fd, &st) == 0) {
+            std::size_t size = std::size_t(st.st_size);
+
+            if (size) {
+                void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (data != MAP_FAILED) {
+                    ::posix_madvise(data, size, access == FileAccess::RANDOM ? POSIX_MADV_RANDOM : POSIX_MADV_SEQUENTIAL);
+                    result = std::make_shared<FileViewImp>(data, size);
+                }
+                else {
+                    PLATFORM_LOG_ERROR(this, "[Platform] File %s cannot be mapped", filePath);
+                }
+            }
+            else {
+                result = std::make_shared<FileViewImp>(nullptr, 0);
+            }
+        }
+
+        ::close(fd);
+        return result;
+    }
+
+    bool PosixPlatform::mountArchive(const char *archivePath) {
+        std::unique_ptr<AssetArchive> archive = std::make_unique<AssetArchive>(mapFile(archivePath, FileAccess::RANDOM));
+
+        if (archive->isValid()) {
+            _archives.emplace_back(std::move(archive));
+            _fileIndex = nullptr;
+            return true;
+        }
+
+        PLATFORM_LOG_ERROR(this, "[Platform] File %s is not a valid archive", archivePath);
+        return false;
+    }
+
+    const FileIndex &PosixPlatform::_getFileIndex(const char *dirPath, bool recursive, bool refresh) {
+        if (_fileIndex == nullptr) {
+            _fileIndex = std::make_unique<FileIndex>();
+
+            for (const auto &archive : _archives) {
+                _fileIndex->addArchive(*archive);
+            }
+        }
+
+        // only requested directories are scanned
+        if (refresh || _fileIndex->hasDirectory(dirPath, recursive) == false) {
+            _fileIndex->addDirectory(".", dirPath, recursive);
+        }
+
+        return *_fileIndex;
+    }
+
+    FileLoadToken PosixPlatform::loadFileAsync(
+        const char *filePath,
+        LoadPriority priority,
+        std::function<void(bool, std::unique_ptr<uint8_t[]> &, std::size_t)> &&completion
+    )
+    {
+        return _fileLoader->load(filePath, priority, std::move(completion));
+    }
+
+    bool PosixPlatform::cancelFileLoad(FileLoadToken token) {
+        return _fileLoader->cancel(token);
+    }
+
+    EventHandlersToken PosixPlatform::addFileChangeHandler(const char *dirPath, EventHandler<void(const char *filePath)> &&changed) {
+        if (_fileWatcher == nullptr) {
+            _fileWatcher = std::make_unique<FileWatcher>(".");
+        }
+
+        if (_fileWatcher->watch(dirPath) == false) {
+            PLATFORM_LOG_ERROR(this, "[Platform] Can't watch directory '%s'", dirPath);
+            return nullptr;
+        }
+
+        return _fileChangeHandlers.add(FileChangeHandler{ dirPath, std::move(changed) });
+    }
+
+    void PosixPlatform::post(Job &&task) {
+        _postQueue.post(std::move(task));
+    }
+
+    std::shared_ptr<JobGroup> PosixPlatform::createJobGroup(std::initializer_list<std::shared_ptr<JobGroup>> dependencies) {
+        return _jobSystem->createGroup(dependencies);
+    }
+
+    void PosixPlatform::waitJobGroup(const std::shared_ptr<JobGroup> &group) {
+        _jobSystem->wait(group);
+    }
+
+    void PosixPlatform::parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t begin, std::size_t end)> &body) {
+        _jobSystem->parallelFor(count, grainSize, body);
+    }
+
+    std::size_t PosixPlatform::getJobWorkerCount() const {
+        return _jobSystem->getWorkerCount();
+    }
+
+    float PosixPlatform::getNativeScreenWidth() const {
+        return _nativeScreenWidth;
+    }
+
+    float PosixPlatform::getNativeScreenHeight() const {
+        return _nativeScreenHeight;
+    }
+
+    void *PosixPlatform::setNativeRenderingContext(void *) {
+        return nullptr;
+    }
+
+    void PosixPlatform::showCursor() {
+
+    }
+
+    void PosixPlatform::hideCursor() {
+
+    }
+
+    void PosixPlatform::showKeyboard() {
+
+    }
+
+    void PosixPlatform::hideKeyboard() {
+
+    }
+
+    EventHandlersToken PosixPlatform::addKeyboardEventHandlers(
+        EventHandler<void(const KeyboardEventArgs &)> &&down,
+        EventHandler<void(const KeyboardEventArgs &)> &&up
+    )
+    {
+        return _keyboardEventHandlers.add(KeyboardEventHandler{ std::move(down), std::move(up) });
+    }
+
+    EventHandlersToken PosixPlatform::addInputEventHandlers(
+        EventHandler<void(const char (&utf8char)[4])> &&input,
+        EventHandler<void()> &&backspace
+    )
+    {
+        return _inputEventHandlers.add(InputEventHandler{ std::move(input), std::move(backspace) });
+    }
+
+    EventHandlersToken PosixPlatform::addMouseEventHandlers(
+        EventHandler<void(const MouseEventArgs &)> &&press,
+        EventHandler<void(const MouseEventArgs &)> &&move,
+        EventHandler<void(const MouseEventArgs &)> &&release
+    )
+    {
+        return _mouseEventHandlers.add(MouseEventHandler{ std::move(press), std::move(move), std::move(release) });
+    }
+
+    EventHandlersToken PosixPlatform::addTouchEventHandlers(
+        EventHandler<void(const TouchEventArgs &)> &&start,
+        EventHandler<void(const TouchEventArgs &)> &&move,
+        EventHandler<void(const TouchEventArgs &)> &&release
+    )
+    {
+        return _touchEventHandlers.add(TouchEventHandler{ std::move(start), std::move(move), std::move(release) });
+    }
+
+    EventHandlersToken PosixPlatform::addGamepadEventHandlers(
+        EventHandler<void(const GamepadEventArgs &)> &&buttonPress,
+        EventHandler<void(const GamepadEventArgs &)> &&buttonRelease
+    )
+    {
+        return _gamepadEventHandlers.add(GamepadEventHandler{ std::move(buttonPress), std::move(buttonRelease) });
+    }
+
+    EventHandlersToken PosixPlatform::addInputBatchHandler(EventHandler<void(const InputBatch &)> &&batch) {
+        return _inputBatchHandlers.add(InputBatchHandler{ std::move(batch) });
+    }
+
+    bool PosixPlatform::startInputRecording(const char *filePath) {
+        std::unique_ptr<InputRecorder> recorder (new InputRecorder (filePath));
+
+        if (recorder->isValid() == false) {
+            PLATFORM_LOG_ERROR(this, "[Platform] Can't create input recording '%s'", filePath);
+            return false;
+        }
+
+        _inputRecorder = std::move(recorder);
+        return true;
+    }
+
+    bool PosixPlatform::startInputReplay(const char *filePath) {
+        std::unique_ptr<uint8_t[]> data;
+        std::size_t size = 0;
+
+        if (loadFile(filePath, data, size)) {
+            std::unique_ptr<InputReplay> replay (new InputReplay (std::move(data), size));
+
+            if (replay->isValid()) {
+                _inputReplay = std::move(replay);
+                return true;
+            }
+        }
+
+        PLATFORM_LOG_ERROR(this, "[Platform] Can't load input recording '%s'", filePath);
+        return false;
+    }
+
+    void PosixPlatform::injectInputEvent(const InputEvent &event) {
+        _injectedEvents.emplace_back(event);
+    }
+
+    void PosixPlatform::removeEventHandlers(EventHandlersToken token) {
+        // token belongs to one table, others reject it by its kind bits
+        _keyboardEventHandlers.remove(token) || _inputEventHandlers.remove(token) || _mouseEventHandlers.remove(token) || _touchEventHandlers.remove(token) || _gamepadEventHandlers.remove(token) || _inputBatchHandlers.remove(token) || _fileChangeHandlers.remove(token);
+    }
+
+    void PosixPlatform::setFramePacing(const FramePacing &pacing) {
+        _frameScheduler.setPacing(pacing);
+    }
+
+    void PosixPlatform::notifyActivity() {
+        _frameScheduler.notifyActivity();
+    }
+
+    FrameTimeHistogram PosixPlatform::getFrameTimeHistogram(bool reset) {
+        return _frameScheduler.getHistogram(reset);
+    }
+
+    bool PosixPlatform::captureProfile(std::uint32_t frameCount, const char *filePath) {
+        return _profileCapture->start(frameCount, filePath);
+    }
+
+    bool PosixPlatform::enablePerfCounters(bool enable) {
+        return _perfCounters->enable(enable);
+    }
+
+    std::vector<PerfCounterStats> PosixPlatform::getPerfCounterStats() const {
+        return _perfCounters->getStats();
+    }
+
+    std::string PosixPlatform::formatPerfCounterStats(PerfCounterFormat format) const {
+        return _perfCounters->format(format);
+    }
+
+    MemoryStats PosixPlatform::getMemoryStats(MemoryCategory category) const {
+        return MemoryTracker::getStats(category);
+    }
+
+    void *PosixPlatform::allocFrameMemory(std::size_t size, std::size_t alignment) {
+        return _frameArena->allocate(size, alignment);
+    }
+
+    FrameArenaStats PosixPlatform::getFrameArenaStats() const {
+        return _frameArena->getStats();
+    }
+
+    void PosixPlatform::run(std::function<void(float)> &&updateAndDraw) {
+        _killed = false;
+
+        while (_killed == false) {
+            // headless replay doesn't wait for wall clock
+            if (_inputReplay == nullptr) {
+                _frameScheduler.waitForFrame();
+            }
+
+            _profileCapture->nextFrame();
+            _perfCounters->nextFrame();
+            MemoryTracker::nextFrame();
+            _frameArena->nextFrame();
+            PLATFORM_PROFILE_ZONE("Frame");
+
+            const float dtSec = beginFrame(_frameScheduler.beginFrame());
+
+            if (_killed == false) {
+                updateAndDraw(dtSec);
+            }
+
+            _frameScheduler.endFrame();
+        }
+    }
+
+    void PosixPlatform::run(std::function<void(float)> &&update, std::function<void(float)> &&draw) {
+        run([update = std::move(update), draw = std::move(draw)](float dtSec) {
+            const std::uint32_t stepCount = _frameScheduler.takeFixedSteps(dtSec);
+
+            for (std::uint32_t i = 0; i < stepCount; i++) {
+                update(_frameScheduler.getPacing().fixedStepSec);
+            }
+
+            draw(_frameScheduler.getInterpolationAlpha());
+        });
+    }
+
+    void PosixPlatform::exit() {
+        _killed = true;
+    }
+
+    float PosixPlatform::beginFrame(float dtSec) {
+        PLATFORM_PROFILE_ZONE("Platform::beginFrame");
+
+        _fileLoader->dispatchCompletions();
+        _postQueue.run(_frameScheduler.getPacing().postBudgetSec);
+
+        if (_fileWatcher) {
+            _changedFiles.clear();
+            _fileWatcher->takeChanges(_changedFiles);
+
+            if (_changedFiles.size()) {
+                // index doesn't know about created and removed files
+                _fileIndex = nullptr;
+            }
+
+            for (const std::string &path : _changedFiles) {
+                _fileChangeHandlers.dispatch([&path](const FileChangeHandler &handlers) {
+                    if (handlers.changed && FileWatcher::isInDirectory(path, handlers.dirPath.c_str())) {
+                        handlers.changed(path.c_str());
+                    }
+                });
+            }
+        }
+
+        if (_inputReplay && _inputReplay->nextFrame(dtSec, [](const InputRecord &record) { dispatchInputRecord(record, record.timeSec); }) == false) {
+            // headless replay ends with the recording
+            _inputReplay = nullptr;
+            _killed = true;
+            return dtSec;
+        }
+
+        // events injected by handlers go to the next frame
+        _injectedEvents.swap(_injectedFrameEvents);
+
+        for (const InputEvent &event : _injectedFrameEvents) {
+            dispatchInjectedEvent(event);
+        }
+
+        _injectedFrameEvents.clear();
+
+        if (_inputRecorder) {
+            InputRecord record;
+            record.type = InputRecordType::FRAME;
+            record.dtSec = dtSec;
+            _inputRecorder->write(record);
+        }
+
+        const InputBatch batch = _inputQueue.flush();
+
+        if (batch.rawCount) {
+            PLATFORM_PROFILE_ZONE("Platform::dispatchInputBatch");
+
+            _inputBatchHandlers.dispatch([&batch](const InputBatchHandler &handlers) {
+                if (handlers.batch) {
+                    handlers.batch(batch);
+                }
+            });
+        }
+
+        return dtSec;
+    }
+
+    std::shared_ptr<Platform> getPlatformInstance() {
+        if (_platform == nullptr) {
+            _platform = std::make_shared<platform::PosixPlatform>();
+        }
+
+        return _platform;
+    }
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+namespace platform {
+    class AsyncFileLoader;
+    class AssetArchive;
+    class FileIndex;
+    class FileWatcher;
+    class JobSystem;
+    class ProfileCapture;
+    class PerfCounterCollector;
+    class FrameArena;
+
+    // Headless platform for Linux build and benchmark machines: no window and no GPU, input is injected or replayed
+    // Virtual screen size is taken from PLATFORM_SCREEN_WIDTH and PLATFORM_SCREEN_HEIGHT environment variables, 1280x720 by default
+    //
+    class PosixPlatform : public Platform {
+    public:
+        PosixPlatform();
+        ~PosixPlatform();
+
+        std::vector<std::string> formFileList(const char *dirPath);
+        void enumerateFiles(const char *dirPath, const char *pattern, bool recursive, const std::function<void(const FileInfo &)> &visitor);
+        bool getFileInfo(const char *filePath, FileInfo &info);
+        bool loadFile(const char *filePath, std::unique_ptr<unsigned char []> &data, std::size_t &size);
+        bool loadFile(const char *filePath, std::uint8_t *buffer, std::size_t capacity, std::size_t &size);
+        std::shared_ptr<FileView> mapFile(const char *filePath, FileAccess access);
+        bool mountArchive(const char *archivePath);
+
+        FileLoadToken loadFileAsync(
+            const char *filePath,
+            LoadPriority priority,
+            std::function<void(bool, std::unique_ptr<uint8_t[]> &, std::size_t)> &&completion
+        );
+
+        bool cancelFileLoad(FileLoadToken token);
+        EventHandlersToken addFileChangeHandler(const char *dirPath, EventHandler<void(const char *filePath)> &&changed);
+
+        void post(Job &&task);
+        std::shared_ptr<JobGroup> createJobGroup(std::initializer_list<std::shared_ptr<JobGroup>> dependencies);
+        void waitJobGroup(const std::shared_ptr<JobGroup> &group);
+        void parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t begin, std::size_t end)> &body);
+        std::size_t getJobWorkerCount() const;
+
+        float getNativeScreenWidth() const;
+        float getNativeScreenHeight() const;
+
+        void *setNativeRenderingContext(void *context);
+
+        void showCursor();
+        void hideCursor();
+        void showKeyboard();
+        void hideKeyboard();
+
+        EventHandlersToken addKeyboardEventHandlers(
+            EventHandler<void(const KeyboardEventArgs &)> &&down,
+            EventHandler<void(const KeyboardEventArgs &)> &&up
+        );
+
+        EventHandlersToken addInputEventHandlers(
+            EventHandler<void(const char (&utf8char)[4])> &&input,
+            EventHandler<void()> &&backspace
+        );
+
+        EventHandlersToken addMouseEventHandlers(
+            EventHandler<void(const MouseEventArgs &)> &&press,
+            EventHandler<void(const MouseEventArgs &)> &&move,
+            EventHandler<void(const MouseEventArgs &)> &&release
+        );
+
+        EventHandlersToken addTouchEventHandlers(
+            EventHandler<void(const TouchEventArgs &)> &&start,
+            EventHandler<void(const TouchEventArgs &)> &&move,
+            EventHandler<void(const TouchEventArgs &)> &&release
+        );
+
+        EventHandlersToken addGamepadEventHandlers(
+            EventHandler<void(const GamepadEventArgs &)> &&buttonPress,
+            EventHandler<void(const GamepadEventArgs &)> &&buttonRelease
+        );
+
+        EventHandlersToken addInputBatchHandler(EventHandler<void(const InputBatch &)> &&batch);
+        void injectInputEvent(const InputEvent &event);
+
+        bool startInputRecording(const char *filePath);
+        bool startInputReplay(const char *filePath);
+
+        void setFramePacing(const FramePacing &pacing);
+        void notifyActivity();
+        FrameTimeHistogram getFrameTimeHistogram(bool reset);
+        bool captureProfile(std::uint32_t frameCount, const char *filePath);
+        bool enablePerfCounters(bool enable);
+        std::vector<PerfCounterStats> getPerfCounterStats() const;
+        std::string formatPerfCounterStats(PerfCounterFormat format) const;
+        MemoryStats getMemoryStats(MemoryCategory category) const;
+        void *allocFrameMemory(std::size_t size, std::size_t alignment);
+        FrameArenaStats getFrameArenaStats() const;
+
+        void run(std::function<void(float)> &&updateAndDraw);
+        void run(std::function<void(float)> &&update, std::function<void(float)> &&draw);
+        void removeEventHandlers(EventHandlersToken token);
+        void exit();
+
+    public:
+        // Called by run() before each updateAndDraw
+        // @dtSec  - measured delta time
+        // @return - delta time for updateAndDraw
+        float beginFrame(float dtSec);
+
+    private:
+        float _nativeScreenWidth;
+        float _nativeScreenHeight;
+        bool _killed;
+
+        std::unique_ptr<AsyncFileLoader> _fileLoader;
+        std::vector<std::unique_ptr<AssetArchive>> _archives;
+        std::unique_ptr<FileIndex> _fileIndex;   // directories are added on demand, reset by mountArchive and file changes
+        std::unique_ptr<JobSystem> _jobSystem;
+        std::unique_ptr<FileWatcher> _fileWatcher;  // created by the first addFileChangeHandler
+        std::unique_ptr<ProfileCapture> _profileCapture;
+        std::unique_ptr<PerfCounterCollector> _perfCounters;
+        std::unique_ptr<FrameArena> _frameArena;
+
+        // @return index with files of @dirPath. @refresh - scan directory even if it's already in the index
+        const FileIndex &_getFileIndex(const char *dirPath, bool recursive, bool refresh);
+    };
+
+    std::vector<std::string> Platform::formFileList(const char *dirPath) {
+        return static_cast<PosixPlatform *>(this)->formFileList(dirPath);
+    }
+
+    void Platform::enumerateFiles(const char *dirPath, const char *pattern, bool recursive, const std::function<void(const FileInfo &)> &visitor) {
+        static_cast<PosixPlatform *>(this)->enumerateFiles(dirPath, pattern, recursive, visitor);
+    }
+
+    bool Platform::getFileInfo(const char *filePath, FileInfo &info) {
+        return static_cast<PosixPlatform *>(this)->getFileInfo(filePath, info);
+    }
+
+    bool Platform::loadFile(const char *filePath, std::unique_ptr<unsigned char []> &data, std::size_t &size) {
+        return static_cast<PosixPlatform *>(this)->loadFile(filePath, data, size);
+    }
+
+    bool Platform::loadFile(const char *filePath, std::uint8_t *buffer, std::size_t capacity, std::size_t &size) {
+        return static_cast<PosixPlatform *>(this)->loadFile(filePath, buffer, capacity, size);
+    }
+
+    std::shared_ptr<FileView> Platform::mapFile(const char *filePath, FileAccess access) {
+        return static_cast<PosixPlatform *>(this)->mapFile(filePath, access);
+    }
+
+    bool Platform::mountArchive(const char *archivePath) {
+        return static_cast<PosixPlatform *>(this)->mountArchive(archivePath);
+    }
+
+    FileLoadToken Platform::loadFileAsync(
+        const char *filePath,
+        LoadPriority priority,
+        std::function<void(bool, std::unique_ptr<uint8_t[]> &, std::size_t)> &&completion
+    )
+    {
+        return static_cast<PosixPlatform *>(this)->loadFileAsync(filePath, priority, std::move(completion));
+    }
+
+    bool Platform::cancelFileLoad(FileLoadToken token) {
+        return static_cast<PosixPlatform *>(this)->cancelFileLoad(token);
+    }
+
+    EventHandlersToken Platform::addFileChangeHandler(const char *dirPath, EventHandler<void(const char *filePath)> &&changed) {
+        return static_cast<PosixPlatform *>(this)->addFileChangeHandler(dirPath, std::move(changed));
+    }
+
+    void Platform::post(Job &&task) {
+        static_cast<PosixPlatform *>(this)->post(std::move(task));
+    }
+
+    std::shared_ptr<JobGroup> Platform::createJobGroup(std::initializer_list<std::shared_ptr<JobGroup>> dependencies) {
+        return static_cast<PosixPlatform *>(this)->createJobGroup(dependencies);
+    }
+
+    void Platform::waitJobGroup(const std::shared_ptr<JobGroup> &group) {
+        static_cast<PosixPlatform *>(this)->waitJobGroup(group);
+    }
+
+    void Platform::parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t begin, std::size_t end)> &body) {
+        static_cast<PosixPlatform *>(this)->parallelFor(count, grainSize, body);
+    }
+
+    std::size_t Platform::getJobWorkerCount() const {
+        return static_cast<const PosixPlatform *>(this)->getJobWorkerCount();
+    }
+
+    float Platform::getNativeScreenWidth() const {
+        return static_cast<const PosixPlatform *>(this)->getNativeScreenWidth();
+    }
+
+    float Platform::getNativeScreenHeight() const {
+        return static_cast<const PosixPlatform *>(this)->getNativeScreenHeight();
+    }
+
+    void *Platform::setNativeRenderingContext(void *context) {
+        return static_cast<PosixPlatform *>(this)->setNativeRenderingContext(context);
+    }
+
+    void Platform::showCursor() {
+        static_cast<PosixPlatform *>(this)->showCursor();
+    }
+
+    void Platform::hideCursor() {
+        static_cast<PosixPlatform *>(this)->hideCursor();
+    }
+
+    void Platform::showKeyboard() {
+        static_cast<PosixPlatform *>(this)->showKeyboard();
+    }
+
+    void Platform::hideKeyboard() {
+        static_cast<PosixPlatform *>(this)->hideKeyboard();
+    }
+
+    EventHandlersToken Platform::addKeyboardEventHandlers(
+        EventHandler<void(const KeyboardEventArgs &)> &&down,
+        EventHandler<void(const KeyboardEventArgs &)> &&up
+    )
+    {
+        return static_cast<PosixPlatform *>(this)->addKeyboardEventHandlers(std::move(down), std::move(up));
+    }
+
+    EventHandlersToken Platform::addInputEventHandlers(
+        EventHandler<void(const char (&utf8char)[4])> &&input,
+        EventHandler<void()> &&backspace
+    )
+    {
+        return static_cast<PosixPlatform *>(this)->addInputEventHandlers(std::move(input), std::move(backspace));
+    }
+
+    EventHandlersToken Platform::addMouseEventHandlers(
+        EventHandler<void(const MouseEventArgs &)> &&press,
+        EventHandler<void(const MouseEventArgs &)> &&move,
+        EventHandler<void(const MouseEventArgs &)> &&release
+    )
+    {
+        return static_cast<PosixPlatform *>(this)->addMouseEventHandlers(std::move(press), std::move(move), std::move(release));
+    }
+
+    EventHandlersToken Platform::addTouchEventHandlers(
+        EventHandler<void(const TouchEventArgs &)> &&start,
+        EventHandler<void(const TouchEventArgs &)> &&move,
+        EventHandler<void(const TouchEventArgs &)> &&release
+    )
+    {
+        return static_cast<PosixPlatform *>(this)->addTouchEventHandlers(std::move(start), std::move(move), std::move(release));
+    }
+
+    EventHandlersToken Platform::addGamepadEventHandlers(
+        EventHandler<void(const GamepadEventArgs &)> &&buttonPress,
+        EventHandler<void(const GamepadEventArgs &)> &&buttonRelease
+    )
+    {
+        return static_cast<PosixPlatform *>(this)->addGamepadEventHandlers(std::move(buttonPress), std::move(buttonRelease));
+    }
+
+    EventHandlersToken Platform::addInputBatchHandler(EventHandler<void(const InputBatch &)> &&batch) {
+        return static_cast<PosixPlatform *>(this)->addInputBatchHandler(std::move(batch));
+    }
+
+    void Platform::injectInputEvent(const InputEvent &event) {
+        static_cast<PosixPlatform *>(this)->injectInputEvent(event);
+    }
+
+    bool Platform::startInputRecording(const char *filePath) {
+        return static_cast<PosixPlatform *>(this)->startInputRecording(filePath);
+    }
+
+    bool Platform::startInputReplay(const char *filePath) {
+        return static_cast<PosixPlatform *>(this)->startInputReplay(filePath);
+    }
+
+    void Platform::setFramePacing(const FramePacing &pacing) {
+        static_cast<PosixPlatform *>(this)->setFramePacing(pacing);
+    }
+
+    void Platform::notifyActivity() {
+        static_cast<PosixPlatform *>(this)->notifyActivity();
+    }
+
+    FrameTimeHistogram Platform::getFrameTimeHistogram(bool reset) {
+        return static_cast<PosixPlatform *>(this)->getFrameTimeHistogram(reset);
+    }
+
+    bool Platform::captureProfile(std::uint32_t frameCount, const char *filePath) {
+        return static_cast<PosixPlatform *>(this)->captureProfile(frameCount, filePath);
+    }
+
+    bool Platform::enablePerfCounters(bool enable) {
+        return static_cast<PosixPlatform *>(this)->enablePerfCounters(enable);
+    }
+
+    std::vector<PerfCounterStats> Platform::getPerfCounterStats() const {
+        return static_cast<const PosixPlatform *>(this)->getPerfCounterStats();
+    }
+
+    std::string Platform::formatPerfCounterStats(PerfCounterFormat format) const {
+        return static_cast<const PosixPlatform *>(this)->formatPerfCounterStats(format);
+    }
+
+    MemoryStats Platform::getMemoryStats(MemoryCategory category) const {
+        return static_cast<const PosixPlatform *>(this)->getMemoryStats(category);
+    }
+
+    void *Platform::allocFrameMemory(std::size_t size, std::size_t alignment) {
+        return static_cast<PosixPlatform *>(this)->allocFrameMemory(size, alignment);
+    }
+
+    FrameArenaStats Platform::getFrameArenaStats() const {
+        return static_cast<const PosixPlatform *>(this)->getFrameArenaStats();
+    }
+
+    void Platform::run(std::function<void(float)> &&updateAndDraw) {
+        static_cast<PosixPlatform *>(this)->run(std::move(updateAndDraw));
+    }
+
+    void Platform::run(std::function<void(float)> &&update, std::function<void(float)> &&draw) {
+        static_cast<PosixPlatform *>(this)->run(std::move(update), std::move(draw));
+    }
+
+    void Platform::removeEventHandlers(EventHandlersToken token) {
+        static_cast<PosixPlatform *>(this)->removeEventHandlers(token);
+    }
+
+    void Platform::exit() {
+        static_cast<PosixPlatform *>(this)->exit();
+    }
+}
@@ -0,0 +1,471 @@
+#include "interfaces.h"
+#include "posix_render.h"
+#include "command_list.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::shared_ptr<platform::PosixRender> _render;
+
+    // Size of 'const' block of shader source. Constants are 16-byte vectors and matrix4, as in translated shaders of GL backend
+    std::uint32_t getConstBlockSize(const char *shadersrc) {
+        struct {
+            const char *name;
+            std::uint32_t size;
+        }
+        typeSizeTable[] = {
+            {"float4", 16},
+            {"int4", 16},
+            {"uint4", 16},
+            {"matrix4", 64},
+        };
+
+        std::istringstream stream (shadersrc ? shadersrc : "");
+        std::string blockName, varname, separator, type;
+
+        while (stream >> blockName) {
+            if (blockName == "const" && (stream >> std::ws).peek() == '{') {
+                std::uint32_t result = 0;
+                stream.ignore();
+
+                while (stream >> varname && varname[0] != '}' && stream >> separator >> type && separator == ":") {
+                    const std::size_t braceStart = varname.find('[');
+                    const std::uint32_t multiply = braceStart != std::string::npos ? std::uint32_t(std::max(std::atoi(varname.c_str() + braceStart + 1), 1)) : 1;
+
+                    for (const auto &entry : typeSizeTable) {
+                        if (type == entry.name) {
+                            result += entry.size * multiply;
+                        }
+                    }
+                }
+
+                return result;
+            }
+        }
+
+        return 0;
+    }
+}
+
+namespace platform {
+    class PosixShader : public Shader {
+    public:
+        PosixShader(const char *shadersrc) : _constBlockSize(::getConstBlockSize(shadersrc)) {}
+
+        ~PosixShader() {
+            if (_render) {
+                _render->forgetShader(this);
+            }
+        }
+
+        std::uint32_t getConstBlockSize() const {
+            return _constBlockSize;
+        }
+
+        std::uint32_t _constBlockSize;
+    };
+
+    std::uint32_t Shader::getConstBlockSize() const {
+        return static_cast<const PosixShader *>(this)->getConstBlockSize();
+    }
+}
+
+namespace platform {
+    class PosixTexture : public Texture2D {
+    public:
+        PosixTexture(Texture2D::Format format, std::uint32_t w, std::uint32_t h, std::uint32_t mipCount)
+        : _format(format)
+        , _width(w)
+        , _height(h)
+        , _mipCount(mipCount)
+        {}
+
+        ~PosixTexture() {
+            if (_render) {
+                _render->forgetTexture(this);
+            }
+        }
+
+        std::uint32_t getWidth() const {
+            return _width;
+        }
+
+        std::uint32_t getHeight() const {
+            return _height;
+        }
+
+        std::uint32_t getMipCount() const {
+            return _mipCount;
+        }
+
+        Texture2D::Format getFormat() const {
+            return _format;
+        }
+
+        // Same estimate as GL backend, drivers store rgb textures as rgba
+        std::size_t getGpuSize() const {
+            const std::size_t bytesPerPixel = _format == Texture2D::Format::R8UN ? 1 : 4;
+            std::size_t result = 0;
+
+            for (std::uint32_t i = 0; i < _mipCount; i++) {
+                result += std::size_t(std::max(_width >> i, 1u)) * std::size_t(std::max(_height >> i, 1u)) * bytesPerPixel;
+            }
+
+            return result;
+        }
+
+        Texture2D::Format _format;
+        std::uint32_t _width;
+        std::uint32_t _height;
+        std::uint32_t _mipCount;
+    };
+
+    std::uint32_t Texture2D::getWidth() const {
+        return static_cast<const PosixTexture *>(this)->getWidth();
+    }
+
+    std::uint32_t Texture2D::getHeight() const {
+        return static_cast<const PosixTexture *>(this)->getHeight();
+    }
+
+    std::uint32_t Texture2D::getMipCount() const {
+        return static_cast<const PosixTexture *>(this)->getMipCount();
+    }
+
+    Texture2D::Format Texture2D::getFormat() const {
+        return static_cast<const PosixTexture *>(this)->getFormat();
+    }
+
+    std::size_t Texture2D::getGpuSize() const {
+        return static_cast<const PosixTexture *>(this)->getGpuSize();
+    }
+}
+
+namespace platform {
+    class PosixData : public StructuredData {
+    public:
+        PosixData(std::uint32_t count, std::uint32_t stride) : _count(count), _stride(stride) {}
+
+        ~PosixData() {
+            if (_render) {
+                _render->forgetData(this);
+            }
+        }
+
+        std::uint32_t getCount() const {
+            return _count;
+        }
+
+        std::uint32_t getStride() const {
+            return _stride;
+        }
+
+        std::size_t getGpuSize() const {
+            return std::size_t(_count) * _stride;
+        }
+
+        std::uint32_t _count;
+        std::uint32_t _stride;
+    };
+
+    std::uint32_t StructuredData::getCount() const {
+        return static_cast<const PosixData *>(this)->getCount();
+    }
+
+    std::uint32_t StructuredData::getStride() const {
+        return static_cast<const PosixData *>(this)->getStride();
+    }
+
+    std::size_t StructuredData::getGpuSize() const {
+        return static_cast<const PosixData *>(this)->getGpuSize();
+    }
+}
+
+namespace platform {
+    PosixRender::PosixRender(const std::shared_ptr<Platform> &platform) : _platform(platform), _drawSorter(std::make_unique<DrawSorter>()) {
+        PLATFORM_LOG_INFO(_platform, "[Render] Null device: commands are counted, nothing is drawn");
+    }
+
+    PosixRender::~PosixRender() {}
+
+    void PosixRender::updateCameraTransform(const float (&)[3], const float (&)[3], const float (&)[16]) {}
+
+    std::shared_ptr<Shader> PosixRender::createShader(
+        const char *shadersrc,
+        const std::initializer_list<ShaderInput> &,
+        const std::initializer_list<ShaderInput> &,
+        const void *
+    ) {
+        return std::make_shared<PosixShader>(shadersrc);
+    }
+
+    bool PosixRender::reloadShader(const std::shared_ptr<Shader> &shader, const char *shadersrc, const void *) {
+        static_cast<PosixShader *>(shader.get())->_constBlockSize = ::getConstBlockSize(shadersrc);
+        _deleteVertexArrays(shader.get());
+        return true;
+    }
+
+    std::shared_ptr<Texture2D> PosixRender::createTexture(
+        Texture2D::Format format,
+        std::uint32_t width,
+        std::uint32_t height,
+        const std::initializer_list<const std::uint8_t *> &mipsData
+    ) {
+        return std::make_shared<PosixTexture>(format, width, height, std::max(std::uint32_t(mipsData.size()), 1u));
+    }
+
+    std::shared_ptr<Texture2D> PosixRender::createTexture(
+        Texture2D::Format format,
+        std::uint32_t width,
+        std::uint32_t height,
+        const std::uint8_t *const *,
+        std::uint32_t mipCount
+    ) {
+        return std::make_shared<PosixTexture>(format, width, height, std::max(mipCount, 1u));
+    }
+
+    void PosixRender::reloadTexture(
+        const std::shared_ptr<Texture2D> &texture,
+        Texture2D::Format format,
+        std::uint32_t width,
+        std::uint32_t height,
+        const std::uint8_t *const *,
+        std::uint32_t mipCount
+    ) {
+        PosixTexture *textureImp = static_cast<PosixTexture *>(texture.get());
+
+        textureImp->_format = format;
+        textureImp->_width = width;
+        textureImp->_height = height;
+        textureImp->_mipCount = std::max(mipCount, 1u);
+    }
+
+    std::shared_ptr<StructuredData> PosixRender::createData(const void *, std::uint32_t count, std::uint32_t stride) {
+        return std::make_shared<PosixData>(count, stride);
+    }
+
+    void PosixRender::applyShader(const std::shared_ptr<Shader> &shader, const void *constants) {
+        if (shader && constants) {
+            _stats.constantUploads++;
+        }
+
+        _applyShader(shader.get(), constants);
+    }
+
+    void PosixRender::applyTextures(const std::initializer_list<const Texture2D *> &textures) {
+        _applyTextures(textures.begin(), textures.size());
+    }
+
+    void PosixRender::drawGeometry(std::uint32_t, Topology) {
+        _stats.drawCalls++;
+    }
+
+    void PosixRender::drawGeometry(
+        const std::shared_ptr<StructuredData> &vertexData,
+        const std::shared_ptr<StructuredData> &instanceData,
+        std::uint32_t vertexCount,
+        std::uint32_t instanceCount,
+        Topology topology
+    ) {
+        _drawGeometry(vertexData.get(), instanceData.get(), vertexCount, instanceCount, topology);
+    }
+
+    std::shared_ptr<CommandList> PosixRender::createCommandList() {
+        return std::make_shared<CommandListImp>();
+    }
+
+    void PosixRender::submitCommandList(const std::shared_ptr<CommandList> &list, bool sorted) {
+        PLATFORM_PROFILE_ZONE("Render::submitCommandList");
+
+        const CommandListImp *listImp = static_cast<const CommandListImp *>(list.get());
+
+        if (sorted) {
+            _drawSorter->add(list);
+        }
+        else {
+            // constants of the whole list are uploaded at once, as in GL backend
+            if (listImp->getConstantsSize(1)) {
+                _stats.constantUploads++;
+            }
+
+            listImp->execute([this](const CommandListImp::Command &command) {
+                switch (command.type) {
+                    case CommandListImp::CommandType::APPLY_SHADER: {
+                        const auto &apply = reinterpret_cast<const CommandListImp::ApplyShaderCommand &>(command);
+                        _applyShader(apply.shader, apply.constantsSize ? CommandListImp::getPayload(apply) : nullptr);
+                        break;
+                    }
+                    case CommandListImp::CommandType::APPLY_TEXTURES: {
+                        const auto &apply = reinterpret_cast<const CommandListImp::ApplyTexturesCommand &>(command);
+                        _applyTextures(static_cast<const Texture2D *const *>(CommandListImp::getPayload(apply)), apply.count);
+                        break;
+                    }
+                    case CommandListImp::CommandType::DRAW: {
+                        _stats.drawCalls++;
+                        break;
+                    }
+                    case CommandListImp::CommandType::DRAW_INSTANCED: {
+                        const auto &draw = reinterpret_cast<const CommandListImp::DrawCommand &>(command);
+                        _drawGeometry(draw.vertexData, draw.instanceData, draw.vertexCount, draw.instanceCount, draw.topology);
+                        break;
+                    }
+                }
+            });
+        }
+
+        _stats.submittedLists++;
+        _stats.submittedCommands += listImp->getCommandCount();
+    }
+
+    void PosixRender::prepareFrame() {}
+
+    void PosixRender::presentFrame(float) {
+        _executeSortedDraws();
+    }
+
+    void PosixRender::getFrameBufferData(std::uint8_t *imgFrame) {
+        std::memset(imgFrame, 0, std::size_t(_platform->getNativeScreenWidth()) * std::size_t(_platform->getNativeScreenHeight()) * 4);
+    }
+
+    RenderStats PosixRender::getStats() const {
+        return _stats;
+    }
+
+    void PosixRender::forgetShader(const Shader *shader) {
+        if (_bindings.shader == shader) {
+            _bindings.shader = nullptr;
+        }
+
+        _deleteVertexArrays(shader);
+    }
+
+    void PosixRender::forgetTexture(const Texture2D *texture) {
+        for (const Texture2D *&binding : _bindings.textures) {
+            if (binding == texture) {
+                binding = nullptr;
+            }
+        }
+    }
+
+    void PosixRender::forgetData(const StructuredData *data) {
+        _deleteVertexArrays(data);
+    }
+
+    void PosixRender::_executeSortedDraws() {
+        PLATFORM_PROFILE_ZONE("Render::executeSortedDraws");
+
+        if (_drawSorter->getConstantsSize()) {
+            _stats.constantUploads++;
+        }
+
+        _drawSorter->execute([this](const DrawSorter::DrawItem &item, bool applyShader, bool applyTextures) {
+            if (applyShader) {
+                _applyShader(item.shader->shader, item.shader->constantsSize ? CommandListImp::getPayload(*item.shader) : nullptr);
+            }
+            if (applyTextures) {
+                _applyTextures(static_cast<const Texture2D *const *>(CommandListImp::getPayload(*item.textures)), item.textures->count);
+            }
+            if (item.draw->header.type == CommandListImp::CommandType::DRAW) {
+                _stats.drawCalls++;
+            }
+            else {
+                _drawGeometry(item.draw->vertexData, item.draw->instanceData, item.draw->vertexCount, item.draw->instanceCount, item.draw->topology);
+            }
+        }, _stats);
+    }
+
+    void PosixRender::_applyShader(const Shader *shader, const void *constants) {
+        if (shader) {
+            // program and permanent constants are bound together, frame data once, range of constants for every upload
+            if (_bindings.shader != shader) {
+                _bindings.shader = shader;
+                _stats.stateCallsIssued += 2;
+            }
+            else {
+                _stats.stateCallsSkipped += 2;
+            }
+            if (_bindings.frameData == false) {
+                _bindings.frameData = true;
+                _stats.stateCallsIssued++;
+            }
+            else {
+                _stats.stateCallsSkipped++;
+            }
+            if (constants) {
+                _stats.stateCallsIssued++;
+            }
+            else {
+                _stats.stateCallsSkipped++;
+            }
+
+            _currentShader = shader;
+            _stats.shaderApplies++;
+        }
+    }
+
+    void PosixRender::_applyTextures(const Texture2D *const *textures, std::size_t count) {
+        if (count > TEXTURE_SLOT_COUNT) {
+            PLATFORM_LOG_WARNING(_platform, "[Render] applyTextures : only %zu texture slots are available", TEXTURE_SLOT_COUNT);
+            count = TEXTURE_SLOT_COUNT;
+        }
+
+        // unit is switched and bound only for texture that isn't bound yet
+        for (std::size_t i = 0; i < count; i++) {
+            if (textures[i] && _bindings.textures[i] != textures[i]) {
+                _stats.stateCallsIssued += _bindings.activeTexture != i ? 2 : 1;
+                _stats.stateCallsSkipped += _bindings.activeTexture != i ? 0 : 1;
+                _bindings.activeTexture = i;
+                _bindings.textures[i] = textures[i];
+            }
+            else if (textures[i]) {
+                _stats.stateCallsSkipped += 2;
+            }
+        }
+
+        _stats.textureApplies++;
+    }
+
+    void PosixRender::_drawGeometry(const StructuredData *vertexData, const StructuredData *instanceData, std::uint32_t, std::uint32_t, Topology) {
+        if (_currentShader) {
+            if (vertexData || instanceData) {
+                const VertexArrayKey key = {_currentShader, vertexData, instanceData};
+
+                if (_vertexArrays.find(key) != _vertexArrays.end()) {
+                    _stats.vertexArraysReused++;
+                }
+                else {
+                    _vertexArrays.emplace(key);
+                    _stats.vertexArraysCreated++;
+                }
+            }
+
+            _stats.drawCalls++;
+        }
+        else {
+            PLATFORM_LOG_WARNING(_platform, "[Render] drawGeometry requires shader set");
+        }
+    }
+
+    void PosixRender::_deleteVertexArrays(const void *shaderOrData) {
+        for (auto entry = _vertexArrays.begin(); entry != _vertexArrays.end(); ) {
+            if (entry->shader == shaderOrData || entry->vertexData == shaderOrData || entry->instanceData == shaderOrData) {
+                entry = _vertexArrays.erase(entry);
+            }
+            else {
+                ++entry;
+            }
+        }
+    }
+
+    std::shared_ptr<RenderingDevice> getRenderingDeviceInstance(const std::shared_ptr<Platform> &platform) {
+        if (_render == nullptr) {
+            _render = std::make_shared<PosixRender>(platform);
+        }
+
+        return _render;
+    }
+}
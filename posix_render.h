@@ -0,0 +1,221 @@
+#pragma once
+
+#include <unordered_set>
+
+namespace platform {
+    class DrawSorter;
+
+    // POSIX has no output, render commands are only counted. Used for tests and benchmarks of recording and submission
+    //
+    class PosixRender : public RenderingDevice {
+    public:
+        PosixRender(const std::shared_ptr<Platform> &platform);
+        ~PosixRender();
+
+        void updateCameraTransform(const float (&camPos)[3], const float(&camDir)[3], const float(&camVP)[16]);
+
+        std::shared_ptr<Shader> createShader(
+            const char *shadersrc,
+            const std::initializer_list<ShaderInput> &vertex,
+            const std::initializer_list<ShaderInput> &instance,
+            const void *prmnt
+        );
+
+        bool reloadShader(const std::shared_ptr<Shader> &shader, const char *shadersrc, const void *prmnt);
+
+        std::shared_ptr<Texture2D> createTexture(
+            Texture2D::Format format,
+            std::uint32_t width,
+            std::uint32_t height,
+            const std::initializer_list<const std::uint8_t *> &mipsData
+        );
+
+        std::shared_ptr<Texture2D> createTexture(
+            Texture2D::Format format,
+            std::uint32_t width,
+            std::uint32_t height,
+            const std::uint8_t *const *mipsData,
+            std::uint32_t mipCount
+        );
+
+        void reloadTexture(
+            const std::shared_ptr<Texture2D> &texture,
+            Texture2D::Format format,
+            std::uint32_t width,
+            std::uint32_t height,
+            const std::uint8_t *const *mipsData,
+            std::uint32_t mipCount
+        );
+
+        std::shared_ptr<StructuredData> createData(const void *data, std::uint32_t count, std::uint32_t stride);
+
+        void applyShader(const std::shared_ptr<Shader> &shader, const void *constants);
+        void applyTextures(const std::initializer_list<const Texture2D *> &textures);
+
+        void drawGeometry(std::uint32_t vertexCount, Topology topology);
+        void drawGeometry(
+            const std::shared_ptr<StructuredData> &vertexData,
+            const std::shared_ptr<StructuredData> &instanceData,
+            std::uint32_t vertexCount,
+            std::uint32_t instanceCount,
+            Topology topology
+        );
+
+        std::shared_ptr<CommandList> createCommandList();
+        void submitCommandList(const std::shared_ptr<CommandList> &list, bool sorted);
+
+        void prepareFrame();
+        void presentFrame(float dtSec);
+        void getFrameBufferData(std::uint8_t *imgFrame);
+
+        RenderStats getStats() const;
+
+        // Called by destructors of shaders, textures and data
+        void forgetShader(const Shader *shader);
+        void forgetTexture(const Texture2D *texture);
+        void forgetData(const StructuredData *data);
+
+    private:
+        void _executeSortedDraws();
+        void _applyShader(const Shader *shader, const void *constants);
+        void _applyTextures(const Texture2D *const *textures, std::size_t count);
+        void _drawGeometry(const StructuredData *vertexData, const StructuredData *instanceData, std::uint32_t vertexCount, std::uint32_t instanceCount, Topology topology);
+        void _deleteVertexArrays(const void *shaderOrData);
+
+        static constexpr std::size_t TEXTURE_SLOT_COUNT = 8;
+
+        // Bindings are filtered as in GL backend, so counters of state calls can be checked without GPU
+        struct BindingState {
+            const Shader *shader = nullptr;             // program and its permanent constants
+            bool frameData = false;                     // buffer of frame data, constants are bound by range on every upload
+            std::size_t activeTexture = 0;
+            const Texture2D *textures[TEXTURE_SLOT_COUNT] = {};
+        };
+
+        // Vertex arrays are cached by shader and data as in GL backend
+        struct VertexArrayKey {
+            const Shader *shader;
+            const StructuredData *vertexData;
+            const StructuredData *instanceData;
+
+            bool operator ==(const VertexArrayKey &other) const {
+                return shader == other.shader && vertexData == other.vertexData && instanceData == other.instanceData;
+            }
+        };
+
+        struct VertexArrayKeyHash {
+            std::size_t operator()(const VertexArrayKey &key) const {
+                return (std::hash<const void *>()(key.shader) * 31 + std::hash<const void *>()(key.vertexData)) * 31 + std::hash<const void *>()(key.instanceData);
+            }
+        };
+
+        std::shared_ptr<Platform> _platform;
+        const Shader *_currentShader = nullptr;
+        BindingState _bindings;
+        std::unordered_set<VertexArrayKey, VertexArrayKeyHash> _vertexArrays;
+        RenderStats _stats {};
+        std::unique_ptr<DrawSorter> _drawSorter;
+    };
+
+    void RenderingDevice::updateCameraTransform(const float (&camPos)[3], const float(&camDir)[3], const float(&camVP)[16]) {
+        static_cast<PosixRender *>(this)->updateCameraTransform(camPos, camDir, camVP);
+    }
+
+    std::shared_ptr<Shader> RenderingDevice::createShader(
+        const char *shadersrc,
+        const std::initializer_list<ShaderInput> &vertex,
+        const std::initializer_list<ShaderInput> &instance,
+        const void *prmnt
+    )
+    {
+        return static_cast<PosixRender *>(this)->createShader(shadersrc, vertex, instance, prmnt);
+    }
+
+    bool RenderingDevice::reloadShader(const std::shared_ptr<Shader> &shader, const char *shadersrc, const void *prmnt) {
+        return static_cast<PosixRender *>(this)->reloadShader(shader, shadersrc, prmnt);
+    }
+
+    std::shared_ptr<Texture2D> RenderingDevice::createTexture(
+        Texture2D::Format format,
+        std::uint32_t width,
+        std::uint32_t height,
+        const std::initializer_list<const std::uint8_t *> &mipsData
+    )
+    {
+        return static_cast<PosixRender *>(this)->createTexture(format, width, height, mipsData);
+    }
+
+    std::shared_ptr<Texture2D> RenderingDevice::createTexture(
+        Texture2D::Format format,
+        std::uint32_t width,
+        std::uint32_t height,
+        const std::uint8_t *const *mipsData,
+        std::uint32_t mipCount
+    )
+    {
+        return static_cast<PosixRender *>(this)->createTexture(format, width, height, mipsData, mipCount);
+    }
+
+    void RenderingDevice::reloadTexture(
+        const std::shared_ptr<Texture2D> &texture,
+        Texture2D::Format format,
+        std::uint32_t width,
+        std::uint32_t height,
+        const std::uint8_t *const *mipsData,
+        std::uint32_t mipCount
+    )
+    {
+        static_cast<PosixRender *>(this)->reloadTexture(texture, format, width, height, mipsData, mipCount);
+    }
+
+    std::shared_ptr<StructuredData> RenderingDevice::createData(const void *data, std::uint32_t count, std::uint32_t stride) {
+        return static_cast<PosixRender *>(this)->createData(data, count, stride);
+    }
+
+    void RenderingDevice::applyShader(const std::shared_ptr<Shader> &shader, const void *constants) {
+        static_cast<PosixRender *>(this)->applyShader(shader, constants);
+    }
+
+    void RenderingDevice::applyTextures(const std::initializer_list<const Texture2D *> &textures) {
+        static_cast<PosixRender *>(this)->applyTextures(textures);
+    }
+
+    void RenderingDevice::drawGeometry(std::uint32_t vertexCount, Topology topology) {
+        static_cast<PosixRender *>(this)->drawGeometry(vertexCount, topology);
+    }
+
+    void RenderingDevice::drawGeometry(
+        const std::shared_ptr<StructuredData> &vertexData,
+        const std::shared_ptr<StructuredData> &instanceData,
+        std::uint32_t vertexCount,
+        std::uint32_t instanceCount,
+        Topology topology
+    )
+    {
+        static_cast<PosixRender *>(this)->drawGeometry(vertexData, instanceData, vertexCount, instanceCount, topology);
+    }
+
+    std::shared_ptr<CommandList> RenderingDevice::createCommandList() {
+        return static_cast<PosixRender *>(this)->createCommandList();
+    }
+
+    void RenderingDevice::submitCommandList(const std::shared_ptr<CommandList> &list, bool sorted) {
+        static_cast<PosixRender *>(this)->submitCommandList(list, sorted);
+    }
+
+    void RenderingDevice::prepareFrame() {
+        static_cast<PosixRender *>(this)->prepareFrame();
+    }
+
+    void RenderingDevice::presentFrame(float dtSec) {
+        static_cast<PosixRender *>(this)->presentFrame(dtSec);
+    }
+
+    void RenderingDevice::getFrameBufferData(std::uint8_t *imgFrame) {
+        static_cast<PosixRender *>(this)->getFrameBufferData(imgFrame);
+    }
+
+    RenderStats RenderingDevice::getStats() const {
+        return static_cast<const PosixRender *>(this)->getStats();
+    }
+}
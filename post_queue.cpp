@@ -0,0 +1,107 @@
+
+#include "post_queue.h"
+
+#include <chrono>
+
+namespace {
+    std::size_t roundCapacity(std::size_t capacity) {
+        std::size_t result = 2;
+
+        while (result < capacity) {
+            result <<= 1;
+        }
+
+        return result;
+    }
+}
+
+namespace platform {
+    PostQueue::PostQueue(std::size_t capacity) : _mask(roundCapacity(capacity) - 1), _cells(new Cell[_mask + 1]) {
+        for (std::size_t i = 0; i <= _mask; i++) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        MemoryTracker::allocated(MemoryCategory::TASKS, (_mask + 1) * sizeof(Cell));
+    }
+
+    PostQueue::~PostQueue() {
+        MemoryTracker::freed(MemoryCategory::TASKS, (_mask + 1) * sizeof(Cell));
+    }
+
+    void PostQueue::post(Job &&task) {
+        if (_overflowCount.load(std::memory_order_acquire) == 0 && _tryPush(task)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(_overflowGuard);
+        _overflow.emplace_back(std::move(task));
+        _overflowCount.fetch_add(1, std::memory_order_release);
+    }
+
+    std::size_t PostQueue::run(double budgetSec) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(budgetSec));
+        std::size_t count = 0;
+
+        while (count == 0 || std::chrono::steady_clock::now() < deadline) {
+            Cell &cell = _cells[_popPosition & _mask];
+
+            if (cell.sequence.load(std::memory_order_acquire) == _popPosition + 1) {
+                Job task = std::move(cell.task);
+                cell.sequence.store(_popPosition + _mask + 1, std::memory_order_release);
+                _popPosition++;
+
+                task();
+                count++;
+                continue;
+            }
+
+            // overflow is taken only when ring is empty: a producer can be writing a cell that precedes its tasks in overflow
+            if (_overflowCount.load(std::memory_order_acquire) == 0 || _pushPosition.load(std::memory_order_acquire) != _popPosition) {
+                break;
+            }
+
+            // ring is empty, the rest of tasks is in overflow list
+            Job task;
+
+            {
+                std::lock_guard<std::mutex> guard(_overflowGuard);
+                task = std::move(_overflow[_overflowOffset++]);
+
+                if (_overflowOffset == _overflow.size()) {
+                    _overflow.clear();
+                    _overflowOffset = 0;
+                }
+            }
+
+            task();
+            count++;
+            _overflowCount.fetch_sub(1, std::memory_order_release);
+        }
+
+        return count;
+    }
+
+    bool PostQueue::_tryPush(Job &task) {
+        std::size_t position = _pushPosition.load(std::memory_order_relaxed);
+
+        while (true) {
+            Cell &cell = _cells[position & _mask];
+            const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(position);
+
+            if (diff == 0) {
+                if (_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.task = std::move(task);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                position = _pushPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
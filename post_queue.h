@@ -0,0 +1,49 @@
+#pragma once
+
+#include "interfaces.h"
+#include "memory_tracker.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace platform {
+    // Multi-producer single-consumer queue of tasks for the thread that runs Platform::run()
+    // Tasks are stored in preallocated ring without locks. When the ring is full, tasks go to locked overflow list
+    // until consumer empties it, so tasks of one producer keep their order
+    //
+    class PostQueue {
+    public:
+        // @capacity - count of tasks in ring, rounded up to power of two
+        //
+        PostQueue(std::size_t capacity);
+        ~PostQueue();
+
+        // Thread-safe
+        //
+        void post(Job &&task);
+
+        // Runs tasks in order of posting until queue is empty or @budgetSec is spent. At least one task is run
+        // Consumer thread only
+        // @return - count of tasks run
+        //
+        std::size_t run(double budgetSec);
+
+    private:
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            Job task;
+        };
+
+        bool _tryPush(Job &task);
+
+        const std::size_t _mask;
+        std::unique_ptr<Cell[]> _cells;
+        alignas(64) std::atomic<std::size_t> _pushPosition {0};
+        alignas(64) std::size_t _popPosition = 0;
+
+        std::atomic<std::size_t> _overflowCount {0};
+        std::mutex _overflowGuard;
+        TrackedVector<Job, MemoryCategory::TASKS> _overflow;
+        std::size_t _overflowOffset = 0;
+    };
+}
@@ -0,0 +1,182 @@
+#include "profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+namespace {
+    constexpr std::uint32_t RECORDS_PER_THREAD = 64 * 1024;    // zones over the limit are dropped until the next capture
+
+    struct ProfileRecord {
+        const char *name;
+        std::uint64_t startNs;
+        std::uint64_t endNs;
+    };
+
+    // Written by the owner thread only. State packs epoch of the records (high half) and their count (low half),
+    // so reader never sees count of one capture with epoch of another
+    //
+    struct ThreadBuffer {
+        std::unique_ptr<ProfileRecord[]> records;
+        std::atomic<std::uint64_t> state {0};
+        std::atomic<std::uint32_t> dropped {0};
+        std::uint32_t threadIndex;
+    };
+
+    // 0 - no capture
+    std::atomic<std::uint32_t> _activeEpoch {0};
+
+    // Buffers live until exit, so capture can be read after its threads have finished
+    std::mutex _buffersGuard;
+    std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+
+    std::uint64_t getTimeNs() {
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    ThreadBuffer &getThreadBuffer() {
+        static thread_local ThreadBuffer *buffer = nullptr;
+
+        if (buffer == nullptr) {
+            std::unique_ptr<ThreadBuffer> created (new ThreadBuffer);
+            created->records.reset(new ProfileRecord[RECORDS_PER_THREAD]);
+
+            std::lock_guard<std::mutex> guard(_buffersGuard);
+            created->threadIndex = std::uint32_t(_buffers.size());
+            buffer = created.get();
+            _buffers.emplace_back(std::move(created));
+        }
+
+        return *buffer;
+    }
+
+    void writeEscaped(std::string &out, const char *text) {
+        for (; *text; text++) {
+            if (*text == '"' || *text == '\\') {
+                out += '\\';
+            }
+            if (std::uint8_t(*text) >= 0x20) {
+                out += *text;
+            }
+        }
+    }
+}
+
+namespace platform {
+    std::uint64_t ProfileZone::begin() {
+        return _activeEpoch.load(std::memory_order_relaxed) ? getTimeNs() : 0;
+    }
+
+    void ProfileZone::end(const char *name, std::uint64_t startNs) {
+        const std::uint32_t epoch = _activeEpoch.load(std::memory_order_relaxed);
+
+        if (epoch == 0) {
+            return;
+        }
+
+        ThreadBuffer &buffer = getThreadBuffer();
+        const std::uint64_t state = buffer.state.load(std::memory_order_relaxed);
+        const std::uint32_t count = std::uint32_t(state >> 32) == epoch ? std::uint32_t(state) : 0;
+
+        if (count < RECORDS_PER_THREAD) {
+            buffer.records[count] = ProfileRecord{name, startNs, getTimeNs()};
+            buffer.state.store((std::uint64_t(epoch) << 32) | (count + 1), std::memory_order_release);
+        }
+        else {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ProfileCapture::ProfileCapture(Platform &platform) : _platform(platform) {}
+
+    bool ProfileCapture::start(std::uint32_t frameCount, const char *filePath) {
+        if (PLATFORM_PROFILER == 0 || _requestedFrames || _remainingFrames || frameCount == 0) {
+            return false;
+        }
+
+        _filePath = filePath;
+        _requestedFrames = frameCount;
+        return true;
+    }
+
+    void ProfileCapture::nextFrame() {
+        if (_remainingFrames && --_remainingFrames == 0) {
+            _activeEpoch.store(0, std::memory_order_relaxed);
+
+            if (_write()) {
+                PLATFORM_LOG_INFO(&_platform, "[Platform] Profile is written to '%s'", _filePath.c_str());
+            }
+            else {
+                PLATFORM_LOG_ERROR(&_platform, "[Platform] Can't write profile to '%s'", _filePath.c_str());
+            }
+        }
+
+        if (_requestedFrames) {
+            _remainingFrames = _requestedFrames;
+            _requestedFrames = 0;
+            _startNs = getTimeNs();
+
+            // epoch is never 0, 0 means "no capture"
+            _epoch = _epoch + 1 ? _epoch + 1 : 1;
+
+            {
+                std::lock_guard<std::mutex> guard(_buffersGuard);
+
+                for (const auto &buffer : _buffers) {
+                    buffer->dropped.store(0, std::memory_order_relaxed);
+                }
+            }
+
+            _activeEpoch.store(_epoch, std::memory_order_relaxed);
+        }
+    }
+
+    bool ProfileCapture::_write() const {
+        std::ofstream stream (_filePath, std::ios::binary | std::ios::out | std::ios::trunc);
+        std::string out = "{\"traceEvents\":[\n";
+        std::uint32_t dropped = 0;
+        char line[128];
+
+        std::lock_guard<std::mutex> guard(_buffersGuard);
+
+        for (const auto &buffer : _buffers) {
+            const std::uint64_t state = buffer->state.load(std::memory_order_acquire);
+
+            if (std::uint32_t(state >> 32) != _epoch) {
+                continue;
+            }
+
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+            std::snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}},\n", buffer->threadIndex, buffer->threadIndex);
+            out += line;
+
+            for (std::uint32_t i = 0; i < std::uint32_t(state); i++) {
+                const ProfileRecord &record = buffer->records[i];
+
+                // zones that started before capture are cut at its start
+                const std::uint64_t startNs = record.startNs > _startNs ? record.startNs : _startNs;
+                const std::uint64_t endNs = record.endNs > startNs ? record.endNs : startNs;
+
+                out += "{\"name\":\"";
+                writeEscaped(out, record.name);
+                std::snprintf(line, sizeof(line), "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n", buffer->threadIndex, double(startNs - _startNs) / 1000.0, double(endNs - startNs) / 1000.0);
+                out += line;
+            }
+
+            // one write per thread keeps memory of the string small
+            stream.write(out.data(), std::streamsize(out.size()));
+            out.clear();
+        }
+
+        if (dropped) {
+            PLATFORM_LOG_WARNING(&_platform, "[Platform] %u profiling zones are dropped, thread buffers are full", dropped);
+        }
+
+        out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Platform\"}}\n]}\n";
+        stream.write(out.data(), std::streamsize(out.size()));
+        return stream.good();
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "interfaces.h"
+
+namespace platform {
+    // Capture of profiling zones for Platform::captureProfile
+    // Zones are stored by ProfileZone in per-thread buffers. Capture only switches the global epoch and reads the buffers after
+    // the last frame, so threads never wait for each other
+    //
+    class ProfileCapture {
+    public:
+        ProfileCapture(Platform &platform);
+
+        // @return - false if capture is in progress or zones are compiled out
+        //
+        bool start(std::uint32_t frameCount, const char *filePath);
+
+        // Called by run() before every frame. Starts requested capture and writes trace file after the last captured frame
+        //
+        void nextFrame();
+
+    private:
+        bool _write() const;
+
+        Platform &_platform;
+        std::string _filePath;
+        std::uint32_t _requestedFrames = 0;
+        std::uint32_t _remainingFrames = 0;
+        std::uint32_t _epoch = 0;
+        std::uint64_t _startNs = 0;
+    };
+}
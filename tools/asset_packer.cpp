@@ -0,0 +1,208 @@
+
+// Builds asset archive from directory tree
+// Usage: asset_packer [-c] <source dir> <archive path>
+//     -c  compress files by LZ4 blocks. File is stored uncompressed if compression doesn't reduce its size
+//
+// Paths in archive are relative to <source dir>. Example: <source dir>/data/map1/test.png is stored as "data/map1/test.png"
+
+#include "../asset_archive.h"
+#include "../lz4_block.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace {
+    struct SourceFile {
+        std::string path;        // relative path
+        std::uint64_t size;
+    };
+
+    bool collectFiles(const std::string &root, const std::string &relative, std::vector<SourceFile> &out) {
+        const std::string dirPath = relative.empty() ? root : root + "/" + relative;
+
+        if (DIR *dir = ::opendir(dirPath.c_str())) {
+            while (const dirent *entry = ::readdir(dir)) {
+                if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+                    continue;
+                }
+
+                const std::string path = relative.empty() ? std::string(entry->d_name) : relative + "/" + entry->d_name;
+                struct stat st;
+
+                if (::stat((root + "/" + path).c_str(), &st) == 0) {
+                    if (S_ISDIR(st.st_mode)) {
+                        collectFiles(root, path, out);
+                    }
+                    else if (S_ISREG(st.st_mode)) {
+                        out.emplace_back(SourceFile{path, std::uint64_t(st.st_size)});
+                    }
+                }
+            }
+
+            ::closedir(dir);
+            return true;
+        }
+
+        return false;
+    }
+
+    std::uint64_t align(std::uint64_t value, std::uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Forms blob of compressed entry. Returns false if compressed blob isn't smaller than source
+    bool compressBlocks(const std::vector<char> &source, std::vector<char> &blob) {
+        const std::size_t blockCount = (source.size() + platform::ASSET_ARCHIVE_BLOCK_SIZE - 1) / platform::ASSET_ARCHIVE_BLOCK_SIZE;
+        std::vector<std::uint32_t> blockTable (blockCount);
+        std::vector<std::uint8_t> block (platform::lz4CompressBound(platform::ASSET_ARCHIVE_BLOCK_SIZE));
+
+        blob.assign(blockCount * sizeof(std::uint32_t), 0);
+
+        for (std::size_t i = 0; i < blockCount; i++) {
+            const std::uint8_t *src = reinterpret_cast<const std::uint8_t *>(source.data()) + i * platform::ASSET_ARCHIVE_BLOCK_SIZE;
+            const std::size_t srcSize = std::min(std::size_t(platform::ASSET_ARCHIVE_BLOCK_SIZE), source.size() - i * platform::ASSET_ARCHIVE_BLOCK_SIZE);
+            const std::size_t compressedSize = platform::lz4Compress(src, srcSize, block.data(), block.size());
+
+            if (compressedSize && compressedSize < srcSize) {
+                blockTable[i] = std::uint32_t(compressedSize);
+                blob.insert(blob.end(), block.begin(), block.begin() + compressedSize);
+            }
+            else {
+                blockTable[i] = std::uint32_t(srcSize) | platform::ASSET_ARCHIVE_BLOCK_RAW;
+                blob.insert(blob.end(), src, src + srcSize);
+            }
+        }
+
+        std::memcpy(blob.data(), blockTable.data(), blockCount * sizeof(std::uint32_t));
+        return blob.size() < source.size();
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    using namespace platform;
+
+    const bool compress = argc == 4 && std::strcmp(argv[1], "-c") == 0;
+
+    if (argc != 3 && compress == false) {
+        std::fprintf(stderr, "Usage: asset_packer [-c] <source dir> <archive path>\n");
+        return 1;
+    }
+
+    const char *sourceDir = argv[argc - 2];
+    const char *archivePath = argv[argc - 1];
+    std::vector<SourceFile> files;
+
+    if (collectFiles(sourceDir, std::string(), files) == false) {
+        std::fprintf(stderr, "Unable to open directory '%s'\n", sourceDir);
+        return 1;
+    }
+
+    std::sort(files.begin(), files.end(), [](const SourceFile &a, const SourceFile &b) {
+        return a.path < b.path;
+    });
+
+    std::uint32_t slotCount = 1;
+
+    while (slotCount < 2 * files.size()) {
+        slotCount <<= 1;
+    }
+
+    AssetArchiveHeader header = {};
+    std::vector<AssetArchiveEntry> slots(slotCount, AssetArchiveEntry{});
+    std::vector<std::uint32_t> sorted;
+    std::string strings;
+
+    header.magic = ASSET_ARCHIVE_MAGIC;
+    header.version = ASSET_ARCHIVE_VERSION;
+    header.entryCount = std::uint32_t(files.size());
+    header.slotCount = slotCount;
+    header.slotsOffset = sizeof(AssetArchiveHeader);
+    header.sortedOffset = header.slotsOffset + slotCount * sizeof(AssetArchiveEntry);
+    header.stringsOffset = header.sortedOffset + files.size() * sizeof(std::uint32_t);
+
+    for (const SourceFile &file : files) {
+        header.stringsSize += file.path.size();
+    }
+
+    std::uint64_t dataOffset = align(header.stringsOffset + header.stringsSize, ASSET_ARCHIVE_ALIGNMENT);
+    std::ofstream output(archivePath, std::ios::binary | std::ios::trunc);
+
+    if (output.is_open() == false) {
+        std::fprintf(stderr, "Unable to create archive '%s'\n", archivePath);
+        return 1;
+    }
+
+    auto pad = [&output](std::uint64_t offset) {
+        static const char zeroes[ASSET_ARCHIVE_ALIGNMENT] = {};
+        output.write(zeroes, std::streamsize(align(offset, ASSET_ARCHIVE_ALIGNMENT) - offset));
+    };
+
+    // blobs are written first, header and tables are written when entries are known
+    output.seekp(std::streamoff(dataOffset));
+
+    std::vector<char> buffer;
+    std::vector<char> blob;
+    std::uint64_t totalSize = 0;
+
+    for (const SourceFile &file : files) {
+        std::ifstream input(std::string(sourceDir) + "/" + file.path, std::ios::binary);
+
+        buffer.resize(std::size_t(file.size));
+
+        if (input.read(buffer.data(), std::streamsize(buffer.size())).gcount() != std::streamsize(buffer.size())) {
+            std::fprintf(stderr, "Unable to read '%s'\n", file.path.c_str());
+            return 1;
+        }
+
+        const bool compressed = compress && compressBlocks(buffer, blob);
+        const std::vector<char> &stored = compressed ? blob : buffer;
+
+        const std::uint64_t hash = assetArchivePathHash(file.path.data(), file.path.size());
+        std::uint32_t index = std::uint32_t(hash) & (slotCount - 1);
+
+        while (slots[index].pathHash != 0) {
+            index = (index + 1) & (slotCount - 1);
+        }
+
+        slots[index].pathHash = hash;
+        slots[index].pathOffset = std::uint32_t(strings.size());
+        slots[index].pathLength = std::uint32_t(file.path.size());
+        slots[index].dataOffset = dataOffset;
+        slots[index].size = file.size;
+        slots[index].storedSize = stored.size();
+        slots[index].flags = compressed ? ASSET_ARCHIVE_ENTRY_COMPRESSED : 0;
+
+        sorted.emplace_back(index);
+        strings += file.path;
+
+        output.write(stored.data(), std::streamsize(stored.size()));
+        pad(dataOffset + stored.size());
+
+        dataOffset = align(dataOffset + stored.size(), ASSET_ARCHIVE_ALIGNMENT);
+        totalSize += file.size;
+    }
+
+    header.blockSize = ASSET_ARCHIVE_BLOCK_SIZE;
+
+    output.seekp(0);
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char *>(slots.data()), std::streamsize(slots.size() * sizeof(AssetArchiveEntry)));
+    output.write(reinterpret_cast<const char *>(sorted.data()), std::streamsize(sorted.size() * sizeof(std::uint32_t)));
+    output.write(strings.data(), std::streamsize(strings.size()));
+    pad(header.stringsOffset + header.stringsSize);
+
+    if (output.good() == false) {
+        std::fprintf(stderr, "Unable to write archive '%s'\n", archivePath);
+        return 1;
+    }
+
+    std::printf("Packed %zu files (%llu bytes) into '%s' (%llu bytes)\n", files.size(), (unsigned long long)totalSize, archivePath, (unsigned long long)dataOffset);
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Compares throughput of Platform::loadFileAsync with serial Platform::loadFile over files listed by formFileList
+// Usage: async_load_bench [files] [kb]
+//     files  files created for the test, 256 by default
+//     kb     size of every file in KB, 256 by default
+// Build: g++ -O2 -std=c++14 tools/async_load_bench.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// Files are created in ./async_load_bench.tmp, because file index of POSIX platform covers the current directory, and are
+// removed at exit. Both passes follow a warm-up pass, so files come from page cache. Async pass runs frames without pacing,
+// its longest frame shows how long the run() thread was blocked
+
+#include "../interfaces.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char *DATA_DIR = "async_load_bench.tmp";
+
+    bool createFiles(std::uint32_t fileCount, std::size_t fileSize) {
+        std::vector<char> contents (fileSize);
+
+        if (::mkdir(DATA_DIR, 0755) != 0) {
+            return false;
+        }
+
+        for (std::uint32_t i = 0; i < fileCount; i++) {
+            const std::string path = std::string(DATA_DIR) + "/file" + std::to_string(i) + ".bin";
+            std::fill(contents.begin(), contents.end(), char(i));
+
+            if (FILE *file = std::fopen(path.c_str(), "wb")) {
+                std::fwrite(contents.data(), 1, contents.size(), file);
+                std::fclose(file);
+            }
+            else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void removeFiles(const std::vector<std::string> &paths) {
+        for (const std::string &path : paths) {
+            ::unlink(path.c_str());
+        }
+
+        ::rmdir(DATA_DIR);
+    }
+
+    double getMBps(std::uint64_t bytes, double sec) {
+        return double(bytes) / (1024.0 * 1024.0) / sec;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const std::uint32_t fileCount = argc > 1 ? std::uint32_t(std::atoi(argv[1])) : 256;
+    const std::size_t fileSize = std::size_t(argc > 2 ? std::atoi(argv[2]) : 256) * 1024;
+
+    if (fileCount == 0 || fileSize == 0) {
+        std::printf("Usage: async_load_bench [files] [kb]\n");
+        return 1;
+    }
+    if (createFiles(fileCount, fileSize) == false) {
+        std::printf("Unable to create files in %s, remove it if it is left from previous run\n", DATA_DIR);
+        return 1;
+    }
+
+    std::shared_ptr<platform::Platform> platform = platform::getPlatformInstance();
+    platform::FramePacing pacing;
+    pacing.targetFrameRate = 0.0f;
+    platform->setFramePacing(pacing);
+
+    const std::vector<std::string> paths = platform->formFileList(DATA_DIR);
+    bool passed = paths.size() == fileCount;
+
+    // warm-up pass puts files to page cache
+    for (const std::string &path : paths) {
+        std::unique_ptr<std::uint8_t[]> data;
+        std::size_t size = 0;
+        platform->loadFile(path.c_str(), data, size);
+    }
+
+    std::uint64_t serialBytes = 0;
+    const auto serialStart = std::chrono::steady_clock::now();
+
+    for (const std::string &path : paths) {
+        std::unique_ptr<std::uint8_t[]> data;
+        std::size_t size = 0;
+
+        passed = platform->loadFile(path.c_str(), data, size) && size == fileSize && passed;
+        serialBytes += size;
+    }
+
+    const double serialSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - serialStart).count();
+
+    std::uint64_t asyncBytes = 0;
+    std::size_t completed = 0;
+    std::uint32_t frameCount = 0;
+    double longestFrameSec = 0.0;
+    bool asyncLoaded = true;
+    auto frameStart = std::chrono::steady_clock::now();
+    const auto asyncStart = frameStart;
+
+    platform->run([&](float) {
+        const auto now = std::chrono::steady_clock::now();
+        longestFrameSec = std::max(longestFrameSec, std::chrono::duration<double>(now - frameStart).count());
+        frameStart = now;
+
+        if (frameCount++ == 0) {
+            for (const std::string &path : paths) {
+                platform->loadFileAsync(path.c_str(), platform::LoadPriority::NORMAL, [&](bool loaded, std::unique_ptr<uint8_t[]> &, std::size_t size) {
+                    asyncLoaded = asyncLoaded && loaded && size == fileSize;
+                    asyncBytes += size;
+                    completed++;
+                });
+            }
+        }
+        if (completed == paths.size()) {
+            platform->exit();
+        }
+    });
+
+    const double asyncSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - asyncStart).count();
+    passed = passed && asyncLoaded && asyncBytes == serialBytes;
+
+    std::printf("files:   %zu of %zu KB\n", paths.size(), fileSize / 1024);
+    std::printf("serial:  %8.1f MB/s, %8.0f files/s, run() thread blocked for %.1f ms\n",
+        getMBps(serialBytes, serialSec), double(paths.size()) / serialSec, serialSec * 1e3);
+    std::printf("async:   %8.1f MB/s, %8.0f files/s, %u frames, longest frame %.2f ms\n",
+        getMBps(asyncBytes, asyncSec), double(paths.size()) / asyncSec, frameCount, longestFrameSec * 1e3);
+
+    removeFiles(paths);
+
+    std::printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
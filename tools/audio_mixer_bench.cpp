@@ -0,0 +1,97 @@
+// Measures cost of software mixer by voice count without sound card
+// Usage: audio_mixer_bench [seconds]
+//     seconds  duration of audio rendered for every voice count, 10 by default
+// Build: g++ -O2 -std=c++14 tools/audio_mixer_bench.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// "copy" voices play sounds of device rate without pitch, "resample" voices have random pitch and go through sinc filters
+
+#include "../audio_mixer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr std::uint32_t SAMPLE_RATE = 48000;
+    constexpr std::uint32_t BLOCK_FRAMES = 256;
+    const std::uint32_t VOICE_COUNTS[] = {1, 8, 32, 64, 128, 256, 512};
+
+    std::vector<std::int16_t> makeTone(std::uint32_t frameCount, std::uint32_t sampleRate, float frequency) {
+        std::vector<std::int16_t> result (frameCount);
+
+        for (std::uint32_t i = 0; i < frameCount; i++) {
+            result[i] = std::int16_t(8000.0f * std::sin(6.2831853f * frequency * float(i) / float(sampleRate)));
+        }
+
+        return result;
+    }
+
+    // @return - seconds of wall time
+    double run(std::uint32_t voiceCount, bool resampled, double seconds) {
+        platform::AudioConfig config;
+        config.sampleRate = SAMPLE_RATE;
+        config.voiceCount = voiceCount;
+        config.blockFrames = BLOCK_FRAMES;
+        config.offline = true;
+
+        platform::AudioMixer mixer (config);
+        std::mt19937 random (voiceCount);
+        std::uniform_real_distribution<float> pitch (0.5f, 2.0f);
+        std::uniform_real_distribution<float> pan (-1.0f, 1.0f);
+
+        const std::uint32_t soundRate = resampled ? 44100 : SAMPLE_RATE;
+        const std::vector<std::int16_t> tone = makeTone(soundRate, soundRate, 440.0f);
+        const std::shared_ptr<platform::Sound> sound = platform::AudioMixer::createSound(tone.data(), std::uint32_t(tone.size()), 1, soundRate);
+
+        for (std::uint32_t i = 0; i < voiceCount; i++) {
+            platform::VoiceParams params;
+            params.gain = 1.0f / float(voiceCount);
+            params.pan = pan(random);
+            params.pitch = resampled ? pitch(random) : 1.0f;
+            params.loop = true;
+            mixer.play(sound, params);
+        }
+
+        std::vector<float> output (BLOCK_FRAMES * 2);
+        const std::uint64_t blockCount = std::uint64_t(seconds * SAMPLE_RATE / BLOCK_FRAMES);
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint64_t i = 0; i < blockCount; i++) {
+            mixer.render(output.data(), BLOCK_FRAMES);
+        }
+
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 10.0;
+
+    if (seconds <= 0.0) {
+        std::printf("Usage: audio_mixer_bench [seconds]\n");
+        return 1;
+    }
+
+    std::printf("%-10s %8s %14s %12s %10s\n", "mode", "voices", "ns/voice-frame", "realtime x", "load %");
+
+    for (const bool resampled : {false, true}) {
+        for (const std::uint32_t voiceCount : VOICE_COUNTS) {
+            const double elapsed = run(voiceCount, resampled, seconds);
+            const double voiceFrames = double(voiceCount) * seconds * SAMPLE_RATE;
+
+            std::printf(
+                "%-10s %8u %14.2f %12.1f %10.2f\n",
+                resampled ? "resample" : "copy",
+                voiceCount,
+                elapsed * 1e9 / voiceFrames,
+                seconds / elapsed,
+                elapsed / seconds * 100.0
+            );
+        }
+    }
+
+    return 0;
+}
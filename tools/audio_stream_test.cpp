@@ -0,0 +1,235 @@
+// Streams long IMA ADPCM file through offline audio device and checks that memory of the process doesn't grow with its length
+// Usage: audio_stream_test [minutes] [file path]
+//     minutes    length of generated stereo 48 kHz file, 10 by default
+//     file path  where the file is written, "audio_stream_test.wav" by default. The file is removed at exit
+// Build: g++ -O2 -std=c++14 tools/audio_stream_test.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// Exit code is 0 if the whole file is played without underruns, output has expected level and peak RSS grows less than RSS_LIMIT_KB
+
+#include "../interfaces.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr std::uint32_t SAMPLE_RATE = 48000;
+    constexpr std::uint32_t CHANNEL_COUNT = 2;
+    constexpr std::uint32_t BLOCK_ALIGN = 2048;
+    constexpr std::uint32_t BLOCK_FRAMES = (BLOCK_ALIGN - 4 * CHANNEL_COUNT) / (4 * CHANNEL_COUNT) * 8 + 1;
+    constexpr std::uint32_t RENDER_FRAMES = 4800;
+    constexpr long RSS_LIMIT_KB = 4096;
+    constexpr float AMPLITUDE = 0.5f;
+    const float FREQUENCIES[CHANNEL_COUNT] = {440.0f, 660.0f};
+
+    const std::int16_t IMA_STEPS[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+        130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060,
+        1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+        7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+    };
+
+    const std::int8_t IMA_INDEX_STEPS[16] = {
+        -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8,
+    };
+
+    struct ChannelState {
+        std::int32_t predictor = 0;
+        std::int32_t index = 0;
+    };
+
+    void writeU16(std::ofstream &stream, std::uint32_t value) {
+        const char bytes[2] = {char(value), char(value >> 8)};
+        stream.write(bytes, 2);
+    }
+
+    void writeU32(std::ofstream &stream, std::uint32_t value) {
+        const char bytes[4] = {char(value), char(value >> 8), char(value >> 16), char(value >> 24)};
+        stream.write(bytes, 4);
+    }
+
+    std::uint8_t encodeNibble(ChannelState &state, std::int32_t sample) {
+        const std::int32_t step = IMA_STEPS[state.index];
+        std::int32_t diff = sample - state.predictor;
+        std::uint8_t nibble = 0;
+
+        if (diff < 0) {
+            nibble = 8;
+            diff = -diff;
+        }
+        if (diff >= step) {
+            nibble |= 4;
+            diff -= step;
+        }
+        if (diff >= step >> 1) {
+            nibble |= 2;
+            diff -= step >> 1;
+        }
+        if (diff >= step >> 2) {
+            nibble |= 1;
+        }
+
+        // encoder tracks the same predictor as decoder
+        std::int32_t delta = step >> 3;
+
+        if (nibble & 1) delta += step >> 2;
+        if (nibble & 2) delta += step >> 1;
+        if (nibble & 4) delta += step;
+
+        state.predictor = std::min(std::max(nibble & 8 ? state.predictor - delta : state.predictor + delta, -32768), 32767);
+        state.index = std::min(std::max(state.index + IMA_INDEX_STEPS[nibble], 0), 88);
+        return nibble;
+    }
+
+    std::int32_t getSample(std::uint64_t frame, std::uint32_t channel) {
+        return std::int32_t(32767.0f * AMPLITUDE * std::sin(6.2831853f * FREQUENCIES[channel] * float(frame % SAMPLE_RATE) / float(SAMPLE_RATE)));
+    }
+
+    // Writes block by block, so the test itself doesn't hold the file in memory
+    bool writeAdpcmWave(const char *path, std::uint32_t frameCount) {
+        std::ofstream stream (path, std::ios::binary | std::ios::out | std::ios::trunc);
+        const std::uint32_t blockCount = (frameCount + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+        const std::uint32_t dataSize = blockCount * BLOCK_ALIGN;
+
+        stream.write("RIFF", 4);
+        writeU32(stream, 4 + (8 + 20) + (8 + 4) + (8 + dataSize));
+        stream.write("WAVEfmt ", 8);
+        writeU32(stream, 20);
+        writeU16(stream, 0x0011);
+        writeU16(stream, CHANNEL_COUNT);
+        writeU32(stream, SAMPLE_RATE);
+        writeU32(stream, std::uint32_t(std::uint64_t(SAMPLE_RATE) * BLOCK_ALIGN / BLOCK_FRAMES));
+        writeU16(stream, BLOCK_ALIGN);
+        writeU16(stream, 4);
+        writeU16(stream, 2);
+        writeU16(stream, BLOCK_FRAMES);
+        stream.write("fact", 4);
+        writeU32(stream, 4);
+        writeU32(stream, frameCount);
+        stream.write("data", 4);
+        writeU32(stream, dataSize);
+
+        ChannelState states[CHANNEL_COUNT];
+        std::vector<std::uint8_t> block (BLOCK_ALIGN);
+
+        for (std::uint32_t b = 0; b < blockCount; b++) {
+            const std::uint64_t first = std::uint64_t(b) * BLOCK_FRAMES;
+
+            std::memset(block.data(), 0, BLOCK_ALIGN);
+
+            for (std::uint32_t c = 0; c < CHANNEL_COUNT; c++) {
+                ChannelState &state = states[c];
+                state.predictor = getSample(first, c);
+
+                block[c * 4 + 0] = std::uint8_t(state.predictor);
+                block[c * 4 + 1] = std::uint8_t(state.predictor >> 8);
+                block[c * 4 + 2] = std::uint8_t(state.index);
+
+                for (std::uint32_t i = 1; i < BLOCK_FRAMES; i++) {
+                    const std::uint32_t sample = i - 1;
+                    const std::uint8_t nibble = encodeNibble(state, getSample(first + i, c));
+                    std::uint8_t &byte = block[4 * CHANNEL_COUNT + ((sample / 8) * CHANNEL_COUNT + c) * 4 + (sample % 8) / 2];
+
+                    byte |= (sample & 1) ? std::uint8_t(nibble << 4) : nibble;
+                }
+            }
+
+            stream.write(reinterpret_cast<const char *>(block.data()), BLOCK_ALIGN);
+        }
+
+        return stream.good();
+    }
+
+    long getRssKb() {
+        std::ifstream status ("/proc/self/status");
+        std::string line;
+
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmRSS:") == 0) {
+                return std::atol(line.c_str() + 6);
+            }
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const double minutes = argc > 1 ? std::atof(argv[1]) : 10.0;
+    const char *path = argc > 2 ? argv[2] : "audio_stream_test.wav";
+    const std::uint32_t frameCount = std::uint32_t(minutes * 60.0 * SAMPLE_RATE);
+
+    if (frameCount == 0 || writeAdpcmWave(path, frameCount) == false) {
+        std::printf("Can't write %s\n", path);
+        return 1;
+    }
+
+    platform::AudioConfig config;
+    config.sampleRate = SAMPLE_RATE;
+    config.offline = true;
+
+    std::shared_ptr<platform::Platform> platform = platform::getPlatformInstance();
+    std::shared_ptr<platform::AudioDevice> audio = platform::getAudioDeviceInstance(platform, config);
+    std::vector<float> output (RENDER_FRAMES * 2);
+
+    // output buffer and first render are not part of streaming
+    audio->render(output.data(), RENDER_FRAMES);
+
+    const long baseRssKb = getRssKb();
+    long peakRssKb = baseRssKb;
+
+    std::shared_ptr<platform::AudioStream> stream = audio->createStream(path);
+    const platform::VoiceToken voice = stream ? audio->playStream(stream) : 0;
+
+    if (voice == 0) {
+        std::printf("Can't play %s\n", path);
+        std::remove(path);
+        return 1;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    std::uint64_t renderedFrames = 0;
+    double sumSquares = 0.0;
+
+    while (audio->isPlaying(voice)) {
+        audio->render(output.data(), RENDER_FRAMES);
+        renderedFrames += RENDER_FRAMES;
+
+        for (float value : output) {
+            sumSquares += double(value) * double(value);
+        }
+
+        // reading /proc costs more than rendering, every second of audio is enough
+        if (renderedFrames % SAMPLE_RATE == 0) {
+            peakRssKb = std::max(peakRssKb, getRssKb());
+        }
+    }
+
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    const platform::AudioStreamStats stats = stream->getStats();
+    const double rms = std::sqrt(sumSquares / double(frameCount * 2));
+    const double expectedRms = AMPLITUDE / std::sqrt(2.0);
+    const long rssGrowthKb = peakRssKb - baseRssKb;
+
+    std::printf("file:        %s, %u frames, %.1f MB\n", path, frameCount, double(frameCount / BLOCK_FRAMES + 1) * BLOCK_ALIGN / (1024.0 * 1024.0));
+    std::printf("rendered:    %llu frames in %.2f s (%.0fx real time)\n", (unsigned long long)renderedFrames, elapsedSec, double(renderedFrames) / SAMPLE_RATE / elapsedSec);
+    std::printf("level:       rms %.4f, expected %.4f\n", rms, expectedRms);
+    std::printf("stream:      %u bytes of buffers, %u underruns\n", stats.memoryBytes, stats.underrunCount);
+    std::printf("peak rss:    %ld KB before streaming, +%ld KB during streaming (limit %ld KB)\n", baseRssKb, rssGrowthKb, RSS_LIMIT_KB);
+
+    const bool passed =
+        renderedFrames >= frameCount &&
+        renderedFrames < frameCount + 2 * RENDER_FRAMES &&
+        std::fabs(rms - expectedRms) < expectedRms * 0.05 &&
+        stats.underrunCount == 0 &&
+        rssGrowthKb < RSS_LIMIT_KB;
+
+    std::printf("%s\n", passed ? "PASSED" : "FAILED");
+    std::remove(path);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+// Measures recording throughput of command lists by thread count and cost of their submission, with null rendering device
+// Usage: command_list_bench [draws] [frames]
+//     draws   draws recorded by every thread per frame, 10000 by default
+//     frames  frames recorded for every thread count, 200 by default
+// Build: g++ -O2 -std=c++14 tools/command_list_bench.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// Every draw is recorded as applyShader with 64 bytes of constants, applyTextures with two slots and instanced drawGeometry
+// Submission is checked to upload constants once per list
+
+#include "../interfaces.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr std::uint32_t COMMANDS_PER_DRAW = 3;
+    constexpr std::uint32_t SHADER_COUNT = 8;
+    constexpr std::uint32_t TEXTURE_COUNT = 16;
+
+    const char *SHADER_SOURCE = R"(
+        const {
+            transform : matrix4
+        }
+        vssrc {
+            out_position = _transform(float4(vertex_position, 1.0), const.transform);
+        }
+        fssrc {
+            out_color = float4(1.0, 1.0, 1.0, 1.0);
+        }
+    )";
+
+    struct Scene {
+        std::vector<std::shared_ptr<platform::Shader>> shaders;
+        std::vector<std::shared_ptr<platform::Texture2D>> textures;
+        std::shared_ptr<platform::StructuredData> vertexData;
+        std::shared_ptr<platform::StructuredData> instanceData;
+    };
+
+    void record(const Scene &scene, platform::CommandList &list, std::uint32_t thread, std::uint32_t drawCount) {
+        float constants[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+        list.reset();
+
+        for (std::uint32_t i = 0; i < drawCount; i++) {
+            const std::uint32_t material = i * 7 + thread;
+
+            constants[12] = float(i);
+            list.applyShader(scene.shaders[material % SHADER_COUNT], constants);
+            list.applyTextures({scene.textures[material % TEXTURE_COUNT].get(), scene.textures[(material + 1) % TEXTURE_COUNT].get()});
+            list.drawGeometry(scene.vertexData, scene.instanceData, 36, 1);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const std::uint32_t drawCount = argc > 1 ? std::uint32_t(std::atoi(argv[1])) : 10000;
+    const std::uint32_t frameCount = argc > 2 ? std::uint32_t(std::atoi(argv[2])) : 200;
+
+    if (drawCount == 0 || frameCount == 0) {
+        std::printf("Usage: command_list_bench [draws] [frames]\n");
+        return 1;
+    }
+
+    std::shared_ptr<platform::Platform> platform = platform::getPlatformInstance();
+    std::shared_ptr<platform::RenderingDevice> render = platform::getRenderingDeviceInstance(platform);
+
+    Scene scene;
+
+    for (std::uint32_t i = 0; i < SHADER_COUNT; i++) {
+        scene.shaders.emplace_back(render->createShader(SHADER_SOURCE, {{"position", platform::ShaderInput::Format::FLOAT3}}));
+    }
+    for (std::uint32_t i = 0; i < TEXTURE_COUNT; i++) {
+        scene.textures.emplace_back(render->createTexture(platform::Texture2D::Format::RGBA8UN, 64, 64));
+    }
+
+    scene.vertexData = render->createData(nullptr, 36, 12);
+    scene.instanceData = render->createData(nullptr, 1, 16);
+
+    const std::uint32_t threadMax = std::max(std::thread::hardware_concurrency(), 1u);
+    bool passed = true;
+
+    std::printf("%8s %14s %14s %14s %12s\n", "threads", "record Mcmd/s", "ns/cmd/thread", "submit Mcmd/s", "list KB");
+
+    for (std::uint32_t threadCount = 1; threadCount <= threadMax; threadCount = threadCount < threadMax ? std::min(threadCount * 2, threadMax) : threadCount + 1) {
+        std::vector<std::shared_ptr<platform::CommandList>> lists;
+        std::vector<std::thread> threads;
+
+        for (std::uint32_t i = 0; i < threadCount; i++) {
+            lists.emplace_back(render->createCommandList());
+        }
+
+        // threads record their lists independently, every frame starts from reset list
+        const auto recordStart = std::chrono::steady_clock::now();
+
+        for (std::uint32_t i = 0; i < threadCount; i++) {
+            threads.emplace_back([&scene, &lists, i, drawCount, frameCount]() {
+                for (std::uint32_t frame = 0; frame < frameCount; frame++) {
+                    record(scene, *lists[i], i, drawCount);
+                }
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+
+        const double recordSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - recordStart).count();
+        const platform::RenderStats statsBefore = render->getStats();
+        const auto submitStart = std::chrono::steady_clock::now();
+
+        for (std::uint32_t frame = 0; frame < frameCount; frame++) {
+            render->prepareFrame();
+
+            for (const std::shared_ptr<platform::CommandList> &list : lists) {
+                render->submitCommandList(list);
+            }
+
+            render->presentFrame(0.0f);
+        }
+
+        const double submitSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - submitStart).count();
+        const platform::RenderStats statsAfter = render->getStats();
+        const double commandCount = double(threadCount) * frameCount * drawCount * COMMANDS_PER_DRAW;
+
+        // constants of every list are uploaded with one mapping
+        passed = passed &&
+            statsAfter.submittedCommands - statsBefore.submittedCommands == std::uint64_t(commandCount) &&
+            statsAfter.drawCalls - statsBefore.drawCalls == std::uint64_t(threadCount) * frameCount * drawCount &&
+            statsAfter.constantUploads - statsBefore.constantUploads == std::uint64_t(threadCount) * frameCount;
+
+        std::printf(
+            "%8u %14.1f %14.2f %14.1f %12.1f\n",
+            threadCount,
+            commandCount / recordSec * 1e-6,
+            recordSec * threadCount * 1e9 / commandCount,
+            commandCount / submitSec * 1e-6,
+            double(lists[0]->getMemorySize()) / 1024.0
+        );
+    }
+
+    std::printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+// Checks sorted submission of command lists with null rendering device
+// Usage: draw_sort_test [draws]
+//     draws  draws recorded to every list, 1000 by default
+// Build: g++ -O2 -std=c++14 tools/draw_sort_test.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// Lists interleave shaders and texture sets. Opaque draws are keyed by shader, textures and random depth, transparent draws
+// have equal keys and must keep order of submission. Counters of the device are compared with stable sort of the same draws
+// State calls issued and skipped by the device are printed for submission in recorded and in sorted order
+
+#include "../interfaces.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr std::uint32_t LIST_COUNT = 4;
+    constexpr std::uint32_t SHADER_COUNT = 5;
+    constexpr std::uint32_t TEXTURE_COUNT = 7;
+    constexpr std::uint32_t TRANSPARENT_EVERY = 10;
+    constexpr std::uint8_t LAYER_OPAQUE = 0;
+    constexpr std::uint8_t LAYER_TRANSPARENT = 1;
+
+    struct Draw {
+        std::uint64_t key;
+        std::uint32_t shader;
+        std::uint32_t texture;
+    };
+
+    struct Changes {
+        std::uint64_t shaders;
+        std::uint64_t textures;
+    };
+
+    Changes countChanges(const std::vector<Draw> &draws) {
+        Changes result = {};
+
+        for (std::size_t i = 0; i < draws.size(); i++) {
+            result.shaders += i == 0 || draws[i].shader != draws[i - 1].shader;
+            result.textures += i == 0 || draws[i].texture != draws[i - 1].texture;
+        }
+
+        return result;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const std::uint32_t drawCount = argc > 1 ? std::uint32_t(std::atoi(argv[1])) : 1000;
+
+    if (drawCount == 0) {
+        std::printf("Usage: draw_sort_test [draws]\n");
+        return 1;
+    }
+
+    std::shared_ptr<platform::Platform> platform = platform::getPlatformInstance();
+    std::shared_ptr<platform::RenderingDevice> render = platform::getRenderingDeviceInstance(platform);
+    std::vector<std::shared_ptr<platform::Shader>> shaders;
+    std::vector<std::shared_ptr<platform::Texture2D>> textures;
+
+    for (std::uint32_t i = 0; i < SHADER_COUNT; i++) {
+        shaders.emplace_back(render->createShader("vssrc { out_position = float4(0.0, 0.0, 0.0, 1.0); } fssrc { out_color = float4(1.0, 1.0, 1.0, 1.0); }", {}));
+    }
+    for (std::uint32_t i = 0; i < TEXTURE_COUNT; i++) {
+        textures.emplace_back(render->createTexture(platform::Texture2D::Format::RGBA8UN, 4, 4));
+    }
+
+    std::shared_ptr<platform::StructuredData> instanceData = render->createData(nullptr, 1, 16);
+    std::vector<std::shared_ptr<platform::CommandList>> lists;
+    std::vector<Draw> draws;
+    std::mt19937 random (1);
+
+    for (std::uint32_t l = 0; l < LIST_COUNT; l++) {
+        lists.emplace_back(render->createCommandList());
+
+        for (std::uint32_t i = 0; i < drawCount; i++) {
+            const bool transparent = i % TRANSPARENT_EVERY == 0;
+            const std::uint32_t shader = std::uint32_t(random() % SHADER_COUNT);
+            const std::uint32_t texture = std::uint32_t(random() % TEXTURE_COUNT);
+            const std::uint32_t depth = std::uint32_t(random() & 0xffffff);
+            const std::uint64_t key = transparent
+                ? platform::CommandList::makeSortKey(LAYER_TRANSPARENT, 0, 0, 0)
+                : platform::CommandList::makeSortKey(LAYER_OPAQUE, std::uint16_t(shader), std::uint16_t(texture), depth);
+
+            lists[l]->setSortKey(key);
+            lists[l]->applyShader(shaders[shader]);
+            lists[l]->applyTextures({textures[texture].get()});
+            lists[l]->drawGeometry(nullptr, instanceData, 6, 1);
+            draws.push_back(Draw{key, shader, texture});
+        }
+    }
+
+    // the same draws in order of submission, then sorted
+    const Changes submitted = countChanges(draws);
+    std::stable_sort(draws.begin(), draws.end(), [](const Draw &a, const Draw &b) {
+        return a.key < b.key;
+    });
+    const Changes sorted = countChanges(draws);
+
+    // recorded order, for comparison of state calls
+    const platform::RenderStats beforeRecorded = render->getStats();
+
+    render->prepareFrame();
+
+    for (const std::shared_ptr<platform::CommandList> &list : lists) {
+        render->submitCommandList(list);
+    }
+
+    render->presentFrame(0.0f);
+
+    const platform::RenderStats before = render->getStats();
+
+    render->prepareFrame();
+
+    for (const std::shared_ptr<platform::CommandList> &list : lists) {
+        render->submitCommandList(list, true);
+    }
+
+    const platform::RenderStats deferred = render->getStats();
+    render->presentFrame(0.0f);
+    const platform::RenderStats after = render->getStats();
+
+    const std::uint64_t totalDraws = std::uint64_t(LIST_COUNT) * drawCount;
+    const std::uint64_t shaderApplies = after.shaderApplies - before.shaderApplies;
+    const std::uint64_t textureApplies = after.textureApplies - before.textureApplies;
+    const std::uint64_t shaderSaved = after.shaderChangesSaved - before.shaderChangesSaved;
+    const std::uint64_t textureSaved = after.textureChangesSaved - before.textureChangesSaved;
+
+    std::printf("draws:          %llu in %u lists\n", (unsigned long long)totalDraws, LIST_COUNT);
+    std::printf("shader changes: %llu submitted, %llu sorted, device applied %llu, saved %llu\n",
+        (unsigned long long)submitted.shaders, (unsigned long long)sorted.shaders, (unsigned long long)shaderApplies, (unsigned long long)shaderSaved);
+    std::printf("texture sets:   %llu submitted, %llu sorted, device applied %llu, saved %llu\n",
+        (unsigned long long)submitted.textures, (unsigned long long)sorted.textures, (unsigned long long)textureApplies, (unsigned long long)textureSaved);
+
+    const bool passed =
+        deferred.drawCalls == before.drawCalls &&
+        after.drawCalls - before.drawCalls == totalDraws &&
+        after.sortedDraws - before.sortedDraws == totalDraws &&
+        shaderApplies == sorted.shaders &&
+        textureApplies == sorted.textures &&
+        shaderSaved == submitted.shaders - sorted.shaders &&
+        textureSaved == submitted.textures - sorted.textures;
+
+    const std::uint64_t recordedIssued = before.stateCallsIssued - beforeRecorded.stateCallsIssued;
+    const std::uint64_t recordedSkipped = before.stateCallsSkipped - beforeRecorded.stateCallsSkipped;
+    const std::uint64_t sortedIssued = after.stateCallsIssued - before.stateCallsIssued;
+    const std::uint64_t sortedSkipped = after.stateCallsSkipped - before.stateCallsSkipped;
+
+    std::printf("state calls:    recorded order %llu issued, %llu skipped; sorted %llu issued, %llu skipped\n",
+        (unsigned long long)recordedIssued, (unsigned long long)recordedSkipped, (unsigned long long)sortedIssued, (unsigned long long)sortedSkipped);
+
+    // every apply of shader is 4 binding calls without filtering, every bound texture slot is 2
+    const bool filtered =
+        recordedIssued + recordedSkipped == totalDraws * 4 + totalDraws * 2 &&
+        sortedIssued + sortedSkipped == shaderApplies * 4 + textureApplies * 2 &&
+        sortedIssued < recordedIssued;
+
+    std::printf("%s\n", passed && filtered ? "PASSED" : "FAILED");
+    return passed && filtered ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+// Compares dispatch of events through EventHandlerTable with unordered_map of std::function, as platforms stored handlers before
+// Usage: event_dispatch_bench [events] [handlers] [frames]
+//     events    mouse move events per frame, 10000 by default
+//     handlers  registered handlers, 100 by default
+//     frames    frames measured, 100 by default
+// Build: g++ -O2 -std=c++14 tools/event_dispatch_bench.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// Handler captures 32 bytes, which fit inline buffer of EventHandler but not small buffer of std::function. Allocations are
+// counted while handlers are added. Every handler is also removed by its token and added again to check tokens
+
+#include "../event_registry.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unordered_map>
+
+namespace {
+    std::size_t _allocationCount = 0;
+
+    struct MouseEventHandler {
+        platform::EventHandler<void(const platform::MouseEventArgs &)> press;
+        platform::EventHandler<void(const platform::MouseEventArgs &)> move;
+        platform::EventHandler<void(const platform::MouseEventArgs &)> release;
+    };
+
+    struct MouseEventFunction {
+        std::function<void(const platform::MouseEventArgs &)> press;
+        std::function<void(const platform::MouseEventArgs &)> move;
+        std::function<void(const platform::MouseEventArgs &)> release;
+    };
+
+    struct Accumulator {
+        double x = 0.0;
+        double y = 0.0;
+    };
+
+    // handler state as big as typical game handler: owner, weights and counter
+    template<typename Handler> Handler makeHandler(Accumulator &accumulator, std::uint32_t index) {
+        const float weightX = float(index % 7) + 1.0f;
+        const float weightY = float(index % 5) + 1.0f;
+        std::uint64_t counter = 0;
+
+        return Handler{
+            nullptr,
+            [&accumulator, weightX, weightY, counter, index](const platform::MouseEventArgs &args) mutable {
+                accumulator.x += args.coordinateX * weightX;
+                accumulator.y += args.coordinateY * weightY + double(index);
+                counter++;
+            },
+            nullptr,
+        };
+    }
+
+    platform::MouseEventArgs makeArgs(std::uint32_t event) {
+        return platform::MouseEventArgs{float(event % 1280), float(event % 720), event % 2 == 0, false};
+    }
+}
+
+void *operator new(std::size_t size) {
+    _allocationCount++;
+
+    if (void *result = std::malloc(size ? size : 1)) {
+        return result;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+int main(int argc, char *argv[]) {
+    const std::uint32_t eventCount = argc > 1 ? std::uint32_t(std::atoi(argv[1])) : 10000;
+    const std::uint32_t handlerCount = argc > 2 ? std::uint32_t(std::atoi(argv[2])) : 100;
+    const std::uint32_t frameCount = argc > 3 ? std::uint32_t(std::atoi(argv[3])) : 100;
+
+    if (eventCount == 0 || handlerCount == 0 || handlerCount > 65536 || frameCount == 0) {
+        std::printf("Usage: event_dispatch_bench [events] [handlers] [frames], up to 65536 handlers\n");
+        return 1;
+    }
+
+    Accumulator tableResult;
+    Accumulator mapResult;
+
+    // tables reserve their arrays with first handler, so table allocations are counted after warm-up of one add/remove
+    platform::EventHandlerTable<MouseEventHandler> table (2);
+    std::vector<platform::EventHandlersToken> tokens;
+    tokens.reserve(handlerCount);
+    table.remove(table.add(makeHandler<MouseEventHandler>(tableResult, 0)));
+
+    std::size_t allocationsStart = _allocationCount;
+
+    for (std::uint32_t i = 0; i < handlerCount; i++) {
+        tokens.emplace_back(table.add(makeHandler<MouseEventHandler>(tableResult, i)));
+    }
+
+    const std::size_t tableAllocations = _allocationCount - allocationsStart;
+
+    std::unordered_map<platform::EventHandlersToken, MouseEventFunction> map;
+    platform::EventHandlersToken lastToken = reinterpret_cast<platform::EventHandlersToken>(0x1);
+    allocationsStart = _allocationCount;
+
+    for (std::uint32_t i = 0; i < handlerCount; i++) {
+        map.emplace(++lastToken, makeHandler<MouseEventFunction>(mapResult, i));
+    }
+
+    const std::size_t mapAllocations = _allocationCount - allocationsStart;
+
+    const auto tableStart = std::chrono::steady_clock::now();
+
+    for (std::uint32_t frame = 0; frame < frameCount; frame++) {
+        for (std::uint32_t event = 0; event < eventCount; event++) {
+            const platform::MouseEventArgs args = makeArgs(event);
+
+            table.dispatch([&args](const MouseEventHandler &handler) {
+                if (handler.move) {
+                    handler.move(args);
+                }
+            });
+        }
+    }
+
+    const double tableSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - tableStart).count();
+    const auto mapStart = std::chrono::steady_clock::now();
+
+    for (std::uint32_t frame = 0; frame < frameCount; frame++) {
+        for (std::uint32_t event = 0; event < eventCount; event++) {
+            const platform::MouseEventArgs args = makeArgs(event);
+
+            for (const auto &item : map) {
+                if (item.second.move) {
+                    item.second.move(args);
+                }
+            }
+        }
+    }
+
+    const double mapSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - mapStart).count();
+
+    // every token is accepted once, stale one is rejected
+    bool tokensValid = true;
+
+    for (platform::EventHandlersToken token : tokens) {
+        tokensValid = tokensValid && table.remove(token);
+    }
+    for (platform::EventHandlersToken token : tokens) {
+        tokensValid = tokensValid && table.remove(token) == false;
+    }
+
+    tokensValid = tokensValid && table.empty();
+
+    std::printf("dispatch:     %u events to %u handlers per frame, %u frames\n", eventCount, handlerCount, frameCount);
+    std::printf("table:        %8.3f ms per frame, %zu allocations for %u handlers\n", tableSec * 1e3 / frameCount, tableAllocations, handlerCount);
+    std::printf("map:          %8.3f ms per frame, %zu allocations for %u handlers\n", mapSec * 1e3 / frameCount, mapAllocations, handlerCount);
+
+    const bool passed =
+        tokensValid &&
+        tableAllocations < handlerCount &&
+        tableResult.x == mapResult.x &&
+        tableResult.y == mapResult.y;
+
+    std::printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
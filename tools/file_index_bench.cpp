@@ -0,0 +1,193 @@
+// Compares enumeration of directory tree through FileIndex with recursive scan of file system, as formFileList did before
+// Usage: file_index_bench [files] [dirs] [queries]
+//     files    files created for the test, 100000 by default
+//     dirs     directories they are spread over, 100 by default
+//     queries  enumerations of the whole tree and of every directory measured, 10 by default
+// Build: g++ -O2 -std=c++14 tools/file_index_bench.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// Empty files are created in ./file_index_bench.tmp and removed at exit. Index is built once, then every query walks its
+// sorted records. Scan opens directories and calls stat for every file on every query, results of both come from warm
+// kernel caches
+
+#include "../file_index.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char *DATA_DIR = "file_index_bench.tmp";
+
+    std::string getDirPath(std::uint32_t dir) {
+        return std::string(DATA_DIR) + "/dir" + std::to_string(dir);
+    }
+
+    std::string getFilePath(std::uint32_t dir, std::uint32_t file) {
+        return getDirPath(dir) + "/file" + std::to_string(file) + (file % 2 ? ".png" : ".bin");
+    }
+
+    bool createTree(std::uint32_t fileCount, std::uint32_t dirCount) {
+        if (::mkdir(DATA_DIR, 0755) != 0) {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < dirCount; i++) {
+            if (::mkdir(getDirPath(i).c_str(), 0755) != 0) {
+                return false;
+            }
+        }
+        for (std::uint32_t i = 0; i < fileCount; i++) {
+            const int fd = ::open(getFilePath(i % dirCount, i).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+            if (fd < 0) {
+                return false;
+            }
+
+            ::close(fd);
+        }
+
+        return true;
+    }
+
+    void removeTree(std::uint32_t fileCount, std::uint32_t dirCount) {
+        for (std::uint32_t i = 0; i < fileCount; i++) {
+            ::unlink(getFilePath(i % dirCount, i).c_str());
+        }
+        for (std::uint32_t i = 0; i < dirCount; i++) {
+            ::rmdir(getDirPath(i).c_str());
+        }
+
+        ::rmdir(DATA_DIR);
+    }
+
+    // readdir and stat for every entry, paths are collected to vector of strings
+    void scan(const std::string &dirPath, bool recursive, std::vector<std::string> &result) {
+        if (DIR *dir = ::opendir(dirPath.c_str())) {
+            while (const dirent *entry = ::readdir(dir)) {
+                if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+                    continue;
+                }
+
+                std::string path = dirPath + "/" + entry->d_name;
+                struct stat st;
+
+                if (::stat(path.c_str(), &st) == 0) {
+                    if (S_ISDIR(st.st_mode) && recursive) {
+                        scan(path, recursive, result);
+                    }
+                    else if (S_ISREG(st.st_mode)) {
+                        result.emplace_back(std::move(path));
+                    }
+                }
+            }
+
+            ::closedir(dir);
+        }
+    }
+
+    template<typename Query> double measure(std::uint32_t queryCount, Query &&query) {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint32_t i = 0; i < queryCount; i++) {
+            query();
+        }
+
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / queryCount;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const std::uint32_t fileCount = argc > 1 ? std::uint32_t(std::atoi(argv[1])) : 100000;
+    const std::uint32_t dirCount = argc > 2 ? std::uint32_t(std::atoi(argv[2])) : 100;
+    const std::uint32_t queryCount = argc > 3 ? std::uint32_t(std::atoi(argv[3])) : 10;
+
+    if (fileCount == 0 || dirCount == 0 || queryCount == 0) {
+        std::printf("Usage: file_index_bench [files] [dirs] [queries]\n");
+        return 1;
+    }
+    if (createTree(fileCount, dirCount) == false) {
+        std::printf("Unable to create files in %s, remove it if it is left from previous run\n", DATA_DIR);
+        removeTree(fileCount, dirCount);
+        return 1;
+    }
+
+    platform::FileIndex index;
+    const auto buildStart = std::chrono::steady_clock::now();
+    index.addDirectory(DATA_DIR);
+    const double buildSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+
+    std::size_t indexTotal = 0;
+    std::size_t indexFiltered = 0;
+    std::size_t indexPerDir = 0;
+    std::uint64_t indexBytes = 0;
+    std::vector<std::string> dirs;
+
+    for (std::uint32_t i = 0; i < dirCount; i++) {
+        dirs.emplace_back("dir" + std::to_string(i));
+    }
+
+    const double indexAllSec = measure(queryCount, [&]() {
+        indexTotal = 0;
+        index.forEach("", nullptr, true, [&](const platform::FileInfo &info) {
+            indexBytes += info.size;
+            indexTotal++;
+        });
+    });
+    const double indexGlobSec = measure(queryCount, [&]() {
+        indexFiltered = 0;
+        index.forEach("", "*.png", true, [&](const platform::FileInfo &) {
+            indexFiltered++;
+        });
+    });
+    const double indexDirsSec = measure(queryCount, [&]() {
+        indexPerDir = 0;
+        for (const std::string &dir : dirs) {
+            index.forEach(dir.c_str(), nullptr, false, [&](const platform::FileInfo &) {
+                indexPerDir++;
+            });
+        }
+    });
+
+    std::size_t scanTotal = 0;
+    std::size_t scanPerDir = 0;
+
+    const double scanAllSec = measure(queryCount, [&]() {
+        std::vector<std::string> result;
+        scan(DATA_DIR, true, result);
+        scanTotal = result.size();
+    });
+    const double scanDirsSec = measure(queryCount, [&]() {
+        scanPerDir = 0;
+        for (std::uint32_t i = 0; i < dirCount; i++) {
+            std::vector<std::string> result;
+            scan(getDirPath(i), false, result);
+            scanPerDir += result.size();
+        }
+    });
+
+    removeTree(fileCount, dirCount);
+
+    std::printf("tree:              %u files in %u directories, index built in %.1f ms\n", fileCount, dirCount, buildSec * 1e3);
+    std::printf("%-18s %12s %12s %10s\n", "query", "index ms", "scan ms", "speed-up");
+    std::printf("%-18s %12.3f %12.3f %9.0fx\n", "whole tree", indexAllSec * 1e3, scanAllSec * 1e3, scanAllSec / indexAllSec);
+    std::printf("%-18s %12.3f %12s %10s\n", "whole tree *.png", indexGlobSec * 1e3, "-", "-");
+    std::printf("%-18s %12.3f %12.3f %9.0fx\n", "every directory", indexDirsSec * 1e3, scanDirsSec * 1e3, scanDirsSec / indexDirsSec);
+
+    const bool passed =
+        indexTotal == fileCount &&
+        indexFiltered == fileCount / 2 &&
+        indexPerDir == fileCount &&
+        scanTotal == fileCount &&
+        scanPerDir == fileCount &&
+        indexBytes == 0;
+
+    std::printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
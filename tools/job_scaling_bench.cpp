@@ -0,0 +1,167 @@
+// Measures scaling of JobSystem by thread count on SoA transform update, and checks that jobs don't allocate tasks
+// Usage: job_scaling_bench [entities] [frames] [threads]
+//     entities  transforms updated every frame, 2000000 by default
+//     frames    frames measured for every thread count, 20 by default
+//     threads   maximum thread count including the calling thread, count of CPU cores by default
+// Build: g++ -O2 -std=c++14 tools/job_scaling_bench.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// One thread updates all entities by itself, N threads use JobSystem with N - 1 workers and parallelFor. Every frame also
+// runs a group of small jobs. Tasks are allocated until free lists of threads fill up, then reused, so all frames together
+// must allocate fewer tasks than two frames submit. Results of every thread count must match single-threaded ones exactly
+
+#include "../job_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr float DT = 1.0f / 60.0f;
+    constexpr std::size_t GRAIN_SIZE = 4096;
+    constexpr std::uint32_t SMALL_JOB_COUNT = 1000;
+    constexpr std::uint32_t WARM_UP_FRAMES = 2;
+
+    struct Transforms {
+        Transforms(std::size_t count) {
+            for (std::vector<float> *stream : {&posX, &posY, &posZ, &velX, &velY, &velZ, &angle, &spin, &scale}) {
+                stream->resize(count);
+            }
+            for (std::vector<float> *stream : {&m00, &m02, &m20, &m22}) {
+                stream->resize(count);
+            }
+            for (std::size_t i = 0; i < count; i++) {
+                posX[i] = float(i % 1000);
+                posY[i] = float(i % 100);
+                posZ[i] = float(i % 10);
+                velX[i] = float(i % 7) - 3.0f;
+                velY[i] = float(i % 5) - 2.0f;
+                velZ[i] = float(i % 3) - 1.0f;
+                angle[i] = float(i % 360) * 0.0174533f;
+                spin[i] = float(i % 11) * 0.1f;
+                scale[i] = 1.0f + float(i % 4) * 0.25f;
+            }
+        }
+
+        // integrates position and rotation around Y axis, forms rotation-scale part of world matrix
+        void update(std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                posX[i] += velX[i] * DT;
+                posY[i] += velY[i] * DT;
+                posZ[i] += velZ[i] * DT;
+                angle[i] += spin[i] * DT;
+
+                const float c = std::cos(angle[i]) * scale[i];
+                const float s = std::sin(angle[i]) * scale[i];
+
+                m00[i] = c;
+                m02[i] = s;
+                m20[i] = -s;
+                m22[i] = c;
+            }
+        }
+
+        bool operator ==(const Transforms &other) const {
+            auto same = [](const std::vector<float> &a, const std::vector<float> &b) {
+                return std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+            };
+
+            return same(posX, other.posX) && same(posY, other.posY) && same(posZ, other.posZ) && same(angle, other.angle) &&
+                same(m00, other.m00) && same(m02, other.m02) && same(m20, other.m20) && same(m22, other.m22);
+        }
+
+        std::vector<float> posX, posY, posZ;
+        std::vector<float> velX, velY, velZ;
+        std::vector<float> angle, spin, scale;
+        std::vector<float> m00, m02, m20, m22;
+    };
+
+    struct Result {
+        double msPerFrame;
+        std::uint64_t taskAllocations;      // during all frames including warm-up
+        std::uint64_t jobCount;
+        bool smallJobsDone;
+    };
+
+    Result measure(std::size_t threadCount, std::size_t entityCount, std::uint32_t frameCount, Transforms &transforms) {
+        std::unique_ptr<platform::JobSystem> jobs = threadCount > 1 ? std::make_unique<platform::JobSystem>(threadCount - 1) : nullptr;
+        std::atomic<std::uint32_t> smallJobsDone {0};
+        std::atomic<std::uint32_t> chunkCount {0};
+        std::uint64_t taskAllocations = 0;
+        double sec = 0.0;
+
+        for (std::uint32_t frame = 0; frame < WARM_UP_FRAMES + frameCount; frame++) {
+            const auto start = std::chrono::steady_clock::now();
+
+            if (jobs) {
+                jobs->parallelFor(entityCount, GRAIN_SIZE, [&transforms, &chunkCount](std::size_t begin, std::size_t end) {
+                    transforms.update(begin, end);
+                    chunkCount.fetch_add(1, std::memory_order_relaxed);
+                });
+
+                std::shared_ptr<platform::JobGroup> group = jobs->createGroup({});
+
+                for (std::uint32_t i = 0; i < SMALL_JOB_COUNT; i++) {
+                    group->add([&smallJobsDone] {
+                        smallJobsDone.fetch_add(1, std::memory_order_relaxed);
+                    });
+                }
+
+                jobs->wait(group);
+            }
+            else {
+                transforms.update(0, entityCount);
+            }
+
+            if (frame >= WARM_UP_FRAMES) {
+                sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            platform::MemoryTracker::nextFrame();
+            taskAllocations += platform::MemoryTracker::getStats(platform::MemoryCategory::TASKS).frameAllocations;
+        }
+
+        // the first chunk of parallelFor is done by calling thread without job
+        const std::uint32_t totalFrames = WARM_UP_FRAMES + frameCount;
+        const std::uint64_t jobCount = jobs ? std::uint64_t(smallJobsDone) + chunkCount - totalFrames : 0;
+        const bool done = jobs == nullptr || smallJobsDone == totalFrames * SMALL_JOB_COUNT;
+        return Result{sec * 1e3 / frameCount, taskAllocations, jobCount, done};
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const std::size_t entityCount = argc > 1 ? std::size_t(std::atoi(argv[1])) : 2000000;
+    const std::uint32_t frameCount = argc > 2 ? std::uint32_t(std::atoi(argv[2])) : 20;
+    const std::size_t threadMax = argc > 3 ? std::size_t(std::atoi(argv[3])) : std::max(std::size_t(std::thread::hardware_concurrency()), std::size_t(1));
+
+    if (entityCount == 0 || frameCount == 0 || threadMax == 0) {
+        std::printf("Usage: job_scaling_bench [entities] [frames] [threads]\n");
+        return 1;
+    }
+
+    Transforms reference (entityCount);
+    const Result serial = measure(1, entityCount, frameCount, reference);
+    bool passed = true;
+
+    std::printf("entities: %zu, %u frames, %u small jobs per frame, %u CPU cores\n", entityCount, frameCount, SMALL_JOB_COUNT, std::thread::hardware_concurrency());
+    std::printf("%-8s %12s %10s %12s %24s\n", "threads", "ms/frame", "speed-up", "efficiency", "tasks allocated / jobs");
+    std::printf("%-8u %12.2f %9.2fx %11.0f%% %24s\n", 1u, serial.msPerFrame, 1.0, 100.0, "-");
+
+    for (std::size_t threadCount = 2; threadCount <= threadMax; threadCount++) {
+        Transforms transforms (entityCount);
+        const Result result = measure(threadCount, entityCount, frameCount, transforms);
+        const double speedUp = serial.msPerFrame / result.msPerFrame;
+        const std::uint64_t jobsPerFrame = result.jobCount / (WARM_UP_FRAMES + frameCount);
+
+        std::printf("%-8zu %12.2f %9.2fx %11.0f%% %13llu / %-8llu\n", threadCount, result.msPerFrame, speedUp, speedUp * 100.0 / double(threadCount),
+            (unsigned long long)result.taskAllocations, (unsigned long long)result.jobCount);
+
+        passed = passed && transforms == reference && result.taskAllocations < 2 * jobsPerFrame && result.smallJobsDone;
+    }
+
+    std::printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
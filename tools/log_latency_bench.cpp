@@ -0,0 +1,173 @@
+// Compares latency of log call on writing threads: AsyncLog against mutex and vfprintf on calling thread, as logging was before
+// Usage: log_latency_bench [threads] [messages] [kb]
+//     threads   writing threads, 8 by default
+//     messages  messages written by every thread, 20000 by default
+//     kb        size of ring buffer of every thread in AsyncLog, 8192 by default
+// Build: g++ -O2 -std=c++14 tools/log_latency_bench.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// Lines are written to /dev/null. Every message has four arguments. Dropped message costs less than stored one, so the run
+// fails if AsyncLog has dropped anything: latencies are valid only when every message was stored
+
+#include "../async_log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char *FORMAT = "[Bench] thread %d wrote message %d, value %.3f, name '%s'";
+    const char *NAME = "sky_shader";
+
+    FILE *_output = nullptr;
+
+    // the same as Platform::logInfo before AsyncLog
+    void writeLocked(const char *fmt, ...) {
+        static std::mutex _logGuard;
+        std::lock_guard<std::mutex> guard(_logGuard);
+
+        char buffer[32];
+        std::time_t t = std::time(nullptr);
+        std::strftime(buffer, sizeof(buffer), "%T", std::gmtime(&t));
+
+        va_list args;
+        va_start(args, fmt);
+        std::fprintf(_output, "[%s %s] ", buffer, "Info");
+        std::vfprintf(_output, fmt, args);
+        std::fprintf(_output, "\n");
+        va_end(args);
+    }
+
+    void writeAsync(platform::AsyncLog &log, const char *fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        log.write(platform::LogLevel::INFO, fmt, args);
+        va_end(args);
+    }
+
+    struct Latency {
+        double mean;
+        double p50;
+        double p99;
+        double p999;
+        double max;
+    };
+
+    // @write(thread, message) is timed for every message of every thread, threads start together
+    template<typename Write> Latency measure(std::uint32_t threadCount, std::uint32_t messageCount, Write &&write) {
+        std::vector<std::vector<double>> samples (threadCount);
+        std::vector<std::thread> threads;
+        std::atomic<bool> started {false};
+
+        for (std::uint32_t i = 0; i < threadCount; i++) {
+            threads.emplace_back([&, i] {
+                std::vector<double> &ns = samples[i];
+                ns.reserve(messageCount);
+
+                while (started.load() == false) {
+                    std::this_thread::yield();
+                }
+
+                for (std::uint32_t m = 0; m < messageCount; m++) {
+                    const auto start = std::chrono::steady_clock::now();
+                    write(i, m);
+                    ns.emplace_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+                }
+            });
+        }
+
+        started = true;
+
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+
+        std::vector<double> all;
+
+        for (const std::vector<double> &ns : samples) {
+            all.insert(all.end(), ns.begin(), ns.end());
+        }
+
+        std::sort(all.begin(), all.end());
+
+        double sum = 0.0;
+
+        for (double ns : all) {
+            sum += ns;
+        }
+
+        auto percentile = [&all](double p) {
+            return all[std::min(all.size() - 1, std::size_t(p * double(all.size())))];
+        };
+
+        return Latency{sum / double(all.size()), percentile(0.5), percentile(0.99), percentile(0.999), all.back()};
+    }
+
+    void print(const char *name, const Latency &latency, const char *dropped) {
+        std::printf("%-16s %8.0f %8.0f %8.0f %8.0f %10.0f %10s\n", name, latency.mean, latency.p50, latency.p99, latency.p999, latency.max, dropped);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const std::uint32_t threadCount = argc > 1 ? std::uint32_t(std::atoi(argv[1])) : 8;
+    const std::uint32_t messageCount = argc > 2 ? std::uint32_t(std::atoi(argv[2])) : 20000;
+    const std::size_t bufferSize = std::size_t(argc > 3 ? std::atoi(argv[3]) : 8192) * 1024;
+
+    if (threadCount == 0 || messageCount == 0 || bufferSize == 0) {
+        std::printf("Usage: log_latency_bench [threads] [messages] [kb]\n");
+        return 1;
+    }
+    if ((_output = std::fopen("/dev/null", "w")) == nullptr) {
+        std::printf("Unable to open /dev/null\n");
+        return 1;
+    }
+
+    const Latency locked = measure(threadCount, messageCount, [](std::uint32_t thread, std::uint32_t message) {
+        writeLocked(FORMAT, int(thread), int(message), double(message) * 0.5, NAME);
+    });
+
+    std::uint64_t lines = 0;
+    std::uint64_t dropped = 0;
+    Latency async;
+
+    {
+        platform::AsyncLog log ([&lines](platform::LogLevel, const char *line) {
+            std::fprintf(_output, "%s\n", line);
+            lines++;
+        }, bufferSize);
+
+        async = measure(threadCount, messageCount, [&log](std::uint32_t thread, std::uint32_t message) {
+            writeAsync(log, FORMAT, int(thread), int(message), double(message) * 0.5, NAME);
+        });
+
+        log.flush();
+        dropped = log.getDroppedCount();
+    }
+
+    const std::uint64_t total = std::uint64_t(threadCount) * messageCount;
+    char droppedText[32];
+    std::snprintf(droppedText, sizeof(droppedText), "%llu", (unsigned long long)dropped);
+
+    std::printf("threads: %u, messages: %u per thread, ring buffer: %zu KB per thread, %u CPU cores\n",
+        threadCount, messageCount, bufferSize / 1024, std::thread::hardware_concurrency());
+    std::printf("%-16s %8s %8s %8s %8s %10s %10s\n", "ns per call", "mean", "p50", "p99", "p99.9", "max", "dropped");
+    print("mutex + vfprintf", locked, "-");
+    print("AsyncLog", async, droppedText);
+
+    std::fclose(_output);
+
+    // lines include warnings about dropped messages
+    const bool passed = dropped == 0 && lines == total;
+
+    if (dropped) {
+        std::printf("Messages were dropped, latencies aren't comparable. Increase ring buffer size\n");
+    }
+
+    std::printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Measures CPU cost of drawGeometry with shaders of many vertex attributes, and checks caching of vertex arrays
+// Usage: vertex_array_bench [draws] [frames]
+//     draws   draws per frame, 10000 by default
+//     frames  frames measured, 100 by default
+// Build: g++ -O2 -std=c++14 tools/vertex_array_bench.cpp $(ls *.cpp | grep -v -e w32_ -e uw_ -e d3d11_) -lpthread
+//
+// Draws cycle through every combination of shader and mesh. Every combination has to set up its vertex array once, later
+// draws only bind it. Destroyed mesh and reloaded shader must drop their vertex arrays, so they are set up again.
+// Null device of POSIX counts cache use only, time per draw is meaningful with GL backend
+
+#include "../interfaces.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    constexpr std::uint32_t SHADER_COUNT = 4;
+    constexpr std::uint32_t MESH_COUNT = 16;
+    constexpr std::uint32_t MESH_VERTEX_COUNT = 36;
+    constexpr std::uint32_t MESH_VERTEX_STRIDE = 100;
+    constexpr std::uint32_t INSTANCE_STRIDE = 64;
+
+    const char *SHADER_SOURCE = R"(
+        vssrc {
+            float2 uv = vertex_uv0 + vertex_uv1 + vertex_uv2 + vertex_uv3;
+            float4 weights = vertex_color0 * vertex_color1 + vertex_weights * vertex_bones + vertex_tangent * vertex_extra;
+            float3 position = vertex_position + vertex_normal * _dot(weights, float4(uv, 0.0, 0.0)) * 0.001;
+            position = position + instance_row0.xyz + instance_row1.xyz + instance_row2.xyz + instance_row3.xyz;
+            out_position = _transform(float4(position, 1.0), _viewProjMatrix);
+        }
+        fssrc {
+            out_color = float4(1.0, 1.0, 1.0, 1.0);
+        }
+    )";
+
+    std::shared_ptr<platform::Shader> createShader(platform::RenderingDevice &render) {
+        return render.createShader(SHADER_SOURCE, {
+            {"position", platform::ShaderInput::Format::FLOAT3},
+            {"normal", platform::ShaderInput::Format::FLOAT3},
+            {"tangent", platform::ShaderInput::Format::FLOAT4},
+            {"color0", platform::ShaderInput::Format::BYTE4_NRM},
+            {"color1", platform::ShaderInput::Format::BYTE4_NRM},
+            {"uv0", platform::ShaderInput::Format::FLOAT2},
+            {"uv1", platform::ShaderInput::Format::FLOAT2},
+            {"uv2", platform::ShaderInput::Format::HALF2},
+            {"uv3", platform::ShaderInput::Format::HALF2},
+            {"weights", platform::ShaderInput::Format::SHORT4_NRM},
+            {"bones", platform::ShaderInput::Format::BYTE4_NRM},
+            {"extra", platform::ShaderInput::Format::FLOAT4},
+        },
+        {
+            {"row0", platform::ShaderInput::Format::FLOAT4},
+            {"row1", platform::ShaderInput::Format::FLOAT4},
+            {"row2", platform::ShaderInput::Format::FLOAT4},
+            {"row3", platform::ShaderInput::Format::FLOAT4},
+        });
+    }
+
+    void drawFrame(
+        platform::RenderingDevice &render,
+        const std::vector<std::shared_ptr<platform::Shader>> &shaders,
+        const std::vector<std::shared_ptr<platform::StructuredData>> &meshes,
+        const std::shared_ptr<platform::StructuredData> &instanceData,
+        std::uint32_t drawCount
+    ) {
+        render.prepareFrame();
+
+        for (std::uint32_t i = 0; i < drawCount; i++) {
+            render.applyShader(shaders[i % SHADER_COUNT]);
+            render.drawGeometry(meshes[(i / SHADER_COUNT) % MESH_COUNT], instanceData, MESH_VERTEX_COUNT, 1);
+        }
+
+        render.presentFrame(0.0f);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const std::uint32_t drawCount = argc > 1 ? std::uint32_t(std::atoi(argv[1])) : 10000;
+    const std::uint32_t frameCount = argc > 2 ? std::uint32_t(std::atoi(argv[2])) : 100;
+
+    if (drawCount < SHADER_COUNT * MESH_COUNT || frameCount == 0) {
+        std::printf("Usage: vertex_array_bench [draws] [frames], at least %u draws\n", SHADER_COUNT * MESH_COUNT);
+        return 1;
+    }
+
+    std::shared_ptr<platform::Platform> platform = platform::getPlatformInstance();
+    std::shared_ptr<platform::RenderingDevice> render = platform::getRenderingDeviceInstance(platform);
+    std::vector<std::shared_ptr<platform::Shader>> shaders;
+    std::vector<std::shared_ptr<platform::StructuredData>> meshes;
+
+    for (std::uint32_t i = 0; i < SHADER_COUNT; i++) {
+        shaders.emplace_back(createShader(*render));
+    }
+    for (std::uint32_t i = 0; i < MESH_COUNT; i++) {
+        meshes.emplace_back(render->createData(nullptr, MESH_VERTEX_COUNT, MESH_VERTEX_STRIDE));
+    }
+
+    std::shared_ptr<platform::StructuredData> instanceData = render->createData(nullptr, 1, INSTANCE_STRIDE);
+
+    // first frame sets up every combination
+    const platform::RenderStats statsStart = render->getStats();
+    drawFrame(*render, shaders, meshes, instanceData, drawCount);
+    const platform::RenderStats statsFirst = render->getStats();
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::uint32_t frame = 0; frame < frameCount; frame++) {
+        drawFrame(*render, shaders, meshes, instanceData, drawCount);
+    }
+
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const platform::RenderStats statsMeasured = render->getStats();
+
+    // replaced mesh and reloaded shader are set up again with every partner
+    meshes[0] = render->createData(nullptr, MESH_VERTEX_COUNT, MESH_VERTEX_STRIDE);
+    render->reloadShader(shaders[0], SHADER_SOURCE);
+    drawFrame(*render, shaders, meshes, instanceData, drawCount);
+    const platform::RenderStats statsInvalidated = render->getStats();
+
+    const std::uint64_t combinations = SHADER_COUNT * MESH_COUNT;
+    const std::uint64_t measuredDraws = std::uint64_t(frameCount) * drawCount;
+    const std::uint64_t firstCreated = statsFirst.vertexArraysCreated - statsStart.vertexArraysCreated;
+    const std::uint64_t measuredCreated = statsMeasured.vertexArraysCreated - statsFirst.vertexArraysCreated;
+    const std::uint64_t measuredReused = statsMeasured.vertexArraysReused - statsFirst.vertexArraysReused;
+    const std::uint64_t invalidatedCreated = statsInvalidated.vertexArraysCreated - statsMeasured.vertexArraysCreated;
+
+    std::printf("attributes:     12 per vertex, 4 per instance\n");
+    std::printf("draws:          %llu in %u frames, %.1f ns/draw\n", (unsigned long long)measuredDraws, frameCount, sec * 1e9 / double(measuredDraws));
+    std::printf("vertex arrays:  %llu set up in first frame, %llu later, %llu draws reused cached\n",
+        (unsigned long long)firstCreated, (unsigned long long)measuredCreated, (unsigned long long)measuredReused);
+    std::printf("invalidation:   %llu set up after mesh was replaced and shader reloaded\n", (unsigned long long)invalidatedCreated);
+
+    const bool passed =
+        firstCreated == combinations &&
+        measuredCreated == 0 &&
+        measuredReused == measuredDraws &&
+        invalidatedCreated == MESH_COUNT + SHADER_COUNT - 1;
+
+    std::printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
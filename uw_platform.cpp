@@ -115,8 +115,8 @@ namespace native {
                         CoreWindow::GetForCurrentThread()->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
                         if (g_updateAndDraw) {
                             auto curFrameTime = std::chrono::high_resolution_clock::now();
-                            float dt = float(std::chrono::duration_cast<std::chrono::microseconds>(curFrameTime - prevFrameTime).count()) / 1000.0f;
-                            g_updateAndDraw(dt); // ms
+                            float dt = float(std::chrono::duration_cast<std::chrono::microseconds>(curFrameTime - prevFrameTime).count()) / 1000000.0f;
+                            g_updateAndDraw(dt); // seconds
                             prevFrameTime = curFrameTime;
                         }
                     }
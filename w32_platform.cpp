@@ -326,7 +326,7 @@ namespace native {
             }
 
             auto curFrameTime = std::chrono::high_resolution_clock::now();
-            float dt = float(std::chrono::duration_cast<std::chrono::microseconds>(curFrameTime - prevFrameTime).count()) / 1000.0f;
+            float dt = float(std::chrono::duration_cast<std::chrono::microseconds>(curFrameTime - prevFrameTime).count()) / 1000000.0f;
             g_updateAndDraw(dt);
             prevFrameTime = curFrameTime;
         }